@@ -0,0 +1,505 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include <e32atomics.h>
+#include "BitDrawAllocator.h"
+#include "BitDrawShadowFade.h"
+#include "BitDrawInterfaceId.h"
+#include "BitDrawScaling.h"
+#include "BitDrawOrigin.h"
+#include "BitDrawPixelFormat.h"
+
+RScanLineBufferPool::RScanLineBufferPool():
+	iMaxFreePerClass(0)
+	{
+	Mem::FillZ(iFree, sizeof(iFree));
+	Mem::FillZ(iFreeCount, sizeof(iFreeCount));
+	}
+
+/**
+@param aMaxFreePerClass Number of free buffers kept in each size class
+@return KErrNone, or an error from creating the lock
+*/
+TInt RScanLineBufferPool::Create(TInt aMaxFreePerClass)
+	{
+	__ASSERT_ALWAYS(aMaxFreePerClass >= 0, Panic(EScreenDriverPanicInvalidParameter));
+	iMaxFreePerClass = aMaxFreePerClass;
+	return iLock.CreateLocal();
+	}
+
+/**
+Frees the buffers kept by the pool. Buffers still in use must not be freed to the pool afterwards.
+*/
+void RScanLineBufferPool::Close()
+	{
+	Trim();
+	iLock.Close();
+	}
+
+/**
+@param aBytes Size of the buffer in bytes
+@return A buffer of at least aBytes bytes, or NULL if there is not enough memory
+*/
+TAny* RScanLineBufferPool::Alloc(TInt aBytes)
+	{
+	__ASSERT_DEBUG(aBytes >= 0, Panic(EScreenDriverPanicInvalidParameter));
+	const TInt sizeClass = SizeClass(aBytes);
+	if (sizeClass < KPooledBufferSizeClasses)
+		{
+		iLock.Wait();
+		TAny* buffer = iFree[sizeClass];
+		if (buffer)
+			{
+			iFree[sizeClass] = *static_cast<TAny**>(buffer);
+			iFreeCount[sizeClass]--;
+			}
+		iLock.Signal();
+		if (buffer)
+			return buffer;
+		aBytes = 1 << (sizeClass + KPooledBufferMinShift);
+		}
+	TBufferHeader* header = static_cast<TBufferHeader*>(User::Alloc(sizeof(TBufferHeader) + aBytes));
+	if (!header)
+		return NULL;
+	header->iSizeClass = sizeClass;
+	return header + 1;
+	}
+
+/**
+@param aBytes Size of the buffer in bytes
+@return A buffer of at least aBytes bytes
+@leave KErrNoMemory Not enough memory
+*/
+TAny* RScanLineBufferPool::AllocL(TInt aBytes)
+	{
+	TAny* buffer = Alloc(aBytes);
+	if (!buffer)
+		User::LeaveNoMemory();
+	return buffer;
+	}
+
+/**
+Returns a buffer to its size class, or to the heap if the class already holds as many free
+buffers as it may.
+@param aBuffer A buffer allocated from this pool, or NULL
+*/
+void RScanLineBufferPool::Free(TAny* aBuffer)
+	{
+	if (!aBuffer)
+		return;
+	TBufferHeader* header = static_cast<TBufferHeader*>(aBuffer) - 1;
+	const TInt sizeClass = header->iSizeClass;
+	if (sizeClass < KPooledBufferSizeClasses)
+		{
+		iLock.Wait();
+		const TBool keep = iFreeCount[sizeClass] < iMaxFreePerClass;
+		if (keep)
+			{
+			*static_cast<TAny**>(aBuffer) = iFree[sizeClass];
+			iFree[sizeClass] = aBuffer;
+			iFreeCount[sizeClass]++;
+			}
+		iLock.Signal();
+		if (keep)
+			return;
+		}
+	User::Free(header);
+	}
+
+/**
+Frees the buffers kept by the pool.
+*/
+void RScanLineBufferPool::Trim()
+	{
+	for (TInt sizeClass = 0; sizeClass < KPooledBufferSizeClasses; sizeClass++)
+		{
+		TAny* buffer = iFree[sizeClass];
+		while (buffer)
+			{
+			TAny* next = *static_cast<TAny**>(buffer);
+			User::Free(static_cast<TBufferHeader*>(buffer) - 1);
+			buffer = next;
+			}
+		iFree[sizeClass] = NULL;
+		iFreeCount[sizeClass] = 0;
+		}
+	}
+
+/**
+@return The smallest size class holding aBytes, or KPooledBufferSizeClasses if none does.
+*/
+TInt RScanLineBufferPool::SizeClass(TInt aBytes)
+	{
+	TInt sizeClass = 0;
+	while (sizeClass < KPooledBufferSizeClasses && (1 << (sizeClass + KPooledBufferMinShift)) < aBytes)
+		sizeClass++;
+	return sizeClass;
+	}
+
+/**
+@param aCachedDevices Number of released devices kept for reuse
+@return The new arena
+@leave KErrNoMemory Not enough memory
+*/
+CDrawDeviceArena* CDrawDeviceArena::NewL(TInt aCachedDevices)
+	{
+	__ASSERT_ALWAYS(aCachedDevices >= 0, Panic(EScreenDriverPanicInvalidParameter));
+	CDrawDeviceArena* self = new(ELeave) CDrawDeviceArena(aCachedDevices);
+	CleanupStack::PushL(self);
+	self->ConstructL();
+	CleanupStack::Pop(self);
+	return self;
+	}
+
+CDrawDeviceArena::CDrawDeviceArena(TInt aCachedDevices):
+	iMaxCached(aCachedDevices),
+	// Keeps every object 8 byte aligned.
+	iSlotSize((sizeof(TSlot) + sizeof(CArenaBitmapDevice) + 7) & ~7)
+	{
+	}
+
+void CDrawDeviceArena::ConstructL()
+	{
+	User::LeaveIfError(iPool.Create());
+	if (iMaxCached > 0)
+		iCache = new(ELeave) TCachedDevice[iMaxCached];
+	}
+
+/**
+@panic EScreenDriverPanicIvalidMethodCall A device of the arena has not been deleted
+*/
+CDrawDeviceArena::~CDrawDeviceArena()
+	{
+	__ASSERT_ALWAYS(iLiveDevices == 0, Panic(EScreenDriverPanicIvalidMethodCall));
+	while (iCachedCount > 0)
+		RemoveCached(0);
+	delete [] iCache;
+	for (TInt index = 0; index < iBlocks.Count(); index++)
+		User::Free(iBlocks[index]);
+	iBlocks.Close();
+	iPool.Close();
+	}
+
+/**
+Creates a bitmap device, as CFbsDrawDevice::NewBitmapDeviceL() does, drawing to pixel memory owned
+by the arena. The stride is the width rounded up to a whole number of 32 bit words.
+@param aSize		Size of the device in pixels
+@param aDispMode	Display mode of the device
+@return The new device, to be deleted before the arena
+@leave KErrNoMemory Not enough memory, or any error from CFbsDrawDevice::NewBitmapDeviceL()
+@panic EScreenDriverPanicInvalidSize aSize is empty
+*/
+CFbsDrawDevice* CDrawDeviceArena::NewBitmapDeviceL(const TSize& aSize, TDisplayMode aDispMode)
+	{
+	__ASSERT_ALWAYS(aSize.iWidth > 0 && aSize.iHeight > 0, Panic(EScreenDriverPanicInvalidSize));
+	TSlot* slot = AllocSlotL();
+	CFbsDrawDevice* device = NULL;
+	TAny* bits = NULL;
+	TRAPD(err, TakeDeviceL(aSize, aDispMode, device, bits));
+	if (err != KErrNone)
+		{
+		FreeSlot(slot);
+		User::Leave(err);
+		}
+	iLiveDevices++;
+	return new(slot + 1) CArenaBitmapDevice(*this, device, bits, aSize);
+	}
+
+/**
+Destroys the released devices kept for reuse, and frees the buffers kept by the pool.
+*/
+void CDrawDeviceArena::Trim()
+	{
+	while (iCachedCount > 0)
+		RemoveCached(0);
+	iPool.Trim();
+	}
+
+CDrawDeviceArena::TSlot* CDrawDeviceArena::AllocSlotL()
+	{
+	if (!iFreeSlots)
+		{
+		TUint8* block = static_cast<TUint8*>(User::AllocL(iSlotSize * KArenaBlockDevices));
+		TInt err = iBlocks.Append(block);
+		if (err != KErrNone)
+			{
+			User::Free(block);
+			User::Leave(err);
+			}
+		for (TInt index = KArenaBlockDevices - 1; index >= 0; index--)
+			{
+			TSlot* slot = reinterpret_cast<TSlot*>(block + index * iSlotSize);
+			slot->iArena = this;
+			slot->iNextFree = iFreeSlots;
+			iFreeSlots = slot;
+			}
+		}
+	TSlot* slot = iFreeSlots;
+	iFreeSlots = slot->iNextFree;
+	return slot;
+	}
+
+void CDrawDeviceArena::FreeSlot(TSlot* aSlot)
+	{
+	aSlot->iNextFree = iFreeSlots;
+	iFreeSlots = aSlot;
+	}
+
+/**
+Takes the most recently released device of the given size and display mode, or creates one.
+*/
+void CDrawDeviceArena::TakeDeviceL(const TSize& aSize, TDisplayMode aDispMode, CFbsDrawDevice*& aDevice, TAny*& aBits)
+	{
+	for (TInt index = iCachedCount - 1; index >= 0; index--)
+		{
+		const TCachedDevice& cached = iCache[index];
+		if (cached.iSize == aSize && cached.iDisplayMode == aDispMode)
+			{
+			aDevice = cached.iDevice;
+			aBits = cached.iBits;
+			iCachedCount--;
+			Mem::Move(iCache + index, iCache + index + 1, (iCachedCount - index) * sizeof(TCachedDevice));
+			return;
+			}
+		}
+	const TInt stride = ((aSize.iWidth * BitsInMemory(aDispMode) + 31) >> 5) << 2;
+	CFbsDrawDevice* device = CFbsDrawDevice::NewBitmapDeviceL(aSize, aDispMode, stride);
+	CleanupStack::PushL(device);
+	aBits = iPool.AllocL(stride * aSize.iHeight);
+	CleanupStack::Pop(device);
+	device->SetBits(aBits);
+	aDevice = device;
+	}
+
+/**
+Called as a device of the arena is deleted: keeps the device it wraps for reuse if its state can be
+reset, otherwise destroys it.
+*/
+void CDrawDeviceArena::Release(CArenaBitmapDevice& aDevice)
+	{
+	CFbsDrawDevice* device = aDevice.iTarget;
+	TBool reusable = !aDevice.iModified && iMaxCached > 0;
+	if (reusable && aDevice.iSwapped)
+		device->SwapWidthAndHeight();
+	if (reusable && aDevice.iRotated)
+		reusable = device->SetOrientation(CFbsDrawDevice::EOrientationNormal);
+	if (reusable && aDevice.iScaled)
+		reusable = ResetScaling(*device);
+	if (!reusable)
+		{
+		delete device;
+		iPool.Free(aDevice.iBits);
+		return;
+		}
+	device->SetBits(aDevice.iBits);
+	device->SetShadowMode(CFbsDrawDevice::ENoShadow);
+	device->SetFadingParameters(KDefaultFadeBlackMap, KDefaultFadeWhiteMap);
+	device->SetDitherOrigin(TPoint(0, 0));
+	device->SetUserDisplayMode(device->DisplayMode());
+	if (iCachedCount == iMaxCached)
+		RemoveCached(0);
+	TCachedDevice& cached = iCache[iCachedCount++];
+	cached.iDevice = device;
+	cached.iBits = aDevice.iBits;
+	cached.iSize = aDevice.iSize;
+	cached.iDisplayMode = device->DisplayMode();
+	}
+
+/**
+Sets the scaling factors to 1 and the origin to [0,0].
+@return ETrue if both were reset.
+*/
+TBool CDrawDeviceArena::ResetScaling(CFbsDrawDevice& aDevice)
+	{
+	TAny* interface = NULL;
+	if (aDevice.GetInterface(KScalingSettingsInterfaceID, interface) != KErrNone ||
+		static_cast<MScalingSettings*>(interface)->Set(1, 1, 1, 1) != KErrNone)
+		{
+		return EFalse;
+		}
+	interface = NULL;
+	return aDevice.GetInterface(KDrawDeviceOriginInterfaceID, interface) == KErrNone &&
+		   static_cast<MDrawDeviceOrigin*>(interface)->Set(TPoint(0, 0)) == KErrNone;
+	}
+
+void CDrawDeviceArena::RemoveCached(TInt aIndex)
+	{
+	delete iCache[aIndex].iDevice;
+	iPool.Free(iCache[aIndex].iBits);
+	iCachedCount--;
+	Mem::Move(iCache + aIndex, iCache + aIndex + 1, (iCachedCount - aIndex) * sizeof(TCachedDevice));
+	}
+
+/**
+Gives the slot of a deleted device object back to its arena.
+*/
+void CDrawDeviceArena::FreeDevice(TAny* aObject)
+	{
+	TSlot* slot = static_cast<TSlot*>(aObject) - 1;
+	CDrawDeviceArena* arena = slot->iArena;
+	arena->iLiveDevices--;
+	arena->FreeSlot(slot);
+	}
+
+CArenaBitmapDevice::CArenaBitmapDevice(CDrawDeviceArena& aArena, CFbsDrawDevice* aTarget, TAny* aBits, const TSize& aSize):
+	CForwardingDrawDevice(aTarget),
+	iArena(aArena),
+	iBits(aBits),
+	iSize(aSize)
+	{
+	}
+
+CArenaBitmapDevice::~CArenaBitmapDevice()
+	{
+	iArena.Release(*this);
+	// Released to the arena, which destroys it when it is not reused.
+	iTarget = NULL;
+	}
+
+/**
+The object lives in a slot of its arena, not on the heap.
+*/
+void CArenaBitmapDevice::operator delete(TAny* aObject)
+	{
+	CDrawDeviceArena::FreeDevice(aObject);
+	}
+
+TBool CArenaBitmapDevice::SetOrientation(TOrientation aOrientation)
+	{
+	const TBool done = iTarget->SetOrientation(aOrientation);
+	if (done)
+		iRotated = aOrientation != EOrientationNormal;
+	return done;
+	}
+
+TInt CArenaBitmapDevice::SetCustomPalette(const CPalette* aPalette)
+	{
+	const TInt err = iTarget->SetCustomPalette(aPalette);
+	if (err == KErrNone)
+		iModified = ETrue;
+	return err;
+	}
+
+void CArenaBitmapDevice::SetDisplayMode(CFbsDrawDevice* aDrawDevice)
+	{
+	iTarget->SetDisplayMode(aDrawDevice);
+	iModified = ETrue;
+	}
+
+/**
+The scaling settings and origin interfaces change state that must be reset before reuse.
+*/
+TInt CArenaBitmapDevice::GetInterface(TInt aInterfaceId, TAny*& aInterface)
+	{
+	const TInt err = iTarget->GetInterface(aInterfaceId, aInterface);
+	if (err == KErrNone && (aInterfaceId == KScalingSettingsInterfaceID || aInterfaceId == KDrawDeviceOriginInterfaceID))
+		iScaled = ETrue;
+	return err;
+	}
+
+void CArenaBitmapDevice::SwapWidthAndHeight()
+	{
+	iTarget->SwapWidthAndHeight();
+	iSwapped = !iSwapped;
+	}
+
+/**
+Wraps an existing device.
+@param aTarget	Device to wrap. Ownership is transferred if the function does not leave.
+@param aPool	Pool the scan line buffers are taken from, which must outlive the device
+@return The new device
+@leave KErrNoMemory Not enough memory
+*/
+CThreadScanLineDevice* CThreadScanLineDevice::NewL(CFbsDrawDevice* aTarget, RScanLineBufferPool& aPool)
+	{
+	return new(ELeave) CThreadScanLineDevice(aTarget, aPool);
+	}
+
+CThreadScanLineDevice::CThreadScanLineDevice(CFbsDrawDevice* aTarget, RScanLineBufferPool& aPool):
+	CForwardingDrawDevice(aTarget),
+	iPool(aPool)
+	{
+	const TSize size = aTarget->SizeInPixels();
+	iBufferBytes = Max(aTarget->ScanLineBytes(), Max(size.iWidth, size.iHeight) * 4);
+	for (TInt index = 0; index < KMaxScanLineBufferThreads; index++)
+		{
+		iBuffers[index].iThreadId = 0;
+		iBuffers[index].iBuffer = NULL;
+		}
+	}
+
+CThreadScanLineDevice::~CThreadScanLineDevice()
+	{
+	for (TInt index = 0; index < KMaxScanLineBufferThreads; index++)
+		iPool.Free(iBuffers[index].iBuffer);
+	}
+
+/**
+Returns the buffer of the calling thread to the pool. A thread that no longer uses the device,
+for example because it is about to exit, should call this so that another thread can have a buffer.
+*/
+void CThreadScanLineDevice::ReleaseThreadBuffer()
+	{
+	const TUint32 threadId = CurrentThreadId();
+	for (TInt index = 0; index < KMaxScanLineBufferThreads; index++)
+		{
+		TThreadBuffer& entry = iBuffers[index];
+		if (__e32_atomic_load_acq32(&entry.iThreadId) == threadId)
+			{
+			iPool.Free(entry.iBuffer);
+			entry.iBuffer = NULL;
+			__e32_atomic_store_rel32(&entry.iThreadId, 0);
+			return;
+			}
+		}
+	}
+
+/**
+@return The scan line buffer of the calling thread, or that of the wrapped device if the calling
+thread cannot have one.
+*/
+TUint32* CThreadScanLineDevice::ScanLineBuffer() const
+	{
+	const TUint32 threadId = CurrentThreadId();
+	for (TInt index = 0; index < KMaxScanLineBufferThreads; index++)
+		{
+		if (__e32_atomic_load_acq32(&iBuffers[index].iThreadId) == threadId)
+			return iBuffers[index].iBuffer;
+		}
+	// Only the thread that claims an entry writes its buffer, and only that thread reads it.
+	for (TInt index = 0; index < KMaxScanLineBufferThreads; index++)
+		{
+		TThreadBuffer& entry = iBuffers[index];
+		TUint32 free = 0;
+		if (entry.iThreadId == 0 && __e32_atomic_cas_acq32(&entry.iThreadId, &free, threadId))
+			{
+			entry.iBuffer = static_cast<TUint32*>(iPool.Alloc(iBufferBytes));
+			if (entry.iBuffer)
+				return entry.iBuffer;
+			__e32_atomic_store_rel32(&entry.iThreadId, 0);
+			break;
+			}
+		}
+	return iTarget->ScanLineBuffer();
+	}
+
+/**
+@return A non-zero identifier of the calling thread.
+*/
+TUint32 CThreadScanLineDevice::CurrentThreadId()
+	{
+	// Thread ids start at 1 and are not reused while the system is up.
+	return TUint32(RThread().Id().Id());
+	}
@@ -0,0 +1,256 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWALLOCATOR_H__
+#define __BITDRAWALLOCATOR_H__
+
+#include <e32base.h>
+#include "BitDrawForwarding.h"
+
+/**
+log2 of the size in bytes of the smallest size class of RScanLineBufferPool.
+@internalComponent
+*/
+const TInt KPooledBufferMinShift = 6;
+
+/**
+Number of size classes of RScanLineBufferPool, each twice the size of the one before: from 64 bytes
+to 4 MB. Larger buffers are allocated and freed on the heap.
+@internalComponent
+*/
+const TInt KPooledBufferSizeClasses = 17;
+
+/**
+Default number of free buffers RScanLineBufferPool keeps in each size class.
+@internalComponent
+*/
+const TInt KDefaultPooledBuffersPerClass = 8;
+
+/**
+Default number of released bitmap devices CDrawDeviceArena keeps for reuse.
+@internalComponent
+*/
+const TInt KDefaultArenaCachedDevices = 32;
+
+/**
+Number of device objects in each block allocated by CDrawDeviceArena.
+@internalComponent
+*/
+const TInt KArenaBlockDevices = 16;
+
+/**
+Maximum number of threads that can have a scan line buffer of their own in a CThreadScanLineDevice.
+@internalComponent
+*/
+const TInt KMaxScanLineBufferThreads = 16;
+
+/**
+Pool of scan line and pixel buffers, recycled by size class.
+
+Requests are rounded up to a power of two of at least 64 bytes. A freed buffer is kept on the free
+list of its class, up to a limit per class, and handed out again to the next request of that class
+without going to the heap. Buffers are 8 byte aligned. The pool can be used from several threads at
+once; the free lists are locked only while a buffer is taken or returned.
+@internalComponent
+*/
+class RScanLineBufferPool
+	{
+public:
+	RScanLineBufferPool();
+	TInt Create(TInt aMaxFreePerClass = KDefaultPooledBuffersPerClass);
+	void Close();
+	TAny* Alloc(TInt aBytes);
+	TAny* AllocL(TInt aBytes);
+	void Free(TAny* aBuffer);
+	void Trim();
+private:
+	/**
+	Header in front of every buffer. The buffer holds the link of the free list while it is free.
+	*/
+	struct TBufferHeader
+		{
+		TInt iSizeClass;		///< KPooledBufferSizeClasses for a buffer that is not pooled
+		TInt iReserved;			///< Keeps the buffer 8 byte aligned
+		};
+private:
+	static TInt SizeClass(TInt aBytes);
+private:
+	RFastLock iLock;
+	TInt iMaxFreePerClass;
+	TAny* iFree[KPooledBufferSizeClasses];
+	TInt iFreeCount[KPooledBufferSizeClasses];
+	};
+
+class CArenaBitmapDevice;
+
+/**
+Creates bitmap devices for short-lived off-screen drawing and recycles them.
+
+A device returned by NewBitmapDeviceL() is placed in a slot of a block of device objects owned by the
+arena, and draws to pixel memory taken from the arena's RScanLineBufferPool, so creating and deleting
+it does not go to the heap once the arena is warm. When it is deleted, the bitmap device it wraps is
+kept together with its pixel memory, and the next request for the same size and display mode gets them
+back. Before that, SwapWidthAndHeight() and SetOrientation() are undone, and the shadow mode, fading
+parameters, dither origin and user display mode are reset to their defaults. If the scaling settings
+or origin interface was handed out by GetInterface(), the scaling factors are reset to 1 and the
+origin to [0,0]. Up to aCachedDevices released devices are kept; beyond that the least recently
+released one is destroyed. A device whose display mode or palette was changed, or whose scaling
+could not be reset, is destroyed rather than kept.
+
+The pixels of a new device are undefined. A device can be given other pixel memory with SetBits(); the
+arena's memory is still recycled when it is deleted.
+
+The arena is not thread safe, and all its devices must be deleted before it is. Its buffer pool is
+thread safe and may be shared, for example with CThreadScanLineDevice.
+@internalComponent
+*/
+class CDrawDeviceArena : public CBase
+	{
+public:
+	static CDrawDeviceArena* NewL(TInt aCachedDevices = KDefaultArenaCachedDevices);
+	~CDrawDeviceArena();
+	CFbsDrawDevice* NewBitmapDeviceL(const TSize& aSize, TDisplayMode aDispMode);
+	void Trim();
+	inline RScanLineBufferPool& BufferPool();
+	inline TInt CachedDeviceCount() const;
+private:
+	/**
+	Released bitmap device kept for reuse.
+	*/
+	struct TCachedDevice
+		{
+		CFbsDrawDevice* iDevice;
+		TAny* iBits;
+		TSize iSize;
+		TDisplayMode iDisplayMode;
+		};
+	/**
+	Header in front of every device object.
+	*/
+	struct TSlot
+		{
+		CDrawDeviceArena* iArena;
+		TSlot* iNextFree;
+		};
+private:
+	CDrawDeviceArena(TInt aCachedDevices);
+	void ConstructL();
+	TSlot* AllocSlotL();
+	void FreeSlot(TSlot* aSlot);
+	void TakeDeviceL(const TSize& aSize, TDisplayMode aDispMode, CFbsDrawDevice*& aDevice, TAny*& aBits);
+	void Release(CArenaBitmapDevice& aDevice);
+	void RemoveCached(TInt aIndex);
+	static TBool ResetScaling(CFbsDrawDevice& aDevice);
+	static void FreeDevice(TAny* aObject);
+private:
+	RScanLineBufferPool iPool;
+	TInt iMaxCached;
+	TInt iSlotSize;
+	TCachedDevice* iCache;
+	TInt iCachedCount;
+	RPointerArray<TAny> iBlocks;
+	TSlot* iFreeSlots;
+	TInt iLiveDevices;
+	friend class CArenaBitmapDevice;
+	};
+
+/**
+@return The pool the arena takes pixel memory from.
+*/
+inline RScanLineBufferPool& CDrawDeviceArena::BufferPool()
+	{
+	return iPool;
+	}
+
+/**
+@return The number of released devices kept for reuse.
+*/
+inline TInt CDrawDeviceArena::CachedDeviceCount() const
+	{
+	return iCachedCount;
+	}
+
+/**
+Bitmap device handed out by CDrawDeviceArena. Records the state that has to be undone before the
+device it wraps can be reused, and gives its object back to the arena when it is deleted.
+@see CDrawDeviceArena
+@internalComponent
+*/
+class CArenaBitmapDevice : public CForwardingDrawDevice
+	{
+public:
+	~CArenaBitmapDevice();
+	static void operator delete(TAny* aObject);
+public: // From CFbsDrawDevice
+	TBool SetOrientation(TOrientation aOrientation);
+	TInt SetCustomPalette(const CPalette* aPalette);
+	void SetDisplayMode(CFbsDrawDevice* aDrawDevice);
+	TInt GetInterface(TInt aInterfaceId, TAny*& aInterface);
+	void SwapWidthAndHeight();
+private:
+	CArenaBitmapDevice(CDrawDeviceArena& aArena, CFbsDrawDevice* aTarget, TAny* aBits, const TSize& aSize);
+private:
+	CDrawDeviceArena& iArena;
+	TAny* iBits;
+	TSize iSize;
+	TBool iRotated;
+	TBool iSwapped;
+	TBool iScaled;
+	TBool iModified;
+	friend class CDrawDeviceArena;
+	};
+
+/**
+Device whose ScanLineBuffer() returns a different buffer to every calling thread, so that threads
+drawing to or reading from the same device at once do not have to serialize on its scan line buffer.
+
+A thread's buffer is taken from a RScanLineBufferPool the first time it calls ScanLineBuffer(), and is
+kept until it calls ReleaseThreadBuffer() or the device is deleted. Finding the buffer of the calling
+thread takes no lock: the table of threads is only written when a thread gets or releases its buffer.
+Buffers hold a line of 32 bit pixels along either dimension, so they stay valid after
+SwapWidthAndHeight(). Once KMaxScanLineBufferThreads threads have a buffer, or if the pool is out of
+memory, the buffer of the wrapped device is returned.
+
+Only ScanLineBuffer() is changed: primitives of the wrapped device that use its own buffer must still
+be serialized by the caller.
+@internalComponent
+*/
+class CThreadScanLineDevice : public CForwardingDrawDevice
+	{
+public:
+	static CThreadScanLineDevice* NewL(CFbsDrawDevice* aTarget, RScanLineBufferPool& aPool);
+	~CThreadScanLineDevice();
+	void ReleaseThreadBuffer();
+public: // From CFbsDrawDevice
+	TUint32* ScanLineBuffer() const;
+private:
+	/**
+	Scan line buffer of one thread.
+	*/
+	struct TThreadBuffer
+		{
+		volatile TUint32 iThreadId;		///< 0 while the entry is free
+		TUint32* iBuffer;
+		};
+private:
+	CThreadScanLineDevice(CFbsDrawDevice* aTarget, RScanLineBufferPool& aPool);
+	static TUint32 CurrentThreadId();
+private:
+	RScanLineBufferPool& iPool;
+	TInt iBufferBytes;
+	mutable TThreadBuffer iBuffers[KMaxScanLineBufferThreads];
+	};
+
+#endif
@@ -0,0 +1,912 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawAlphaBlend.h"
+#include "bitdraw.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define __BITDRAW_SSE2__
+#include <immintrin.h>
+#if defined(__x86_64__)
+#define __BITDRAW_AVX2__
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define __BITDRAW_NEON__
+#include <arm_neon.h>
+#endif
+
+/**
+Per-instruction-set table of span kernels.
+aForceAlpha is ORed into every 32bpp destination pixel - 0xFF000000 for EColor16MU, 0 otherwise.
+iOver32 composes premultiplied source pixels over the destination.
+@internalComponent
+*/
+struct TBlendFunctions
+	{
+	void (*iLine32)(TUint32* aDest, const TUint32* aSrc, const TUint32* aBack, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha);
+	void (*iColor32)(TUint32* aDest, TUint32 aColor, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha);
+	void (*iLine64K)(TUint16* aDest, const TUint32* aSrc, const TUint16* aBack, const TUint8* aMask, TInt aLength);
+	void (*iColor64K)(TUint16* aDest, TUint32 aColor, const TUint8* aMask, TInt aLength);
+	void (*iOver32)(TUint32* aDest, const TUint32* aSrc, TInt aLength, TUint32 aForceAlpha);
+	};
+
+const TUint32 KOpaque = 0xff000000;
+
+//
+// Scalar kernels. These define the results every other implementation must reproduce.
+//
+
+LOCAL_C inline TUint32 BlendPixel32(TUint32 aSrc, TUint32 aBack, TUint32 aAlpha)
+	{
+	const TUint32 inv = 255 - aAlpha;
+	const TUint32 b = Div255((aSrc & 0xff) * aAlpha + (aBack & 0xff) * inv);
+	const TUint32 g = Div255(((aSrc >> 8) & 0xff) * aAlpha + ((aBack >> 8) & 0xff) * inv);
+	const TUint32 r = Div255(((aSrc >> 16) & 0xff) * aAlpha + ((aBack >> 16) & 0xff) * inv);
+	const TUint32 a = Div255((aSrc >> 24) * aAlpha + (aBack >> 24) * inv);
+	return (a << 24) | (r << 16) | (g << 8) | b;
+	}
+
+LOCAL_C inline TUint32 Expand64K(TUint32 aPixel)
+	{
+	const TUint32 r = (aPixel >> 11) & 0x1f;
+	const TUint32 g = (aPixel >> 5) & 0x3f;
+	const TUint32 b = aPixel & 0x1f;
+	return KOpaque | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+	}
+
+LOCAL_C inline TUint16 Pack64K(TUint32 aPixel)
+	{
+	return TUint16(((aPixel >> 8) & 0xf800) | ((aPixel >> 5) & 0x07e0) | ((aPixel >> 3) & 0x001f));
+	}
+
+LOCAL_C void Line32Scalar(TUint32* aDest, const TUint32* aSrc, const TUint32* aBack, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha)
+	{
+	for (TInt i = 0; i < aLength; i++)
+		{
+		const TUint32 alpha = aMask[i];
+		if (alpha == 0)
+			aDest[i] = aBack[i] | aForceAlpha;
+		else if (alpha == 255)
+			aDest[i] = aSrc[i] | KOpaque;
+		else
+			aDest[i] = BlendPixel32(aSrc[i] | KOpaque, aBack[i], alpha) | aForceAlpha;
+		}
+	}
+
+LOCAL_C void Color32Scalar(TUint32* aDest, TUint32 aColor, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha)
+	{
+	aColor |= KOpaque;
+	for (TInt i = 0; i < aLength; i++)
+		{
+		const TUint32 alpha = aMask[i];
+		if (alpha == 0)
+			aDest[i] |= aForceAlpha;
+		else if (alpha == 255)
+			aDest[i] = aColor;
+		else
+			aDest[i] = BlendPixel32(aColor, aDest[i], alpha) | aForceAlpha;
+		}
+	}
+
+LOCAL_C void Line64KScalar(TUint16* aDest, const TUint32* aSrc, const TUint16* aBack, const TUint8* aMask, TInt aLength)
+	{
+	for (TInt i = 0; i < aLength; i++)
+		{
+		const TUint32 alpha = aMask[i];
+		if (alpha == 0)
+			aDest[i] = aBack[i];
+		else if (alpha == 255)
+			aDest[i] = Pack64K(aSrc[i]);
+		else
+			aDest[i] = Pack64K(BlendPixel32(aSrc[i] | KOpaque, Expand64K(aBack[i]), alpha));
+		}
+	}
+
+LOCAL_C void Color64KScalar(TUint16* aDest, TUint32 aColor, const TUint8* aMask, TInt aLength)
+	{
+	aColor |= KOpaque;
+	const TUint16 packed = Pack64K(aColor);
+	for (TInt i = 0; i < aLength; i++)
+		{
+		const TUint32 alpha = aMask[i];
+		if (alpha == 255)
+			aDest[i] = packed;
+		else if (alpha != 0)
+			aDest[i] = Pack64K(BlendPixel32(aColor, Expand64K(aDest[i]), alpha));
+		}
+	}
+
+/**
+Src-over for a premultiplied source: C = Cs + Cd * (255 - As) / 255 on all four channels,
+saturated so that sources whose colour exceeds their alpha cannot wrap.
+*/
+LOCAL_C inline TUint32 OverPixel32(TUint32 aSrc, TUint32 aBack)
+	{
+	const TUint32 inv = 255 - (aSrc >> 24);
+	TUint32 result = 0;
+	for (TInt shift = 0; shift < 32; shift += 8)
+		{
+		const TUint32 channel = ((aSrc >> shift) & 0xff) + Div255(((aBack >> shift) & 0xff) * inv);
+		result |= Min(channel, TUint32(0xff)) << shift;
+		}
+	return result;
+	}
+
+LOCAL_C void Over32Scalar(TUint32* aDest, const TUint32* aSrc, TInt aLength, TUint32 aForceAlpha)
+	{
+	for (TInt i = 0; i < aLength; i++)
+		{
+		const TUint32 src = aSrc[i];
+		if (src >= KOpaque)
+			aDest[i] = src;
+		else if (src == 0)
+			aDest[i] |= aForceAlpha;
+		else
+			aDest[i] = OverPixel32(src, aDest[i]) | aForceAlpha;
+		}
+	}
+
+LOCAL_D const TBlendFunctions KScalarFunctions =
+	{
+	Line32Scalar,
+	Color32Scalar,
+	Line64KScalar,
+	Color64KScalar,
+	Over32Scalar
+	};
+
+/**
+Reads 4 (or 8) mask bytes as one word, so that all-transparent and all-opaque
+blocks can be detected with a single comparison.
+*/
+LOCAL_C inline TUint32 Mask4(const TUint8* aMask)
+	{
+	return aMask[0] | (aMask[1] << 8) | (aMask[2] << 16) | (TUint32(aMask[3]) << 24);
+	}
+
+LOCAL_C inline TUint64 Mask8(const TUint8* aMask)
+	{
+	return Mask4(aMask) | (TUint64(Mask4(aMask + 4)) << 32);
+	}
+
+const TUint64 KMask8Opaque = 0xffffffffffffffffULL;
+
+#ifdef __BITDRAW_SSE2__
+
+//
+// SSE2 kernels - 4 pixels per iteration for 32bpp, 8 for 64K.
+//
+
+/** (aSrc * aAlpha + aBack * (255 - aAlpha)) / 255 on 16-bit lanes. */
+LOCAL_C inline __m128i Blend16Sse2(__m128i aSrc, __m128i aBack, __m128i aAlpha)
+	{
+	const __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), aAlpha);
+	__m128i x = _mm_add_epi16(_mm_mullo_epi16(aSrc, aAlpha), _mm_mullo_epi16(aBack, inv));
+	x = _mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8));
+	return _mm_srli_epi16(x, 8);
+	}
+
+LOCAL_C inline __m128i Blend32Sse2(__m128i aSrc, __m128i aBack, TUint32 aMask)
+	{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i alpha = _mm_cvtsi32_si128(TInt(aMask));
+	alpha = _mm_unpacklo_epi8(alpha, alpha);
+	alpha = _mm_unpacklo_epi16(alpha, alpha);
+	const __m128i lo = Blend16Sse2(_mm_unpacklo_epi8(aSrc, zero), _mm_unpacklo_epi8(aBack, zero), _mm_unpacklo_epi8(alpha, zero));
+	const __m128i hi = Blend16Sse2(_mm_unpackhi_epi8(aSrc, zero), _mm_unpackhi_epi8(aBack, zero), _mm_unpackhi_epi8(alpha, zero));
+	return _mm_packus_epi16(lo, hi);
+	}
+
+LOCAL_C void Line32Sse2(TUint32* aDest, const TUint32* aSrc, const TUint32* aBack, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha)
+	{
+	const __m128i opaque = _mm_set1_epi32(TInt(KOpaque));
+	const __m128i force = _mm_set1_epi32(TInt(aForceAlpha));
+	TInt i = 0;
+	for (; i + 4 <= aLength; i += 4)
+		{
+		const TUint32 mask = Mask4(aMask + i);
+		__m128i* dest = reinterpret_cast<__m128i*>(aDest + i);
+		const __m128i back = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aBack + i));
+		if (mask == 0)
+			{
+			if (aDest != aBack || aForceAlpha)
+				_mm_storeu_si128(dest, _mm_or_si128(back, force));
+			continue;
+			}
+		const __m128i src = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i)), opaque);
+		if (mask == 0xffffffff)
+			_mm_storeu_si128(dest, src);
+		else
+			_mm_storeu_si128(dest, _mm_or_si128(Blend32Sse2(src, back, mask), force));
+		}
+	Line32Scalar(aDest + i, aSrc + i, aBack + i, aMask + i, aLength - i, aForceAlpha);
+	}
+
+LOCAL_C void Color32Sse2(TUint32* aDest, TUint32 aColor, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha)
+	{
+	const __m128i src = _mm_set1_epi32(TInt(aColor | KOpaque));
+	const __m128i force = _mm_set1_epi32(TInt(aForceAlpha));
+	TInt i = 0;
+	for (; i + 4 <= aLength; i += 4)
+		{
+		const TUint32 mask = Mask4(aMask + i);
+		__m128i* dest = reinterpret_cast<__m128i*>(aDest + i);
+		if (mask == 0)
+			{
+			if (aForceAlpha)
+				_mm_storeu_si128(dest, _mm_or_si128(_mm_loadu_si128(dest), force));
+			}
+		else if (mask == 0xffffffff)
+			_mm_storeu_si128(dest, src);
+		else
+			_mm_storeu_si128(dest, _mm_or_si128(Blend32Sse2(src, _mm_loadu_si128(dest), mask), force));
+		}
+	Color32Scalar(aDest + i, aColor, aMask + i, aLength - i, aForceAlpha);
+	}
+
+/** Splits 8 EColor64K pixels into 8-bit channel values on 16-bit lanes. */
+LOCAL_C inline void Expand64KSse2(__m128i aPixels, __m128i& aRed, __m128i& aGreen, __m128i& aBlue)
+	{
+	const __m128i r = _mm_srli_epi16(aPixels, 11);
+	const __m128i g = _mm_and_si128(_mm_srli_epi16(aPixels, 5), _mm_set1_epi16(0x3f));
+	const __m128i b = _mm_and_si128(aPixels, _mm_set1_epi16(0x1f));
+	aRed = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+	aGreen = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+	aBlue = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+	}
+
+LOCAL_C inline __m128i Pack64KSse2(__m128i aRed, __m128i aGreen, __m128i aBlue)
+	{
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_srli_epi16(aRed, 3), 11),
+									 _mm_slli_epi16(_mm_srli_epi16(aGreen, 2), 5)),
+						_mm_srli_epi16(aBlue, 3));
+	}
+
+/** Splits 8 ERgb pixels into 8-bit channel values on 16-bit lanes. */
+LOCAL_C inline void SplitRgbSse2(const TUint32* aSrc, __m128i& aRed, __m128i& aGreen, __m128i& aBlue)
+	{
+	const __m128i ff = _mm_set1_epi32(0xff);
+	const __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc));
+	const __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + 4));
+	aBlue = _mm_packs_epi32(_mm_and_si128(s0, ff), _mm_and_si128(s1, ff));
+	aGreen = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 8), ff), _mm_and_si128(_mm_srli_epi32(s1, 8), ff));
+	aRed = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 16), ff), _mm_and_si128(_mm_srli_epi32(s1, 16), ff));
+	}
+
+LOCAL_C void Line64KSse2(TUint16* aDest, const TUint32* aSrc, const TUint16* aBack, const TUint8* aMask, TInt aLength)
+	{
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const TUint64 mask = Mask8(aMask + i);
+		__m128i* dest = reinterpret_cast<__m128i*>(aDest + i);
+		const __m128i back = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aBack + i));
+		if (mask == 0)
+			{
+			if (aDest != aBack)
+				_mm_storeu_si128(dest, back);
+			continue;
+			}
+		__m128i sr, sg, sb;
+		SplitRgbSse2(aSrc + i, sr, sg, sb);
+		if (mask == KMask8Opaque)
+			{
+			_mm_storeu_si128(dest, Pack64KSse2(sr, sg, sb));
+			continue;
+			}
+		__m128i br, bg, bb;
+		Expand64KSse2(back, br, bg, bb);
+		const __m128i alpha = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(aMask + i)), _mm_setzero_si128());
+		_mm_storeu_si128(dest, Pack64KSse2(Blend16Sse2(sr, br, alpha), Blend16Sse2(sg, bg, alpha), Blend16Sse2(sb, bb, alpha)));
+		}
+	Line64KScalar(aDest + i, aSrc + i, aBack + i, aMask + i, aLength - i);
+	}
+
+LOCAL_C void Color64KSse2(TUint16* aDest, TUint32 aColor, const TUint8* aMask, TInt aLength)
+	{
+	const __m128i sr = _mm_set1_epi16((aColor >> 16) & 0xff);
+	const __m128i sg = _mm_set1_epi16((aColor >> 8) & 0xff);
+	const __m128i sb = _mm_set1_epi16(aColor & 0xff);
+	const __m128i packed = _mm_set1_epi16(TInt16(Pack64K(aColor)));
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const TUint64 mask = Mask8(aMask + i);
+		__m128i* dest = reinterpret_cast<__m128i*>(aDest + i);
+		if (mask == 0)
+			continue;
+		if (mask == KMask8Opaque)
+			{
+			_mm_storeu_si128(dest, packed);
+			continue;
+			}
+		__m128i br, bg, bb;
+		Expand64KSse2(_mm_loadu_si128(dest), br, bg, bb);
+		const __m128i alpha = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(aMask + i)), _mm_setzero_si128());
+		_mm_storeu_si128(dest, Pack64KSse2(Blend16Sse2(sr, br, alpha), Blend16Sse2(sg, bg, alpha), Blend16Sse2(sb, bb, alpha)));
+		}
+	Color64KScalar(aDest + i, aColor, aMask + i, aLength - i);
+	}
+
+/** Cd * (255 - As) / 255 for the two pixels of aBack in the 16-bit lanes of aSrc. */
+LOCAL_C inline __m128i Fade16Sse2(__m128i aSrc, __m128i aBack)
+	{
+	const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(aSrc, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	__m128i x = _mm_mullo_epi16(aBack, _mm_sub_epi16(_mm_set1_epi16(255), alpha));
+	x = _mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8));
+	return _mm_srli_epi16(x, 8);
+	}
+
+LOCAL_C void Over32Sse2(TUint32* aDest, const TUint32* aSrc, TInt aLength, TUint32 aForceAlpha)
+	{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(TInt(KOpaque));
+	const __m128i force = _mm_set1_epi32(TInt(aForceAlpha));
+	TInt i = 0;
+	for (; i + 4 <= aLength; i += 4)
+		{
+		const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i));
+		__m128i* dest = reinterpret_cast<__m128i*>(aDest + i);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(src, zero)) == 0xffff)
+			{
+			if (aForceAlpha)
+				_mm_storeu_si128(dest, _mm_or_si128(_mm_loadu_si128(dest), force));
+			continue;
+			}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(src, opaque), opaque)) == 0xffff)
+			{
+			_mm_storeu_si128(dest, src);
+			continue;
+			}
+		const __m128i back = _mm_loadu_si128(dest);
+		const __m128i lo = Fade16Sse2(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(back, zero));
+		const __m128i hi = Fade16Sse2(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(back, zero));
+		_mm_storeu_si128(dest, _mm_or_si128(_mm_adds_epu8(src, _mm_packus_epi16(lo, hi)), force));
+		}
+	Over32Scalar(aDest + i, aSrc + i, aLength - i, aForceAlpha);
+	}
+
+LOCAL_D const TBlendFunctions KSse2Functions =
+	{
+	Line32Sse2,
+	Color32Sse2,
+	Line64KSse2,
+	Color64KSse2,
+	Over32Sse2
+	};
+
+#endif // __BITDRAW_SSE2__
+
+#ifdef __BITDRAW_AVX2__
+
+//
+// AVX2 kernels - 8 pixels per iteration for 32bpp. The 64K kernels gain little from the wider
+// registers once the channels are split, so the AVX2 table reuses the SSE2 ones.
+//
+
+#define __BITDRAW_TARGET_AVX2__ __attribute__((target("avx2")))
+
+__BITDRAW_TARGET_AVX2__ LOCAL_C inline __m256i Blend16Avx2(__m256i aSrc, __m256i aBack, __m256i aAlpha)
+	{
+	const __m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(255), aAlpha);
+	__m256i x = _mm256_add_epi16(_mm256_mullo_epi16(aSrc, aAlpha), _mm256_mullo_epi16(aBack, inv));
+	x = _mm256_add_epi16(_mm256_add_epi16(x, _mm256_set1_epi16(1)), _mm256_srli_epi16(x, 8));
+	return _mm256_srli_epi16(x, 8);
+	}
+
+__BITDRAW_TARGET_AVX2__ LOCAL_C inline __m256i Blend32Avx2(__m256i aSrc, __m256i aBack, const TUint8* aMask)
+	{
+	const __m256i zero = _mm256_setzero_si256();
+	// Widen the 8 mask bytes to one per 32-bit lane, then replicate each into all four channel bytes.
+	const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12,
+											0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12);
+	const __m256i alpha = _mm256_shuffle_epi8(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(aMask))), spread);
+	const __m256i lo = Blend16Avx2(_mm256_unpacklo_epi8(aSrc, zero), _mm256_unpacklo_epi8(aBack, zero), _mm256_unpacklo_epi8(alpha, zero));
+	const __m256i hi = Blend16Avx2(_mm256_unpackhi_epi8(aSrc, zero), _mm256_unpackhi_epi8(aBack, zero), _mm256_unpackhi_epi8(alpha, zero));
+	return _mm256_packus_epi16(lo, hi);
+	}
+
+__BITDRAW_TARGET_AVX2__ LOCAL_C void Line32Avx2(TUint32* aDest, const TUint32* aSrc, const TUint32* aBack, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha)
+	{
+	const __m256i opaque = _mm256_set1_epi32(TInt(KOpaque));
+	const __m256i force = _mm256_set1_epi32(TInt(aForceAlpha));
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const TUint64 mask = Mask8(aMask + i);
+		__m256i* dest = reinterpret_cast<__m256i*>(aDest + i);
+		const __m256i back = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aBack + i));
+		if (mask == 0)
+			{
+			if (aDest != aBack || aForceAlpha)
+				_mm256_storeu_si256(dest, _mm256_or_si256(back, force));
+			continue;
+			}
+		const __m256i src = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + i)), opaque);
+		if (mask == KMask8Opaque)
+			_mm256_storeu_si256(dest, src);
+		else
+			_mm256_storeu_si256(dest, _mm256_or_si256(Blend32Avx2(src, back, aMask + i), force));
+		}
+	Line32Sse2(aDest + i, aSrc + i, aBack + i, aMask + i, aLength - i, aForceAlpha);
+	}
+
+__BITDRAW_TARGET_AVX2__ LOCAL_C void Color32Avx2(TUint32* aDest, TUint32 aColor, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha)
+	{
+	const __m256i src = _mm256_set1_epi32(TInt(aColor | KOpaque));
+	const __m256i force = _mm256_set1_epi32(TInt(aForceAlpha));
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const TUint64 mask = Mask8(aMask + i);
+		__m256i* dest = reinterpret_cast<__m256i*>(aDest + i);
+		if (mask == 0)
+			{
+			if (aForceAlpha)
+				_mm256_storeu_si256(dest, _mm256_or_si256(_mm256_loadu_si256(dest), force));
+			}
+		else if (mask == KMask8Opaque)
+			_mm256_storeu_si256(dest, src);
+		else
+			_mm256_storeu_si256(dest, _mm256_or_si256(Blend32Avx2(src, _mm256_loadu_si256(dest), aMask + i), force));
+		}
+	Color32Sse2(aDest + i, aColor, aMask + i, aLength - i, aForceAlpha);
+	}
+
+__BITDRAW_TARGET_AVX2__ LOCAL_C inline __m256i Fade16Avx2(__m256i aSrc, __m256i aBack)
+	{
+	const __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(aSrc, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	__m256i x = _mm256_mullo_epi16(aBack, _mm256_sub_epi16(_mm256_set1_epi16(255), alpha));
+	x = _mm256_add_epi16(_mm256_add_epi16(x, _mm256_set1_epi16(1)), _mm256_srli_epi16(x, 8));
+	return _mm256_srli_epi16(x, 8);
+	}
+
+__BITDRAW_TARGET_AVX2__ LOCAL_C void Over32Avx2(TUint32* aDest, const TUint32* aSrc, TInt aLength, TUint32 aForceAlpha)
+	{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i opaque = _mm256_set1_epi32(TInt(KOpaque));
+	const __m256i force = _mm256_set1_epi32(TInt(aForceAlpha));
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + i));
+		__m256i* dest = reinterpret_cast<__m256i*>(aDest + i);
+		if (_mm256_testz_si256(src, src))
+			{
+			if (aForceAlpha)
+				_mm256_storeu_si256(dest, _mm256_or_si256(_mm256_loadu_si256(dest), force));
+			continue;
+			}
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(src, opaque), opaque)) == -1)
+			{
+			_mm256_storeu_si256(dest, src);
+			continue;
+			}
+		const __m256i back = _mm256_loadu_si256(dest);
+		const __m256i lo = Fade16Avx2(_mm256_unpacklo_epi8(src, zero), _mm256_unpacklo_epi8(back, zero));
+		const __m256i hi = Fade16Avx2(_mm256_unpackhi_epi8(src, zero), _mm256_unpackhi_epi8(back, zero));
+		_mm256_storeu_si256(dest, _mm256_or_si256(_mm256_adds_epu8(src, _mm256_packus_epi16(lo, hi)), force));
+		}
+	Over32Sse2(aDest + i, aSrc + i, aLength - i, aForceAlpha);
+	}
+
+LOCAL_D const TBlendFunctions KAvx2Functions =
+	{
+	Line32Avx2,
+	Color32Avx2,
+	Line64KSse2,
+	Color64KSse2,
+	Over32Avx2
+	};
+
+#endif // __BITDRAW_AVX2__
+
+#ifdef __BITDRAW_NEON__
+
+//
+// NEON kernels - 8 pixels per iteration, channels de-interleaved by vld4/vst4.
+//
+
+/** (aSrc * aAlpha + aBack * (255 - aAlpha)) / 255 on 8-bit lanes. */
+LOCAL_C inline uint8x8_t Blend8Neon(uint8x8_t aSrc, uint8x8_t aBack, uint8x8_t aAlpha, uint8x8_t aInv)
+	{
+	uint16x8_t x = vmull_u8(aSrc, aAlpha);
+	x = vmlal_u8(x, aBack, aInv);
+	x = vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8));
+	return vshrn_n_u16(x, 8);
+	}
+
+LOCAL_C inline uint8x8x4_t Blend32Neon(uint8x8x4_t aSrc, uint8x8x4_t aBack, uint8x8_t aAlpha, uint8x8_t aForce)
+	{
+	const uint8x8_t inv = vsub_u8(vdup_n_u8(255), aAlpha);
+	uint8x8x4_t res;
+	res.val[0] = Blend8Neon(aSrc.val[0], aBack.val[0], aAlpha, inv);
+	res.val[1] = Blend8Neon(aSrc.val[1], aBack.val[1], aAlpha, inv);
+	res.val[2] = Blend8Neon(aSrc.val[2], aBack.val[2], aAlpha, inv);
+	res.val[3] = vorr_u8(Blend8Neon(aSrc.val[3], aBack.val[3], aAlpha, inv), aForce);
+	return res;
+	}
+
+LOCAL_C void Line32Neon(TUint32* aDest, const TUint32* aSrc, const TUint32* aBack, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha)
+	{
+	const uint8x8_t force = vdup_n_u8(TUint8(aForceAlpha >> 24));
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const TUint64 mask = Mask8(aMask + i);
+		TUint8* dest = reinterpret_cast<TUint8*>(aDest + i);
+		uint8x8x4_t back = vld4_u8(reinterpret_cast<const TUint8*>(aBack + i));
+		if (mask == 0)
+			{
+			if (aDest != aBack || aForceAlpha)
+				{
+				back.val[3] = vorr_u8(back.val[3], force);
+				vst4_u8(dest, back);
+				}
+			continue;
+			}
+		uint8x8x4_t src = vld4_u8(reinterpret_cast<const TUint8*>(aSrc + i));
+		src.val[3] = vdup_n_u8(0xff);
+		if (mask == KMask8Opaque)
+			vst4_u8(dest, src);
+		else
+			vst4_u8(dest, Blend32Neon(src, back, vld1_u8(aMask + i), force));
+		}
+	Line32Scalar(aDest + i, aSrc + i, aBack + i, aMask + i, aLength - i, aForceAlpha);
+	}
+
+LOCAL_C void Color32Neon(TUint32* aDest, TUint32 aColor, const TUint8* aMask, TInt aLength, TUint32 aForceAlpha)
+	{
+	const uint8x8_t force = vdup_n_u8(TUint8(aForceAlpha >> 24));
+	uint8x8x4_t src;
+	src.val[0] = vdup_n_u8(TUint8(aColor));
+	src.val[1] = vdup_n_u8(TUint8(aColor >> 8));
+	src.val[2] = vdup_n_u8(TUint8(aColor >> 16));
+	src.val[3] = vdup_n_u8(0xff);
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const TUint64 mask = Mask8(aMask + i);
+		TUint8* dest = reinterpret_cast<TUint8*>(aDest + i);
+		if (mask == 0)
+			{
+			if (aForceAlpha)
+				{
+				uint8x8x4_t back = vld4_u8(dest);
+				back.val[3] = vorr_u8(back.val[3], force);
+				vst4_u8(dest, back);
+				}
+			}
+		else if (mask == KMask8Opaque)
+			vst4_u8(dest, src);
+		else
+			vst4_u8(dest, Blend32Neon(src, vld4_u8(dest), vld1_u8(aMask + i), force));
+		}
+	Color32Scalar(aDest + i, aColor, aMask + i, aLength - i, aForceAlpha);
+	}
+
+LOCAL_C inline uint16x8_t Pack64KNeon(uint8x8_t aRed, uint8x8_t aGreen, uint8x8_t aBlue)
+	{
+	const uint16x8_t r = vshlq_n_u16(vmovl_u8(vshr_n_u8(aRed, 3)), 11);
+	const uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(aGreen, 2)), 5);
+	const uint16x8_t b = vmovl_u8(vshr_n_u8(aBlue, 3));
+	return vorrq_u16(vorrq_u16(r, g), b);
+	}
+
+LOCAL_C inline void Expand64KNeon(uint16x8_t aPixels, uint8x8_t& aRed, uint8x8_t& aGreen, uint8x8_t& aBlue)
+	{
+	const uint16x8_t r = vshrq_n_u16(aPixels, 11);
+	const uint16x8_t g = vandq_u16(vshrq_n_u16(aPixels, 5), vdupq_n_u16(0x3f));
+	const uint16x8_t b = vandq_u16(aPixels, vdupq_n_u16(0x1f));
+	aRed = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2)));
+	aGreen = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4)));
+	aBlue = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2)));
+	}
+
+LOCAL_C void Line64KNeon(TUint16* aDest, const TUint32* aSrc, const TUint16* aBack, const TUint8* aMask, TInt aLength)
+	{
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const TUint64 mask = Mask8(aMask + i);
+		const uint16x8_t back = vld1q_u16(aBack + i);
+		if (mask == 0)
+			{
+			if (aDest != aBack)
+				vst1q_u16(aDest + i, back);
+			continue;
+			}
+		const uint8x8x4_t src = vld4_u8(reinterpret_cast<const TUint8*>(aSrc + i));
+		if (mask == KMask8Opaque)
+			{
+			vst1q_u16(aDest + i, Pack64KNeon(src.val[2], src.val[1], src.val[0]));
+			continue;
+			}
+		uint8x8_t br, bg, bb;
+		Expand64KNeon(back, br, bg, bb);
+		const uint8x8_t alpha = vld1_u8(aMask + i);
+		const uint8x8_t inv = vsub_u8(vdup_n_u8(255), alpha);
+		vst1q_u16(aDest + i, Pack64KNeon(Blend8Neon(src.val[2], br, alpha, inv),
+										 Blend8Neon(src.val[1], bg, alpha, inv),
+										 Blend8Neon(src.val[0], bb, alpha, inv)));
+		}
+	Line64KScalar(aDest + i, aSrc + i, aBack + i, aMask + i, aLength - i);
+	}
+
+LOCAL_C void Color64KNeon(TUint16* aDest, TUint32 aColor, const TUint8* aMask, TInt aLength)
+	{
+	const uint8x8_t sr = vdup_n_u8(TUint8(aColor >> 16));
+	const uint8x8_t sg = vdup_n_u8(TUint8(aColor >> 8));
+	const uint8x8_t sb = vdup_n_u8(TUint8(aColor));
+	const uint16x8_t packed = vdupq_n_u16(Pack64K(aColor));
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const TUint64 mask = Mask8(aMask + i);
+		if (mask == 0)
+			continue;
+		if (mask == KMask8Opaque)
+			{
+			vst1q_u16(aDest + i, packed);
+			continue;
+			}
+		uint8x8_t br, bg, bb;
+		Expand64KNeon(vld1q_u16(aDest + i), br, bg, bb);
+		const uint8x8_t alpha = vld1_u8(aMask + i);
+		const uint8x8_t inv = vsub_u8(vdup_n_u8(255), alpha);
+		vst1q_u16(aDest + i, Pack64KNeon(Blend8Neon(sr, br, alpha, inv),
+										 Blend8Neon(sg, bg, alpha, inv),
+										 Blend8Neon(sb, bb, alpha, inv)));
+		}
+	Color64KScalar(aDest + i, aColor, aMask + i, aLength - i);
+	}
+
+LOCAL_C void Over32Neon(TUint32* aDest, const TUint32* aSrc, TInt aLength, TUint32 aForceAlpha)
+	{
+	const uint8x8_t force = vdup_n_u8(TUint8(aForceAlpha >> 24));
+	TInt i = 0;
+	for (; i + 8 <= aLength; i += 8)
+		{
+		TUint8* dest = reinterpret_cast<TUint8*>(aDest + i);
+		const uint8x8x4_t src = vld4_u8(reinterpret_cast<const TUint8*>(aSrc + i));
+		const uint8x8_t any = vorr_u8(vorr_u8(src.val[0], src.val[1]), vorr_u8(src.val[2], src.val[3]));
+		if (vget_lane_u64(vreinterpret_u64_u8(any), 0) == 0)
+			{
+			if (aForceAlpha)
+				{
+				uint8x8x4_t back = vld4_u8(dest);
+				back.val[3] = vorr_u8(back.val[3], force);
+				vst4_u8(dest, back);
+				}
+			continue;
+			}
+		if (vget_lane_u64(vreinterpret_u64_u8(src.val[3]), 0) == KMask8Opaque)
+			{
+			vst4_u8(dest, src);
+			continue;
+			}
+		const uint8x8_t inv = vsub_u8(vdup_n_u8(255), src.val[3]);
+		uint8x8x4_t res = vld4_u8(dest);
+		for (TInt channel = 0; channel < 4; channel++)
+			{
+			uint16x8_t x = vmull_u8(res.val[channel], inv);
+			x = vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8));
+			res.val[channel] = vqadd_u8(src.val[channel], vshrn_n_u16(x, 8));
+			}
+		res.val[3] = vorr_u8(res.val[3], force);
+		vst4_u8(dest, res);
+		}
+	Over32Scalar(aDest + i, aSrc + i, aLength - i, aForceAlpha);
+	}
+
+LOCAL_D const TBlendFunctions KNeonFunctions =
+	{
+	Line32Neon,
+	Color32Neon,
+	Line64KNeon,
+	Color64KNeon,
+	Over32Neon
+	};
+
+#endif // __BITDRAW_NEON__
+
+/**
+Constructs the kernels with the best implementation available on the running CPU.
+*/
+TAlphaBlendSpan::TAlphaBlendSpan()
+	{
+#if defined(__BITDRAW_NEON__)
+	Select(EBlendImplNeon);
+#else
+	Select(IsImplementationAvailable(EBlendImplAvx2) ? EBlendImplAvx2 : EBlendImplSse2);
+#endif
+	}
+
+/**
+Constructs the kernels with the requested implementation. If it is not available
+on the running CPU the scalar kernels are used instead.
+@param aImplementation Requested instruction set
+*/
+TAlphaBlendSpan::TAlphaBlendSpan(TBlendImplementation aImplementation)
+	{
+	Select(aImplementation);
+	}
+
+void TAlphaBlendSpan::Select(TBlendImplementation aImplementation)
+	{
+	iFunctions = &KScalarFunctions;
+	iImplementation = EBlendImplScalar;
+	if (!IsImplementationAvailable(aImplementation))
+		return;
+	switch (aImplementation)
+		{
+#ifdef __BITDRAW_SSE2__
+	case EBlendImplSse2:
+		iFunctions = &KSse2Functions;
+		break;
+#endif
+#ifdef __BITDRAW_AVX2__
+	case EBlendImplAvx2:
+		iFunctions = &KAvx2Functions;
+		break;
+#endif
+#ifdef __BITDRAW_NEON__
+	case EBlendImplNeon:
+		iFunctions = &KNeonFunctions;
+		break;
+#endif
+	default:
+		return;
+		}
+	iImplementation = aImplementation;
+	}
+
+/**
+@param aImplementation Instruction set to check
+@return ETrue if the kernels were built for aImplementation and the running CPU supports it.
+*/
+TBool TAlphaBlendSpan::IsImplementationAvailable(TBlendImplementation aImplementation)
+	{
+	switch (aImplementation)
+		{
+	case EBlendImplScalar:
+		return ETrue;
+#ifdef __BITDRAW_SSE2__
+	case EBlendImplSse2:
+		return ETrue;
+#endif
+#ifdef __BITDRAW_AVX2__
+	case EBlendImplAvx2:
+		return __builtin_cpu_supports("avx2") ? ETrue : EFalse;
+#endif
+#ifdef __BITDRAW_NEON__
+	case EBlendImplNeon:
+		return ETrue;
+#endif
+	default:
+		return EFalse;
+		}
+	}
+
+/**
+@param aDestMode Display mode of the destination
+@return ETrue if BlendLine and BlendColor accept aDestMode.
+*/
+TBool TAlphaBlendSpan::IsDisplayModeSupported(TDisplayMode aDestMode)
+	{
+	return aDestMode == EColor16MU || aDestMode == EColor16MA || aDestMode == EColor16MAP || aDestMode == EColor64K;
+	}
+
+/**
+Blends a line of ERgb source pixels over a background, writing the result to aDest.
+This is the body of both WriteRgbAlphaLine overloads: pass the destination as aBackground
+for the three-buffer one and the aBuffer2 line for the four-buffer one. aDest and
+aBackground may be the same buffer, but must not otherwise overlap.
+@param aDestMode	Display mode of aDest and aBackground
+@param aDest		Destination pixels
+@param aRgbBuffer	Source pixels in ERgb format
+@param aBackground	Background pixels in aDestMode format
+@param aMaskBuffer	Alpha values in EGray256 format
+@param aLength		Number of pixels
+@panic EScreenDriverPanicInvalidDisplayMode If aDestMode is not supported
+*/
+void TAlphaBlendSpan::BlendLine(TDisplayMode aDestMode, TAny* aDest, const TUint8* aRgbBuffer,
+								const TAny* aBackground, const TUint8* aMaskBuffer, TInt aLength) const
+	{
+	const TUint32* src = reinterpret_cast<const TUint32*>(aRgbBuffer);
+	switch (aDestMode)
+		{
+	case EColor64K:
+		iFunctions->iLine64K(static_cast<TUint16*>(aDest), src, static_cast<const TUint16*>(aBackground), aMaskBuffer, aLength);
+		break;
+	case EColor16MU:
+		iFunctions->iLine32(static_cast<TUint32*>(aDest), src, static_cast<const TUint32*>(aBackground), aMaskBuffer, aLength, KOpaque);
+		break;
+	case EColor16MA:
+	case EColor16MAP:
+		iFunctions->iLine32(static_cast<TUint32*>(aDest), src, static_cast<const TUint32*>(aBackground), aMaskBuffer, aLength, 0);
+		break;
+	default:
+		Panic(EScreenDriverPanicInvalidDisplayMode);
+		}
+	}
+
+/**
+@param aDestMode Display mode of the destination
+@return ETrue if BlendPremultipliedLine accepts aDestMode.
+*/
+TBool TAlphaBlendSpan::IsPremultipliedModeSupported(TDisplayMode aDestMode)
+	{
+	return aDestMode == EColor16MU || aDestMode == EColor16MAP;
+	}
+
+/**
+Composes a line of premultiplied source pixels over aDest (src-over). Each channel becomes
+Cs + Cd * (255 - As) / 255, with the same rounding as the other kernels and no division by the
+source alpha. For EColor16MU the destination alpha is set to 0xFF. Runs of transparent and of
+opaque source pixels are skipped and copied rather than blended.
+@param aDestMode	Display mode of aDest
+@param aDest		Destination pixels
+@param aSrc			Source pixels in EColor16MAP format
+@param aLength		Number of pixels
+@panic EScreenDriverPanicInvalidDisplayMode If aDestMode is not supported
+*/
+void TAlphaBlendSpan::BlendPremultipliedLine(TDisplayMode aDestMode, TAny* aDest, const TUint32* aSrc, TInt aLength) const
+	{
+	switch (aDestMode)
+		{
+	case EColor16MU:
+		iFunctions->iOver32(static_cast<TUint32*>(aDest), aSrc, aLength, KOpaque);
+		break;
+	case EColor16MAP:
+		iFunctions->iOver32(static_cast<TUint32*>(aDest), aSrc, aLength, 0);
+		break;
+	default:
+		Panic(EScreenDriverPanicInvalidDisplayMode);
+		}
+	}
+
+/**
+Blends a solid colour into aDest using aMaskBuffer as the alpha channel.
+This is the body of WriteRgbAlphaMulti. The alpha component of aColor is ignored.
+@param aDestMode	Display mode of aDest
+@param aDest		Destination pixels
+@param aColor		Colour to blend
+@param aMaskBuffer	Alpha values in EGray256 format
+@param aLength		Number of pixels
+@panic EScreenDriverPanicInvalidDisplayMode If aDestMode is not supported
+*/
+void TAlphaBlendSpan::BlendColor(TDisplayMode aDestMode, TAny* aDest, TRgb aColor,
+								 const TUint8* aMaskBuffer, TInt aLength) const
+	{
+	const TUint32 color = aColor.Internal();
+	switch (aDestMode)
+		{
+	case EColor64K:
+		iFunctions->iColor64K(static_cast<TUint16*>(aDest), color, aMaskBuffer, aLength);
+		break;
+	case EColor16MU:
+		iFunctions->iColor32(static_cast<TUint32*>(aDest), color, aMaskBuffer, aLength, KOpaque);
+		break;
+	case EColor16MA:
+	case EColor16MAP:
+		iFunctions->iColor32(static_cast<TUint32*>(aDest), color, aMaskBuffer, aLength, 0);
+		break;
+	default:
+		Panic(EScreenDriverPanicInvalidDisplayMode);
+		}
+	}
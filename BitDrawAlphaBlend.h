@@ -0,0 +1,104 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWALPHABLEND_H__
+#define __BITDRAWALPHABLEND_H__
+
+#include <gdi.h>
+
+/**
+Instruction sets the alpha blending span kernels can be built for.
+@see TAlphaBlendSpan
+@internalComponent
+*/
+enum TBlendImplementation
+	{
+	/** Portable C++ kernels, always available.
+	*/
+	EBlendImplScalar,
+	/** SSE2 kernels (x86 and x86-64).
+	*/
+	EBlendImplSse2,
+	/** AVX2 kernels (x86-64), selected only if the CPU reports AVX2 support.
+	*/
+	EBlendImplAvx2,
+	/** NEON kernels (ARMv7 with NEON and AArch64).
+	*/
+	EBlendImplNeon
+	};
+
+/**
+Exact integer division by 255 for aValue in the range [0, 255 * 255].
+This is the rounding used by all alpha blending kernels, so that every implementation
+produces the same result as (C1 * A + C2 * (255 - A)) / 255.
+@internalComponent
+*/
+inline TUint32 Div255(TUint32 aValue)
+	{
+	return (aValue + 1 + (aValue >> 8)) >> 8;
+	}
+
+struct TBlendFunctions;
+
+/**
+Span kernels for the WriteRgbAlphaLine and WriteRgbAlphaMulti implementations of the
+EColor16MU, EColor16MA, EColor16MAP and EColor64K draw devices.
+
+All kernels apply (C1 * A + C2 * (255 - A)) / 255 per channel, where C1 is the source pixel,
+C2 the background pixel and A the mask value. The destination alpha channel is handled as follows:
+	- EColor16MU  - set to 0xFF;
+	- EColor16MA  - blended as if the source alpha was 0xFF;
+	- EColor16MAP - blended as if the source alpha was 0xFF, which is src-over for a premultiplied
+	                destination.
+Runs of mask values equal to 0 or 255 are copied rather than blended.
+BlendPremultipliedLine() composes EColor16MAP source pixels src-over into EColor16MU and
+EColor16MAP destinations, without a separate mask.
+The vectorized kernels are bit-exact with the scalar ones.
+
+A draw device normally owns one instance, constructed with the default constructor, which picks
+the best implementation the running CPU supports. Shadowing and fading are not applied by the
+kernels - the caller applies them afterwards if the shadow/fade flag is set.
+@internalComponent
+*/
+class TAlphaBlendSpan
+	{
+public:
+	TAlphaBlendSpan();
+	TAlphaBlendSpan(TBlendImplementation aImplementation);
+	static TBool IsDisplayModeSupported(TDisplayMode aDestMode);
+	static TBool IsPremultipliedModeSupported(TDisplayMode aDestMode);
+	static TBool IsImplementationAvailable(TBlendImplementation aImplementation);
+	inline TBlendImplementation Implementation() const;
+	void BlendLine(TDisplayMode aDestMode, TAny* aDest, const TUint8* aRgbBuffer,
+				   const TAny* aBackground, const TUint8* aMaskBuffer, TInt aLength) const;
+	void BlendColor(TDisplayMode aDestMode, TAny* aDest, TRgb aColor,
+					const TUint8* aMaskBuffer, TInt aLength) const;
+	void BlendPremultipliedLine(TDisplayMode aDestMode, TAny* aDest, const TUint32* aSrc, TInt aLength) const;
+private:
+	void Select(TBlendImplementation aImplementation);
+private:
+	const TBlendFunctions* iFunctions;
+	TBlendImplementation iImplementation;
+	};
+
+/**
+@return The instruction set used by this instance.
+*/
+inline TBlendImplementation TAlphaBlendSpan::Implementation() const
+	{
+	return iImplementation;
+	}
+
+#endif
@@ -0,0 +1,302 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawBatched.h"
+#include "BitDrawPixelFormat.h"
+#include "BitDrawRasterOp.h"
+
+/**
+Per-pixel loops of one display mode.
+*/
+template <TDisplayMode MODE>
+struct TPlotter
+	{
+	typedef TPixelFormat<MODE> TFormat;
+
+	static inline void Plot(const TDirectScanLineInfo& aInfo, const TPoint& aPhysical, const TRasterOp& aOp)
+		{
+		TUint8* row = aInfo.RowAddress(aPhysical.iY);
+		TFormat::Write(row, aPhysical.iX, aOp.Pixel(TFormat::Read(row, aPhysical.iX)));
+		}
+
+	/**
+	Writes the points within aClipRect, setting aOp again whenever the colour changes.
+	*/
+	static void WritePoints(const TDirectScanLineInfo& aInfo, const TPoint* aPoints, TInt aCount,
+							const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+							CGraphicsContext::TDrawMode aDrawMode, TRasterOp& aOp)
+		{
+		TRgb color = *aColors;
+		for (const TPoint* const end = aPoints + aCount; aPoints < end; aPoints++, aColors += aColorStep)
+			{
+			if (!aClipRect.Contains(*aPoints))
+				continue;
+			if (aColorStep && *aColors != color)
+				{
+				color = *aColors;
+				aOp.Set(MODE, aDrawMode, color);
+				}
+			Plot(aInfo, aInfo.LogicalToPhysical(*aPoints), aOp);
+			}
+		}
+
+	/**
+	Writes aLength pixels of a physical column, from aPhysical, down if aStep is 1 or up if
+	aStep is -1.
+	*/
+	static void WriteColumn(const TDirectScanLineInfo& aInfo, TPoint aPhysical, TInt aStep, TInt aLength, const TRasterOp& aOp)
+		{
+		for (; aLength > 0; aLength--, aPhysical.iY += aStep)
+			Plot(aInfo, aPhysical, aOp);
+		}
+
+	static void ReadPixels(const TDirectScanLineInfo& aInfo, const TPoint* aPoints, TInt aCount, TRgb* aColors)
+		{
+		for (const TPoint* const end = aPoints + aCount; aPoints < end; aPoints++)
+			{
+			const TPoint physical(aInfo.LogicalToPhysical(*aPoints));
+			*aColors++ = TFormat::ToRgb(TFormat::Read(aInfo.RowAddress(physical.iY), physical.iX));
+			}
+		}
+	};
+
+typedef void (*TWritePointsFunction)(const TDirectScanLineInfo& aInfo, const TPoint* aPoints, TInt aCount,
+									 const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+									 CGraphicsContext::TDrawMode aDrawMode, TRasterOp& aOp);
+typedef void (*TWriteColumnFunction)(const TDirectScanLineInfo& aInfo, TPoint aPhysical, TInt aStep, TInt aLength, const TRasterOp& aOp);
+typedef void (*TReadPixelsFunction)(const TDirectScanLineInfo& aInfo, const TPoint* aPoints, TInt aCount, TRgb* aColors);
+
+struct TPlotFunctions
+	{
+	TWritePointsFunction iWritePoints;
+	TWriteColumnFunction iWriteColumn;
+	TReadPixelsFunction iReadPixels;
+	};
+
+#define BITDRAW_PLOTTER(aMode) \
+	{TPlotter<aMode>::WritePoints, TPlotter<aMode>::WriteColumn, TPlotter<aMode>::ReadPixels}
+
+/**
+Loops of each display mode, in TDisplayMode order.
+*/
+LOCAL_D const TPlotFunctions KPlotFunctions[EColorLast] =
+	{
+	{NULL, NULL, NULL},
+	BITDRAW_PLOTTER(EGray2),
+	BITDRAW_PLOTTER(EGray4),
+	BITDRAW_PLOTTER(EGray16),
+	BITDRAW_PLOTTER(EGray256),
+	BITDRAW_PLOTTER(EColor16),
+	BITDRAW_PLOTTER(EColor256),
+	BITDRAW_PLOTTER(EColor64K),
+	BITDRAW_PLOTTER(EColor16M),
+	BITDRAW_PLOTTER(ERgb),
+	BITDRAW_PLOTTER(EColor4K),
+	BITDRAW_PLOTTER(EColor16MU),
+	BITDRAW_PLOTTER(EColor16MA),
+	BITDRAW_PLOTTER(EColor16MAP)
+	};
+
+#undef BITDRAW_PLOTTER
+
+/**
+@return EFalse if aDrawMode writes the pen and one of the colours is translucent.
+*/
+LOCAL_C TBool CanWrite(const TRgb* aColors, TInt aColorStep, TInt aCount, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!(aDrawMode & CGraphicsContext::EPenmode))
+		return ETrue;
+	const TInt count = aColorStep ? aCount : 1;
+	for (TInt index = 0; index < count; index++)
+		{
+		if (aColors[index].Alpha() != 0xff)
+			return EFalse;
+		}
+	return ETrue;
+	}
+
+/**
+@return ETrue if the direct functions can write with aDrawMode into a device with layout aInfo.
+*/
+TBool TBatchedPlot::IsSupported(const TDirectScanLineInfo& aInfo, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	return aInfo.iFactorX == 1 && aInfo.iFactorY == 1 && (aInfo.iStride & 3) == 0 &&
+		   aInfo.iDisplayMode > ENone && aInfo.iDisplayMode < EColorLast &&
+		   TRasterOp::IsSupported(aInfo.iDisplayMode, aDrawMode);
+	}
+
+/**
+Writes points into the memory described by aInfo. Implements MBatchedPlotting::WritePoints()
+for devices with no shadowing or fading set.
+@param aInfo		Memory layout of the device
+@param aPoints		Logical positions of the points
+@param aCount		Number of points
+@param aColors		Colour of the points if aColorStep is 0, of each point if it is 1
+@param aColorStep	0 or 1
+@param aClipRect	Logical clipping rectangle; must lie within the draw rectangle of the device
+@param aDrawMode	Draw mode
+@return KErrNone, or KErrNotSupported if IsSupported() returns EFalse or EDrawModePEN is given a
+		translucent colour; nothing is drawn then.
+*/
+TInt TBatchedPlot::WritePoints(const TDirectScanLineInfo& aInfo, const TPoint* aPoints, TInt aCount,
+							   const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+							   CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!IsSupported(aInfo, aDrawMode) || !CanWrite(aColors, aColorStep, aCount, aDrawMode))
+		return KErrNotSupported;
+	if (aCount <= 0)
+		return KErrNone;
+	TRasterOp op;
+	op.Set(aInfo.iDisplayMode, aDrawMode, *aColors);
+	KPlotFunctions[aInfo.iDisplayMode].iWritePoints(aInfo, aPoints, aCount, aColors, aColorStep, aClipRect, aDrawMode, op);
+	return KErrNone;
+	}
+
+/**
+Writes horizontal spans into the memory described by aInfo. Spans along physical rows are
+filled by TRasterOp::FillSpan(); in the rotated orientations they are physical columns.
+Implements MBatchedPlotting::WriteSpans() for devices with no shadowing or fading set.
+@param aInfo		Memory layout of the device
+@param aSpans		Logical spans
+@param aCount		Number of spans
+@param aColors		Colour of the spans if aColorStep is 0, of each span if it is 1
+@param aColorStep	0 or 1
+@param aClipRect	Logical clipping rectangle; must lie within the draw rectangle of the device
+@param aDrawMode	Draw mode
+@return KErrNone, or KErrNotSupported if IsSupported() returns EFalse or EDrawModePEN is given a
+		translucent colour; nothing is drawn then.
+*/
+TInt TBatchedPlot::WriteSpans(const TDirectScanLineInfo& aInfo, const TPlotSpan* aSpans, TInt aCount,
+							  const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+							  CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!IsSupported(aInfo, aDrawMode) || !CanWrite(aColors, aColorStep, aCount, aDrawMode))
+		return KErrNotSupported;
+	if (aCount <= 0)
+		return KErrNone;
+	const TWriteColumnFunction writeColumn = KPlotFunctions[aInfo.iDisplayMode].iWriteColumn;
+	const TBool rows = aInfo.iLogicalXStep.iY == 0;
+	const TInt step = rows ? aInfo.iLogicalXStep.iX : aInfo.iLogicalXStep.iY;
+	TRasterOp op;
+	TRgb color = *aColors;
+	op.Set(aInfo.iDisplayMode, aDrawMode, color);
+	for (const TPlotSpan* const end = aSpans + aCount; aSpans < end; aSpans++, aColors += aColorStep)
+		{
+		if (aSpans->iY < aClipRect.iTl.iY || aSpans->iY >= aClipRect.iBr.iY)
+			continue;
+		const TInt left = Max(aSpans->iX, aClipRect.iTl.iX);
+		const TInt right = Min(aSpans->iX + aSpans->iLength, aClipRect.iBr.iX);
+		if (left >= right)
+			continue;
+		if (aColorStep && *aColors != color)
+			{
+			color = *aColors;
+			op.Set(aInfo.iDisplayMode, aDrawMode, color);
+			}
+		const TInt length = right - left;
+		const TPoint physical(aInfo.LogicalToPhysical(TPoint(left, aSpans->iY)));
+		if (rows)
+			op.FillSpan(aInfo.RowAddress(physical.iY), step > 0 ? physical.iX : physical.iX - length + 1, length);
+		else
+			writeColumn(aInfo, physical, step, length, op);
+		}
+	return KErrNone;
+	}
+
+/**
+Reads the colours of points from the memory described by aInfo. Implements
+MBatchedPlotting::ReadPixels().
+@param aInfo	Memory layout of the device
+@param aPoints	Logical positions of the points; they must lie within the draw rectangle
+@param aCount	Number of points
+@param aColors	Receives the colour of each point
+@return KErrNone, or KErrNotSupported if the device is scaled; nothing is read then.
+*/
+TInt TBatchedPlot::ReadPixels(const TDirectScanLineInfo& aInfo, const TPoint* aPoints, TInt aCount, TRgb* aColors)
+	{
+	if (aInfo.iFactorX != 1 || aInfo.iFactorY != 1 || aInfo.iDisplayMode <= ENone || aInfo.iDisplayMode >= EColorLast)
+		return KErrNotSupported;
+	KPlotFunctions[aInfo.iDisplayMode].iReadPixels(aInfo, aPoints, aCount, aColors);
+	return KErrNone;
+	}
+
+/**
+Writes points through WriteRgb() of aDevice. Implements MBatchedPlotting::WritePoints() for any
+device, and is the fallback of devices whose layout or settings WritePoints() does not support.
+@param aDevice		Device to draw to
+@param aPoints		Logical positions of the points
+@param aCount		Number of points
+@param aColors		Colour of the points if aColorStep is 0, of each point if it is 1
+@param aColorStep	0 or 1
+@param aClipRect	Logical clipping rectangle
+@param aDrawMode	Draw mode
+*/
+void TBatchedPlot::WritePointsWithPrimitives(CFbsDrawDevice& aDevice, const TPoint* aPoints, TInt aCount,
+											 const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+											 CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TRect clipRect;
+	aDevice.GetDrawRect(clipRect);
+	clipRect.Intersection(aClipRect);
+	for (const TPoint* const end = aPoints + aCount; aPoints < end; aPoints++, aColors += aColorStep)
+		{
+		if (clipRect.Contains(*aPoints))
+			aDevice.WriteRgb(aPoints->iX, aPoints->iY, *aColors, aDrawMode);
+		}
+	}
+
+/**
+Writes horizontal spans through WriteRgbMulti() of aDevice. Implements MBatchedPlotting::WriteSpans()
+for any device, and is the fallback of devices whose layout or settings WriteSpans() does not
+support.
+@param aDevice		Device to draw to
+@param aSpans		Logical spans
+@param aCount		Number of spans
+@param aColors		Colour of the spans if aColorStep is 0, of each span if it is 1
+@param aColorStep	0 or 1
+@param aClipRect	Logical clipping rectangle
+@param aDrawMode	Draw mode
+*/
+void TBatchedPlot::WriteSpansWithPrimitives(CFbsDrawDevice& aDevice, const TPlotSpan* aSpans, TInt aCount,
+											const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+											CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TRect clipRect;
+	aDevice.GetDrawRect(clipRect);
+	clipRect.Intersection(aClipRect);
+	for (const TPlotSpan* const end = aSpans + aCount; aSpans < end; aSpans++, aColors += aColorStep)
+		{
+		if (aSpans->iY < clipRect.iTl.iY || aSpans->iY >= clipRect.iBr.iY)
+			continue;
+		const TInt left = Max(aSpans->iX, clipRect.iTl.iX);
+		const TInt right = Min(aSpans->iX + aSpans->iLength, clipRect.iBr.iX);
+		if (left < right)
+			aDevice.WriteRgbMulti(left, aSpans->iY, right - left, 1, *aColors, aDrawMode);
+		}
+	}
+
+/**
+Reads the colours of points through ReadPixel() of aDevice. Implements MBatchedPlotting::ReadPixels()
+for any device.
+@param aDevice	Device to read from
+@param aPoints	Logical positions of the points; they must lie within the draw rectangle
+@param aCount	Number of points
+@param aColors	Receives the colour of each point
+*/
+void TBatchedPlot::ReadPixelsWithPrimitives(const CFbsDrawDevice& aDevice, const TPoint* aPoints, TInt aCount, TRgb* aColors)
+	{
+	for (const TPoint* const end = aPoints + aCount; aPoints < end; aPoints++)
+		*aColors++ = aDevice.ReadPixel(aPoints->iX, aPoints->iY);
+	}
@@ -0,0 +1,134 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWBATCHED_H__
+#define __BITDRAWBATCHED_H__
+
+#include "BitDrawDirectAccess.h"
+
+/**
+One horizontal span of a batch: iLength pixels from [iX,iY] to the right.
+@see MBatchedPlotting
+@internalComponent
+*/
+class TPlotSpan
+	{
+public:
+	TInt iX;
+	TInt iY;
+	TInt iLength;
+	};
+
+/**
+Batched pixel plotting for draw devices, retrieved with
+CFbsDrawDevice::GetInterface(KBatchedPlottingInterfaceID, ...).
+
+Line, ellipse and polygon rasterizers produce pixels one at a time; passing them to the device in
+arrays replaces a virtual call, a bounds check and a logical to physical transform per pixel with
+one call per batch. Points and spans are clipped to aClipRect, so the caller need not check them.
+Pixels are written as WriteRgb() and WriteRgbMulti() write them with the same colour and draw
+mode, shadowing and fading included, and read as ReadPixel() reads them.
+Screen devices must be told about the changed area with UpdateRegion().
+@see TBatchedPlot
+@internalComponent
+*/
+class MBatchedPlotting
+	{
+public:
+	/**
+	Writes points in one colour.
+	@param aPoints		Logical positions of the points
+	@param aCount		Number of points
+	@param aClipRect	Logical rectangle outside which nothing is drawn
+	@param aColor		Colour of the points
+	@param aDrawMode	Draw mode
+	*/
+	virtual void WritePoints(const TPoint* aPoints, TInt aCount, const TRect& aClipRect,
+							 TRgb aColor, CGraphicsContext::TDrawMode aDrawMode) = 0;
+	/**
+	Writes points in a colour each.
+	@param aPoints		Logical positions of the points
+	@param aColors		Colour of each point
+	@param aCount		Number of points
+	@param aClipRect	Logical rectangle outside which nothing is drawn
+	@param aDrawMode	Draw mode
+	*/
+	virtual void WritePoints(const TPoint* aPoints, const TRgb* aColors, TInt aCount, const TRect& aClipRect,
+							 CGraphicsContext::TDrawMode aDrawMode) = 0;
+	/**
+	Writes horizontal spans in one colour.
+	@param aSpans		Logical spans
+	@param aCount		Number of spans
+	@param aClipRect	Logical rectangle outside which nothing is drawn
+	@param aColor		Colour of the spans
+	@param aDrawMode	Draw mode
+	*/
+	virtual void WriteSpans(const TPlotSpan* aSpans, TInt aCount, const TRect& aClipRect,
+							TRgb aColor, CGraphicsContext::TDrawMode aDrawMode) = 0;
+	/**
+	Writes horizontal spans in a colour each.
+	@param aSpans		Logical spans
+	@param aColors		Colour of each span
+	@param aCount		Number of spans
+	@param aClipRect	Logical rectangle outside which nothing is drawn
+	@param aDrawMode	Draw mode
+	*/
+	virtual void WriteSpans(const TPlotSpan* aSpans, const TRgb* aColors, TInt aCount, const TRect& aClipRect,
+							CGraphicsContext::TDrawMode aDrawMode) = 0;
+	/**
+	Reads the colours of points.
+	@param aPoints	Logical positions of the points; they must lie within the draw rectangle
+	@param aCount	Number of points
+	@param aColors	Receives the colour of each point
+	*/
+	virtual void ReadPixels(const TPoint* aPoints, TInt aCount, TRgb* aColors) const = 0;
+	};
+
+/**
+Implementations of MBatchedPlotting. The write functions take either a single colour, with
+aColorStep 0, or a colour per point or span, with aColorStep 1.
+
+The direct functions work on the memory layout of a device that is not scaled, in any
+orientation and display mode, with a loop specialized for the pixel format. The draw mode is
+applied by TRasterOp, whose pattern is set again only when the colour changes from one element to
+the next, and spans along physical rows are filled a word at a time. Shadowing and fading are not
+applied, so a device must only use them with ENoShadow. A translucent colour in EDrawModePEN is
+not supported, as it is blended rather than written.
+
+The WithPrimitives() functions go through WriteRgb(), WriteRgbMulti() and ReadPixel() of any
+device, after clipping each element once.
+@internalComponent
+*/
+class TBatchedPlot
+	{
+public:
+	static TBool IsSupported(const TDirectScanLineInfo& aInfo, CGraphicsContext::TDrawMode aDrawMode);
+	static TInt WritePoints(const TDirectScanLineInfo& aInfo, const TPoint* aPoints, TInt aCount,
+							const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+							CGraphicsContext::TDrawMode aDrawMode);
+	static TInt WriteSpans(const TDirectScanLineInfo& aInfo, const TPlotSpan* aSpans, TInt aCount,
+						   const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+						   CGraphicsContext::TDrawMode aDrawMode);
+	static TInt ReadPixels(const TDirectScanLineInfo& aInfo, const TPoint* aPoints, TInt aCount, TRgb* aColors);
+	static void WritePointsWithPrimitives(CFbsDrawDevice& aDevice, const TPoint* aPoints, TInt aCount,
+										  const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+										  CGraphicsContext::TDrawMode aDrawMode);
+	static void WriteSpansWithPrimitives(CFbsDrawDevice& aDevice, const TPlotSpan* aSpans, TInt aCount,
+										 const TRgb* aColors, TInt aColorStep, const TRect& aClipRect,
+										 CGraphicsContext::TDrawMode aDrawMode);
+	static void ReadPixelsWithPrimitives(const CFbsDrawDevice& aDevice, const TPoint* aPoints, TInt aCount, TRgb* aColors);
+	};
+
+#endif
@@ -0,0 +1,698 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include <e32atomics.h>
+#include "BitDrawBuffered.h"
+#include "BitDrawPixelFormat.h"
+#include "BitDrawInterfaceId.h"
+
+/**
+Creates a screen device for aScreenNo and a buffered device presenting to it.
+@param aScreenNo	Screen number
+@param aDispMode	Display mode of the screen and of the back buffers
+@param aBufferCount	Number of back buffers, 2 or 3
+@return The new device
+@leave KErrNoMemory Not enough memory, or any error returned by CFbsDrawDevice::NewScreenDeviceL(),
+CFbsDrawDevice::NewBitmapDeviceL() or RThread::Create()
+@panic EScreenDriverPanicInvalidParameter if aBufferCount is not in the range [2, KMaxScreenBuffers]
+*/
+CBufferedScreenDevice* CBufferedScreenDevice::NewScreenDeviceL(TInt aScreenNo, TDisplayMode aDispMode, TInt aBufferCount)
+	{
+	CFbsDrawDevice* screen = CFbsDrawDevice::NewScreenDeviceL(aScreenNo, aDispMode);
+	CleanupStack::PushL(screen);
+	CBufferedScreenDevice* self = NewL(screen, aBufferCount);
+	CleanupStack::Pop(screen);
+	return self;
+	}
+
+/**
+Creates a buffered device presenting to an existing screen device. The back buffers take the size
+and display mode of aScreen and are initialised with its content.
+@param aScreen		Device to present to. Ownership is transferred if the function does not leave.
+@param aBufferCount	Number of back buffers, 2 or 3
+@return The new device
+@leave KErrNoMemory Not enough memory, or any error returned by CFbsDrawDevice::NewBitmapDeviceL()
+or RThread::Create()
+@panic EScreenDriverPanicInvalidParameter if aBufferCount is not in the range [2, KMaxScreenBuffers]
+*/
+CBufferedScreenDevice* CBufferedScreenDevice::NewL(CFbsDrawDevice* aScreen, TInt aBufferCount)
+	{
+	__ASSERT_ALWAYS(aBufferCount >= 2 && aBufferCount <= KMaxScreenBuffers, Panic(EScreenDriverPanicInvalidParameter));
+	const TSize size(aScreen->SizeInPixels());
+	const TDisplayMode dispMode = aScreen->DisplayMode();
+	const TInt stride = ((size.iWidth * BitsInMemory(dispMode) + 31) >> 5) << 2;
+	CFbsDrawDevice* firstBuffer = CFbsDrawDevice::NewBitmapDeviceL(size, dispMode, stride);
+	CleanupStack::PushL(firstBuffer);
+	CBufferedScreenDevice* self = new(ELeave) CBufferedScreenDevice(firstBuffer, aScreen, aBufferCount, stride);
+	CleanupStack::Pop(firstBuffer);
+	TRAPD(err, self->ConstructL());
+	if (err != KErrNone)
+		{
+		// Ownership of aScreen stays with the caller.
+		self->iScreen = NULL;
+		delete self;
+		User::Leave(err);
+		}
+	return self;
+	}
+
+CBufferedScreenDevice::CBufferedScreenDevice(CFbsDrawDevice* aFirstBuffer, CFbsDrawDevice* aScreen, TInt aBufferCount, TInt aStride):
+	CForwardingDrawDevice(aFirstBuffer),
+	iScreen(aScreen),
+	iBufferCount(aBufferCount),
+	iStride(aStride),
+	iOrientation(EOrientationNormal),
+	iShadowMode(ENoShadow),
+	iUserDisplayMode(ENone),
+	iFactorX(1),
+	iFactorY(1),
+	iDivisorX(1),
+	iDivisorY(1)
+	{
+	iBuffers[0] = aFirstBuffer;
+	iBufferSize = aFirstBuffer->SizeInPixels();
+	iBitsPerPixel = BitsInMemory(aFirstBuffer->DisplayMode());
+	}
+
+void CBufferedScreenDevice::ConstructL()
+	{
+	const TSize size(iScreen->SizeInPixels());
+	const TDisplayMode dispMode = iScreen->DisplayMode();
+	for (TInt index = 0; index < iBufferCount; index++)
+		{
+		if (!iBuffers[index])
+			iBuffers[index] = CFbsDrawDevice::NewBitmapDeviceL(size, dispMode, iStride);
+		iBufferBits[index] = static_cast<TUint8*>(User::AllocZL(iStride * size.iHeight));
+		iBuffers[index]->SetBits(iBufferBits[index]);
+		}
+	// Room for one row or column of 32bpp pixels, whatever the orientation.
+	const TInt lineWords = Max(size.iWidth, size.iHeight);
+	iDrawLine = new(ELeave) TUint32[lineWords];
+	iPresentLine = new(ELeave) TUint32[lineWords];
+	User::LeaveIfError(iPresentSemaphore.CreateLocal(0));
+	User::LeaveIfError(iFreeSemaphore.CreateLocal(0));
+
+	// Start from what is on the screen, as drawing straight to it would.
+	const TDisplayMode lineMode = iBuffers[0]->ScanLineDisplayMode();
+	for (TInt y = 0; y < size.iHeight; y++)
+		{
+		iScreen->ReadLine(0, y, size.iWidth, iDrawLine, lineMode);
+		iBuffers[0]->WriteLine(0, y, size.iWidth, iDrawLine, CGraphicsContext::EDrawModePEN);
+		}
+	MarkAllStale();
+
+	User::LeaveIfError(iPresenter.Create(KNullDesC, PresenterThreadFunction, KDefaultStackSize, NULL, this));
+	iPresenterStarted = ETrue;
+	iPresenter.Resume();
+	}
+
+/**
+Presents the frames already submitted, then stops the presenter thread.
+Drawing done since the last Update() is not presented.
+*/
+CBufferedScreenDevice::~CBufferedScreenDevice()
+	{
+	if (iPresenterStarted)
+		{
+		iShutdown = ETrue;
+		iPresentSemaphore.Signal();
+		TRequestStatus status;
+		iPresenter.Logon(status);
+		User::WaitForRequest(status);
+		iPresenter.Close();
+		}
+	for (TInt index = 0; index < iBufferCount; index++)
+		{
+		delete iBuffers[index];
+		User::Free(iBufferBits[index]);
+		}
+	// The current buffer was deleted above.
+	iTarget = NULL;
+	delete iScreen;
+	delete [] iDrawLine;
+	delete [] iPresentLine;
+	iPresentSemaphore.Close();
+	iFreeSemaphore.Close();
+	}
+
+/**
+Blocks until every submitted frame has been presented.
+*/
+void CBufferedScreenDevice::WaitForPresent()
+	{
+	while (__e32_atomic_load_acq32(&iPresented) != iSubmitted)
+		iFreeSemaphore.Wait();
+	}
+
+/**
+Hands the current buffer to the presenter, if anything was drawn, and makes the next buffer the
+drawing target once it is free and up to date.
+*/
+void CBufferedScreenDevice::Submit()
+	{
+	if (iFrameDamage.IsEmpty())
+		return;
+	// The current buffer is never in the ring, so the ring has a free entry.
+	TFrame& frame = iFrames[iSubmitted % iBufferCount];
+	frame.iBuffer = iCurrent;
+	frame.iDamage.Clear();
+	const TRect* rect = iFrameDamage.RectangleList();
+	for (TInt count = iFrameDamage.Count(); count > 0; count--, rect++)
+		{
+		frame.iDamage.AddRect(*rect);
+		for (TInt index = 0; index < iBufferCount; index++)
+			{
+			if (index != iCurrent)
+				iStale[index].AddRect(*rect);
+			}
+		}
+	iFrameDamage.Clear();
+	__e32_atomic_store_rel32(&iSubmitted, iSubmitted + 1);
+	iPresentSemaphore.Signal();
+
+	// Buffers are used in turn, so the next one is free once at most iBufferCount - 1 frames,
+	// the one just submitted included, are waiting. Stale signals only cause another check.
+	const TInt next = (iCurrent + 1) % iBufferCount;
+	while (iSubmitted - __e32_atomic_load_acq32(&iPresented) >= TUint32(iBufferCount))
+		iFreeSemaphore.Wait();
+	ApplySettings(next);
+	CopyStale(next, iCurrent);
+	iCurrent = next;
+	iTarget = iBuffers[next];
+	}
+
+/**
+Brings a buffer up to date by copying its stale area from the newest buffer. Pixels around
+the stale area may be copied as well; they are the same in both buffers.
+The presenter may be reading aFrom at the same time; both threads only read it.
+@param aBuffer	Buffer to bring up to date
+@param aFrom	Buffer holding the newest frame
+*/
+void CBufferedScreenDevice::CopyStale(TInt aBuffer, TInt aFrom)
+	{
+	TDamageRegion& stale = iStale[aBuffer];
+	if (stale.IsEmpty())
+		return;
+	CFbsDrawDevice& dest = *iBuffers[aBuffer];
+	const CFbsDrawDevice& src = *iBuffers[aFrom];
+	const TRect bounds(src.SizeInPixels());
+	const TDisplayMode lineMode = src.ScanLineDisplayMode();
+	TDirectScanLineInfo layout;
+	GetBufferInfo(aFrom, layout);
+	if (iShadowMode != ENoShadow)
+		dest.SetShadowMode(ENoShadow);
+	const TRect* staleRect = stale.RectangleList();
+	for (TInt count = stale.Count(); count > 0; count--, staleRect++)
+		{
+		TRect rect(*staleRect);
+		rect.Intersection(bounds);
+		if (rect.IsEmpty())
+			continue;
+		if (iOrientation == EOrientationNormal)
+			{
+			// Logical rows cover whole rows of the buffer memory, scaled and offset by the origin.
+			const TPoint tl(layout.LogicalToPhysical(rect.iTl));
+			const TPoint br(layout.LogicalToPhysical(rect.iBr));
+			const TInt first = (tl.iX * iBitsPerPixel) >> 3;
+			const TInt bytes = ((br.iX * iBitsPerPixel + 7) >> 3) - first;
+			for (TInt y = tl.iY; y < br.iY; y++)
+				{
+				const TInt offset = y * iStride + first;
+				Mem::Copy(iBufferBits[aBuffer] + offset, iBufferBits[aFrom] + offset, bytes);
+				}
+			}
+		else
+			{
+			for (TInt y = rect.iTl.iY; y < rect.iBr.iY; y++)
+				{
+				src.ReadLine(rect.iTl.iX, y, rect.Width(), iDrawLine, lineMode);
+				dest.WriteLine(rect.iTl.iX, y, rect.Width(), iDrawLine, CGraphicsContext::EDrawModePEN);
+				}
+			}
+		}
+	if (iShadowMode != ENoShadow)
+		dest.SetShadowMode(iShadowMode);
+	stale.Clear();
+	}
+
+/**
+Marks every buffer but the current one as entirely stale, after a change that makes the
+stale areas recorded so far meaningless.
+*/
+void CBufferedScreenDevice::MarkAllStale()
+	{
+	const TRect all(iBuffers[iCurrent]->SizeInPixels());
+	for (TInt index = 0; index < iBufferCount; index++)
+		{
+		iStale[index].Clear();
+		if (index != iCurrent)
+			iStale[index].AddRect(all);
+		}
+	}
+
+/**
+Records that settings were changed on the current buffer, and are still to be set on the others.
+@param aSettings TBufferSetting flags of the settings changed
+*/
+void CBufferedScreenDevice::ChangeSettings(TUint aSettings)
+	{
+	for (TInt index = 0; index < iBufferCount; index++)
+		{
+		if (index != iCurrent)
+			iPendingSettings[index] |= aSettings;
+		}
+	}
+
+/**
+Sets the settings changed since a buffer was last the drawing target on it. The presenter is done
+with the buffer, so this cannot race with it.
+*/
+void CBufferedScreenDevice::ApplySettings(TInt aBuffer)
+	{
+	const TUint pending = iPendingSettings[aBuffer];
+	CFbsDrawDevice& buffer = *iBuffers[aBuffer];
+	if (pending & ESettingDitherOrigin)
+		buffer.SetDitherOrigin(iDitherOrigin);
+	if (pending & ESettingUserDisplayMode)
+		buffer.SetUserDisplayMode(iUserDisplayMode);
+	if (pending & ESettingShadowMode)
+		buffer.SetShadowMode(iShadowMode);
+	if (pending & ESettingFadingParameters)
+		buffer.SetFadingParameters(iFadeBlackMap, iFadeWhiteMap);
+	iPendingSettings[aBuffer] = 0;
+	}
+
+TInt CBufferedScreenDevice::PresenterThreadFunction(TAny* aPtr)
+	{
+	static_cast<CBufferedScreenDevice*>(aPtr)->PresenterLoop();
+	return KErrNone;
+	}
+
+/**
+Presents the frames in the order they were submitted. There is one signal per frame and
+one for the shutdown, so the frames are all presented before the thread exits.
+*/
+void CBufferedScreenDevice::PresenterLoop()
+	{
+	FOREVER
+		{
+		iPresentSemaphore.Wait();
+		const TUint32 presented = iPresented;
+		if (presented == __e32_atomic_load_acq32(&iSubmitted))
+			{
+			if (iShutdown)
+				return;
+			continue;
+			}
+		Present(iFrames[presented % iBufferCount]);
+		__e32_atomic_store_rel32(&iPresented, presented + 1);
+		iFreeSemaphore.Signal();
+		}
+	}
+
+/**
+Retrieves the memory layout of the screen if it is the layout of the buffers: the same display mode,
+orientation, scaling and origin, with pixels of whole bytes.
+@param aLayout	Layout of the buffers
+@param aInfo	Upon return contains the memory layout of the screen, if ETrue is returned
+@return ETrue if physical rows of the buffers can be copied to the same physical rows of the screen.
+*/
+TBool CBufferedScreenDevice::GetMatchingScreenInfo(const TDirectScanLineInfo& aLayout, TDirectScanLineInfo& aInfo) const
+	{
+	TAny* access = NULL;
+	if (iScreen->GetInterface(KDirectScanLineAccessInterfaceID, access) != KErrNone || !access ||
+		static_cast<MDirectScanLineAccess*>(access)->GetScanLineInfo(aInfo) != KErrNone)
+		{
+		return EFalse;
+		}
+	return aInfo.HasBytePixels() && aInfo.iDisplayMode == aLayout.iDisplayMode &&
+		   aInfo.iOrientation == aLayout.iOrientation && aInfo.iPhysicalOrigin == aLayout.iPhysicalOrigin &&
+		   aInfo.iFactorX == aLayout.iFactorX && aInfo.iFactorY == aLayout.iFactorY;
+	}
+
+/**
+Copies the damaged area of a frame to the screen and updates it. The screen has the scaling and
+origin of the buffers, so logical rows are the same on both. In the normal orientation, the physical
+rows covered are copied straight into the frame buffer of the screen when it supports direct access
+in the layout of the buffers; otherwise logical rows are copied with ReadLine()/WriteLine().
+*/
+void CBufferedScreenDevice::Present(const TFrame& aFrame)
+	{
+	const CFbsDrawDevice& buffer = *iBuffers[aFrame.iBuffer];
+	const TRect bounds(buffer.SizeInPixels());
+	TDirectScanLineInfo layout;
+	GetBufferInfo(aFrame.iBuffer, layout);
+	TDirectScanLineInfo info;
+	const TBool direct = iOrientation == EOrientationNormal && GetMatchingScreenInfo(layout, info);
+	const TDisplayMode lineMode = iScreen->ScanLineDisplayMode();
+	const TInt bytesPerPixel = iBitsPerPixel >> 3;
+	const TRect* damageRect = aFrame.iDamage.RectangleList();
+	for (TInt count = aFrame.iDamage.Count(); count > 0; count--, damageRect++)
+		{
+		TRect rect(*damageRect);
+		rect.Intersection(bounds);
+		if (rect.IsEmpty())
+			continue;
+		if (direct)
+			{
+			const TPoint tl(layout.LogicalToPhysical(rect.iTl));
+			const TPoint br(layout.LogicalToPhysical(rect.iBr));
+			const TInt offset = tl.iX * bytesPerPixel;
+			for (TInt y = tl.iY; y < br.iY; y++)
+				Mem::Copy(info.RowAddress(y) + offset, layout.RowAddress(y) + offset, (br.iX - tl.iX) * bytesPerPixel);
+			continue;
+			}
+		for (TInt y = rect.iTl.iY; y < rect.iBr.iY; y++)
+			{
+			buffer.ReadLine(rect.iTl.iX, y, rect.Width(), iPresentLine, lineMode);
+			iScreen->WriteLine(rect.iTl.iX, y, rect.Width(), iPresentLine, CGraphicsContext::EDrawModePEN);
+			}
+		}
+	TRegionFix<KMaxDamageRects> region;
+	aFrame.iDamage.GetRegion(region);
+	iScreen->Update(region);
+	}
+
+TBool CBufferedScreenDevice::SetOrientation(TOrientation aOrientation)
+	{
+	WaitForPresent();
+	if (!iScreen->SetOrientation(aOrientation))
+		return EFalse;
+	for (TInt index = 0; index < iBufferCount; index++)
+		{
+		if (!iBuffers[index]->SetOrientation(aOrientation))
+			{
+			// The buffers are all the same kind of device, so only the first one can fail.
+			iScreen->SetOrientation(iOrientation);
+			return EFalse;
+			}
+		}
+	iOrientation = aOrientation;
+	MarkAllStale();
+	return ETrue;
+	}
+
+TInt CBufferedScreenDevice::InitScreen()
+	{
+	WaitForPresent();
+	return iScreen->InitScreen();
+	}
+
+/**
+Sets or unsets auto-update. With auto-update on, every UpdateRegion() call is presented as a frame.
+@param aValue ETrue, if the screen is set to auto-update; EFalse, otherwise.
+*/
+void CBufferedScreenDevice::SetAutoUpdate(TBool aValue)
+	{
+	iAutoUpdate = aValue;
+	}
+
+/**
+Ignored: the device draws into back buffers it owns.
+*/
+void CBufferedScreenDevice::SetBits(TAny* /*aBits*/)
+	{
+	}
+
+TInt CBufferedScreenDevice::SetCustomPalette(const CPalette* aPalette)
+	{
+	WaitForPresent();
+	TInt err = iScreen->SetCustomPalette(aPalette);
+	for (TInt index = 0; index < iBufferCount && err == KErrNone; index++)
+		err = iBuffers[index]->SetCustomPalette(aPalette);
+	return err;
+	}
+
+void CBufferedScreenDevice::SetDisplayMode(CFbsDrawDevice* aDrawDevice)
+	{
+	WaitForPresent();
+	for (TInt index = 0; index < iBufferCount; index++)
+		{
+		iBuffers[index]->SetDisplayMode(aDrawDevice);
+		// Every buffer took the settings of aDrawDevice.
+		iPendingSettings[index] = 0;
+		}
+	TakeScaling();
+	MarkAllStale();
+	}
+
+void CBufferedScreenDevice::SetDitherOrigin(const TPoint& aPoint)
+	{
+	iDitherOrigin = aPoint;
+	iTarget->SetDitherOrigin(aPoint);
+	ChangeSettings(ESettingDitherOrigin);
+	}
+
+void CBufferedScreenDevice::SetUserDisplayMode(TDisplayMode aDisplayMode)
+	{
+	iUserDisplayMode = aDisplayMode;
+	iTarget->SetUserDisplayMode(aDisplayMode);
+	ChangeSettings(ESettingUserDisplayMode);
+	}
+
+void CBufferedScreenDevice::SetShadowMode(TShadowMode aShadowMode)
+	{
+	iShadowMode = aShadowMode;
+	iTarget->SetShadowMode(aShadowMode);
+	ChangeSettings(ESettingShadowMode);
+	}
+
+void CBufferedScreenDevice::SetFadingParameters(TUint8 aBlackMap,TUint8 aWhiteMap)
+	{
+	iFadeBlackMap = aBlackMap;
+	iFadeWhiteMap = aWhiteMap;
+	iTarget->SetFadingParameters(aBlackMap, aWhiteMap);
+	ChangeSettings(ESettingFadingParameters);
+	}
+
+/**
+Presents the area reported with UpdateRegion() since the last update.
+Returns as soon as the next back buffer is free.
+*/
+void CBufferedScreenDevice::Update()
+	{
+	Submit();
+	}
+
+/**
+Presents aRegion together with the area reported with UpdateRegion() since the last update.
+Returns as soon as the next back buffer is free.
+@param aRegion Region to update (logical coordinates)
+*/
+void CBufferedScreenDevice::Update(const TRegion& aRegion)
+	{
+	const TRect* rect = aRegion.RectangleList();
+	for (TInt count = aRegion.Count(); count > 0; count--, rect++)
+		iFrameDamage.AddRect(*rect);
+	Submit();
+	}
+
+/**
+Adds aRect to the area presented by the next update.
+@param aRect Rectangle to update (logical coordinates)
+*/
+void CBufferedScreenDevice::UpdateRegion(const TRect& aRect)
+	{
+	iFrameDamage.AddRect(aRect);
+	if (iAutoUpdate)
+		Submit();
+	}
+
+/**
+Describes the memory of a back buffer in the normal orientation.
+@param aBuffer	Index of the buffer
+@param aInfo	Upon return contains the memory layout of the buffer, with its scaling and origin
+*/
+void CBufferedScreenDevice::GetBufferInfo(TInt aBuffer, TDirectScanLineInfo& aInfo) const
+	{
+	aInfo.iBits = iBufferBits[aBuffer];
+	aInfo.iStride = iStride;
+	aInfo.iDisplayMode = iBuffers[aBuffer]->DisplayMode();
+	aInfo.iBitsPerPixel = iBitsPerPixel;
+	aInfo.iPhysicalSize = iBufferSize;
+	aInfo.iOrientation = EOrientationNormal;
+	aInfo.iPhysicalOrigin = iOrigin;
+	aInfo.iLogicalXStep.SetXY(1, 0);
+	aInfo.iLogicalYStep.SetXY(0, 1);
+	aInfo.iFactorX = iFactorX;
+	aInfo.iFactorY = iFactorY;
+	}
+
+/**
+Describes the memory of the current back buffer, which changes with every Update().
+*/
+TInt CBufferedScreenDevice::GetScanLineInfo(TDirectScanLineInfo& aInfo) const
+	{
+	if (iOrientation != EOrientationNormal)
+		return KErrNotSupported;
+	GetBufferInfo(iCurrent, aInfo);
+	return KErrNone;
+	}
+
+/**
+Sets the scaling factors of the screen and of every buffer, once the frames submitted so far
+have been presented.
+@return KErrNone, KErrNotSupported if the screen or the buffers do not support scaling, or the
+error returned by MScalingSettings::Set().
+*/
+TInt CBufferedScreenDevice::Set(TInt aFactorX, TInt aFactorY, TInt aDivisorX, TInt aDivisorY)
+	{
+	WaitForPresent();
+	TAny* interface = NULL;
+	TInt err = iScreen->GetInterface(KScalingSettingsInterfaceID, interface);
+	if (err == KErrNone)
+		err = static_cast<MScalingSettings*>(interface)->Set(aFactorX, aFactorY, aDivisorX, aDivisorY);
+	if (err != KErrNone)
+		return err;
+	for (TInt index = 0; index < iBufferCount; index++)
+		{
+		err = iBuffers[index]->GetInterface(KScalingSettingsInterfaceID, interface);
+		if (err == KErrNone)
+			err = static_cast<MScalingSettings*>(interface)->Set(aFactorX, aFactorY, aDivisorX, aDivisorY);
+		if (err != KErrNone)
+			{
+			// The buffers are all the same kind of device, so only the first one can fail.
+			iScreen->GetInterface(KScalingSettingsInterfaceID, interface);
+			static_cast<MScalingSettings*>(interface)->Set(iFactorX, iFactorY, iDivisorX, iDivisorY);
+			return err;
+			}
+		}
+	iFactorX = aFactorX;
+	iFactorY = aFactorY;
+	iDivisorX = aDivisorX;
+	iDivisorY = aDivisorY;
+	MarkAllStale();
+	return KErrNone;
+	}
+
+void CBufferedScreenDevice::Get(TInt& aFactorX, TInt& aFactorY, TInt& aDivisorX, TInt& aDivisorY)
+	{
+	aFactorX = iFactorX;
+	aFactorY = iFactorY;
+	aDivisorX = iDivisorX;
+	aDivisorY = iDivisorY;
+	}
+
+TBool CBufferedScreenDevice::IsScalingOff()
+	{
+	TAny* interface = NULL;
+	iTarget->GetInterface(KScalingSettingsInterfaceID, interface);
+	return static_cast<MScalingSettings*>(interface)->IsScalingOff();
+	}
+
+/**
+Sets the origin of the screen and of every buffer, once the frames submitted so far have been
+presented.
+@return KErrNone, KErrNotSupported if the screen or the buffers do not support an origin, or the
+error returned by MDrawDeviceOrigin::Set().
+*/
+TInt CBufferedScreenDevice::Set(const TPoint& aOrigin)
+	{
+	WaitForPresent();
+	TAny* interface = NULL;
+	TInt err = iScreen->GetInterface(KDrawDeviceOriginInterfaceID, interface);
+	if (err == KErrNone)
+		err = static_cast<MDrawDeviceOrigin*>(interface)->Set(aOrigin);
+	if (err != KErrNone)
+		return err;
+	for (TInt index = 0; index < iBufferCount; index++)
+		{
+		err = iBuffers[index]->GetInterface(KDrawDeviceOriginInterfaceID, interface);
+		if (err == KErrNone)
+			err = static_cast<MDrawDeviceOrigin*>(interface)->Set(aOrigin);
+		if (err != KErrNone)
+			{
+			// The buffers are all the same kind of device, so only the first one can fail.
+			iScreen->GetInterface(KDrawDeviceOriginInterfaceID, interface);
+			static_cast<MDrawDeviceOrigin*>(interface)->Set(iOrigin);
+			return err;
+			}
+		}
+	iOrigin = aOrigin;
+	MarkAllStale();
+	return KErrNone;
+	}
+
+void CBufferedScreenDevice::Get(TPoint& aOrigin)
+	{
+	aOrigin = iOrigin;
+	}
+
+/**
+Takes the scaling and origin the buffers were given by SetDisplayMode() or were reset to by
+SwapWidthAndHeight(), and sets them on the screen as well.
+*/
+void CBufferedScreenDevice::TakeScaling()
+	{
+	TAny* interface = NULL;
+	if (iBuffers[0]->GetInterface(KScalingSettingsInterfaceID, interface) == KErrNone)
+		static_cast<MScalingSettings*>(interface)->Get(iFactorX, iFactorY, iDivisorX, iDivisorY);
+	if (iScreen->GetInterface(KScalingSettingsInterfaceID, interface) == KErrNone)
+		static_cast<MScalingSettings*>(interface)->Set(iFactorX, iFactorY, iDivisorX, iDivisorY);
+	if (iBuffers[0]->GetInterface(KDrawDeviceOriginInterfaceID, interface) == KErrNone)
+		static_cast<MDrawDeviceOrigin*>(interface)->Get(iOrigin);
+	if (iScreen->GetInterface(KDrawDeviceOriginInterfaceID, interface) == KErrNone)
+		static_cast<MDrawDeviceOrigin*>(interface)->Set(iOrigin);
+	}
+
+/**
+The back buffer's own direct access is preferred, as it describes every orientation. Scaling and
+origin are offered by the device itself, when the back buffers and the screen support them, so
+that they are set on all of them.
+*/
+TInt CBufferedScreenDevice::GetInterface(TInt aInterfaceId, TAny*& aInterface)
+	{
+	if (aInterfaceId == KScalingSettingsInterfaceID || aInterfaceId == KDrawDeviceOriginInterfaceID)
+		{
+		TAny* interface = NULL;
+		TInt err = iTarget->GetInterface(aInterfaceId, interface);
+		if (err == KErrNone)
+			err = iScreen->GetInterface(aInterfaceId, interface);
+		if (err != KErrNone)
+			return err;
+		if (aInterfaceId == KScalingSettingsInterfaceID)
+			aInterface = static_cast<MScalingSettings*>(this);
+		else
+			aInterface = static_cast<MDrawDeviceOrigin*>(this);
+		return KErrNone;
+		}
+	const TInt err = iTarget->GetInterface(aInterfaceId, aInterface);
+	if (err != KErrNone && aInterfaceId == KDirectScanLineAccessInterfaceID)
+		{
+		aInterface = static_cast<MDirectScanLineAccess*>(this);
+		return KErrNone;
+		}
+	return err;
+	}
+
+/**
+The bitmap devices lay their memory out again with the new width and switch scaling off, so the
+stride, the physical size and the scaling of the buffers are taken from them afterwards.
+*/
+void CBufferedScreenDevice::SwapWidthAndHeight()
+	{
+	WaitForPresent();
+	const TSize size(iBuffers[0]->SizeInPixels());
+	iScreen->SwapWidthAndHeight();
+	for (TInt index = 0; index < iBufferCount; index++)
+		iBuffers[index]->SwapWidthAndHeight();
+	if (iBuffers[0]->SizeInPixels() != size)
+		{
+		iBufferSize.SetSize(iBufferSize.iHeight, iBufferSize.iWidth);
+		iStride = iBuffers[0]->ScanLineBytes();
+		}
+	TakeScaling();
+	MarkAllStale();
+	}
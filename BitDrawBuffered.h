@@ -0,0 +1,180 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWBUFFERED_H__
+#define __BITDRAWBUFFERED_H__
+
+#include <e32base.h>
+#include "BitDrawForwarding.h"
+#include "BitDrawDamage.h"
+#include "BitDrawDirectAccess.h"
+#include "BitDrawScaling.h"
+#include "BitDrawOrigin.h"
+
+/**
+Maximum number of back buffers of a CBufferedScreenDevice.
+@internalComponent
+*/
+const TInt KMaxScreenBuffers = 3;
+
+/**
+Screen device that draws into two or three back buffers in memory and presents them to a screen
+device on a dedicated presenter thread, so that drawing the next frame overlaps with pushing the
+previous one.
+
+The area reported with UpdateRegion() since the last update forms the damage of the current frame.
+Update() hands the back buffer and its damage to the presenter thread and returns with the next
+free buffer as the drawing target; it only blocks if every other buffer is still waiting to be
+presented. The presenter copies the damaged area to the screen device and calls
+Update(const TRegion&) on it. Before the next buffer is drawn to, the area drawn since it was last
+presented is copied to it from the newest buffer, so every buffer always holds the whole frame.
+
+Frames are passed to the presenter through a single-producer, single-consumer ring indexed by two
+counters updated with atomic operations; the semaphores only wake a waiting thread.
+
+Functions that change the layout of the device (orientation, display mode, InitScreen()) wait
+until every submitted frame has been presented. The dither origin, user display mode, shadow mode
+and fading parameters are set on the current buffer at once, and on each other buffer when it next
+becomes the drawing target, so they neither wait nor change a buffer the presenter is reading. Auto-update presents every UpdateRegion() call
+as a frame of its own. SetBits() is ignored: the back buffers are owned by the device.
+Interfaces returned by GetInterface() refer to the current back buffer and are only valid until
+the next Update(), except MScalingSettings and MDrawDeviceOrigin: the device offers them itself when
+both the back buffers and the screen device do, and sets the scaling and origin on the screen and on
+every buffer, so that presented logical rows land where drawing straight to the screen would put them.
+If the back buffers do not offer MDirectScanLineAccess themselves, the device describes the memory
+of the current back buffer while it is in the normal orientation.
+The screen device must be in its normal orientation when the buffered device is created.
+@internalComponent
+*/
+class CBufferedScreenDevice : public CForwardingDrawDevice, public MDirectScanLineAccess,
+							  public MScalingSettings, public MDrawDeviceOrigin
+	{
+public:
+	static CBufferedScreenDevice* NewScreenDeviceL(TInt aScreenNo, TDisplayMode aDispMode, TInt aBufferCount);
+	static CBufferedScreenDevice* NewL(CFbsDrawDevice* aScreen, TInt aBufferCount);
+	~CBufferedScreenDevice();
+	void WaitForPresent();
+	inline TInt BufferCount() const;
+public: // From MDirectScanLineAccess
+	TInt GetScanLineInfo(TDirectScanLineInfo& aInfo) const;
+public: // From MScalingSettings
+	TInt Set(TInt aFactorX, TInt aFactorY, TInt aDivisorX, TInt aDivisorY);
+	void Get(TInt& aFactorX, TInt& aFactorY, TInt& aDivisorX, TInt& aDivisorY);
+	TBool IsScalingOff();
+public: // From MDrawDeviceOrigin
+	TInt Set(const TPoint& aOrigin);
+	void Get(TPoint& aOrigin);
+public: // From CFbsDrawDevice
+	TBool SetOrientation(TOrientation aOrientation);
+	TInt InitScreen();
+	void SetAutoUpdate(TBool aValue);
+	void SetBits(TAny* aBits);
+	TInt SetCustomPalette(const CPalette* aPalette);
+	void SetDisplayMode(CFbsDrawDevice* aDrawDevice);
+	void SetDitherOrigin(const TPoint& aPoint);
+	void SetUserDisplayMode(TDisplayMode aDisplayMode);
+	void SetShadowMode(TShadowMode aShadowMode);
+	void SetFadingParameters(TUint8 aBlackMap,TUint8 aWhiteMap);
+	void Update();
+	void Update(const TRegion& aRegion);
+	void UpdateRegion(const TRect& aRect);
+	TInt GetInterface(TInt aInterfaceId, TAny*& aInterface);
+	void SwapWidthAndHeight();
+private:
+	/**
+	Frame waiting in the ring: the buffer to present and its damage.
+	*/
+	struct TFrame
+		{
+		TInt iBuffer;
+		TDamageRegionFix<KMaxDamageRects> iDamage;
+		};
+	/**
+	Settings that are set on the other buffers when they become the drawing target.
+	*/
+	enum TBufferSetting
+		{
+		ESettingDitherOrigin = 0x01,
+		ESettingUserDisplayMode = 0x02,
+		ESettingShadowMode = 0x04,
+		ESettingFadingParameters = 0x08
+		};
+private:
+	CBufferedScreenDevice(CFbsDrawDevice* aFirstBuffer, CFbsDrawDevice* aScreen, TInt aBufferCount, TInt aStride);
+	void ConstructL();
+	void Submit();
+	void CopyStale(TInt aBuffer, TInt aFrom);
+	void MarkAllStale();
+	void GetBufferInfo(TInt aBuffer, TDirectScanLineInfo& aInfo) const;
+	void TakeScaling();
+	void ChangeSettings(TUint aSettings);
+	void ApplySettings(TInt aBuffer);
+	static TInt PresenterThreadFunction(TAny* aPtr);
+	void PresenterLoop();
+	TBool GetMatchingScreenInfo(const TDirectScanLineInfo& aLayout, TDirectScanLineInfo& aInfo) const;
+	void Present(const TFrame& aFrame);
+private:
+	CFbsDrawDevice* iScreen;
+	TInt iBufferCount;
+	CFbsDrawDevice* iBuffers[KMaxScreenBuffers];
+	TUint8* iBufferBits[KMaxScreenBuffers];
+	/** Area of each buffer that differs from the newest frame. */
+	TDamageRegionFix<KMaxDamageRects> iStale[KMaxScreenBuffers];
+	TInt iStride;
+	/** Size of the back buffers in physical pixels. */
+	TSize iBufferSize;
+	/** Bits a pixel of the back buffers takes in memory. */
+	TInt iBitsPerPixel;
+	TInt iCurrent;
+	TDamageRegionFix<KMaxDamageRects> iFrameDamage;
+	TFrame iFrames[KMaxScreenBuffers];
+	/** Number of frames submitted; written by the drawing thread only. */
+	TUint32 iSubmitted;
+	/** Number of frames presented; written by the presenter thread only. */
+	TUint32 iPresented;
+	RSemaphore iPresentSemaphore;
+	RSemaphore iFreeSemaphore;
+	RThread iPresenter;
+	TBool iPresenterStarted;
+	volatile TBool iShutdown;
+	TUint32* iDrawLine;
+	TUint32* iPresentLine;
+	TBool iAutoUpdate;
+	TOrientation iOrientation;
+	TShadowMode iShadowMode;
+	TPoint iDitherOrigin;
+	TDisplayMode iUserDisplayMode;
+	TUint8 iFadeBlackMap;
+	TUint8 iFadeWhiteMap;
+	/** TBufferSetting flags of the settings each buffer has yet to take. */
+	TUint iPendingSettings[KMaxScreenBuffers];
+	/** Scaling settings of the screen and of every buffer. */
+	TInt iFactorX;
+	TInt iFactorY;
+	TInt iDivisorX;
+	TInt iDivisorY;
+	/** Origin of the screen and of every buffer. */
+	TPoint iOrigin;
+	};
+
+/**
+@return The number of back buffers.
+*/
+inline TInt CBufferedScreenDevice::BufferCount() const
+	{
+	return iBufferCount;
+	}
+
+#endif
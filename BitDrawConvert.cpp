@@ -0,0 +1,424 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawConvert.h"
+#include "BitDrawPixelFormat.h"
+#include "bitdraw.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define __BITDRAW_SSE2__
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define __BITDRAW_NEON__
+#include <arm_neon.h>
+#endif
+
+__ASSERT_COMPILE(EColor16MAP + 1 == EColorLast);
+
+const TUint32 KOpaque = 0xff000000;
+
+//
+// Copy between scan lines of the same display mode.
+//
+
+template <TInt BITS>
+LOCAL_C void CopySpan(const TAny* aSrc, TInt aSrcX, TAny* aDest, TInt aDestX, TInt aLength)
+	{
+	if (BITS >= 8)
+		{
+		const TInt bytesPerPixel = BITS / 8;
+		Mem::Copy(static_cast<TUint8*>(aDest) + aDestX * bytesPerPixel,
+				  static_cast<const TUint8*>(aSrc) + aSrcX * bytesPerPixel, aLength * bytesPerPixel);
+		return;
+		}
+	const TInt pixelsPerByte = BITS < 8 ? 8 / BITS : 1;
+	TInt x = 0;
+	if (aSrcX % pixelsPerByte == 0 && aDestX % pixelsPerByte == 0)
+		{
+		const TInt bytes = aLength / pixelsPerByte;
+		Mem::Copy(static_cast<TUint8*>(aDest) + aDestX / pixelsPerByte,
+				  static_cast<const TUint8*>(aSrc) + aSrcX / pixelsPerByte, bytes);
+		x = bytes * pixelsPerByte;
+		}
+	for (; x < aLength; x++)
+		TPixelAccess<BITS>::Write(aDest, aDestX + x, TPixelAccess<BITS>::Read(aSrc, aSrcX + x));
+	}
+
+//
+// Bit manipulation converters between EColor64K, EColor16M and the 32bpp modes. Each one
+// reproduces the TRgb conversion of the pairs it is used for.
+//
+
+/** EColor64K to EColor16MU, EColor16MA, EColor16MAP or ERgb. */
+LOCAL_C void SixtyFourKToThirtyTwo(const TAny* aSrc, TAny* aDest, TInt aLength)
+	{
+	const TUint16* src = static_cast<const TUint16*>(aSrc);
+	TUint32* dest = static_cast<TUint32*>(aDest);
+	TInt i = 0;
+#if defined(__BITDRAW_SSE2__)
+	const __m128i mask6 = _mm_set1_epi16(0x3f);
+	const __m128i mask5 = _mm_set1_epi16(0x1f);
+	const __m128i alpha = _mm_set1_epi16(TInt16(0xff00));
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		const __m128i r = _mm_srli_epi16(pixels, 11);
+		const __m128i g = _mm_and_si128(_mm_srli_epi16(pixels, 5), mask6);
+		const __m128i b = _mm_and_si128(pixels, mask5);
+		const __m128i r8 = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+		const __m128i g8 = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+		const __m128i b8 = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+		const __m128i gb = _mm_or_si128(b8, _mm_slli_epi16(g8, 8));
+		const __m128i ar = _mm_or_si128(r8, alpha);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_unpacklo_epi16(gb, ar));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 4), _mm_unpackhi_epi16(gb, ar));
+		}
+#elif defined(__BITDRAW_NEON__)
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const uint16x8_t pixels = vld1q_u16(src + i);
+		const uint8x8_t r = vand_u8(vshrn_n_u16(pixels, 8), vdup_n_u8(0xf8));
+		const uint8x8_t g = vand_u8(vshrn_n_u16(pixels, 3), vdup_n_u8(0xfc));
+		const uint8x8_t b = vshl_n_u8(vmovn_u16(pixels), 3);
+		uint8x8x4_t out;
+		out.val[0] = vorr_u8(b, vshr_n_u8(b, 5));
+		out.val[1] = vorr_u8(g, vshr_n_u8(g, 6));
+		out.val[2] = vorr_u8(r, vshr_n_u8(r, 5));
+		out.val[3] = vdup_n_u8(0xff);
+		vst4_u8(reinterpret_cast<TUint8*>(dest + i), out);
+		}
+#endif
+	for (; i < aLength; i++)
+		{
+		const TUint32 pixel = src[i];
+		const TUint32 r = pixel >> 11;
+		const TUint32 g = (pixel >> 5) & 0x3f;
+		const TUint32 b = pixel & 0x1f;
+		dest[i] = KOpaque | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+		}
+	}
+
+/** EColor16MU, EColor16MA or ERgb to EColor64K. */
+LOCAL_C void ThirtyTwoToSixtyFourK(const TAny* aSrc, TAny* aDest, TInt aLength)
+	{
+	const TUint32* src = static_cast<const TUint32*>(aSrc);
+	TUint16* dest = static_cast<TUint16*>(aDest);
+	TInt i = 0;
+#if defined(__BITDRAW_SSE2__)
+	const __m128i maskR = _mm_set1_epi32(0xf800);
+	const __m128i maskG = _mm_set1_epi32(0x07e0);
+	const __m128i maskB = _mm_set1_epi32(0x001f);
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16(TInt16(0x8000));
+	for (; i + 8 <= aLength; i += 8)
+		{
+		__m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+		lo = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(lo, 8), maskR),
+									   _mm_and_si128(_mm_srli_epi32(lo, 5), maskG)),
+						  _mm_and_si128(_mm_srli_epi32(lo, 3), maskB));
+		hi = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(hi, 8), maskR),
+									   _mm_and_si128(_mm_srli_epi32(hi, 5), maskG)),
+						  _mm_and_si128(_mm_srli_epi32(hi, 3), maskB));
+		// SSE2 only packs with signed saturation, so bias the values into the signed range.
+		const __m128i packed = _mm_packs_epi32(_mm_sub_epi32(lo, bias32), _mm_sub_epi32(hi, bias32));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_add_epi16(packed, bias16));
+		}
+#elif defined(__BITDRAW_NEON__)
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const uint8x8x4_t pixels = vld4_u8(reinterpret_cast<const TUint8*>(src + i));
+		const uint16x8_t r = vshll_n_u8(vand_u8(pixels.val[2], vdup_n_u8(0xf8)), 8);
+		const uint16x8_t g = vshll_n_u8(vand_u8(pixels.val[1], vdup_n_u8(0xfc)), 3);
+		const uint16x8_t b = vmovl_u8(vshr_n_u8(pixels.val[0], 3));
+		vst1q_u16(dest + i, vorrq_u16(vorrq_u16(r, g), b));
+		}
+#endif
+	for (; i < aLength; i++)
+		{
+		const TUint32 pixel = src[i];
+		dest[i] = TUint16(((pixel >> 8) & 0xf800) | ((pixel >> 5) & 0x07e0) | ((pixel >> 3) & 0x001f));
+		}
+	}
+
+/** EColor16M to EColor16MU, EColor16MA, EColor16MAP or ERgb. */
+LOCAL_C void TwentyFourToThirtyTwo(const TAny* aSrc, TAny* aDest, TInt aLength)
+	{
+	const TUint8* src = static_cast<const TUint8*>(aSrc);
+	TUint32* dest = static_cast<TUint32*>(aDest);
+	TInt i = 0;
+#if defined(__BITDRAW_NEON__)
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const uint8x8x3_t pixels = vld3_u8(src + i * 3);
+		uint8x8x4_t out;
+		out.val[0] = pixels.val[0];
+		out.val[1] = pixels.val[1];
+		out.val[2] = pixels.val[2];
+		out.val[3] = vdup_n_u8(0xff);
+		vst4_u8(reinterpret_cast<TUint8*>(dest + i), out);
+		}
+#endif
+	for (; i < aLength; i++)
+		{
+		const TUint8* pixel = src + i * 3;
+		dest[i] = KOpaque | (pixel[2] << 16) | (pixel[1] << 8) | pixel[0];
+		}
+	}
+
+/** EColor16MU, EColor16MA or ERgb to EColor16M. */
+LOCAL_C void ThirtyTwoToTwentyFour(const TAny* aSrc, TAny* aDest, TInt aLength)
+	{
+	const TUint32* src = static_cast<const TUint32*>(aSrc);
+	TUint8* dest = static_cast<TUint8*>(aDest);
+	TInt i = 0;
+#if defined(__BITDRAW_NEON__)
+	for (; i + 8 <= aLength; i += 8)
+		{
+		const uint8x8x4_t pixels = vld4_u8(reinterpret_cast<const TUint8*>(src + i));
+		uint8x8x3_t out;
+		out.val[0] = pixels.val[0];
+		out.val[1] = pixels.val[1];
+		out.val[2] = pixels.val[2];
+		vst3_u8(dest + i * 3, out);
+		}
+#endif
+	for (; i < aLength; i++)
+		{
+		const TUint32 pixel = src[i];
+		TUint8* out = dest + i * 3;
+		out[0] = TUint8(pixel);
+		out[1] = TUint8(pixel >> 8);
+		out[2] = TUint8(pixel >> 16);
+		}
+	}
+
+/** EColor64K to EColor16M. */
+LOCAL_C void SixtyFourKToTwentyFour(const TAny* aSrc, TAny* aDest, TInt aLength)
+	{
+	const TUint16* src = static_cast<const TUint16*>(aSrc);
+	TUint8* dest = static_cast<TUint8*>(aDest);
+	for (TInt i = 0; i < aLength; i++)
+		{
+		const TUint32 pixel = src[i];
+		const TUint32 r = pixel >> 11;
+		const TUint32 g = (pixel >> 5) & 0x3f;
+		const TUint32 b = pixel & 0x1f;
+		TUint8* out = dest + i * 3;
+		out[0] = TUint8((b << 3) | (b >> 2));
+		out[1] = TUint8((g << 2) | (g >> 4));
+		out[2] = TUint8((r << 3) | (r >> 2));
+		}
+	}
+
+/** EColor16M to EColor64K. */
+LOCAL_C void TwentyFourToSixtyFourK(const TAny* aSrc, TAny* aDest, TInt aLength)
+	{
+	const TUint8* src = static_cast<const TUint8*>(aSrc);
+	TUint16* dest = static_cast<TUint16*>(aDest);
+	for (TInt i = 0; i < aLength; i++)
+		{
+		const TUint8* pixel = src + i * 3;
+		dest[i] = TUint16(((pixel[2] & 0xf8) << 8) | ((pixel[1] & 0xfc) << 3) | (pixel[0] >> 3));
+		}
+	}
+
+/** Between EColor16MU, EColor16MA and ERgb where the result is opaque. */
+LOCAL_C void ThirtyTwoOpaque(const TAny* aSrc, TAny* aDest, TInt aLength)
+	{
+	const TUint32* src = static_cast<const TUint32*>(aSrc);
+	TUint32* dest = static_cast<TUint32*>(aDest);
+	for (TInt i = 0; i < aLength; i++)
+		dest[i] = src[i] | KOpaque;
+	}
+
+/** Between EColor16MA and ERgb, which hold the same value. */
+LOCAL_C void ThirtyTwoCopy(const TAny* aSrc, TAny* aDest, TInt aLength)
+	{
+	Mem::Copy(aDest, aSrc, aLength * 4);
+	}
+
+//
+// Converters for each pair of display modes.
+//
+
+template <TDisplayMode SRC, TDisplayMode DEST>
+struct TSpanConverter
+	{
+	static void Convert(const TAny* aSrc, TInt aSrcX, TAny* aDest, TInt aDestX, TInt aLength);
+	};
+
+/**
+Generic converter. A source of up to 8bpp is converted through a table of every possible pixel
+value when the span is at least as long as the table; otherwise each run of identical pixels is
+converted once through TRgb.
+*/
+template <TDisplayMode SRC, TDisplayMode DEST>
+void TSpanConverter<SRC, DEST>::Convert(const TAny* aSrc, TInt aSrcX, TAny* aDest, TInt aDestX, TInt aLength)
+	{
+	typedef TPixelFormat<SRC> TSrc;
+	typedef TPixelFormat<DEST> TDest;
+	if (aLength <= 0)
+		return;
+	if (SRC == DEST)
+		{
+		CopySpan<TSrc::EBitsPerPixel>(aSrc, aSrcX, aDest, aDestX, aLength);
+		return;
+		}
+	const TInt srcValues = TSrc::EBitsPerPixel <= 8 ? 1 << (TSrc::EBitsPerPixel & 15) : 0;
+	if (aLength >= srcValues && srcValues > 0)
+		{
+		TUint32 table[256];
+		for (TInt value = 0; value < srcValues; value++)
+			table[value] = TDest::FromRgb(TSrc::ToRgb(value));
+		for (TInt x = 0; x < aLength; x++)
+			TDest::Write(aDest, aDestX + x, table[TSrc::Read(aSrc, aSrcX + x)]);
+		return;
+		}
+	TUint32 lastIn = TSrc::Read(aSrc, aSrcX);
+	TUint32 lastOut = TDest::FromRgb(TSrc::ToRgb(lastIn));
+	for (TInt x = 0; x < aLength; x++)
+		{
+		const TUint32 pixel = TSrc::Read(aSrc, aSrcX + x);
+		if (pixel != lastIn)
+			{
+			lastIn = pixel;
+			lastOut = TDest::FromRgb(TSrc::ToRgb(pixel));
+			}
+		TDest::Write(aDest, aDestX + x, lastOut);
+		}
+	}
+
+#define BITDRAW_SPAN_CONVERTER(aSrcMode, aDestMode, aFunction) \
+template <> \
+void TSpanConverter<aSrcMode, aDestMode>::Convert(const TAny* aSrc, TInt aSrcX, TAny* aDest, TInt aDestX, TInt aLength) \
+	{ \
+	aFunction(static_cast<const TUint8*>(aSrc) + aSrcX * (TPixelFormat<aSrcMode>::EBitsPerPixel / 8), \
+			  static_cast<TUint8*>(aDest) + aDestX * (TPixelFormat<aDestMode>::EBitsPerPixel / 8), aLength); \
+	}
+
+BITDRAW_SPAN_CONVERTER(EColor64K, EColor16M, SixtyFourKToTwentyFour)
+BITDRAW_SPAN_CONVERTER(EColor64K, ERgb, SixtyFourKToThirtyTwo)
+BITDRAW_SPAN_CONVERTER(EColor64K, EColor16MU, SixtyFourKToThirtyTwo)
+BITDRAW_SPAN_CONVERTER(EColor64K, EColor16MA, SixtyFourKToThirtyTwo)
+BITDRAW_SPAN_CONVERTER(EColor64K, EColor16MAP, SixtyFourKToThirtyTwo)
+BITDRAW_SPAN_CONVERTER(EColor16M, EColor64K, TwentyFourToSixtyFourK)
+BITDRAW_SPAN_CONVERTER(EColor16M, ERgb, TwentyFourToThirtyTwo)
+BITDRAW_SPAN_CONVERTER(EColor16M, EColor16MU, TwentyFourToThirtyTwo)
+BITDRAW_SPAN_CONVERTER(EColor16M, EColor16MA, TwentyFourToThirtyTwo)
+BITDRAW_SPAN_CONVERTER(EColor16M, EColor16MAP, TwentyFourToThirtyTwo)
+BITDRAW_SPAN_CONVERTER(ERgb, EColor64K, ThirtyTwoToSixtyFourK)
+BITDRAW_SPAN_CONVERTER(ERgb, EColor16M, ThirtyTwoToTwentyFour)
+BITDRAW_SPAN_CONVERTER(ERgb, EColor16MU, ThirtyTwoOpaque)
+BITDRAW_SPAN_CONVERTER(ERgb, EColor16MA, ThirtyTwoCopy)
+BITDRAW_SPAN_CONVERTER(EColor16MU, EColor64K, ThirtyTwoToSixtyFourK)
+BITDRAW_SPAN_CONVERTER(EColor16MU, EColor16M, ThirtyTwoToTwentyFour)
+BITDRAW_SPAN_CONVERTER(EColor16MU, ERgb, ThirtyTwoOpaque)
+BITDRAW_SPAN_CONVERTER(EColor16MU, EColor16MA, ThirtyTwoOpaque)
+BITDRAW_SPAN_CONVERTER(EColor16MU, EColor16MAP, ThirtyTwoOpaque)
+BITDRAW_SPAN_CONVERTER(EColor16MA, EColor64K, ThirtyTwoToSixtyFourK)
+BITDRAW_SPAN_CONVERTER(EColor16MA, EColor16M, ThirtyTwoToTwentyFour)
+BITDRAW_SPAN_CONVERTER(EColor16MA, ERgb, ThirtyTwoCopy)
+BITDRAW_SPAN_CONVERTER(EColor16MA, EColor16MU, ThirtyTwoOpaque)
+
+#undef BITDRAW_SPAN_CONVERTER
+
+#define BITDRAW_CONVERT_ROW(aSrcMode) \
+	{ \
+	NULL, \
+	TSpanConverter<aSrcMode, EGray2>::Convert, \
+	TSpanConverter<aSrcMode, EGray4>::Convert, \
+	TSpanConverter<aSrcMode, EGray16>::Convert, \
+	TSpanConverter<aSrcMode, EGray256>::Convert, \
+	TSpanConverter<aSrcMode, EColor16>::Convert, \
+	TSpanConverter<aSrcMode, EColor256>::Convert, \
+	TSpanConverter<aSrcMode, EColor64K>::Convert, \
+	TSpanConverter<aSrcMode, EColor16M>::Convert, \
+	TSpanConverter<aSrcMode, ERgb>::Convert, \
+	TSpanConverter<aSrcMode, EColor4K>::Convert, \
+	TSpanConverter<aSrcMode, EColor16MU>::Convert, \
+	TSpanConverter<aSrcMode, EColor16MA>::Convert, \
+	TSpanConverter<aSrcMode, EColor16MAP>::Convert \
+	}
+
+/**
+Converter for each source (first index) and destination (second index) display mode,
+in TDisplayMode order.
+*/
+LOCAL_D const TConvertSpanFunction KConvertFunctions[EColorLast][EColorLast] =
+	{
+	{NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL},
+	BITDRAW_CONVERT_ROW(EGray2),
+	BITDRAW_CONVERT_ROW(EGray4),
+	BITDRAW_CONVERT_ROW(EGray16),
+	BITDRAW_CONVERT_ROW(EGray256),
+	BITDRAW_CONVERT_ROW(EColor16),
+	BITDRAW_CONVERT_ROW(EColor256),
+	BITDRAW_CONVERT_ROW(EColor64K),
+	BITDRAW_CONVERT_ROW(EColor16M),
+	BITDRAW_CONVERT_ROW(ERgb),
+	BITDRAW_CONVERT_ROW(EColor4K),
+	BITDRAW_CONVERT_ROW(EColor16MU),
+	BITDRAW_CONVERT_ROW(EColor16MA),
+	BITDRAW_CONVERT_ROW(EColor16MAP)
+	};
+
+#undef BITDRAW_CONVERT_ROW
+
+/**
+@param aDispMode Display mode to check
+@return ETrue if aDispMode can be used as source or destination of a conversion.
+*/
+TBool TScanLineConverter::IsDisplayModeSupported(TDisplayMode aDispMode)
+	{
+	return aDispMode > ENone && aDispMode < EColorLast;
+	}
+
+/**
+Returns the converter for a pair of display modes, so that the table lookup is done once
+for a series of scan lines.
+@param aSrcMode		Display mode of the source scan line
+@param aDestMode	Display mode of the destination scan line
+@return The converter, or NULL if either display mode is not supported.
+*/
+TConvertSpanFunction TScanLineConverter::Function(TDisplayMode aSrcMode, TDisplayMode aDestMode)
+	{
+	if (!IsDisplayModeSupported(aSrcMode) || !IsDisplayModeSupported(aDestMode))
+		return NULL;
+	return KConvertFunctions[aSrcMode][aDestMode];
+	}
+
+/**
+Converts aLength pixels of one scan line to another display mode.
+@param aSrcMode		Display mode of aSrc
+@param aSrc			Source scan line
+@param aSrcX		Index of the first source pixel
+@param aDestMode	Display mode of aDest
+@param aDest		Destination scan line. Must not overlap aSrc unless both modes are the same.
+@param aDestX		Index of the first destination pixel
+@param aLength		Number of pixels to convert
+@panic EScreenDriverPanicInvalidDisplayMode if either display mode is not supported
+*/
+void TScanLineConverter::Convert(TDisplayMode aSrcMode, const TAny* aSrc, TInt aSrcX,
+								 TDisplayMode aDestMode, TAny* aDest, TInt aDestX, TInt aLength)
+	{
+	const TConvertSpanFunction function = Function(aSrcMode, aDestMode);
+	__ASSERT_ALWAYS(function, Panic(EScreenDriverPanicInvalidDisplayMode));
+	__ASSERT_DEBUG(aSrc && aDest, Panic(EScreenDriverPanicNullPointer));
+	__ASSERT_DEBUG(aSrcX >= 0 && aDestX >= 0 && aLength >= 0, Panic(EScreenDriverPanicOutOfBounds));
+	function(aSrc, aSrcX, aDest, aDestX, aLength);
+	}
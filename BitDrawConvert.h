@@ -0,0 +1,53 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWCONVERT_H__
+#define __BITDRAWCONVERT_H__
+
+#include <gdi.h>
+
+/**
+Converts aLength pixels starting at pixel aSrcX of the scan line aSrc to pixels starting at
+pixel aDestX of the scan line aDest.
+@see TScanLineConverter
+@internalComponent
+*/
+typedef void (*TConvertSpanFunction)(const TAny* aSrc, TInt aSrcX, TAny* aDest, TInt aDestX, TInt aLength);
+
+/**
+Scan line conversion between any two display modes from EGray2 to EColor16MAP, used to
+implement CFbsDrawDevice::ReadLine() and to prepare the buffers passed to WriteLine().
+
+Every source and destination pair has its own converter, instantiated at compile time from
+TPixelFormat and selected through a two-dimensional table:
+	- pairs of the same mode copy the pixels;
+	- sources up to 8bpp convert each possible pixel value once per span and then look pixels up;
+	- EColor64K, EColor16M and the 32bpp modes other than EColor16MAP have dedicated bit
+	  manipulation converters between each other, vectorized with SSE2 or NEON where available;
+	- other pairs convert each pixel through TRgb, once per run of identical pixels.
+Every converter gives the same result as converting each pixel through TRgb.
+@see TPixelFormat
+@internalComponent
+*/
+class TScanLineConverter
+	{
+public:
+	static TBool IsDisplayModeSupported(TDisplayMode aDispMode);
+	static TConvertSpanFunction Function(TDisplayMode aSrcMode, TDisplayMode aDestMode);
+	static void Convert(TDisplayMode aSrcMode, const TAny* aSrc, TInt aSrcX,
+						TDisplayMode aDestMode, TAny* aDest, TInt aDestX, TInt aLength);
+	};
+
+#endif
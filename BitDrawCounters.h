@@ -0,0 +1,105 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWCOUNTERS_H__
+#define __BITDRAWCOUNTERS_H__
+
+#include <e32base.h>
+#include "bitdraw.h"
+#include "BitDrawExtInterfaceId.h"
+
+/**
+Drawing primitives counted by MDrawDeviceCounters.
+@internalComponent
+*/
+enum TDrawPrimitive
+	{
+	EPrimitiveWriteRgb,
+	EPrimitiveWriteRgbMulti,
+	EPrimitiveWriteLine,
+	EPrimitiveWriteBinary,
+	EPrimitiveWriteBinaryLine,
+	EPrimitiveWriteBinaryLineVertical,
+	/** WriteRgbAlphaLine() with a single source buffer. */
+	EPrimitiveWriteRgbAlphaLine,
+	/** WriteRgbAlphaLine() with a source and a background buffer. */
+	EPrimitiveWriteRgbAlphaLine2,
+	EPrimitiveWriteRgbAlphaMulti,
+	EPrimitiveMapColors,
+	EPrimitiveShadowArea,
+	EPrimitiveReadLine,
+	/** Number of primitives; not a primitive. */
+	EDrawPrimitiveCount
+	};
+
+/**
+Counters of one drawing primitive for one draw mode and display mode.
+@see MDrawDeviceCounters
+@internalComponent
+*/
+class TDrawCounter
+	{
+public:
+	/** Primitive counted. */
+	TDrawPrimitive iPrimitive;
+	/** Draw mode passed to the primitive; 0 for primitives without a draw mode. */
+	CGraphicsContext::TDrawMode iDrawMode;
+	/** Display mode of the device, or the requested display mode for EPrimitiveReadLine;
+	ENone for calls that could not be broken down because too many combinations were in use. */
+	TDisplayMode iDisplayMode;
+	/** Number of calls. */
+	TUint32 iCalls;
+	/** Number of pixels the calls covered. */
+	TInt64 iPixels;
+	/** Total time spent in the calls, in microseconds. */
+	TInt64 iMicroSeconds;
+	};
+
+/**
+Performance counters of a draw device, retrieved with
+CFbsDrawDevice::GetInterface(KDrawDeviceCountersInterfaceID, ...).
+
+Counting is off until SetCountersEnabled(ETrue) is called. While it is off no counting or timing
+is done, so the interface can be left in production builds. Counters are not thread safe: the
+counting device must be called from one thread at a time.
+@see CInstrumentedDrawDevice
+@internalComponent
+*/
+class MDrawDeviceCounters
+	{
+public:
+	/**
+	Starts or stops counting. Counters are kept when counting stops.
+	@param aEnabled ETrue to count the following calls
+	*/
+	virtual void SetCountersEnabled(TBool aEnabled) = 0;
+	/**
+	@return ETrue if calls are being counted.
+	*/
+	virtual TBool CountersEnabled() const = 0;
+	/**
+	Takes a snapshot of the counters.
+	@param aCounters Upon return contains one entry per primitive, draw mode and display mode
+	combination called since the last ResetCounters(). Existing entries are removed.
+	@return KErrNone, or KErrNoMemory if aCounters could not be extended.
+	*/
+	virtual TInt GetCounters(RArray<TDrawCounter>& aCounters) const = 0;
+	/**
+	Sets all counters to zero.
+	*/
+	virtual void ResetCounters() = 0;
+	};
+
+#endif
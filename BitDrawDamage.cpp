@@ -0,0 +1,451 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawDamage.h"
+#include "BitDrawExtInterfaceId.h"
+#include "BitDrawInterfaceId.h"
+
+LOCAL_C inline TInt64 Area(const TRect& aRect)
+	{
+	return TInt64(aRect.Width()) * aRect.Height();
+	}
+
+LOCAL_C inline TBool Contains(const TRect& aOuter, const TRect& aInner)
+	{
+	return aInner.iTl.iX >= aOuter.iTl.iX && aInner.iBr.iX <= aOuter.iBr.iX &&
+		   aInner.iTl.iY >= aOuter.iTl.iY && aInner.iBr.iY <= aOuter.iBr.iY;
+	}
+
+//
+// TDamageRegion
+//
+
+TDamageRegion::TDamageRegion(TRect* aRectangles, TInt aCapacity):
+	iRectangles(aRectangles),
+	iCount(0),
+	iCapacity(aCapacity),
+	iMaxRects(aCapacity)
+	{
+	}
+
+/**
+Adds a rectangle to the region, merging it with existing rectangles where the cost
+says so. Empty rectangles are ignored.
+@param aRect Rectangle to add
+*/
+void TDamageRegion::AddRect(const TRect& aRect)
+	{
+	if (aRect.IsEmpty())
+		return;
+	TRect rect(aRect);
+	TBool merged;
+	do
+		{
+		merged = EFalse;
+		for (TInt index = 0; index < iCount; index++)
+			{
+			const TRect& existing = iRectangles[index];
+			if (Contains(existing, rect))
+				return;
+			if (Contains(rect, existing) || iCost.ShouldMerge(WastedPixels(existing, rect)))
+				{
+				// The grown rectangle may now absorb rectangles already checked, so start again.
+				rect.BoundingRect(existing);
+				Remove(index);
+				merged = ETrue;
+				break;
+				}
+			}
+		} while (merged);
+	while (iCount >= iMaxRects)
+		MergeCheapest(rect);
+	iRectangles[iCount++] = rect;
+	}
+
+/**
+Removes all rectangles from the region.
+*/
+void TDamageRegion::Clear()
+	{
+	iCount = 0;
+	}
+
+/**
+@return The smallest rectangle containing the whole region.
+*/
+TRect TDamageRegion::BoundingRect() const
+	{
+	TRect bounds;
+	if (iCount > 0)
+		bounds = iRectangles[0];
+	for (TInt index = 1; index < iCount; index++)
+		bounds.BoundingRect(iRectangles[index]);
+	return bounds;
+	}
+
+/**
+Copies the rectangles into a TRegion, for passing to CFbsDrawDevice::Update().
+If aRegion cannot hold them all it is set to the bounding rectangle.
+@param aRegion Upon return contains the rectangles of the region
+*/
+void TDamageRegion::GetRegion(TRegion& aRegion) const
+	{
+	aRegion.Clear();
+	for (TInt index = 0; index < iCount; index++)
+		aRegion.AddRect(iRectangles[index]);
+	if (aRegion.CheckError())
+		{
+		aRegion.Clear();
+		aRegion.AddRect(BoundingRect());
+		}
+	}
+
+/**
+Sets the cost used to decide whether rectangles are merged. Rectangles already in the
+region are not affected.
+@param aCost New cost
+*/
+void TDamageRegion::SetCost(const TDamageCost& aCost)
+	{
+	iCost = aCost;
+	}
+
+/**
+Sets the maximum number of rectangles in the region, merging rectangles if the region
+already holds more.
+@param aMaxRects Maximum number of rectangles
+@panic EScreenDriverPanicInvalidParameter if aMaxRects is not in the range [1, capacity]
+*/
+void TDamageRegion::SetMaxRects(TInt aMaxRects)
+	{
+	__ASSERT_ALWAYS(aMaxRects > 0 && aMaxRects <= iCapacity, Panic(EScreenDriverPanicInvalidParameter));
+	iMaxRects = aMaxRects;
+	while (iCount > iMaxRects)
+		{
+		TRect last(iRectangles[--iCount]);
+		while (iCount >= iMaxRects)
+			MergeCheapest(last);
+		iRectangles[iCount++] = last;
+		}
+	}
+
+TInt64 TDamageRegion::WastedPixels(const TRect& aRect1, const TRect& aRect2)
+	{
+	TRect bounds(aRect1);
+	bounds.BoundingRect(aRect2);
+	TInt64 wasted = Area(bounds) - Area(aRect1) - Area(aRect2);
+	if (aRect1.Intersects(aRect2))
+		{
+		TRect overlap(aRect1);
+		overlap.Intersection(aRect2);
+		wasted += Area(overlap);
+		}
+	return wasted;
+	}
+
+void TDamageRegion::Remove(TInt aIndex)
+	{
+	iRectangles[aIndex] = iRectangles[--iCount];
+	}
+
+/**
+Reduces the number of rectangles by one, merging either aRect with a rectangle of the
+region or two rectangles of the region, whichever wastes fewer pixels.
+*/
+void TDamageRegion::MergeCheapest(TRect& aRect)
+	{
+	TInt64 bestWasted = WastedPixels(iRectangles[0], aRect);
+	TInt bestFirst = 0;
+	TInt bestSecond = KErrNotFound;
+	for (TInt first = 0; first < iCount; first++)
+		{
+		const TInt64 withNew = WastedPixels(iRectangles[first], aRect);
+		if (withNew < bestWasted)
+			{
+			bestWasted = withNew;
+			bestFirst = first;
+			bestSecond = KErrNotFound;
+			}
+		for (TInt second = first + 1; second < iCount; second++)
+			{
+			const TInt64 wasted = WastedPixels(iRectangles[first], iRectangles[second]);
+			if (wasted < bestWasted)
+				{
+				bestWasted = wasted;
+				bestFirst = first;
+				bestSecond = second;
+				}
+			}
+		}
+	if (bestSecond == KErrNotFound)
+		{
+		aRect.BoundingRect(iRectangles[bestFirst]);
+		Remove(bestFirst);
+		}
+	else
+		{
+		iRectangles[bestFirst].BoundingRect(iRectangles[bestSecond]);
+		Remove(bestSecond);
+		}
+	}
+
+//
+// CDamageTrackingDrawDevice
+//
+
+/**
+Creates a damage tracking device.
+@param aTarget Device to draw to. Ownership is transferred if the function does not leave.
+@return The new device
+@leave KErrNoMemory Not enough memory
+*/
+CDamageTrackingDrawDevice* CDamageTrackingDrawDevice::NewL(CFbsDrawDevice* aTarget)
+	{
+	return new(ELeave) CDamageTrackingDrawDevice(aTarget);
+	}
+
+CDamageTrackingDrawDevice::CDamageTrackingDrawDevice(CFbsDrawDevice* aTarget):
+	CForwardingDrawDevice(aTarget)
+	{
+	iTarget->SetAutoUpdate(EFalse);
+	iTarget->GetDrawRect(iDrawRect);
+	}
+
+/**
+Sets the cost used to decide whether damaged rectangles are merged.
+@param aCost New cost
+*/
+void CDamageTrackingDrawDevice::SetDamageCost(const TDamageCost& aCost)
+	{
+	iDamage.SetCost(aCost);
+	}
+
+/**
+Sets the maximum number of rectangles pushed by one Update().
+@param aMaxRects Maximum number of rectangles, in the range [1, KMaxDamageRects]
+@panic EScreenDriverPanicInvalidParameter if aMaxRects is out of range
+*/
+void CDamageTrackingDrawDevice::SetMaxDamageRects(TInt aMaxRects)
+	{
+	iDamage.SetMaxRects(aMaxRects);
+	}
+
+void CDamageTrackingDrawDevice::AddDamage(const TRect& aRect)
+	{
+	if (iInterfaceUsed)
+		iTarget->GetDrawRect(iDrawRect);
+	TRect rect(aRect);
+	rect.Intersection(iDrawRect);
+	iDamage.AddRect(rect);
+	if (iAutoUpdate)
+		Update();
+	}
+
+void CDamageTrackingDrawDevice::AddDamageAll()
+	{
+	iTarget->GetDrawRect(iDrawRect);
+	AddDamage(iDrawRect);
+	}
+
+void CDamageTrackingDrawDevice::MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards)
+	{
+	iTarget->MapColors(aRect, aColors, aNumPairs, aMapForwards);
+	AddDamage(aRect);
+	}
+
+TBool CDamageTrackingDrawDevice::SetOrientation(TOrientation aOrientation)
+	{
+	const TBool set = iTarget->SetOrientation(aOrientation);
+	if (set)
+		AddDamageAll();
+	return set;
+	}
+
+void CDamageTrackingDrawDevice::WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteBinary(aX, aY, aBuffer, aLength, aHeight, aColor, aDrawMode);
+	AddDamage(TRect(aX, aY, aX + aLength, aY + aHeight));
+	}
+
+void CDamageTrackingDrawDevice::WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteBinaryLine(aX, aY, aBuffer, aLength, aColor, aDrawMode);
+	AddDamage(TRect(aX, aY, aX + aLength, aY + 1));
+	}
+
+void CDamageTrackingDrawDevice::WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp)
+	{
+	iTarget->WriteBinaryLineVertical(aX, aY, aBuffer, aHeight, aColor, aDrawMode, aUp);
+	if (aUp)
+		AddDamage(TRect(aX, aY - aHeight + 1, aX + 1, aY + 1));
+	else
+		AddDamage(TRect(aX, aY, aX + 1, aY + aHeight));
+	}
+
+void CDamageTrackingDrawDevice::WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteRgb(aX, aY, aColor, aDrawMode);
+	AddDamage(TRect(aX, aY, aX + 1, aY + 1));
+	}
+
+void CDamageTrackingDrawDevice::WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteRgbMulti(aX, aY, aLength, aHeight, aColor, aDrawMode);
+	AddDamage(TRect(aX, aY, aX + aLength, aY + aHeight));
+	}
+
+void CDamageTrackingDrawDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer, aMaskBuffer, aDrawMode);
+	AddDamage(TRect(aX, aY, aX + aLength, aY + 1));
+	}
+
+void CDamageTrackingDrawDevice::WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteLine(aX, aY, aLength, aBuffer, aDrawMode);
+	AddDamage(TRect(aX, aY, aX + aLength, aY + 1));
+	}
+
+TInt CDamageTrackingDrawDevice::InitScreen()
+	{
+	const TInt err = iTarget->InitScreen();
+	iTarget->SetAutoUpdate(EFalse);
+	AddDamageAll();
+	return err;
+	}
+
+/**
+Sets or unsets auto-update. With auto-update on, the damage of every primitive
+is pushed as soon as the primitive completes.
+@param aValue ETrue, if the screen is set to auto-update; EFalse, otherwise.
+*/
+void CDamageTrackingDrawDevice::SetAutoUpdate(TBool aValue)
+	{
+	iAutoUpdate = aValue;
+	if (iAutoUpdate)
+		Update();
+	}
+
+void CDamageTrackingDrawDevice::SetBits(TAny* aBits)
+	{
+	iTarget->SetBits(aBits);
+	AddDamageAll();
+	}
+
+void CDamageTrackingDrawDevice::SetDisplayMode(CFbsDrawDevice* aDrawDevice)
+	{
+	iTarget->SetDisplayMode(aDrawDevice);
+	AddDamageAll();
+	}
+
+void CDamageTrackingDrawDevice::ShadowArea(const TRect& aRect)
+	{
+	iTarget->ShadowArea(aRect);
+	AddDamage(aRect);
+	}
+
+/**
+Pushes the damaged area to the target with a single Update(const TRegion&) call,
+then clears it. Does nothing if nothing has been drawn since the last update.
+The whole draw rectangle is pushed if an interface has been handed out since the last update.
+*/
+void CDamageTrackingDrawDevice::Update()
+	{
+	if (iInterfacePending)
+		{
+		iInterfacePending = EFalse;
+		iTarget->GetDrawRect(iDrawRect);
+		iDamage.AddRect(iDrawRect);
+		}
+	if (iDamage.IsEmpty())
+		return;
+	TRegionFix<KMaxDamageRects> region;
+	iDamage.GetRegion(region);
+	iDamage.Clear();
+	iTarget->Update(region);
+	}
+
+/**
+Pushes the union of the damaged area and aRegion to the target.
+@param aRegion Region to update (logical coordinates)
+*/
+void CDamageTrackingDrawDevice::Update(const TRegion& aRegion)
+	{
+	const TRect* rect = aRegion.RectangleList();
+	for (TInt count = aRegion.Count(); count > 0; count--, rect++)
+		iDamage.AddRect(*rect);
+	Update();
+	}
+
+/**
+Adds aRect to the damaged area.
+@param aRect Rectangle to update (logical coordinates)
+*/
+void CDamageTrackingDrawDevice::UpdateRegion(const TRect& aRect)
+	{
+	AddDamage(aRect);
+	}
+
+void CDamageTrackingDrawDevice::WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer)
+	{
+	iTarget->WriteRgbAlphaMulti(aX, aY, aLength, aColor, aMaskBuffer);
+	AddDamage(TRect(aX, aY, aX + aLength, aY + 1));
+	}
+
+void CDamageTrackingDrawDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+												  const TUint8* aRgbBuffer1,
+												  const TUint8* aBuffer2,
+												  const TUint8* aMaskBuffer,
+												  CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer1, aBuffer2, aMaskBuffer, aDrawMode);
+	AddDamage(TRect(aX, aY, aX + aLength, aY + 1));
+	}
+
+/**
+Interfaces that change the scaling or origin damage the whole draw rectangle at the next Update(),
+and make the draw rectangle be read again for all later damage. Interfaces that write pixels
+unseen only damage the whole draw rectangle. The counters only read, so handing them out has no
+effect; nor does a failed request. Interfaces this device does not know of are assumed to write
+pixels.
+*/
+TInt CDamageTrackingDrawDevice::GetInterface(TInt aInterfaceId, TAny*& aInterface)
+	{
+	const TInt err = iTarget->GetInterface(aInterfaceId, aInterface);
+	if (err != KErrNone)
+		return err;
+	switch (aInterfaceId)
+		{
+	case KDrawDeviceCountersInterfaceID:
+		break;
+	case KScalingSettingsInterfaceID:
+	case KDrawDeviceOriginInterfaceID:
+		iInterfacePending = ETrue;
+		iInterfaceUsed = ETrue;
+		break;
+	default:
+		// KDirectScanLineAccessInterfaceID, KBlockAccessInterfaceID, KGlyphRunInterfaceID,
+		// KPremultipliedAlphaInterfaceID, KBatchedPlottingInterfaceID and unknown interfaces
+		iInterfacePending = ETrue;
+		break;
+		}
+	return err;
+	}
+
+void CDamageTrackingDrawDevice::SwapWidthAndHeight()
+	{
+	iTarget->SwapWidthAndHeight();
+	AddDamageAll();
+	}
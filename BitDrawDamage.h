@@ -0,0 +1,245 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWDAMAGE_H__
+#define __BITDRAWDAMAGE_H__
+
+#include "BitDrawForwarding.h"
+
+/**
+Maximum number of rectangles a CDamageTrackingDrawDevice keeps.
+@internalComponent
+*/
+const TInt KMaxDamageRects = 16;
+
+/**
+Weights used by TDamageRegion to decide whether two rectangles should be merged.
+Replacing rectangles a and b by their bounding rectangle adds
+	area(bounding) - area(a) - area(b) + area(a intersect b)
+wasted pixels to the region and saves one rectangle. The rectangles are merged if
+	wasted pixels * iPixelCost <= iRectCost
+A rectangle contained in another, and rectangles that abut or overlap along a whole edge, waste
+no pixels and are always merged. Other overlapping rectangles waste the corners of their bounding
+rectangle that neither covers, and are kept apart if those cost more than a rectangle.
+@internalComponent
+*/
+class TDamageCost
+	{
+public:
+	inline TDamageCost();
+	inline TDamageCost(TInt aPixelCost, TInt aRectCost);
+	inline TBool ShouldMerge(TInt64 aWastedPixels) const;
+public:
+	/** Cost of pushing one pixel that was not drawn. */
+	TInt iPixelCost;
+	/** Fixed cost of pushing one extra rectangle. */
+	TInt iRectCost;
+	};
+
+/**
+Set of dirty rectangles, kept small by merging rectangles as they are added.
+Unlike TRegion, the rectangles may overlap and may cover pixels that were not added:
+the region is a conservative superset of the union of the added rectangles.
+The number of rectangles never exceeds MaxRects(); once the limit is reached, the pair
+that wastes the fewest pixels is merged.
+Storage is supplied by the derived class, as for TRegion.
+@see TDamageRegionFix
+@internalComponent
+*/
+class TDamageRegion
+	{
+public:
+	void AddRect(const TRect& aRect);
+	void Clear();
+	inline TInt Count() const;
+	inline TBool IsEmpty() const;
+	inline const TRect* RectangleList() const;
+	TRect BoundingRect() const;
+	void GetRegion(TRegion& aRegion) const;
+	void SetCost(const TDamageCost& aCost);
+	inline const TDamageCost& Cost() const;
+	void SetMaxRects(TInt aMaxRects);
+	inline TInt MaxRects() const;
+protected:
+	TDamageRegion(TRect* aRectangles, TInt aCapacity);
+private:
+	static TInt64 WastedPixels(const TRect& aRect1, const TRect& aRect2);
+	void Remove(TInt aIndex);
+	void MergeCheapest(TRect& aRect);
+private:
+	TRect* iRectangles;
+	TInt iCount;
+	TInt iCapacity;
+	TInt iMaxRects;
+	TDamageCost iCost;
+	};
+
+/**
+TDamageRegion with storage for S rectangles.
+@internalComponent
+*/
+template <TInt S>
+class TDamageRegionFix : public TDamageRegion
+	{
+public:
+	inline TDamageRegionFix();
+private:
+	TRect iRectangleStore[S];
+	};
+
+/**
+Draw device that records the area touched by every drawing primitive before forwarding it to
+a target device, typically a screen. Update() pushes only the coalesced dirty area to the target
+with a single Update(const TRegion&) call, then clears it.
+
+Interfaces returned by GetInterface() may write pixels, or change the scaling and origin of the
+target, without this device seeing it. Handing one out therefore damages the whole draw rectangle
+at the next Update(); after the scaling or origin interface has been handed out, the draw rectangle
+is read again from the target before every rectangle is clipped to it. MDrawDeviceCounters only
+reads, and does not damage anything. An interface must be requested again for every use, as
+CFbsBitGc does, for its pixels to be pushed.
+Auto-update is implemented by this device; the target is always kept with auto-update off.
+@internalComponent
+*/
+class CDamageTrackingDrawDevice : public CForwardingDrawDevice
+	{
+public:
+	static CDamageTrackingDrawDevice* NewL(CFbsDrawDevice* aTarget);
+	void SetDamageCost(const TDamageCost& aCost);
+	void SetMaxDamageRects(TInt aMaxRects);
+	inline const TDamageRegion& Damage() const;
+public: // From CFbsDrawDevice
+	void MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards);
+	TBool SetOrientation(TOrientation aOrientation);
+	void WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp);
+	void WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode);
+	void WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode);
+	TInt InitScreen();
+	void SetAutoUpdate(TBool aValue);
+	void SetBits(TAny* aBits);
+	void SetDisplayMode(CFbsDrawDevice* aDrawDevice);
+	void ShadowArea(const TRect& aRect);
+	void Update();
+	void Update(const TRegion& aRegion);
+	void UpdateRegion(const TRect& aRect);
+	void WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+						   const TUint8* aRgbBuffer1,
+						   const TUint8* aBuffer2,
+						   const TUint8* aMaskBuffer,
+						   CGraphicsContext::TDrawMode aDrawMode);
+	TInt GetInterface(TInt aInterfaceId, TAny*& aInterface);
+	void SwapWidthAndHeight();
+private:
+	CDamageTrackingDrawDevice(CFbsDrawDevice* aTarget);
+	void AddDamage(const TRect& aRect);
+	void AddDamageAll();
+private:
+	TDamageRegionFix<KMaxDamageRects> iDamage;
+	TRect iDrawRect;
+	TBool iAutoUpdate;
+	/** An interface has been handed out since the last Update(). */
+	TBool iInterfacePending;
+	/** The scaling or origin interface has been handed out, so the draw rectangle may change behind this device. */
+	TBool iInterfaceUsed;
+	};
+
+/**
+Constructs a cost under which one extra rectangle is worth 1024 wasted pixels.
+*/
+inline TDamageCost::TDamageCost():
+	iPixelCost(1),
+	iRectCost(1024)
+	{
+	}
+
+/**
+@param aPixelCost	Cost of pushing one pixel that was not drawn
+@param aRectCost	Fixed cost of pushing one extra rectangle
+*/
+inline TDamageCost::TDamageCost(TInt aPixelCost, TInt aRectCost):
+	iPixelCost(aPixelCost),
+	iRectCost(aRectCost)
+	{
+	}
+
+/**
+@param aWastedPixels Number of pixels the merge would add to the region
+@return ETrue if merging is cheaper than keeping both rectangles.
+*/
+inline TBool TDamageCost::ShouldMerge(TInt64 aWastedPixels) const
+	{
+	return aWastedPixels * iPixelCost <= iRectCost;
+	}
+
+/**
+@return The number of rectangles in the region.
+*/
+inline TInt TDamageRegion::Count() const
+	{
+	return iCount;
+	}
+
+/**
+@return ETrue if no rectangles have been added since the last Clear().
+*/
+inline TBool TDamageRegion::IsEmpty() const
+	{
+	return iCount == 0;
+	}
+
+/**
+@return The rectangles in the region. They may overlap.
+*/
+inline const TRect* TDamageRegion::RectangleList() const
+	{
+	return iRectangles;
+	}
+
+/**
+@return The cost used to decide whether rectangles are merged.
+*/
+inline const TDamageCost& TDamageRegion::Cost() const
+	{
+	return iCost;
+	}
+
+/**
+@return The maximum number of rectangles the region holds.
+*/
+inline TInt TDamageRegion::MaxRects() const
+	{
+	return iMaxRects;
+	}
+
+template <TInt S>
+inline TDamageRegionFix<S>::TDamageRegionFix():
+	TDamageRegion(iRectangleStore, S)
+	{
+	}
+
+/**
+@return The area touched since the last Update().
+*/
+inline const TDamageRegion& CDamageTrackingDrawDevice::Damage() const
+	{
+	return iDamage;
+	}
+
+#endif
@@ -0,0 +1,172 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWDIRECTACCESS_H__
+#define __BITDRAWDIRECTACCESS_H__
+
+#include "bitdraw.h"
+#include "BitDrawExtInterfaceId.h"
+
+/**
+Memory layout of a draw device, as reported by MDirectScanLineAccess.
+
+The physical position of the logical pixel [x,y] is
+	iPhysicalOrigin + iLogicalXStep * x + iLogicalYStep * y
+where iLogicalXStep and iLogicalYStep are unit vectors describing the current orientation,
+before any scaling (iFactorX/iFactorY physical pixels per logical pixel) is applied.
+The address of physical row y is iBits + y * iStride.
+@internalComponent
+*/
+class TDirectScanLineInfo
+	{
+public:
+	inline TBool IsDirect() const;
+	inline TBool HasBytePixels() const;
+	inline TPoint LogicalToPhysical(const TPoint& aLogical) const;
+	inline TUint8* RowAddress(TInt aPhysicalY) const;
+	inline TAny* PixelAddress(TInt aLogicalX, TInt aLogicalY) const;
+public:
+	/** Address of physical row 0. */
+	TUint8* iBits;
+	/** Bytes between the starts of two physical rows - the value of ScanLineBytes(). */
+	TInt iStride;
+	/** Format of the pixels in memory - the value of DisplayMode(). */
+	TDisplayMode iDisplayMode;
+	/** Bits a pixel of iDisplayMode takes in memory: 16 for EColor4K, not the 12 significant ones. */
+	TInt iBitsPerPixel;
+	/** Size of the pixel memory in physical pixels. */
+	TSize iPhysicalSize;
+	/** Current orientation. */
+	CFbsDrawDevice::TOrientation iOrientation;
+	/** Physical position of the logical pixel [0,0]. */
+	TPoint iPhysicalOrigin;
+	/** Physical step for one logical pixel along x. */
+	TPoint iLogicalXStep;
+	/** Physical step for one logical pixel along y. */
+	TPoint iLogicalYStep;
+	/** Physical pixels per logical pixel along x; 1 if the device is not scaled. */
+	TInt iFactorX;
+	/** Physical pixels per logical pixel along y; 1 if the device is not scaled. */
+	TInt iFactorY;
+	};
+
+/**
+Zero-copy access to the pixel memory of a draw device, retrieved with
+CFbsDrawDevice::GetInterface(KDirectScanLineAccessInterfaceID, ...).
+
+When TDirectScanLineInfo::IsDirect() returns ETrue, logical rows are physical rows and a caller
+whose pixels are already in DisplayMode() format may read and write them in place instead of going
+through ReadLine()/WriteLine() and the scan line buffer. Shadowing, fading and draw modes are not
+applied to pixels written directly, and screen devices must be told about them with UpdateRegion().
+
+The information remains valid until the next call to SetBits(), SetOrientation(),
+SetDisplayMode(), SwapWidthAndHeight() or a change of the scaling settings.
+@see CFbsDrawDevice::GetInterface
+@internalComponent
+*/
+class MDirectScanLineAccess
+	{
+public:
+	/**
+	Retrieves the memory layout of the device.
+	@param aInfo Upon return contains the memory layout and the current logical to physical transform.
+	@return KErrNone, or KErrNotSupported if the pixel memory cannot currently be accessed directly
+	(for example a screen device without a frame buffer mapped into the process).
+	*/
+	virtual TInt GetScanLineInfo(TDirectScanLineInfo& aInfo) const = 0;
+	};
+
+/**
+Helper for callers of MDirectScanLineAccess.
+@internalComponent
+*/
+class TDirectScanLine
+	{
+public:
+	inline static TBool Get(CFbsDrawDevice& aDevice, TDirectScanLineInfo& aInfo);
+	};
+
+/**
+@return ETrue if logical rows map one to one onto physical rows, i.e. the orientation is normal and
+the device is not scaled. The logical origin may still be non-zero.
+*/
+inline TBool TDirectScanLineInfo::IsDirect() const
+	{
+	return iOrientation == CFbsDrawDevice::EOrientationNormal && iFactorX == 1 && iFactorY == 1;
+	}
+
+/**
+@return ETrue if every pixel takes a whole number of bytes, i.e. 8bpp or more.
+*/
+inline TBool TDirectScanLineInfo::HasBytePixels() const
+	{
+	return iBitsPerPixel >= 8 && (iBitsPerPixel & 7) == 0;
+	}
+
+/**
+@param aLogical Logical coordinates of a pixel
+@return Physical coordinates of the top-left physical pixel covered by aLogical.
+*/
+inline TPoint TDirectScanLineInfo::LogicalToPhysical(const TPoint& aLogical) const
+	{
+	const TInt x = aLogical.iX * iFactorX;
+	const TInt y = aLogical.iY * iFactorY;
+	return TPoint(iPhysicalOrigin.iX + iLogicalXStep.iX * x + iLogicalYStep.iX * y,
+				  iPhysicalOrigin.iY + iLogicalXStep.iY * x + iLogicalYStep.iY * y);
+	}
+
+/**
+@param aPhysicalY Physical row
+@return Address of the first byte of the row.
+*/
+inline TUint8* TDirectScanLineInfo::RowAddress(TInt aPhysicalY) const
+	{
+	__ASSERT_DEBUG(aPhysicalY >= 0 && aPhysicalY < iPhysicalSize.iHeight, Panic(EScreenDriverPanicOutOfBounds));
+	return iBits + aPhysicalY * iStride;
+	}
+
+/**
+Only valid for display modes of 8bpp or more.
+@param aLogicalX Logical x coordinate
+@param aLogicalY Logical y coordinate
+@return Address of the first byte of the physical pixel covered by [aLogicalX,aLogicalY].
+@panic EScreenDriverPanicInvalidDisplayMode if pixels do not take a whole number of bytes
+*/
+inline TAny* TDirectScanLineInfo::PixelAddress(TInt aLogicalX, TInt aLogicalY) const
+	{
+	__ASSERT_DEBUG(HasBytePixels(), Panic(EScreenDriverPanicInvalidDisplayMode));
+	const TPoint physical(LogicalToPhysical(TPoint(aLogicalX, aLogicalY)));
+	__ASSERT_DEBUG(physical.iX >= 0 && physical.iX < iPhysicalSize.iWidth, Panic(EScreenDriverPanicOutOfBounds));
+	return RowAddress(physical.iY) + physical.iX * (iBitsPerPixel >> 3);
+	}
+
+/**
+Retrieves the memory layout of aDevice if it supports direct access and its logical rows are
+physical rows.
+@param aDevice	Device to query
+@param aInfo	Upon return contains the memory layout of aDevice, if ETrue is returned
+@return ETrue if aDevice supports MDirectScanLineAccess and aInfo.IsDirect() is ETrue.
+*/
+inline TBool TDirectScanLine::Get(CFbsDrawDevice& aDevice, TDirectScanLineInfo& aInfo)
+	{
+	TAny* access = NULL;
+	if (aDevice.GetInterface(KDirectScanLineAccessInterfaceID, access) != KErrNone || !access)
+		return EFalse;
+	if (static_cast<MDirectScanLineAccess*>(access)->GetScanLineInfo(aInfo) != KErrNone)
+		return EFalse;
+	return aInfo.IsDirect();
+	}
+
+#endif
@@ -0,0 +1,45 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWEXTINTERFACEID_H__
+#define __BITDRAWEXTINTERFACEID_H__
+
+/**
+Interface IDs of the CFbsDrawDevice extensions declared in this component, to be passed to
+CFbsDrawDevice::GetInterface(). The values start at 0x100 to keep them clear of the IDs
+in BitDrawInterfaceId.h.
+@see CFbsDrawDevice::GetInterface
+@internalComponent
+*/
+
+/** @see MDirectScanLineAccess */
+const TInt KDirectScanLineAccessInterfaceID = 0x100;
+
+/** @see MBlockAccess */
+const TInt KBlockAccessInterfaceID = 0x101;
+
+/** @see MDrawDeviceCounters */
+const TInt KDrawDeviceCountersInterfaceID = 0x102;
+
+/** @see MGlyphRunDrawing */
+const TInt KGlyphRunInterfaceID = 0x103;
+
+/** @see MPremultipliedAlphaBlending */
+const TInt KPremultipliedAlphaInterfaceID = 0x104;
+
+/** @see MBatchedPlotting */
+const TInt KBatchedPlottingInterfaceID = 0x105;
+
+#endif
@@ -0,0 +1,235 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawForwarding.h"
+
+/**
+@param aTarget Device to forward to. Ownership is transferred.
+@panic EScreenDriverPanicNullPointer if aTarget == NULL
+*/
+CForwardingDrawDevice::CForwardingDrawDevice(CFbsDrawDevice* aTarget):
+	iTarget(aTarget)
+	{
+	__ASSERT_ALWAYS(aTarget, Panic(EScreenDriverPanicNullPointer));
+	}
+
+CForwardingDrawDevice::~CForwardingDrawDevice()
+	{
+	delete iTarget;
+	}
+
+TDisplayMode CForwardingDrawDevice::DisplayMode() const
+	{
+	return iTarget->DisplayMode();
+	}
+
+TInt CForwardingDrawDevice::LongWidth() const
+	{
+	return iTarget->LongWidth();
+	}
+
+void CForwardingDrawDevice::MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards)
+	{
+	iTarget->MapColors(aRect, aColors, aNumPairs, aMapForwards);
+	}
+
+void CForwardingDrawDevice::ReadLine(TInt aX,TInt aY,TInt aLength,TAny* aBuffer,TDisplayMode aDispMode) const
+	{
+	iTarget->ReadLine(aX, aY, aLength, aBuffer, aDispMode);
+	}
+
+TRgb CForwardingDrawDevice::ReadPixel(TInt aX,TInt aY) const
+	{
+	return iTarget->ReadPixel(aX, aY);
+	}
+
+TUint32* CForwardingDrawDevice::ScanLineBuffer() const
+	{
+	return iTarget->ScanLineBuffer();
+	}
+
+TInt CForwardingDrawDevice::ScanLineBytes() const
+	{
+	return iTarget->ScanLineBytes();
+	}
+
+TDisplayMode CForwardingDrawDevice::ScanLineDisplayMode() const
+	{
+	return iTarget->ScanLineDisplayMode();
+	}
+
+TSize CForwardingDrawDevice::SizeInPixels() const
+	{
+	return iTarget->SizeInPixels();
+	}
+
+TInt CForwardingDrawDevice::HorzTwipsPerThousandPixels() const
+	{
+	return iTarget->HorzTwipsPerThousandPixels();
+	}
+
+TInt CForwardingDrawDevice::VertTwipsPerThousandPixels() const
+	{
+	return iTarget->VertTwipsPerThousandPixels();
+	}
+
+void CForwardingDrawDevice::OrientationsAvailable(TBool aOrientation[4])
+	{
+	iTarget->OrientationsAvailable(aOrientation);
+	}
+
+TBool CForwardingDrawDevice::SetOrientation(TOrientation aOrientation)
+	{
+	return iTarget->SetOrientation(aOrientation);
+	}
+
+void CForwardingDrawDevice::WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteBinary(aX, aY, aBuffer, aLength, aHeight, aColor, aDrawMode);
+	}
+
+void CForwardingDrawDevice::WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteBinaryLine(aX, aY, aBuffer, aLength, aColor, aDrawMode);
+	}
+
+void CForwardingDrawDevice::WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp)
+	{
+	iTarget->WriteBinaryLineVertical(aX, aY, aBuffer, aHeight, aColor, aDrawMode, aUp);
+	}
+
+void CForwardingDrawDevice::WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteRgb(aX, aY, aColor, aDrawMode);
+	}
+
+void CForwardingDrawDevice::WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteRgbMulti(aX, aY, aLength, aHeight, aColor, aDrawMode);
+	}
+
+void CForwardingDrawDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer, aMaskBuffer, aDrawMode);
+	}
+
+void CForwardingDrawDevice::WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteLine(aX, aY, aLength, aBuffer, aDrawMode);
+	}
+
+TInt CForwardingDrawDevice::InitScreen()
+	{
+	return iTarget->InitScreen();
+	}
+
+void CForwardingDrawDevice::SetAutoUpdate(TBool aValue)
+	{
+	iTarget->SetAutoUpdate(aValue);
+	}
+
+void CForwardingDrawDevice::SetBits(TAny* aBits)
+	{
+	iTarget->SetBits(aBits);
+	}
+
+TInt CForwardingDrawDevice::SetCustomPalette(const CPalette* aPalette)
+	{
+	return iTarget->SetCustomPalette(aPalette);
+	}
+
+TInt CForwardingDrawDevice::GetCustomPalette(CPalette*& aPalette)
+	{
+	return iTarget->GetCustomPalette(aPalette);
+	}
+
+void CForwardingDrawDevice::SetDisplayMode(CFbsDrawDevice* aDrawDevice)
+	{
+	iTarget->SetDisplayMode(aDrawDevice);
+	}
+
+void CForwardingDrawDevice::SetDitherOrigin(const TPoint& aPoint)
+	{
+	iTarget->SetDitherOrigin(aPoint);
+	}
+
+void CForwardingDrawDevice::SetUserDisplayMode(TDisplayMode aDisplayMode)
+	{
+	iTarget->SetUserDisplayMode(aDisplayMode);
+	}
+
+void CForwardingDrawDevice::SetShadowMode(TShadowMode aShadowMode)
+	{
+	iTarget->SetShadowMode(aShadowMode);
+	}
+
+void CForwardingDrawDevice::SetFadingParameters(TUint8 aBlackMap,TUint8 aWhiteMap)
+	{
+	iTarget->SetFadingParameters(aBlackMap, aWhiteMap);
+	}
+
+void CForwardingDrawDevice::ShadowArea(const TRect& aRect)
+	{
+	iTarget->ShadowArea(aRect);
+	}
+
+void CForwardingDrawDevice::ShadowBuffer(TInt aLength,TUint32* aBuffer)
+	{
+	iTarget->ShadowBuffer(aLength, aBuffer);
+	}
+
+void CForwardingDrawDevice::Update()
+	{
+	iTarget->Update();
+	}
+
+void CForwardingDrawDevice::Update(const TRegion& aRegion)
+	{
+	iTarget->Update(aRegion);
+	}
+
+void CForwardingDrawDevice::UpdateRegion(const TRect& aRect)
+	{
+	iTarget->UpdateRegion(aRect);
+	}
+
+void CForwardingDrawDevice::WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer)
+	{
+	iTarget->WriteRgbAlphaMulti(aX, aY, aLength, aColor, aMaskBuffer);
+	}
+
+void CForwardingDrawDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+											  const TUint8* aRgbBuffer1,
+											  const TUint8* aBuffer2,
+											  const TUint8* aMaskBuffer,
+											  CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer1, aBuffer2, aMaskBuffer, aDrawMode);
+	}
+
+TInt CForwardingDrawDevice::GetInterface(TInt aInterfaceId, TAny*& aInterface)
+	{
+	return iTarget->GetInterface(aInterfaceId, aInterface);
+	}
+
+void CForwardingDrawDevice::GetDrawRect(TRect& aDrawRect) const
+	{
+	iTarget->GetDrawRect(aDrawRect);
+	}
+
+void CForwardingDrawDevice::SwapWidthAndHeight()
+	{
+	iTarget->SwapWidthAndHeight();
+	}
@@ -0,0 +1,92 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWFORWARDING_H__
+#define __BITDRAWFORWARDING_H__
+
+#include "bitdraw.h"
+
+/**
+Base class for draw devices that wrap another draw device. Every CFbsDrawDevice function
+is forwarded unchanged to the target device; derived classes override the ones they need
+to observe or alter.
+The target device is owned by the forwarding device.
+@internalComponent
+*/
+class CForwardingDrawDevice : public CFbsDrawDevice
+	{
+public:
+	~CForwardingDrawDevice();
+	inline CFbsDrawDevice& Target() const;
+public: // From CFbsDrawDevice
+	TDisplayMode DisplayMode() const;
+	TInt LongWidth() const;
+	void MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards);
+	void ReadLine(TInt aX,TInt aY,TInt aLength,TAny* aBuffer,TDisplayMode aDispMode) const;
+	TRgb ReadPixel(TInt aX,TInt aY) const;
+	TUint32* ScanLineBuffer() const;
+	TInt ScanLineBytes() const;
+	TDisplayMode ScanLineDisplayMode() const;
+	TSize SizeInPixels() const;
+	TInt HorzTwipsPerThousandPixels() const;
+	TInt VertTwipsPerThousandPixels() const;
+	void OrientationsAvailable(TBool aOrientation[4]);
+	TBool SetOrientation(TOrientation aOrientation);
+	void WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp);
+	void WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode);
+	void WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode);
+	TInt InitScreen();
+	void SetAutoUpdate(TBool aValue);
+	void SetBits(TAny* aBits);
+	TInt SetCustomPalette(const CPalette* aPalette);
+	TInt GetCustomPalette(CPalette*& aPalette);
+	void SetDisplayMode(CFbsDrawDevice* aDrawDevice);
+	void SetDitherOrigin(const TPoint& aPoint);
+	void SetUserDisplayMode(TDisplayMode aDisplayMode);
+	void SetShadowMode(TShadowMode aShadowMode);
+	void SetFadingParameters(TUint8 aBlackMap,TUint8 aWhiteMap);
+	void ShadowArea(const TRect& aRect);
+	void ShadowBuffer(TInt aLength,TUint32* aBuffer);
+	void Update();
+	void Update(const TRegion& aRegion);
+	void UpdateRegion(const TRect& aRect);
+	void WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+						   const TUint8* aRgbBuffer1,
+						   const TUint8* aBuffer2,
+						   const TUint8* aMaskBuffer,
+						   CGraphicsContext::TDrawMode aDrawMode);
+	TInt GetInterface(TInt aInterfaceId, TAny*& aInterface);
+	void GetDrawRect(TRect& aDrawRect) const;
+	void SwapWidthAndHeight();
+protected:
+	CForwardingDrawDevice(CFbsDrawDevice* aTarget);
+protected:
+	CFbsDrawDevice* iTarget;
+	};
+
+/**
+@return The wrapped device.
+*/
+inline CFbsDrawDevice& CForwardingDrawDevice::Target() const
+	{
+	return *iTarget;
+	}
+
+#endif
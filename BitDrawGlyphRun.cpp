@@ -0,0 +1,219 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawGlyphRun.h"
+#include "BitDrawMapColors.h"
+
+/** Pixels gathered at once when blending a row that is not contiguous in memory. */
+const TInt KGlyphGatherPixels = 64;
+
+/** Words of the line buffer of DrawWithPrimitives(); longer rows are drawn in several calls. */
+const TInt KGlyphLineWords = 8;
+
+/**
+Reads aCount bits, at most 32, of a coverage row starting at bit aBit, without reading past the
+byte holding the last one.
+*/
+LOCAL_C TUint32 ReadBits(const TUint8* aRow, TInt aBit, TInt aCount)
+	{
+	const TUint8* byte = aRow + (aBit >> 3);
+	const TInt shift = aBit & 7;
+	TUint32 value = *byte++ >> shift;
+	for (TInt got = 8 - shift; got < aCount; got += 8)
+		value |= TUint32(*byte++) << got;
+	if (aCount < 32)
+		value &= (1u << aCount) - 1;
+	return value;
+	}
+
+LOCAL_C inline void WritePixel(TUint8* aDest, TUint32 aPixel, TInt aBytesPerPixel)
+	{
+	switch (aBytesPerPixel)
+		{
+	case 1:
+		*aDest = TUint8(aPixel);
+		break;
+	case 2:
+		*reinterpret_cast<TUint16*>(aDest) = TUint16(aPixel);
+		break;
+	case 3:
+		aDest[0] = TUint8(aPixel);
+		aDest[1] = TUint8(aPixel >> 8);
+		aDest[2] = TUint8(aPixel >> 16);
+		break;
+	default:
+		*reinterpret_cast<TUint32*>(aDest) = aPixel;
+		break;
+		}
+	}
+
+/**
+Writes aPixel to the pixels of a row whose coverage bit is set, skipping clear bytes.
+*/
+LOCAL_C void WriteMonoRow(TUint8* aDest, TInt aXStep, TInt aBytesPerPixel, TUint32 aPixel,
+						  const TUint8* aCoverage, TInt aFirstBit, TInt aLength)
+	{
+	TInt index = 0;
+	while (index < aLength)
+		{
+		const TInt bit = aFirstBit + index;
+		const TUint32 bits = aCoverage[bit >> 3] >> (bit & 7);
+		if (bits == 0)
+			{
+			index += 8 - (bit & 7);
+			continue;
+			}
+		if (bits & 1)
+			WritePixel(aDest + index * aXStep, aPixel, aBytesPerPixel);
+		index++;
+		}
+	}
+
+/**
+@return ETrue if Draw() can draw a run with these parameters into a device with layout aInfo.
+*/
+TBool TGlyphRun::IsSupported(const TDirectScanLineInfo& aInfo, TGlyphCoverage aCoverage,
+							 TRgb aColor, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (aInfo.iFactorX != 1 || aInfo.iFactorY != 1)
+		return EFalse;
+	if (aCoverage == EGlyphCoverageGray256)
+		return TAlphaBlendSpan::IsDisplayModeSupported(aInfo.iDisplayMode);
+	return aInfo.HasBytePixels() && aDrawMode == CGraphicsContext::EDrawModePEN && aColor.Alpha() == 0xff;
+	}
+
+/**
+Draws a glyph run into the memory described by aInfo. Implements MGlyphRunDrawing::DrawGlyphRun()
+for devices with no shadowing or fading set.
+@param aInfo		Memory layout of the device
+@param aGlyphs		Glyphs to draw
+@param aCount		Number of glyphs
+@param aCoverage	Format of the coverage bitmaps
+@param aClipRect	Logical clipping rectangle; must lie within the draw rectangle of the device
+@param aColor		Colour of the glyphs
+@param aDrawMode	Draw mode of mono glyphs
+@return KErrNone, or KErrNotSupported if IsSupported() returns EFalse; nothing is drawn then.
+*/
+TInt TGlyphRun::Draw(const TDirectScanLineInfo& aInfo, const TGlyphRunEntry* aGlyphs, TInt aCount, TGlyphCoverage aCoverage,
+					 const TRect& aClipRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode) const
+	{
+	if (!IsSupported(aInfo, aCoverage, aColor, aDrawMode))
+		return KErrNotSupported;
+	const TInt bytesPerPixel = aInfo.iBitsPerPixel >> 3;
+	const TInt xStep = aInfo.iLogicalXStep.iX * bytesPerPixel + aInfo.iLogicalXStep.iY * aInfo.iStride;
+	const TInt yStep = aInfo.iLogicalYStep.iX * bytesPerPixel + aInfo.iLogicalYStep.iY * aInfo.iStride;
+	const TBool gray = aCoverage == EGlyphCoverageGray256;
+	const TUint32 pixel = gray ? 0 : RDrawColorMap::RgbToPixel(aInfo.iDisplayMode, aColor);
+	for (const TGlyphRunEntry* glyph = aGlyphs; glyph < aGlyphs + aCount; glyph++)
+		{
+		TRect rect(glyph->iPosition, glyph->iSize);
+		rect.Intersection(aClipRect);
+		if (rect.IsEmpty())
+			continue;
+		const TInt firstX = rect.iTl.iX - glyph->iPosition.iX;
+		const TInt width = rect.Width();
+		const TUint8* coverage = glyph->iCoverage + (rect.iTl.iY - glyph->iPosition.iY) * glyph->iStride;
+		TUint8* dest = static_cast<TUint8*>(aInfo.PixelAddress(rect.iTl.iX, rect.iTl.iY));
+		for (TInt rows = rect.Height(); rows > 0; rows--, coverage += glyph->iStride, dest += yStep)
+			{
+			if (gray)
+				BlendRow(aInfo.iDisplayMode, dest, xStep, bytesPerPixel, aColor, coverage + firstX, width);
+			else
+				WriteMonoRow(dest, xStep, bytesPerPixel, pixel, coverage, firstX, width);
+			}
+		}
+	return KErrNone;
+	}
+
+/**
+Blends aColor into a row. Rows that are not contiguous in memory, in rotated orientations,
+are gathered into a buffer, blended there and scattered back.
+*/
+void TGlyphRun::BlendRow(TDisplayMode aDispMode, TUint8* aDest, TInt aXStep, TInt aBytesPerPixel,
+						 TRgb aColor, const TUint8* aMask, TInt aLength) const
+	{
+	if (aXStep == aBytesPerPixel)
+		{
+		iBlend.BlendColor(aDispMode, aDest, aColor, aMask, aLength);
+		return;
+		}
+	TUint32 gathered[KGlyphGatherPixels];
+	TUint8* const buffer = reinterpret_cast<TUint8*>(gathered);
+	while (aLength > 0)
+		{
+		const TInt count = Min(aLength, KGlyphGatherPixels);
+		TUint8* pixel = aDest;
+		for (TInt index = 0; index < count; index++, pixel += aXStep)
+			Mem::Copy(buffer + index * aBytesPerPixel, pixel, aBytesPerPixel);
+		iBlend.BlendColor(aDispMode, buffer, aColor, aMask, count);
+		pixel = aDest;
+		for (TInt index = 0; index < count; index++, pixel += aXStep)
+			Mem::Copy(pixel, buffer + index * aBytesPerPixel, aBytesPerPixel);
+		aDest += count * aXStep;
+		aMask += count;
+		aLength -= count;
+		}
+	}
+
+/**
+Draws a glyph run through the primitives of aDevice. Implements MGlyphRunDrawing::DrawGlyphRun()
+for any device, and is the fallback of devices whose layout or settings Draw() does not support.
+@param aDevice		Device to draw to
+@param aGlyphs		Glyphs to draw
+@param aCount		Number of glyphs
+@param aCoverage	Format of the coverage bitmaps
+@param aClipRect	Logical clipping rectangle
+@param aColor		Colour of the glyphs
+@param aDrawMode	Draw mode of mono glyphs
+*/
+void TGlyphRun::DrawWithPrimitives(CFbsDrawDevice& aDevice, const TGlyphRunEntry* aGlyphs, TInt aCount,
+								   TGlyphCoverage aCoverage, const TRect& aClipRect,
+								   TRgb aColor, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TRect clipRect;
+	aDevice.GetDrawRect(clipRect);
+	clipRect.Intersection(aClipRect);
+	TUint32 line[KGlyphLineWords];
+	for (const TGlyphRunEntry* glyph = aGlyphs; glyph < aGlyphs + aCount; glyph++)
+		{
+		TRect rect(glyph->iPosition, glyph->iSize);
+		rect.Intersection(clipRect);
+		if (rect.IsEmpty())
+			continue;
+		const TInt firstX = rect.iTl.iX - glyph->iPosition.iX;
+		const TInt width = rect.Width();
+		const TUint8* coverage = glyph->iCoverage + (rect.iTl.iY - glyph->iPosition.iY) * glyph->iStride;
+		for (TInt y = rect.iTl.iY; y < rect.iBr.iY; y++, coverage += glyph->iStride)
+			{
+			if (aCoverage == EGlyphCoverageGray256)
+				{
+				aDevice.WriteRgbAlphaMulti(rect.iTl.iX, y, width, aColor, coverage + firstX);
+				continue;
+				}
+			for (TInt done = 0; done < width; done += KGlyphLineWords * 32)
+				{
+				const TInt length = Min(width - done, KGlyphLineWords * 32);
+				TUint32 any = 0;
+				for (TInt word = 0; word * 32 < length; word++)
+					{
+					line[word] = ReadBits(coverage, firstX + done + word * 32, Min(32, length - word * 32));
+					any |= line[word];
+					}
+				if (any)
+					aDevice.WriteBinaryLine(rect.iTl.iX + done, y, line, length, aColor, aDrawMode);
+				}
+			}
+		}
+	}
@@ -0,0 +1,111 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWGLYPHRUN_H__
+#define __BITDRAWGLYPHRUN_H__
+
+#include "BitDrawDirectAccess.h"
+#include "BitDrawAlphaBlend.h"
+
+/**
+Format of the coverage bitmaps of a glyph run.
+@see MGlyphRunDrawing
+@internalComponent
+*/
+enum TGlyphCoverage
+	{
+	/** One bit per pixel, bit 0 of each byte leftmost, as the words passed to WriteBinary(). */
+	EGlyphCoverageMono,
+	/** One byte per pixel, used as the mask of WriteRgbAlphaMulti(). */
+	EGlyphCoverageGray256
+	};
+
+/**
+One glyph of a run: a coverage bitmap and where it goes.
+@internalComponent
+*/
+class TGlyphRunEntry
+	{
+public:
+	/** Logical position of the top-left pixel of the coverage bitmap. */
+	TPoint iPosition;
+	/** Size of the coverage bitmap in pixels; any width is allowed. */
+	TSize iSize;
+	/** First row of the coverage bitmap. */
+	const TUint8* iCoverage;
+	/** Bytes between the starts of two rows of iCoverage. */
+	TInt iStride;
+	};
+
+/**
+Batched text drawing for draw devices, retrieved with
+CFbsDrawDevice::GetInterface(KGlyphRunInterfaceID, ...).
+
+One call draws a whole run of glyphs in one colour, so that clipping, the logical to physical
+transform and the colour conversion are done once per run instead of once per glyph row.
+Mono glyphs are drawn as WriteBinary() would draw them with the same colour and draw mode.
+Gray glyphs are blended as WriteRgbAlphaMulti() would blend them; the draw mode does not apply.
+Shadowing and fading are applied as by those functions.
+Screen devices must be told about the changed area with UpdateRegion().
+@see TGlyphRun
+@internalComponent
+*/
+class MGlyphRunDrawing
+	{
+public:
+	/**
+	Draws a run of glyphs.
+	@param aGlyphs		Glyphs to draw
+	@param aCount		Number of glyphs
+	@param aCoverage	Format of the coverage bitmaps of all the glyphs
+	@param aClipRect	Logical rectangle outside which nothing is drawn
+	@param aColor		Colour of the glyphs
+	@param aDrawMode	Draw mode of mono glyphs
+	*/
+	virtual void DrawGlyphRun(const TGlyphRunEntry* aGlyphs, TInt aCount, TGlyphCoverage aCoverage,
+							  const TRect& aClipRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode) = 0;
+	};
+
+/**
+Implementations of MGlyphRunDrawing.
+
+Draw() writes into the memory layout of a device that is not scaled, in any orientation.
+Gray glyphs are blended by the TAlphaBlendSpan kernels, in place for rows that are contiguous in
+memory and through a small buffer otherwise; it supports the display modes TAlphaBlendSpan
+supports. Mono glyphs are written for opaque colours in EDrawModePEN, in display modes of 8bpp
+or more. Shadowing and fading are not applied, so a device must only use it with ENoShadow.
+
+DrawWithPrimitives() draws through the primitives of any device, one WriteBinaryLine() or
+WriteRgbAlphaMulti() call per visible glyph row, after clipping the run once.
+@internalComponent
+*/
+class TGlyphRun
+	{
+public:
+	static TBool IsSupported(const TDirectScanLineInfo& aInfo, TGlyphCoverage aCoverage,
+							 TRgb aColor, CGraphicsContext::TDrawMode aDrawMode);
+	TInt Draw(const TDirectScanLineInfo& aInfo, const TGlyphRunEntry* aGlyphs, TInt aCount, TGlyphCoverage aCoverage,
+			  const TRect& aClipRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode) const;
+	static void DrawWithPrimitives(CFbsDrawDevice& aDevice, const TGlyphRunEntry* aGlyphs, TInt aCount,
+								   TGlyphCoverage aCoverage, const TRect& aClipRect,
+								   TRgb aColor, CGraphicsContext::TDrawMode aDrawMode);
+private:
+	void BlendRow(TDisplayMode aDispMode, TUint8* aDest, TInt aXStep, TInt aBytesPerPixel,
+				  TRgb aColor, const TUint8* aMask, TInt aLength) const;
+private:
+	TAlphaBlendSpan iBlend;
+	};
+
+#endif
@@ -0,0 +1,630 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#if defined(__linux__)
+
+#include <e32atomics.h>
+#include <hal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "BitDrawHeadless.h"
+#include "BitDrawMapColors.h"
+#include "BitDrawPixelFormat.h"
+#include "BitDrawInterfaceId.h"
+#include "BitDrawScaling.h"
+#include "BitDrawOrigin.h"
+
+_LIT8(KDefaultHeadlessScreenPath, "/dev/shm/bitdraw-screen%d");
+
+__ASSERT_COMPILE(sizeof(TSharedScreenHeader) <= KSharedScreenHeaderSize);
+
+LOCAL_C TInt ErrnoToError(TInt aErrno)
+	{
+	switch (aErrno)
+		{
+	case ENOENT:
+	case ENOTDIR:
+		return KErrPathNotFound;
+	case EACCES:
+	case EPERM:
+	case EROFS:
+		return KErrAccessDenied;
+	case ENOMEM:
+		return KErrNoMemory;
+	case ENOSPC:
+		return KErrDiskFull;
+	default:
+		return KErrGeneral;
+		}
+	}
+
+/**
+Creates the screen device of a Linux hosted build.
+The pixels are mapped from /dev/shm/bitdraw-screen<aScreenNo>, and the size is taken from HAL,
+or is KDefaultHeadlessScreenWidth x KDefaultHeadlessScreenHeight if HAL does not report one.
+@param aScreenNo	Screen number
+@param aDispMode	Display mode of the screen
+@return The new device
+@leave KErrNoMemory Not enough memory, or any error from CFbsDrawDevice::NewBitmapDeviceL() or
+from opening and mapping the file
+*/
+CHeadlessScreenDevice* CHeadlessScreenDevice::NewL(TInt aScreenNo, TDisplayMode aDispMode)
+	{
+	TSize size(KDefaultHeadlessScreenWidth, KDefaultHeadlessScreenHeight);
+	TInt width;
+	TInt height;
+	if (HAL::Get(aScreenNo, HALData::EDisplayXPixels, width) == KErrNone && width > 0 &&
+		HAL::Get(aScreenNo, HALData::EDisplayYPixels, height) == KErrNone && height > 0)
+		{
+		size.SetSize(width, height);
+		}
+	TBuf8<KMaxFileName> path;
+	path.Format(KDefaultHeadlessScreenPath, aScreenNo);
+	return NewL(aScreenNo, aDispMode, size, path);
+	}
+
+/**
+Creates a headless screen device mapping the given file, which is created if needed and resized
+to hold the header and the pixels.
+@param aScreenNo	Screen number, used for HAL queries
+@param aDispMode	Display mode of the screen
+@param aSize		Size of the screen in pixels
+@param aPath		Path of the file to map, for example in /dev/shm
+@return The new device
+@leave KErrNoMemory Not enough memory, or any error from CFbsDrawDevice::NewBitmapDeviceL() or
+from opening and mapping the file
+*/
+CHeadlessScreenDevice* CHeadlessScreenDevice::NewL(TInt aScreenNo, TDisplayMode aDispMode, const TSize& aSize, const TDesC8& aPath)
+	{
+	const TInt stride = ((aSize.iWidth * BitsInMemory(aDispMode) + 31) >> 5) << 2;
+	CFbsDrawDevice* target = CFbsDrawDevice::NewBitmapDeviceL(aSize, aDispMode, stride);
+	CleanupStack::PushL(target);
+	CHeadlessScreenDevice* self = new(ELeave) CHeadlessScreenDevice(target, aScreenNo);
+	CleanupStack::Pop(target);
+	CleanupStack::PushL(self);
+	self->ConstructL(aSize, aPath);
+	CleanupStack::Pop(self);
+	return self;
+	}
+
+CHeadlessScreenDevice::CHeadlessScreenDevice(CFbsDrawDevice* aTarget, TInt aScreenNo):
+	CForwardingDrawDevice(aTarget),
+	iScreenNo(aScreenNo),
+	iOrientation(EOrientationNormal),
+	iHorzTwips(KDefaultHeadlessTwipsPerThousandPixels),
+	iVertTwips(KDefaultHeadlessTwipsPerThousandPixels),
+	iShadowMode(ENoShadow),
+	iUserDisplayMode(ENone)
+	{
+	}
+
+void CHeadlessScreenDevice::ConstructL(const TSize& aSize, const TDesC8& aPath)
+	{
+	const TDisplayMode dispMode = iTarget->DisplayMode();
+	const TInt bpp = BitsInMemory(dispMode);
+	const TInt stride = ((aSize.iWidth * bpp + 31) >> 5) << 2;
+	iMappingSize = KSharedScreenHeaderSize + stride * aSize.iHeight;
+
+	TBuf8<KMaxFileName + 1> path(aPath);
+	const int fd = open(reinterpret_cast<const char*>(path.PtrZ()), O_RDWR | O_CREAT, 0666);
+	if (fd < 0)
+		User::Leave(ErrnoToError(errno));
+	TInt err = KErrNone;
+	if (ftruncate(fd, iMappingSize) != 0)
+		err = ErrnoToError(errno);
+	else
+		{
+		void* mapping = mmap(NULL, iMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mapping == MAP_FAILED)
+			err = ErrnoToError(errno);
+		else
+			iMapping = mapping;
+		}
+	// The mapping keeps the file open.
+	close(fd);
+	User::LeaveIfError(err);
+
+	iHeader = static_cast<TSharedScreenHeader*>(iMapping);
+	iPixels = static_cast<TUint8*>(iMapping) + KSharedScreenHeaderSize;
+	iHeader->iMagic = KSharedScreenMagic;
+	iHeader->iVersion = KSharedScreenVersion;
+	iHeader->iHeaderSize = KSharedScreenHeaderSize;
+	iHeader->iWidth = aSize.iWidth;
+	iHeader->iHeight = aSize.iHeight;
+	iHeader->iStride = stride;
+	iHeader->iDisplayMode = dispMode;
+	iHeader->iBitsPerPixel = bpp;
+	iHeader->iOrientation = iOrientation;
+	iHeader->iSequence = 0;
+	iHeader->iFrameCounter = 0;
+	iHeader->iDamageCount = 0;
+	iPhysicalSize = aSize;
+	iTarget->SetBits(iPixels);
+	// Without its EColor4K or EColor64K table, ShadowArea() processes pixels one at a time.
+	iShadowFade.Create(dispMode);
+
+	TInt xPixels;
+	TInt yPixels;
+	TInt xTwips;
+	TInt yTwips;
+	if (HAL::Get(iScreenNo, HALData::EDisplayXPixels, xPixels) == KErrNone && xPixels > 0 &&
+		HAL::Get(iScreenNo, HALData::EDisplayYPixels, yPixels) == KErrNone && yPixels > 0 &&
+		HAL::Get(iScreenNo, HALData::EDisplayXTwips, xTwips) == KErrNone &&
+		HAL::Get(iScreenNo, HALData::EDisplayYTwips, yTwips) == KErrNone)
+		{
+		iHorzTwips = TInt(TInt64(xTwips) * 1000 / xPixels);
+		iVertTwips = TInt(TInt64(yTwips) * 1000 / yPixels);
+		}
+	}
+
+/**
+Unmaps the frame buffer. The file is kept, with the last frame in it.
+*/
+CHeadlessScreenDevice::~CHeadlessScreenDevice()
+	{
+	if (iMapping)
+		munmap(iMapping, iMappingSize);
+	iInversePalette.Close();
+	iShadowFade.Close();
+	}
+
+/**
+Sets the values returned by HorzTwipsPerThousandPixels() and VertTwipsPerThousandPixels().
+@param aHorzTwips	Width of a thousand pixels in twips
+@param aVertTwips	Height of a thousand pixels in twips
+@panic EScreenDriverPanicInvalidParameter if either value is not positive
+*/
+void CHeadlessScreenDevice::SetTwipsPerThousandPixels(TInt aHorzTwips, TInt aVertTwips)
+	{
+	__ASSERT_ALWAYS(aHorzTwips > 0 && aVertTwips > 0, Panic(EScreenDriverPanicInvalidParameter));
+	iHorzTwips = aHorzTwips;
+	iVertTwips = aVertTwips;
+	}
+
+/**
+Describes the mapped pixels. Only available in the normal orientation, unless the bitmap device
+drawing into them reports its own layout. The scaling and origin are those of the bitmap device,
+and the stride and size follow SwapWidthAndHeight(), so they may differ from the header.
+*/
+TInt CHeadlessScreenDevice::GetScanLineInfo(TDirectScanLineInfo& aInfo) const
+	{
+	if (iOrientation != EOrientationNormal)
+		return KErrNotSupported;
+	aInfo.iBits = iPixels;
+	aInfo.iStride = iTarget->ScanLineBytes();
+	aInfo.iDisplayMode = TDisplayMode(iHeader->iDisplayMode);
+	aInfo.iBitsPerPixel = iHeader->iBitsPerPixel;
+	aInfo.iPhysicalSize = iPhysicalSize;
+	aInfo.iOrientation = EOrientationNormal;
+	aInfo.iPhysicalOrigin.SetXY(0, 0);
+	aInfo.iLogicalXStep.SetXY(1, 0);
+	aInfo.iLogicalYStep.SetXY(0, 1);
+	aInfo.iFactorX = 1;
+	aInfo.iFactorY = 1;
+	// The settings are asked for every time, as SetDisplayMode() and SwapWidthAndHeight() change them too.
+	TAny* interface = NULL;
+	if (iTarget->GetInterface(KDrawDeviceOriginInterfaceID, interface) == KErrNone)
+		static_cast<MDrawDeviceOrigin*>(interface)->Get(aInfo.iPhysicalOrigin);
+	if (iTarget->GetInterface(KScalingSettingsInterfaceID, interface) == KErrNone)
+		{
+		TInt divisorX;
+		TInt divisorY;
+		static_cast<MScalingSettings*>(interface)->Get(aInfo.iFactorX, aInfo.iFactorY, divisorX, divisorY);
+		}
+	return KErrNone;
+	}
+
+TInt CHeadlessScreenDevice::WriteBlock(const TRect& aRect, const TAny* aBuffer, TInt aStride)
+	{
+	TDirectScanLineInfo info;
+	if (!GetLayout(info))
+		return KErrNotSupported;
+	return TRotatedBlock::WriteBlock(info, aRect, aBuffer, aStride);
+	}
+
+TInt CHeadlessScreenDevice::ReadBlock(const TRect& aRect, TAny* aBuffer, TInt aStride) const
+	{
+	TDirectScanLineInfo info;
+	if (!GetLayout(info))
+		return KErrNotSupported;
+	return TRotatedBlock::ReadBlock(info, aRect, aBuffer, aStride);
+	}
+
+TInt CHeadlessScreenDevice::WriteBinaryBlockVertical(TInt aX, TInt aY, const TUint32* aBuffer, TInt aColumnWords,
+													 TInt aWidth, TInt aHeight, TRgb aColor, TBool aUp)
+	{
+	TDirectScanLineInfo info;
+	if (!GetLayout(info))
+		return KErrNotSupported;
+	return TRotatedBlock::WriteBinaryBlockVertical(info, aX, aY, aBuffer, aColumnWords, aWidth, aHeight,
+												   RDrawColorMap::RgbToPixel(info.iDisplayMode, aColor), aUp);
+	}
+
+void CHeadlessScreenDevice::DrawGlyphRun(const TGlyphRunEntry* aGlyphs, TInt aCount, TGlyphCoverage aCoverage,
+										 const TRect& aClipRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TDirectScanLineInfo info;
+	if (!WritesDirect(info) ||
+		iGlyphRun.Draw(info, aGlyphs, aCount, aCoverage, aClipRect, aColor, aDrawMode) != KErrNone)
+		{
+		TGlyphRun::DrawWithPrimitives(*iTarget, aGlyphs, aCount, aCoverage, aClipRect, aColor, aDrawMode);
+		}
+	}
+
+void CHeadlessScreenDevice::WriteRgbAlphaLinePremultiplied(TInt aX, TInt aY, TInt aLength, const TUint32* aPixels)
+	{
+	TDirectScanLineInfo info;
+	if (!WritesDirect(info) || iPremultiplied.Write(info, aX, aY, aLength, aPixels) != KErrNone)
+		TPremultipliedLine::WriteWithPrimitives(*iTarget, aX, aY, aLength, aPixels);
+	}
+
+void CHeadlessScreenDevice::WritePoints(const TPoint* aPoints, TInt aCount, const TRect& aClipRect,
+										TRgb aColor, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TDirectScanLineInfo info;
+	if (!WritesDirect(info) ||
+		TBatchedPlot::WritePoints(info, aPoints, aCount, &aColor, 0, aClipRect, aDrawMode) != KErrNone)
+		{
+		TBatchedPlot::WritePointsWithPrimitives(*iTarget, aPoints, aCount, &aColor, 0, aClipRect, aDrawMode);
+		}
+	}
+
+void CHeadlessScreenDevice::WritePoints(const TPoint* aPoints, const TRgb* aColors, TInt aCount, const TRect& aClipRect,
+										CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TDirectScanLineInfo info;
+	if (!WritesDirect(info) ||
+		TBatchedPlot::WritePoints(info, aPoints, aCount, aColors, 1, aClipRect, aDrawMode) != KErrNone)
+		{
+		TBatchedPlot::WritePointsWithPrimitives(*iTarget, aPoints, aCount, aColors, 1, aClipRect, aDrawMode);
+		}
+	}
+
+void CHeadlessScreenDevice::WriteSpans(const TPlotSpan* aSpans, TInt aCount, const TRect& aClipRect,
+									   TRgb aColor, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TDirectScanLineInfo info;
+	if (!WritesDirect(info) ||
+		TBatchedPlot::WriteSpans(info, aSpans, aCount, &aColor, 0, aClipRect, aDrawMode) != KErrNone)
+		{
+		TBatchedPlot::WriteSpansWithPrimitives(*iTarget, aSpans, aCount, &aColor, 0, aClipRect, aDrawMode);
+		}
+	}
+
+void CHeadlessScreenDevice::WriteSpans(const TPlotSpan* aSpans, const TRgb* aColors, TInt aCount, const TRect& aClipRect,
+									   CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TDirectScanLineInfo info;
+	if (!WritesDirect(info) ||
+		TBatchedPlot::WriteSpans(info, aSpans, aCount, aColors, 1, aClipRect, aDrawMode) != KErrNone)
+		{
+		TBatchedPlot::WriteSpansWithPrimitives(*iTarget, aSpans, aCount, aColors, 1, aClipRect, aDrawMode);
+		}
+	}
+
+/**
+Reading does not depend on the shadow mode or user display mode, so only the layout is needed.
+*/
+void CHeadlessScreenDevice::ReadPixels(const TPoint* aPoints, TInt aCount, TRgb* aColors) const
+	{
+	TDirectScanLineInfo info;
+	if (!GetLayout(info) || TBatchedPlot::ReadPixels(info, aPoints, aCount, aColors) != KErrNone)
+		TBatchedPlot::ReadPixelsWithPrimitives(*iTarget, aPoints, aCount, aColors);
+	}
+
+/**
+The lookup structure is built once for the whole of aRect.
+*/
+void CHeadlessScreenDevice::MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards)
+	{
+	TDirectScanLineInfo info;
+	if (!GetLayout(info) || !info.IsDirect())
+		{
+		iTarget->MapColors(aRect, aColors, aNumPairs, aMapForwards);
+		return;
+		}
+	if (aRect.IsEmpty())
+		return;
+	// Ownership of the copy of the palette is passed by GetCustomPalette().
+	CPalette* palette = NULL;
+	const RInversePalette* inversePalette = NULL;
+	if (info.iDisplayMode == EColor256 && iTarget->GetCustomPalette(palette) == KErrNone)
+		{
+		// Without its cells the inverse lookup compares against every entry, as the palette does.
+		if (iInversePalette.Create(*palette) != KErrNotSupported)
+			inversePalette = &iInversePalette;
+		delete palette;
+		}
+	RDrawColorMap map;
+	// The map compares every pixel against every pair if its lookup structure cannot be allocated.
+	map.Create(info.iDisplayMode, aColors, aNumPairs, aMapForwards, aRect.Width() * aRect.Height(), inversePalette);
+	const TPoint topLeft(info.LogicalToPhysical(aRect.iTl));
+	for (TInt y = 0; y < aRect.Height(); y++)
+		map.MapLine(info.RowAddress(topLeft.iY + y), topLeft.iX, aRect.Width());
+	map.Close();
+	}
+
+TInt CHeadlessScreenDevice::HorzTwipsPerThousandPixels() const
+	{
+	return iHorzTwips;
+	}
+
+TInt CHeadlessScreenDevice::VertTwipsPerThousandPixels() const
+	{
+	return iVertTwips;
+	}
+
+/**
+Damage collected before the change is published first, in the orientation it was drawn in.
+*/
+TBool CHeadlessScreenDevice::SetOrientation(TOrientation aOrientation)
+	{
+	Publish();
+	if (!iTarget->SetOrientation(aOrientation))
+		return EFalse;
+	iOrientation = aOrientation;
+	__e32_atomic_store_rel32(&iHeader->iOrientation, aOrientation);
+	return ETrue;
+	}
+
+void CHeadlessScreenDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TDirectScanLineInfo info;
+	if (aDrawMode == CGraphicsContext::EDrawModePEN && DrawsDirect(info))
+		{
+		TAny* dest = info.PixelAddress(aX, aY);
+		iBlend.BlendLine(info.iDisplayMode, dest, aRgbBuffer, dest, aMaskBuffer, aLength);
+		}
+	else
+		iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer, aMaskBuffer, aDrawMode);
+	}
+
+/**
+Sets or unsets auto-update. With auto-update on, every UpdateRegion() call publishes a frame.
+@param aValue ETrue, if the screen is set to auto-update; EFalse, otherwise.
+*/
+void CHeadlessScreenDevice::SetAutoUpdate(TBool aValue)
+	{
+	iAutoUpdate = aValue;
+	}
+
+/**
+Ignored: the pixels are always the mapped frame buffer.
+*/
+void CHeadlessScreenDevice::SetBits(TAny* /*aBits*/)
+	{
+	}
+
+/**
+The shadow mode, user display mode and fading parameters taken from aDrawDevice are not known.
+*/
+void CHeadlessScreenDevice::SetDisplayMode(CFbsDrawDevice* aDrawDevice)
+	{
+	iTarget->SetDisplayMode(aDrawDevice);
+	iUnknownSettings = EUnknownShadowMode | EUnknownUserDisplayMode | EUnknownFadingParameters;
+	}
+
+void CHeadlessScreenDevice::SetUserDisplayMode(TDisplayMode aDisplayMode)
+	{
+	iTarget->SetUserDisplayMode(aDisplayMode);
+	iUserDisplayMode = aDisplayMode;
+	iUnknownSettings &= ~EUnknownUserDisplayMode;
+	}
+
+void CHeadlessScreenDevice::SetShadowMode(TShadowMode aShadowMode)
+	{
+	iTarget->SetShadowMode(aShadowMode);
+	iShadowMode = aShadowMode;
+	iShadowFade.SetShadowMode(aShadowMode);
+	iUnknownSettings &= ~EUnknownShadowMode;
+	}
+
+void CHeadlessScreenDevice::SetFadingParameters(TUint8 aBlackMap,TUint8 aWhiteMap)
+	{
+	iTarget->SetFadingParameters(aBlackMap, aWhiteMap);
+	iShadowFade.SetFadingParameters(aBlackMap, aWhiteMap);
+	iUnknownSettings &= ~EUnknownFadingParameters;
+	}
+
+/**
+The rows of the mapped memory are processed in place while logical rows are physical rows.
+*/
+void CHeadlessScreenDevice::ShadowArea(const TRect& aRect)
+	{
+	TDirectScanLineInfo info;
+	if ((iUnknownSettings & (EUnknownShadowMode | EUnknownFadingParameters)) ||
+		!GetLayout(info) || !info.IsDirect())
+		{
+		iTarget->ShadowArea(aRect);
+		return;
+		}
+	if (aRect.IsEmpty())
+		return;
+	const TPoint topLeft(info.LogicalToPhysical(aRect.iTl));
+	for (TInt y = 0; y < aRect.Height(); y++)
+		iShadowFade.ShadowLine(info.RowAddress(topLeft.iY + y), topLeft.iX, aRect.Width());
+	}
+
+/**
+Publishes the area reported with UpdateRegion() since the last update as a new frame.
+*/
+void CHeadlessScreenDevice::Update()
+	{
+	Publish();
+	}
+
+/**
+Publishes aRegion, together with the area reported with UpdateRegion(), as a new frame.
+@param aRegion Region to update (logical coordinates)
+*/
+void CHeadlessScreenDevice::Update(const TRegion& aRegion)
+	{
+	const TRect* rect = aRegion.RectangleList();
+	for (TInt count = aRegion.Count(); count > 0; count--, rect++)
+		iDamage.AddRect(*rect);
+	Publish();
+	}
+
+/**
+Adds aRect to the area published by the next update.
+@param aRect Rectangle to update (logical coordinates)
+*/
+void CHeadlessScreenDevice::UpdateRegion(const TRect& aRect)
+	{
+	iDamage.AddRect(aRect);
+	if (iAutoUpdate)
+		Publish();
+	}
+
+void CHeadlessScreenDevice::WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer)
+	{
+	TDirectScanLineInfo info;
+	if (DrawsDirect(info))
+		iBlend.BlendColor(info.iDisplayMode, info.PixelAddress(aX, aY), aColor, aMaskBuffer, aLength);
+	else
+		iTarget->WriteRgbAlphaMulti(aX, aY, aLength, aColor, aMaskBuffer);
+	}
+
+void CHeadlessScreenDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+											  const TUint8* aRgbBuffer1,
+											  const TUint8* aBuffer2,
+											  const TUint8* aMaskBuffer,
+											  CGraphicsContext::TDrawMode aDrawMode)
+	{
+	TDirectScanLineInfo info;
+	// aBuffer2 is in ScanLineDisplayMode() format, and the kernels take it in the display mode.
+	if (aDrawMode == CGraphicsContext::EDrawModePEN && DrawsDirect(info) &&
+		iTarget->ScanLineDisplayMode() == info.iDisplayMode)
+		{
+		iBlend.BlendLine(info.iDisplayMode, info.PixelAddress(aX, aY), aRgbBuffer1, aBuffer2, aMaskBuffer, aLength);
+		}
+	else
+		iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer1, aBuffer2, aMaskBuffer, aDrawMode);
+	}
+
+/**
+The bitmap device's own interfaces are preferred, as they describe every orientation and know
+its settings.
+*/
+TInt CHeadlessScreenDevice::GetInterface(TInt aInterfaceId, TAny*& aInterface)
+	{
+	const TInt err = iTarget->GetInterface(aInterfaceId, aInterface);
+	if (err == KErrNone)
+		return err;
+	switch (aInterfaceId)
+		{
+	case KDirectScanLineAccessInterfaceID:
+		aInterface = static_cast<MDirectScanLineAccess*>(this);
+		return KErrNone;
+	case KBlockAccessInterfaceID:
+		aInterface = static_cast<MBlockAccess*>(this);
+		return KErrNone;
+	case KGlyphRunInterfaceID:
+		aInterface = static_cast<MGlyphRunDrawing*>(this);
+		return KErrNone;
+	case KPremultipliedAlphaInterfaceID:
+		aInterface = static_cast<MPremultipliedAlphaBlending*>(this);
+		return KErrNone;
+	case KBatchedPlottingInterfaceID:
+		aInterface = static_cast<MBatchedPlotting*>(this);
+		return KErrNone;
+	default:
+		return err;
+		}
+	}
+
+/**
+Damage collected before the swap is published first, in the size it was drawn in. The bitmap device
+lays the mapped memory out again with the new width.
+*/
+void CHeadlessScreenDevice::SwapWidthAndHeight()
+	{
+	Publish();
+	const TSize size(iTarget->SizeInPixels());
+	iTarget->SwapWidthAndHeight();
+	if (iTarget->SizeInPixels() != size)
+		iPhysicalSize.SetSize(iPhysicalSize.iHeight, iPhysicalSize.iWidth);
+	}
+
+/**
+Gets the layout of the pixels from the bitmap device if it reports one, and from the mapping
+otherwise.
+@return ETrue if the layout is available.
+*/
+TBool CHeadlessScreenDevice::GetLayout(TDirectScanLineInfo& aInfo) const
+	{
+	return TDirectScanLine::Get(*iTarget, aInfo) || GetScanLineInfo(aInfo) == KErrNone;
+	}
+
+/**
+@return ETrue if no shadowing, fading or user display mode is set, so drawing can write straight
+into the pixels, and their layout is available in aInfo.
+*/
+TBool CHeadlessScreenDevice::WritesDirect(TDirectScanLineInfo& aInfo) const
+	{
+	if ((iUnknownSettings & (EUnknownShadowMode | EUnknownUserDisplayMode)) || iShadowMode != ENoShadow ||
+		(iUserDisplayMode != ENone && iUserDisplayMode != iTarget->DisplayMode()))
+		{
+		return EFalse;
+		}
+	return GetLayout(aInfo);
+	}
+
+/**
+@return ETrue if the alpha blending primitives can blend straight into the pixels, whose layout
+is then in aInfo.
+*/
+TBool CHeadlessScreenDevice::DrawsDirect(TDirectScanLineInfo& aInfo) const
+	{
+	return WritesDirect(aInfo) && aInfo.IsDirect() && TAlphaBlendSpan::IsDisplayModeSupported(aInfo.iDisplayMode);
+	}
+
+/**
+Writes the collected damage and a new frame counter to the header, under iSequence.
+Does nothing if nothing was reported since the last frame.
+*/
+void CHeadlessScreenDevice::Publish()
+	{
+	if (iDamage.IsEmpty())
+		return;
+	const TUint32 sequence = iHeader->iSequence;
+	__e32_atomic_store_ord32(&iHeader->iSequence, sequence + 1);
+	const TRect* rect = iDamage.RectangleList();
+	const TInt count = iDamage.Count();
+	for (TInt index = 0; index < count; index++, rect++)
+		{
+		iHeader->iDamage[index][0] = rect->iTl.iX;
+		iHeader->iDamage[index][1] = rect->iTl.iY;
+		iHeader->iDamage[index][2] = rect->iBr.iX;
+		iHeader->iDamage[index][3] = rect->iBr.iY;
+		}
+	iHeader->iDamageCount = count;
+	iHeader->iFrameCounter++;
+	__e32_atomic_store_rel32(&iHeader->iSequence, sequence + 2);
+	iDamage.Clear();
+	}
+
+/**
+Linux hosted builds have no display; their screens are headless.
+@see CHeadlessScreenDevice
+*/
+EXPORT_C CFbsDrawDevice* CFbsDrawDevice::NewScreenDeviceL(TInt aScreenNo, TDisplayMode aDispMode)
+	{
+	return CHeadlessScreenDevice::NewL(aScreenNo, aDispMode);
+	}
+
+#endif // __linux__
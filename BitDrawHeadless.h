@@ -0,0 +1,258 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWHEADLESS_H__
+#define __BITDRAWHEADLESS_H__
+
+#include "BitDrawForwarding.h"
+#include "BitDrawDamage.h"
+#include "BitDrawDirectAccess.h"
+#include "BitDrawAlphaBlend.h"
+#include "BitDrawRotatedBlock.h"
+#include "BitDrawGlyphRun.h"
+#include "BitDrawPremultiplied.h"
+#include "BitDrawBatched.h"
+#include "BitDrawPalette.h"
+#include "BitDrawShadowFade.h"
+
+/**
+Size in bytes of the header at the start of a shared frame buffer. The pixels follow it,
+so they start on a page boundary.
+@internalComponent
+*/
+const TInt KSharedScreenHeaderSize = 4096;
+
+/**
+Value of TSharedScreenHeader::iMagic: "BDFB" in memory order.
+@internalComponent
+*/
+const TUint32 KSharedScreenMagic = 0x42464442;
+
+/**
+Layout version of TSharedScreenHeader.
+@internalComponent
+*/
+const TUint32 KSharedScreenVersion = 1;
+
+/**
+Size of the screen created by CHeadlessScreenDevice::NewL(TInt, TDisplayMode) when HAL does not
+report one.
+@internalComponent
+*/
+const TInt KDefaultHeadlessScreenWidth = 640;
+const TInt KDefaultHeadlessScreenHeight = 480;
+
+/**
+Twips per thousand pixels reported when HAL does not report the size of the display: 96 pixels
+per inch.
+@internalComponent
+*/
+const TInt KDefaultHeadlessTwipsPerThousandPixels = 15000;
+
+/**
+Header of a shared frame buffer, at offset 0 of the mapped file. All fields are in the byte order
+of the host.
+
+The pixel layout fields are written once, when the device is created. The frame fields are
+protected by iSequence: it is odd while the device is writing them. A reader copies iSequence,
+waits for it to be even, copies the frame fields, then reads iSequence again and retries if it
+changed. Pixels are written while drawing and are not covered by iSequence.
+@see CHeadlessScreenDevice
+@internalComponent
+*/
+class TSharedScreenHeader
+	{
+public:
+	/** KSharedScreenMagic. */
+	TUint32 iMagic;
+	/** KSharedScreenVersion. */
+	TUint32 iVersion;
+	/** Offset of the first row of pixels from the start of the file. */
+	TUint32 iHeaderSize;
+	/** Size of the pixel memory in physical pixels. */
+	TInt32 iWidth;
+	TInt32 iHeight;
+	/** Bytes between the starts of two rows. */
+	TInt32 iStride;
+	/** TDisplayMode of the pixels. */
+	TInt32 iDisplayMode;
+	/** Bits a pixel takes in memory: 16 for EColor4K. */
+	TInt32 iBitsPerPixel;
+	/** CFbsDrawDevice::TOrientation the damage rectangles are expressed in. */
+	TInt32 iOrientation;
+	/** Odd while the frame fields below are being written. */
+	TUint32 iSequence;
+	/** Number of frames published with Update(). */
+	TUint32 iFrameCounter;
+	/** Number of valid entries in iDamage. */
+	TInt32 iDamageCount;
+	/** Area updated by the last frame: left, top, right, bottom, in logical coordinates. */
+	TInt32 iDamage[KMaxDamageRects][4];
+	};
+
+/**
+Screen device whose pixels live in a memory mapped file, typically in /dev/shm, so that other
+processes can sample frames without copying them. Used as the screen device of Linux hosted
+builds, where there is no display: drawing is done by the bitmap device of the same display mode,
+on the mapped memory.
+
+UpdateRegion() collects the damaged area; Update() publishes it in the header together with a new
+frame counter. With auto-update on, every UpdateRegion() call publishes a frame.
+The file is left in place when the device is destroyed.
+
+The display size and twips come from HAL for the screen number, if available; the twips can be
+overridden with SetTwipsPerThousandPixels().
+
+While logical rows are physical rows and no shadowing, fading or user display mode is set,
+WriteRgbAlphaLine() in EDrawModePEN and WriteRgbAlphaMulti() blend straight into the mapped
+memory with the TAlphaBlendSpan kernels, for the display modes those support. Any other case
+goes to the bitmap device. After SetDisplayMode() the settings taken from the other device are not
+known, so the kernels are only used again once SetShadowMode() and SetUserDisplayMode() have been
+called. MapColors() maps the rows of the mapped memory in place with RDrawColorMap in the same
+case, whatever the settings; in EColor256 the custom palette of the bitmap device is looked up
+with an RInversePalette, which is only built again when the palette changes. ShadowArea() shadows
+and fades those rows in place with RShadowFadeTables once the shadow mode and fading parameters
+are known.
+
+The layout of the mapped memory given to these follows the scaling, origin and swapped size of the
+bitmap device, so logical coordinates are mapped the way the bitmap device maps them.
+
+If the bitmap device does not offer MBlockAccess, the device offers it itself with TRotatedBlock,
+on the layout reported by the bitmap device, or on the mapping in the normal orientation. Its
+functions return KErrNotSupported while neither layout is available.
+
+Likewise, if the bitmap device does not offer them, the device offers MGlyphRunDrawing,
+MPremultipliedAlphaBlending and MBatchedPlotting itself. They write into the mapped memory with
+TGlyphRun, TPremultipliedLine and TBatchedPlot when the layout and settings allow it, as for the
+alpha blending primitives but in any orientation, and go through the primitives of the bitmap
+device otherwise.
+@internalComponent
+*/
+class CHeadlessScreenDevice : public CForwardingDrawDevice, public MDirectScanLineAccess, public MBlockAccess,
+							  public MGlyphRunDrawing, public MPremultipliedAlphaBlending, public MBatchedPlotting
+	{
+public:
+	static CHeadlessScreenDevice* NewL(TInt aScreenNo, TDisplayMode aDispMode);
+	static CHeadlessScreenDevice* NewL(TInt aScreenNo, TDisplayMode aDispMode, const TSize& aSize, const TDesC8& aPath);
+	~CHeadlessScreenDevice();
+	void SetTwipsPerThousandPixels(TInt aHorzTwips, TInt aVertTwips);
+	inline const TSharedScreenHeader& Header() const;
+	inline TInt ScreenNo() const;
+public: // From MDirectScanLineAccess
+	TInt GetScanLineInfo(TDirectScanLineInfo& aInfo) const;
+public: // From MBlockAccess
+	TInt WriteBlock(const TRect& aRect, const TAny* aBuffer, TInt aStride);
+	TInt ReadBlock(const TRect& aRect, TAny* aBuffer, TInt aStride) const;
+	TInt WriteBinaryBlockVertical(TInt aX, TInt aY, const TUint32* aBuffer, TInt aColumnWords,
+								  TInt aWidth, TInt aHeight, TRgb aColor, TBool aUp);
+public: // From MGlyphRunDrawing
+	void DrawGlyphRun(const TGlyphRunEntry* aGlyphs, TInt aCount, TGlyphCoverage aCoverage,
+					  const TRect& aClipRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode);
+public: // From MPremultipliedAlphaBlending
+	void WriteRgbAlphaLinePremultiplied(TInt aX, TInt aY, TInt aLength, const TUint32* aPixels);
+public: // From MBatchedPlotting
+	void WritePoints(const TPoint* aPoints, TInt aCount, const TRect& aClipRect,
+					 TRgb aColor, CGraphicsContext::TDrawMode aDrawMode);
+	void WritePoints(const TPoint* aPoints, const TRgb* aColors, TInt aCount, const TRect& aClipRect,
+					 CGraphicsContext::TDrawMode aDrawMode);
+	void WriteSpans(const TPlotSpan* aSpans, TInt aCount, const TRect& aClipRect,
+					TRgb aColor, CGraphicsContext::TDrawMode aDrawMode);
+	void WriteSpans(const TPlotSpan* aSpans, const TRgb* aColors, TInt aCount, const TRect& aClipRect,
+					CGraphicsContext::TDrawMode aDrawMode);
+	void ReadPixels(const TPoint* aPoints, TInt aCount, TRgb* aColors) const;
+public: // From CFbsDrawDevice
+	void MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards);
+	TInt HorzTwipsPerThousandPixels() const;
+	TInt VertTwipsPerThousandPixels() const;
+	TBool SetOrientation(TOrientation aOrientation);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode);
+	void SetAutoUpdate(TBool aValue);
+	void SetBits(TAny* aBits);
+	void SetDisplayMode(CFbsDrawDevice* aDrawDevice);
+	void SetUserDisplayMode(TDisplayMode aDisplayMode);
+	void SetShadowMode(TShadowMode aShadowMode);
+	void SetFadingParameters(TUint8 aBlackMap,TUint8 aWhiteMap);
+	void ShadowArea(const TRect& aRect);
+	void Update();
+	void Update(const TRegion& aRegion);
+	void UpdateRegion(const TRect& aRect);
+	void WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+						   const TUint8* aRgbBuffer1,
+						   const TUint8* aBuffer2,
+						   const TUint8* aMaskBuffer,
+						   CGraphicsContext::TDrawMode aDrawMode);
+	TInt GetInterface(TInt aInterfaceId, TAny*& aInterface);
+	void SwapWidthAndHeight();
+private:
+	/**
+	Settings that are not known after SetDisplayMode(), until they are set again.
+	*/
+	enum TUnknownSetting
+		{
+		EUnknownShadowMode = 0x01,
+		EUnknownUserDisplayMode = 0x02,
+		EUnknownFadingParameters = 0x04
+		};
+private:
+	CHeadlessScreenDevice(CFbsDrawDevice* aTarget, TInt aScreenNo);
+	void ConstructL(const TSize& aSize, const TDesC8& aPath);
+	void Publish();
+	TBool GetLayout(TDirectScanLineInfo& aInfo) const;
+	TBool WritesDirect(TDirectScanLineInfo& aInfo) const;
+	TBool DrawsDirect(TDirectScanLineInfo& aInfo) const;
+private:
+	TInt iScreenNo;
+	TAny* iMapping;
+	TInt iMappingSize;
+	TSharedScreenHeader* iHeader;
+	TUint8* iPixels;
+	/** Size of the mapped pixels in physical pixels, swapped by SwapWidthAndHeight(). */
+	TSize iPhysicalSize;
+	TDamageRegionFix<KMaxDamageRects> iDamage;
+	TBool iAutoUpdate;
+	TOrientation iOrientation;
+	TInt iHorzTwips;
+	TInt iVertTwips;
+	TShadowMode iShadowMode;
+	TDisplayMode iUserDisplayMode;
+	/** TUnknownSetting flags. */
+	TUint iUnknownSettings;
+	TAlphaBlendSpan iBlend;
+	TGlyphRun iGlyphRun;
+	TPremultipliedLine iPremultiplied;
+	/** Inverse lookup of the custom palette of the bitmap device, kept across MapColors() calls. */
+	RInversePalette iInversePalette;
+	/** Shadow mode and fading parameters applied by ShadowArea(). */
+	RShadowFadeTables iShadowFade;
+	};
+
+/**
+@return The header of the shared frame buffer.
+*/
+inline const TSharedScreenHeader& CHeadlessScreenDevice::Header() const
+	{
+	return *iHeader;
+	}
+
+/**
+@return The screen number the device was created for.
+*/
+inline TInt CHeadlessScreenDevice::ScreenNo() const
+	{
+	return iScreenNo;
+	}
+
+#endif
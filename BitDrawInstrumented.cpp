@@ -0,0 +1,291 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include <hal.h>
+#include "BitDrawInstrumented.h"
+
+/** Set in every used key, so that 0 marks an empty slot. */
+const TUint32 KKeyUsed = 0x80000000;
+const TUint32 KHashMultiplier = 0x9e3779b1;
+/** log2(KMaxDrawCounters) */
+const TInt KHashBits = 8;
+/** Entries used before new combinations go to the overflow counters, to keep probing short. */
+const TInt KMaxUsedEntries = KMaxDrawCounters * 3 / 4;
+
+__ASSERT_COMPILE(KMaxDrawCounters == 1 << KHashBits);
+
+/**
+Wraps an existing draw device. Counting is disabled until SetCountersEnabled(ETrue) is called.
+@param aTarget Device to instrument. Ownership is transferred if the function does not leave.
+@return The new device
+@leave KErrNoMemory Not enough memory
+*/
+CInstrumentedDrawDevice* CInstrumentedDrawDevice::NewL(CFbsDrawDevice* aTarget)
+	{
+	return new(ELeave) CInstrumentedDrawDevice(aTarget);
+	}
+
+CInstrumentedDrawDevice::CInstrumentedDrawDevice(CFbsDrawDevice* aTarget):
+	CForwardingDrawDevice(aTarget),
+	iCountsUp(ETrue)
+	{
+	if (HAL::Get(HALData::EFastCounterFrequency, iFrequency) != KErrNone || iFrequency <= 0)
+		iFrequency = 1000000;
+	TInt countsUp;
+	if (HAL::Get(HALData::EFastCounterCountsUp, countsUp) == KErrNone)
+		iCountsUp = countsUp;
+	}
+
+void CInstrumentedDrawDevice::SetCountersEnabled(TBool aEnabled)
+	{
+	iEnabled = aEnabled;
+	}
+
+TBool CInstrumentedDrawDevice::CountersEnabled() const
+	{
+	return iEnabled;
+	}
+
+TInt CInstrumentedDrawDevice::GetCounters(RArray<TDrawCounter>& aCounters) const
+	{
+	aCounters.Reset();
+	const TInt numEntries = KMaxDrawCounters + EDrawPrimitiveCount;
+	for (TInt index = 0; index < numEntries; index++)
+		{
+		const TBool overflow = index >= KMaxDrawCounters;
+		const TEntry& entry = overflow ? iOverflow[index - KMaxDrawCounters] : iEntries[index];
+		if (entry.iCalls == 0)
+			continue;
+		TDrawCounter counter;
+		if (overflow)
+			{
+			counter.iPrimitive = TDrawPrimitive(index - KMaxDrawCounters);
+			counter.iDrawMode = CGraphicsContext::TDrawMode(0);
+			counter.iDisplayMode = ENone;
+			}
+		else
+			{
+			counter.iPrimitive = TDrawPrimitive(entry.iKey & 0xff);
+			counter.iDrawMode = CGraphicsContext::TDrawMode((entry.iKey >> 8) & 0xff);
+			counter.iDisplayMode = TDisplayMode((entry.iKey >> 16) & 0xff);
+			}
+		counter.iCalls = entry.iCalls;
+		counter.iPixels = entry.iPixels;
+		counter.iMicroSeconds = entry.iTicks * 1000000 / iFrequency;
+		const TInt err = aCounters.Append(counter);
+		if (err != KErrNone)
+			return err;
+		}
+	return KErrNone;
+	}
+
+void CInstrumentedDrawDevice::ResetCounters()
+	{
+	Mem::FillZ(iEntries, sizeof(iEntries));
+	Mem::FillZ(iOverflow, sizeof(iOverflow));
+	iUsed = 0;
+	}
+
+/**
+Adds one call to the counters of its combination.
+@param aStart Value of User::FastCounter() before the call was forwarded
+*/
+void CInstrumentedDrawDevice::Record(TDrawPrimitive aPrimitive, TInt aDrawMode, TDisplayMode aDispMode, TInt64 aPixels, TUint32 aStart)
+	{
+	const TUint32 now = User::FastCounter();
+	const TUint32 ticks = iCountsUp ? now - aStart : aStart - now;
+	const TUint32 key = KKeyUsed | aPrimitive | (TUint32(aDrawMode & 0xff) << 8) | (TUint32(aDispMode & 0xff) << 16);
+	TUint32 slot = (key * KHashMultiplier) >> (32 - KHashBits);
+	TEntry* entry;
+	FOREVER
+		{
+		entry = &iEntries[slot];
+		if (entry->iKey == key)
+			break;
+		if (entry->iKey == 0)
+			{
+			if (iUsed >= KMaxUsedEntries)
+				{
+				entry = &iOverflow[aPrimitive];
+				break;
+				}
+			entry->iKey = key;
+			iUsed++;
+			break;
+			}
+		slot = (slot + 1) & (KMaxDrawCounters - 1);
+		}
+	entry->iCalls++;
+	entry->iPixels += aPixels;
+	entry->iTicks += ticks;
+	}
+
+void CInstrumentedDrawDevice::MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards)
+	{
+	if (!iEnabled)
+		{
+		iTarget->MapColors(aRect, aColors, aNumPairs, aMapForwards);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->MapColors(aRect, aColors, aNumPairs, aMapForwards);
+	Record(EPrimitiveMapColors, 0, iTarget->DisplayMode(), TInt64(aRect.Width()) * aRect.Height(), start);
+	}
+
+void CInstrumentedDrawDevice::ReadLine(TInt aX,TInt aY,TInt aLength,TAny* aBuffer,TDisplayMode aDispMode) const
+	{
+	if (!iEnabled)
+		{
+		iTarget->ReadLine(aX, aY, aLength, aBuffer, aDispMode);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->ReadLine(aX, aY, aLength, aBuffer, aDispMode);
+	const_cast<CInstrumentedDrawDevice*>(this)->Record(EPrimitiveReadLine, 0, aDispMode, aLength, start);
+	}
+
+void CInstrumentedDrawDevice::WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!iEnabled)
+		{
+		iTarget->WriteBinary(aX, aY, aBuffer, aLength, aHeight, aColor, aDrawMode);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->WriteBinary(aX, aY, aBuffer, aLength, aHeight, aColor, aDrawMode);
+	Record(EPrimitiveWriteBinary, aDrawMode, iTarget->DisplayMode(), TInt64(aLength) * aHeight, start);
+	}
+
+void CInstrumentedDrawDevice::WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!iEnabled)
+		{
+		iTarget->WriteBinaryLine(aX, aY, aBuffer, aLength, aColor, aDrawMode);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->WriteBinaryLine(aX, aY, aBuffer, aLength, aColor, aDrawMode);
+	Record(EPrimitiveWriteBinaryLine, aDrawMode, iTarget->DisplayMode(), aLength, start);
+	}
+
+void CInstrumentedDrawDevice::WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp)
+	{
+	if (!iEnabled)
+		{
+		iTarget->WriteBinaryLineVertical(aX, aY, aBuffer, aHeight, aColor, aDrawMode, aUp);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->WriteBinaryLineVertical(aX, aY, aBuffer, aHeight, aColor, aDrawMode, aUp);
+	Record(EPrimitiveWriteBinaryLineVertical, aDrawMode, iTarget->DisplayMode(), aHeight, start);
+	}
+
+void CInstrumentedDrawDevice::WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!iEnabled)
+		{
+		iTarget->WriteRgb(aX, aY, aColor, aDrawMode);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->WriteRgb(aX, aY, aColor, aDrawMode);
+	Record(EPrimitiveWriteRgb, aDrawMode, iTarget->DisplayMode(), 1, start);
+	}
+
+void CInstrumentedDrawDevice::WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!iEnabled)
+		{
+		iTarget->WriteRgbMulti(aX, aY, aLength, aHeight, aColor, aDrawMode);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->WriteRgbMulti(aX, aY, aLength, aHeight, aColor, aDrawMode);
+	Record(EPrimitiveWriteRgbMulti, aDrawMode, iTarget->DisplayMode(), TInt64(aLength) * aHeight, start);
+	}
+
+void CInstrumentedDrawDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!iEnabled)
+		{
+		iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer, aMaskBuffer, aDrawMode);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer, aMaskBuffer, aDrawMode);
+	Record(EPrimitiveWriteRgbAlphaLine, aDrawMode, iTarget->DisplayMode(), aLength, start);
+	}
+
+void CInstrumentedDrawDevice::WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!iEnabled)
+		{
+		iTarget->WriteLine(aX, aY, aLength, aBuffer, aDrawMode);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->WriteLine(aX, aY, aLength, aBuffer, aDrawMode);
+	Record(EPrimitiveWriteLine, aDrawMode, iTarget->DisplayMode(), aLength, start);
+	}
+
+void CInstrumentedDrawDevice::ShadowArea(const TRect& aRect)
+	{
+	if (!iEnabled)
+		{
+		iTarget->ShadowArea(aRect);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->ShadowArea(aRect);
+	Record(EPrimitiveShadowArea, 0, iTarget->DisplayMode(), TInt64(aRect.Width()) * aRect.Height(), start);
+	}
+
+void CInstrumentedDrawDevice::WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer)
+	{
+	if (!iEnabled)
+		{
+		iTarget->WriteRgbAlphaMulti(aX, aY, aLength, aColor, aMaskBuffer);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->WriteRgbAlphaMulti(aX, aY, aLength, aColor, aMaskBuffer);
+	Record(EPrimitiveWriteRgbAlphaMulti, 0, iTarget->DisplayMode(), aLength, start);
+	}
+
+void CInstrumentedDrawDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+												const TUint8* aRgbBuffer1,
+												const TUint8* aBuffer2,
+												const TUint8* aMaskBuffer,
+												CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (!iEnabled)
+		{
+		iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer1, aBuffer2, aMaskBuffer, aDrawMode);
+		return;
+		}
+	const TUint32 start = User::FastCounter();
+	iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer1, aBuffer2, aMaskBuffer, aDrawMode);
+	Record(EPrimitiveWriteRgbAlphaLine2, aDrawMode, iTarget->DisplayMode(), aLength, start);
+	}
+
+TInt CInstrumentedDrawDevice::GetInterface(TInt aInterfaceId, TAny*& aInterface)
+	{
+	if (aInterfaceId == KDrawDeviceCountersInterfaceID)
+		{
+		aInterface = static_cast<MDrawDeviceCounters*>(this);
+		return KErrNone;
+		}
+	return iTarget->GetInterface(aInterfaceId, aInterface);
+	}
@@ -0,0 +1,88 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWINSTRUMENTED_H__
+#define __BITDRAWINSTRUMENTED_H__
+
+#include "BitDrawForwarding.h"
+#include "BitDrawCounters.h"
+
+/**
+Number of primitive, draw mode and display mode combinations a CInstrumentedDrawDevice
+can count separately.
+@internalComponent
+*/
+const TInt KMaxDrawCounters = 256;
+
+/**
+Draw device that implements MDrawDeviceCounters for the device it wraps.
+While counting is enabled every counted primitive is timed with User::FastCounter() and
+recorded in a fixed-size hash table, so no memory is allocated while drawing. Once three
+quarters of KMaxDrawCounters combinations are in use, new combinations are counted per
+primitive with display mode ENone.
+While counting is disabled each primitive costs one extra test before it is forwarded.
+@internalComponent
+*/
+class CInstrumentedDrawDevice : public CForwardingDrawDevice, public MDrawDeviceCounters
+	{
+public:
+	static CInstrumentedDrawDevice* NewL(CFbsDrawDevice* aTarget);
+public: // From MDrawDeviceCounters
+	void SetCountersEnabled(TBool aEnabled);
+	TBool CountersEnabled() const;
+	TInt GetCounters(RArray<TDrawCounter>& aCounters) const;
+	void ResetCounters();
+public: // From CFbsDrawDevice
+	void MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards);
+	void ReadLine(TInt aX,TInt aY,TInt aLength,TAny* aBuffer,TDisplayMode aDispMode) const;
+	void WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp);
+	void WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode);
+	void WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode);
+	void ShadowArea(const TRect& aRect);
+	void WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+						   const TUint8* aRgbBuffer1,
+						   const TUint8* aBuffer2,
+						   const TUint8* aMaskBuffer,
+						   CGraphicsContext::TDrawMode aDrawMode);
+	TInt GetInterface(TInt aInterfaceId, TAny*& aInterface);
+private:
+	/**
+	Counters of one combination, keyed by primitive, draw mode and display mode.
+	*/
+	struct TEntry
+		{
+		TUint32 iKey;
+		TUint32 iCalls;
+		TInt64 iPixels;
+		TInt64 iTicks;
+		};
+private:
+	CInstrumentedDrawDevice(CFbsDrawDevice* aTarget);
+	void Record(TDrawPrimitive aPrimitive, TInt aDrawMode, TDisplayMode aDispMode, TInt64 aPixels, TUint32 aStart);
+private:
+	TBool iEnabled;
+	TInt iFrequency;
+	TBool iCountsUp;
+	TInt iUsed;
+	TEntry iEntries[KMaxDrawCounters];
+	TEntry iOverflow[EDrawPrimitiveCount];
+	};
+
+#endif
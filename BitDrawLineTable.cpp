@@ -0,0 +1,149 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+
+#include "BitDrawLineTable.h"
+#include "bitdraw.h"
+
+TPixelLineTable::TPixelLineTable():
+	iDispMode(ENone),
+	iBitsPerPixel(0)
+	{
+	}
+
+/**
+Sets the display mode of the pixels that will be passed to ProcessLine().
+@param aDispMode Display mode of the draw device
+@panic EScreenDriverPanicInvalidDisplayMode if aDispMode is not a draw device display mode
+*/
+void TPixelLineTable::SetDisplayMode(TDisplayMode aDispMode)
+	{
+	iDispMode = aDispMode;
+	switch (aDispMode)
+		{
+	case EGray2:
+		iBitsPerPixel = 1;
+		break;
+	case EGray4:
+		iBitsPerPixel = 2;
+		break;
+	case EGray16:
+	case EColor16:
+		iBitsPerPixel = 4;
+		break;
+	case EGray256:
+	case EColor256:
+		iBitsPerPixel = 8;
+		break;
+	case EColor4K:
+	case EColor64K:
+		iBitsPerPixel = 16;
+		break;
+	case EColor16M:
+		iBitsPerPixel = 24;
+		break;
+	case EColor16MU:
+	case EColor16MA:
+	case EColor16MAP:
+		iBitsPerPixel = 32;
+		break;
+	default:
+		Panic(EScreenDriverPanicInvalidDisplayMode);
+		}
+	}
+
+/**
+Combines the first 1 << iBitsPerPixel entries of the pixel table into the byte table, which
+processes all the pixels held in one byte at once.
+*/
+void TPixelLineTable::BuildByteTable()
+	{
+	__ASSERT_DEBUG(iBitsPerPixel > 0 && iBitsPerPixel <= 8, Panic(EScreenDriverPanicInvalidDisplayMode));
+	const TInt pixelsPerByte = 8 / iBitsPerPixel;
+	const TInt valueMask = (1 << iBitsPerPixel) - 1;
+	for (TInt byte = 0; byte < 256; byte++)
+		{
+		TInt processed = 0;
+		for (TInt index = 0; index < pixelsPerByte; index++)
+			{
+			const TInt shift = index * iBitsPerPixel;
+			processed |= iPixelTable[(byte >> shift) & valueMask] << shift;
+			}
+		iByteTable[byte] = TUint8(processed);
+		}
+	}
+
+/**
+Processes aLength pixels of one physical scan line.
+@param aScanLine	Address of the scan line, in the display mode set by SetDisplayMode()
+@param aX			Index of the first pixel to process within the scan line
+@param aLength		Number of pixels to process
+*/
+void TPixelLineTable::ProcessLine(TAny* aScanLine, TInt aX, TInt aLength) const
+	{
+	__ASSERT_DEBUG(aScanLine, Panic(EScreenDriverPanicNullPointer));
+	__ASSERT_DEBUG(aX >= 0 && aLength >= 0, Panic(EScreenDriverPanicOutOfBounds));
+	if (aLength <= 0)
+		return;
+	switch (iBitsPerPixel)
+		{
+	case 1:
+	case 2:
+	case 4:
+	case 8:
+		ProcessPackedLine(static_cast<TUint8*>(aScanLine), aX, aLength);
+		break;
+	case 16:
+		ProcessSixteenBppLine(static_cast<TUint16*>(aScanLine) + aX, aLength);
+		break;
+	case 24:
+		ProcessTwentyFourBppLine(static_cast<TUint8*>(aScanLine) + aX * 3, aLength);
+		break;
+	default:
+		ProcessThirtyTwoBppLine(static_cast<TUint32*>(aScanLine) + aX, aLength);
+		break;
+		}
+	}
+
+void TPixelLineTable::ProcessPackedPixel(TUint8* aScanLine, TInt aX) const
+	{
+	const TInt pixelsPerByte = 8 / iBitsPerPixel;
+	const TInt valueMask = (1 << iBitsPerPixel) - 1;
+	TUint8& byte = aScanLine[aX / pixelsPerByte];
+	const TInt shift = (aX % pixelsPerByte) * iBitsPerPixel;
+	const TInt value = (byte >> shift) & valueMask;
+	byte = TUint8((byte & ~(valueMask << shift)) | (iPixelTable[value] << shift));
+	}
+
+/**
+Whole bytes are processed through the byte table, partial bytes at either end of the
+line a pixel at a time.
+*/
+void TPixelLineTable::ProcessPackedLine(TUint8* aScanLine, TInt aX, TInt aLength) const
+	{
+	const TInt pixelsPerByte = 8 / iBitsPerPixel;
+	const TInt end = aX + aLength;
+	const TInt alignedStart = Min(((aX + pixelsPerByte - 1) / pixelsPerByte) * pixelsPerByte, end);
+	const TInt alignedEnd = Max((end / pixelsPerByte) * pixelsPerByte, alignedStart);
+	TInt x = aX;
+	for (; x < alignedStart; x++)
+		ProcessPackedPixel(aScanLine, x);
+	TUint8* byte = aScanLine + alignedStart / pixelsPerByte;
+	TUint8* const byteLimit = aScanLine + alignedEnd / pixelsPerByte;
+	for (; byte < byteLimit; byte++)
+		*byte = iByteTable[*byte];
+	for (x = alignedEnd; x < end; x++)
+		ProcessPackedPixel(aScanLine, x);
+	}
@@ -0,0 +1,60 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWLINETABLE_H__
+#define __BITDRAWLINETABLE_H__
+
+#include <gdi.h>
+
+/**
+Base of the lookups that process the pixels of a scan line in place, one at a time and
+independently of each other, such as RDrawColorMap and RShadowFadeTables.
+
+ProcessLine() walks a line of any draw device display mode:
+	- display modes up to 8bpp go through a 256-entry byte table, which processes a whole byte
+	  (8, 4, 2 or 1 pixels) per lookup; partial bytes at either end of the line are processed
+	  a pixel at a time through the pixel table. The derived class fills the pixel table with
+	  the processed value of every pixel value, then calls BuildByteTable();
+	- 16bpp, 24bpp and 32bpp lines are passed to the derived class.
+@internalComponent
+*/
+class TPixelLineTable
+	{
+public:
+	void ProcessLine(TAny* aScanLine, TInt aX, TInt aLength) const;
+protected:
+	TPixelLineTable();
+	void SetDisplayMode(TDisplayMode aDispMode);
+	void BuildByteTable();
+	/**
+	Processes aLength EColor4K or EColor64K pixels. EColor4K pixels may have bits set above
+	bit 11, which must not be used to index a table of 0x1000 entries.
+	*/
+	virtual void ProcessSixteenBppLine(TUint16* aPixels, TInt aLength) const = 0;
+	/** Processes aLength EColor16M pixels, stored blue first. */
+	virtual void ProcessTwentyFourBppLine(TUint8* aPixels, TInt aLength) const = 0;
+	/** Processes aLength EColor16MU, EColor16MA or EColor16MAP pixels. */
+	virtual void ProcessThirtyTwoBppLine(TUint32* aPixels, TInt aLength) const = 0;
+private:
+	void ProcessPackedPixel(TUint8* aScanLine, TInt aX) const;
+	void ProcessPackedLine(TUint8* aScanLine, TInt aX, TInt aLength) const;
+protected:
+	TDisplayMode iDispMode;
+	TInt iBitsPerPixel;
+	TUint8 iPixelTable[256];
+	TUint8 iByteTable[256];
+	};
+
+#endif
@@ -0,0 +1,378 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawMapColors.h"
+#include "bitdraw.h"
+
+const TInt KMinHashSize = 16;
+const TUint32 KHashMultiplier = 0x9e3779b1;
+
+RDrawColorMap::RDrawColorMap():
+	iPalette(NULL),
+	iLookup(ELookupLinear),
+	iColors(NULL),
+	iNumPairs(0),
+	iMatchOffset(0),
+	iDirectTable(NULL),
+	iHash(NULL),
+	iHashShift(0)
+	{
+	}
+
+/**
+Builds the lookup structure for one MapColors() call.
+@param aDispMode	Display mode of the pixels that will be passed to MapLine()
+@param aColors		Colour map, as passed to MapColors(). Must remain valid until Close().
+@param aNumPairs	Number of pairs in aColors
+@param aMapForwards	If ETrue, match the first colour of a pair and replace by the second,
+					otherwise match the second and replace by the first.
+@param aPixelCount	Number of pixels that will be mapped; used to choose the lookup structure.
+@param aPalette		Inverse lookup of the custom palette of an EColor256 device, or NULL for the
+					default palette. Ignored in other display modes. Must remain valid until
+					Close().
+@return KErrNone if a lookup structure was built, KErrNoMemory if the map will fall back to
+		comparing pixels against every pair. MapLine() may be used in either case.
+@panic EScreenDriverPanicNullPointer	if aColors == NULL
+@panic EScreenDriverPanicZeroLength		if aNumPairs <= 0
+@panic EScreenDriverPanicInvalidDisplayMode if aDispMode is not a draw device display mode
+*/
+TInt RDrawColorMap::Create(TDisplayMode aDispMode, const TRgb* aColors, TInt aNumPairs, TBool aMapForwards, TInt aPixelCount,
+						   const RInversePalette* aPalette)
+	{
+	__ASSERT_ALWAYS(aColors, Panic(EScreenDriverPanicNullPointer));
+	__ASSERT_ALWAYS(aNumPairs > 0, Panic(EScreenDriverPanicZeroLength));
+	Close();
+	SetDisplayMode(aDispMode);
+	iPalette = aDispMode == EColor256 ? aPalette : NULL;
+	iColors = aColors;
+	iNumPairs = aNumPairs;
+	iMatchOffset = aMapForwards ? 0 : 1;
+	iLookup = ELookupLinear;
+	if (iBitsPerPixel <= 8)
+		{
+		BuildPixelTable();
+		return KErrNone;
+		}
+	const TInt tableEntries = aDispMode == EColor4K ? 0x1000 : 0x10000;
+	if (iBitsPerPixel == 16 && aPixelCount >= tableEntries)
+		return BuildDirectTable();
+	return BuildHash();
+	}
+
+/**
+Frees the lookup structure.
+*/
+void RDrawColorMap::Close()
+	{
+	delete [] iDirectTable;
+	iDirectTable = NULL;
+	delete [] iHash;
+	iHash = NULL;
+	iLookup = ELookupLinear;
+	}
+
+/**
+Converts a pixel value to TRgb, the form in which MapColors() compares colours.
+@param aDispMode	Display mode of aPixel
+@param aPixel		Pixel value
+@return TRgb value of the pixel
+*/
+TRgb RDrawColorMap::PixelToRgb(TDisplayMode aDispMode, TUint32 aPixel)
+	{
+	switch (aDispMode)
+		{
+	case EGray2:
+		return TRgb::Gray2(aPixel);
+	case EGray4:
+		return TRgb::Gray4(aPixel);
+	case EGray16:
+		return TRgb::Gray16(aPixel);
+	case EGray256:
+		return TRgb::Gray256(aPixel);
+	case EColor16:
+		return TRgb::Color16(aPixel);
+	case EColor256:
+		return TRgb::Color256(aPixel);
+	case EColor4K:
+		return TRgb::Color4K(aPixel);
+	case EColor64K:
+		return TRgb::Color64K(aPixel);
+	case EColor16M:
+		return TRgb::Color16M(aPixel);
+	case EColor16MU:
+		return TRgb::_Color16MU(aPixel);
+	case EColor16MA:
+		return TRgb::_Color16MA(aPixel);
+	case EColor16MAP:
+		return TRgb::_Color16MAP(aPixel);
+	default:
+		Panic(EScreenDriverPanicInvalidDisplayMode);
+		return TRgb();
+		}
+	}
+
+/**
+Converts a TRgb value to a pixel value.
+@param aDispMode	Display mode of the returned pixel
+@param aColor		Colour to convert
+@return Pixel value, in the low bits of the returned word for modes under 32bpp.
+*/
+TUint32 RDrawColorMap::RgbToPixel(TDisplayMode aDispMode, TRgb aColor)
+	{
+	switch (aDispMode)
+		{
+	case EGray2:
+		return aColor.Gray2();
+	case EGray4:
+		return aColor.Gray4();
+	case EGray16:
+		return aColor.Gray16();
+	case EGray256:
+		return aColor.Gray256();
+	case EColor16:
+		return aColor.Color16();
+	case EColor256:
+		return aColor.Color256();
+	case EColor4K:
+		return aColor.Color4K();
+	case EColor64K:
+		return aColor.Color64K();
+	case EColor16M:
+		return aColor.Color16M();
+	case EColor16MU:
+		return aColor._Color16MU() | 0xff000000;
+	case EColor16MA:
+		return aColor._Color16MA();
+	case EColor16MAP:
+		return aColor._Color16MAP();
+	default:
+		Panic(EScreenDriverPanicInvalidDisplayMode);
+		return 0;
+		}
+	}
+
+/**
+PixelToRgb() for the display mode passed to Create(), through the custom palette if there is one.
+*/
+TRgb RDrawColorMap::ToRgb(TUint32 aPixel) const
+	{
+	if (iPalette && TInt(aPixel) < iPalette->Entries())
+		return iPalette->Entry(aPixel);
+	return PixelToRgb(iDispMode, aPixel);
+	}
+
+/**
+RgbToPixel() for the display mode passed to Create(), through the custom palette if there is one.
+*/
+TUint32 RDrawColorMap::ToPixel(TRgb aColor) const
+	{
+	if (iPalette)
+		return iPalette->NearestIndex(aColor);
+	return RgbToPixel(iDispMode, aColor);
+	}
+
+/**
+Sub-byte and 8bpp modes: every possible pixel value is mapped once, then combined into
+a table which maps all the pixels held in one byte at once.
+*/
+void RDrawColorMap::BuildPixelTable()
+	{
+	const TInt numValues = 1 << iBitsPerPixel;
+	for (TInt value = 0; value < numValues; value++)
+		{
+		TUint32 pixel;
+		iPixelTable[value] = TUint8(FindLinear(ToRgb(value), pixel) ? pixel : value);
+		}
+	BuildByteTable();
+	iLookup = ELookupByteTable;
+	}
+
+/**
+16bpp modes: the pixel to TRgb conversion is one-to-one, so only the pixel value of each
+matched colour needs an entry. Pairs are applied last to first so that the first
+matching pair wins.
+*/
+TInt RDrawColorMap::BuildDirectTable()
+	{
+	const TInt numValues = iDispMode == EColor4K ? 0x1000 : 0x10000;
+	iDirectTable = new TUint16[numValues];
+	if (!iDirectTable)
+		return KErrNoMemory;
+	for (TInt value = 0; value < numValues; value++)
+		iDirectTable[value] = TUint16(value);
+	for (TInt index = iNumPairs - 1; index >= 0; index--)
+		{
+		const TRgb match = iColors[index * 2 + iMatchOffset];
+		const TUint32 pixel = ToPixel(match);
+		if (ToRgb(pixel) == match)
+			iDirectTable[pixel] = TUint16(ToPixel(iColors[index * 2 + 1 - iMatchOffset]));
+		}
+	iLookup = ELookupDirectTable;
+	return KErrNone;
+	}
+
+/**
+Open-addressed hash from the TRgb value of the colour to match to the replacement pixel value.
+The table is kept at most half full. An existing key is never replaced, so that the first
+matching pair wins.
+*/
+TInt RDrawColorMap::BuildHash()
+	{
+	TInt size = KMinHashSize;
+	TUint32 bits = 4;
+	while (size < iNumPairs * 2)
+		{
+		size <<= 1;
+		bits++;
+		}
+	iHash = new THashEntry[size];
+	if (!iHash)
+		return KErrNoMemory;
+	Mem::FillZ(iHash, size * sizeof(THashEntry));
+	iHashShift = 32 - bits;
+	const TUint32 mask = size - 1;
+	for (TInt index = 0; index < iNumPairs; index++)
+		{
+		const TUint32 key = iColors[index * 2 + iMatchOffset].Internal();
+		TUint32 slot = (key * KHashMultiplier) >> iHashShift;
+		while (iHash[slot].iUsed && iHash[slot].iKey != key)
+			slot = (slot + 1) & mask;
+		if (!iHash[slot].iUsed)
+			{
+			iHash[slot].iKey = key;
+			iHash[slot].iPixel = ToPixel(iColors[index * 2 + 1 - iMatchOffset]);
+			iHash[slot].iUsed = ETrue;
+			}
+		}
+	iLookup = ELookupHash;
+	return KErrNone;
+	}
+
+TBool RDrawColorMap::Find(TRgb aColor, TUint32& aPixel) const
+	{
+	if (iLookup != ELookupHash)
+		return FindLinear(aColor, aPixel);
+	const TUint32 key = aColor.Internal();
+	const TUint32 mask = (0xffffffffu >> iHashShift);
+	TUint32 slot = (key * KHashMultiplier) >> iHashShift;
+	while (iHash[slot].iUsed)
+		{
+		if (iHash[slot].iKey == key)
+			{
+			aPixel = iHash[slot].iPixel;
+			return ETrue;
+			}
+		slot = (slot + 1) & mask;
+		}
+	return EFalse;
+	}
+
+TBool RDrawColorMap::FindLinear(TRgb aColor, TUint32& aPixel) const
+	{
+	const TRgb* color = iColors + iMatchOffset;
+	for (TInt index = 0; index < iNumPairs; index++, color += 2)
+		{
+		if (*color == aColor)
+			{
+			aPixel = ToPixel(iColors[index * 2 + 1 - iMatchOffset]);
+			return ETrue;
+			}
+		}
+	return EFalse;
+	}
+
+TUint32 RDrawColorMap::MapPixel(TUint32 aPixel) const
+	{
+	TUint32 mapped;
+	return Find(ToRgb(aPixel), mapped) ? mapped : aPixel;
+	}
+
+/**
+Maps aLength pixels of one physical scan line.
+@param aScanLine	Address of the scan line, in the display mode passed to Create()
+@param aX			Index of the first pixel to map within the scan line
+@param aLength		Number of pixels to map
+*/
+void RDrawColorMap::MapLine(TAny* aScanLine, TInt aX, TInt aLength) const
+	{
+	ProcessLine(aScanLine, aX, aLength);
+	}
+
+void RDrawColorMap::ProcessSixteenBppLine(TUint16* aPixels, TInt aLength) const
+	{
+	TUint16* const limit = aPixels + aLength;
+	if (iLookup == ELookupDirectTable)
+		{
+		// The EColor4K table only covers the low 12 bits; pixels are left unchanged unless matched.
+		const TUint32 valueMask = iDispMode == EColor4K ? 0x0fff : 0xffff;
+		for (; aPixels < limit; aPixels++)
+			{
+			const TUint32 value = *aPixels & valueMask;
+			const TUint16 mapped = iDirectTable[value];
+			if (mapped != value)
+				*aPixels = mapped;
+			}
+		return;
+		}
+	TUint32 lastIn = *aPixels;
+	TUint32 lastOut = MapPixel(lastIn);
+	for (; aPixels < limit; aPixels++)
+		{
+		if (*aPixels != lastIn)
+			{
+			lastIn = *aPixels;
+			lastOut = MapPixel(lastIn);
+			}
+		*aPixels = TUint16(lastOut);
+		}
+	}
+
+void RDrawColorMap::ProcessTwentyFourBppLine(TUint8* aPixels, TInt aLength) const
+	{
+	TUint8* const limit = aPixels + aLength * 3;
+	TUint32 lastIn = aPixels[0] | (aPixels[1] << 8) | (aPixels[2] << 16);
+	TUint32 lastOut = MapPixel(lastIn);
+	for (; aPixels < limit; aPixels += 3)
+		{
+		const TUint32 pixel = aPixels[0] | (aPixels[1] << 8) | (aPixels[2] << 16);
+		if (pixel != lastIn)
+			{
+			lastIn = pixel;
+			lastOut = MapPixel(pixel);
+			}
+		if (lastOut != lastIn)
+			{
+			aPixels[0] = TUint8(lastOut);
+			aPixels[1] = TUint8(lastOut >> 8);
+			aPixels[2] = TUint8(lastOut >> 16);
+			}
+		}
+	}
+
+void RDrawColorMap::ProcessThirtyTwoBppLine(TUint32* aPixels, TInt aLength) const
+	{
+	TUint32* const limit = aPixels + aLength;
+	TUint32 lastIn = *aPixels;
+	TUint32 lastOut = MapPixel(lastIn);
+	for (; aPixels < limit; aPixels++)
+		{
+		if (*aPixels != lastIn)
+			{
+			lastIn = *aPixels;
+			lastOut = MapPixel(lastIn);
+			}
+		*aPixels = lastOut;
+		}
+	}
@@ -0,0 +1,99 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWMAPCOLORS_H__
+#define __BITDRAWMAPCOLORS_H__
+
+#include <gdi.h>
+#include "BitDrawLineTable.h"
+#include "BitDrawPalette.h"
+
+/**
+Colour map lookup used to implement CFbsDrawDevice::MapColors().
+
+The lookup structure is built once per MapColors() call, so that the cost per pixel does not
+depend on the number of colour pairs:
+	- display modes up to 8bpp use a 256-entry byte table, which maps a whole byte
+	  (8, 4, 2 or 1 pixels) per lookup;
+	- EColor4K and EColor64K use a direct table indexed by pixel value, unless the area to be
+	  mapped is smaller than the table, in which case the hash described below is used;
+	- 24bpp and 32bpp modes use an open-addressed hash keyed by the TRgb value of the pixel.
+Runs of identical pixels are looked up once.
+
+The semantics of CFbsDrawDevice::MapColors() are preserved: pixels are converted to TRgb
+before comparison, through the custom palette of an EColor256 device if it has one, the
+first matching pair wins, and unmatched pixels are left unchanged. Replacement colours are
+converted to indices of a custom palette with RInversePalette, which picks the same entry as
+CPalette::NearestIndex().
+If the lookup structure cannot be allocated the map falls back to comparing every pixel
+against every pair, so MapLine() can always be used once Create() has been called.
+
+@see CFbsDrawDevice::MapColors
+@see TPixelLineTable
+@see RInversePalette
+@internalComponent
+*/
+class RDrawColorMap : private TPixelLineTable
+	{
+public:
+	RDrawColorMap();
+	TInt Create(TDisplayMode aDispMode, const TRgb* aColors, TInt aNumPairs, TBool aMapForwards, TInt aPixelCount,
+				const RInversePalette* aPalette = NULL);
+	void Close();
+	void MapLine(TAny* aScanLine, TInt aX, TInt aLength) const;
+	static TRgb PixelToRgb(TDisplayMode aDispMode, TUint32 aPixel);
+	static TUint32 RgbToPixel(TDisplayMode aDispMode, TRgb aColor);
+private:
+	/**
+	Lookup structure selected by Create().
+	*/
+	enum TLookup
+		{
+		ELookupLinear,
+		ELookupByteTable,
+		ELookupDirectTable,
+		ELookupHash
+		};
+	struct THashEntry
+		{
+		TUint32 iKey;
+		TUint32 iPixel;
+		TBool iUsed;
+		};
+private:
+	TRgb ToRgb(TUint32 aPixel) const;
+	TUint32 ToPixel(TRgb aColor) const;
+	void BuildPixelTable();
+	TInt BuildDirectTable();
+	TInt BuildHash();
+	TBool Find(TRgb aColor, TUint32& aPixel) const;
+	TBool FindLinear(TRgb aColor, TUint32& aPixel) const;
+	TUint32 MapPixel(TUint32 aPixel) const;
+private: // From TPixelLineTable
+	void ProcessSixteenBppLine(TUint16* aPixels, TInt aLength) const;
+	void ProcessTwentyFourBppLine(TUint8* aPixels, TInt aLength) const;
+	void ProcessThirtyTwoBppLine(TUint32* aPixels, TInt aLength) const;
+private:
+	const RInversePalette* iPalette;
+	TLookup iLookup;
+	const TRgb* iColors;
+	TInt iNumPairs;
+	TInt iMatchOffset;
+	TUint16* iDirectTable;
+	THashEntry* iHash;
+	TUint32 iHashShift;
+	};
+
+#endif
@@ -0,0 +1,267 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawPalette.h"
+
+/** Number of cells along each axis of the RGB cube, and the shift from a component to its cell. */
+const TInt KCellsPerAxis = 32;
+const TInt KCellShift = 3;
+const TInt KCellCount = KCellsPerAxis * KCellsPerAxis * KCellsPerAxis;
+
+/** Initial capacities of the candidate lists, grown as needed. */
+const TInt KInitialListCount = 1024;
+const TInt KInitialCandidateCount = 4096;
+
+/**
+Grows aBuffer, holding aCount elements, so that it can hold at least aRequired elements.
+*/
+template <class T>
+LOCAL_C TBool Reserve(T*& aBuffer, TInt aCount, TInt& aCapacity, TInt aRequired)
+	{
+	if (aRequired <= aCapacity)
+		return ETrue;
+	TInt capacity = aCapacity * 2;
+	while (capacity < aRequired)
+		capacity *= 2;
+	T* buffer = new T[capacity];
+	if (!buffer)
+		return EFalse;
+	Mem::Copy(buffer, aBuffer, aCount * sizeof(T));
+	delete [] aBuffer;
+	aBuffer = buffer;
+	aCapacity = capacity;
+	return ETrue;
+	}
+
+RInversePalette::RInversePalette():
+	iEntries(0),
+	iCells(NULL),
+	iLists(NULL),
+	iCandidates(NULL)
+	{
+	}
+
+/**
+Copies a palette and builds its inverse lookup. Setting the palette already held does nothing.
+@param aPalette	Palette set on the device
+@return KErrNone if the inverse lookup was built, KErrNoMemory if NearestIndex() will fall back
+		to comparing against every entry, KErrNotSupported if aPalette has no entries or more
+		than KMaxInversePaletteEntries; the previous palette is kept then.
+*/
+TInt RInversePalette::Create(const CPalette& aPalette)
+	{
+	const TInt entries = aPalette.Entries();
+	if (entries <= 0 || entries > KMaxInversePaletteEntries)
+		return KErrNotSupported;
+	TBool same = iCells && entries == iEntries;
+	for (TInt index = 0; same && index < entries; index++)
+		same = aPalette.GetEntry(index) == iPalette[index];
+	if (same)
+		return KErrNone;
+	Close();
+	iEntries = entries;
+	for (TInt index = 0; index < entries; index++)
+		iPalette[index] = aPalette.GetEntry(index);
+	const TInt err = BuildCells();
+	if (err != KErrNone)
+		Close();
+	return err;
+	}
+
+/**
+Frees the inverse lookup. The copy of the palette is kept, so NearestIndex() still works.
+*/
+void RInversePalette::Close()
+	{
+	delete [] iCells;
+	iCells = NULL;
+	delete [] iLists;
+	iLists = NULL;
+	delete [] iCandidates;
+	iCandidates = NULL;
+	}
+
+/**
+Keeps the candidate entries of every cell. A cell with a single candidate holds its index;
+any other holds KMaxInversePaletteEntries plus the number of its list in iLists. A list is the
+offset of its first candidate in iCandidates shifted left by 8, ORed with the number of candidates
+minus one. Candidates are in ascending index order, so that ties resolve as in
+CPalette::NearestIndex().
+
+The distances of each entry to each slab of cells are computed per axis first; the distance of
+an entry to a cell is then the sum of its distances to the three slabs holding the cell.
+*/
+TInt RInversePalette::BuildCells()
+	{
+	const TInt entries = iEntries;
+	const TInt axisSize = KCellsPerAxis * entries;
+	TUint8* minDistance = new TUint8[axisSize * 3];
+	TUint8* maxDistance = new TUint8[axisSize * 3];
+	iCells = new TUint16[KCellCount];
+	TInt listCapacity = KInitialListCount;
+	TInt candidateCapacity = KInitialCandidateCount;
+	iLists = new TUint32[listCapacity];
+	iCandidates = new TUint8[candidateCapacity];
+	TInt err = minDistance && maxDistance && iCells && iLists && iCandidates ? KErrNone : KErrNoMemory;
+	if (err == KErrNone)
+		{
+		for (TInt index = 0; index < entries; index++)
+			{
+			const TInt component[3] = { iPalette[index].Red(), iPalette[index].Green(), iPalette[index].Blue() };
+			for (TInt axis = 0; axis < 3; axis++)
+				for (TInt cell = 0; cell < KCellsPerAxis; cell++)
+					{
+					const TInt low = cell << KCellShift;
+					const TInt high = low + (1 << KCellShift) - 1;
+					const TInt value = component[axis];
+					const TInt offset = axis * axisSize + cell * entries + index;
+					minDistance[offset] = TUint8(value < low ? low - value : (value > high ? value - high : 0));
+					maxDistance[offset] = TUint8(Max(Abs(value - low), Abs(value - high)));
+					}
+			}
+		}
+	TInt minRedGreen[KMaxInversePaletteEntries];
+	TInt maxRedGreen[KMaxInversePaletteEntries];
+	TUint8 candidates[KMaxInversePaletteEntries];
+	TInt lists = 0;
+	TInt used = 0;
+	TUint16* cell = iCells;
+	for (TInt red = 0; err == KErrNone && red < KCellsPerAxis; red++)
+		for (TInt green = 0; err == KErrNone && green < KCellsPerAxis; green++)
+			{
+			const TUint8* minRed = minDistance + red * entries;
+			const TUint8* maxRed = maxDistance + red * entries;
+			const TUint8* minGreen = minDistance + axisSize + green * entries;
+			const TUint8* maxGreen = maxDistance + axisSize + green * entries;
+			for (TInt index = 0; index < entries; index++)
+				{
+				minRedGreen[index] = minRed[index] + minGreen[index];
+				maxRedGreen[index] = maxRed[index] + maxGreen[index];
+				}
+			for (TInt blue = 0; blue < KCellsPerAxis; blue++, cell++)
+				{
+				const TUint8* minBlue = minDistance + 2 * axisSize + blue * entries;
+				const TUint8* maxBlue = maxDistance + 2 * axisSize + blue * entries;
+				TInt bound = KMaxTInt;
+				for (TInt index = 0; index < entries; index++)
+					bound = Min(bound, maxRedGreen[index] + maxBlue[index]);
+				TInt count = 0;
+				for (TInt index = 0; index < entries; index++)
+					{
+					if (minRedGreen[index] + minBlue[index] <= bound)
+						candidates[count++] = TUint8(index);
+					}
+				if (count == 1)
+					{
+					*cell = candidates[0];
+					continue;
+					}
+				if (!Reserve(iLists, lists, listCapacity, lists + 1) ||
+					!Reserve(iCandidates, used, candidateCapacity, used + count))
+					{
+					err = KErrNoMemory;
+					break;
+					}
+				Mem::Copy(iCandidates + used, candidates, count);
+				iLists[lists] = (TUint32(used) << 8) | (count - 1);
+				*cell = TUint16(KMaxInversePaletteEntries + lists);
+				lists++;
+				used += count;
+				}
+			}
+	delete [] minDistance;
+	delete [] maxDistance;
+	return err;
+	}
+
+/**
+@param aColor	Colour to match; alpha is ignored
+@return The index of the palette entry nearest to aColor, as CPalette::NearestIndex() returns it.
+*/
+TInt RInversePalette::NearestIndex(TRgb aColor) const
+	{
+	if (!iCells)
+		return NearestIndexLinear(aColor, NULL, iEntries);
+	const TInt cell = ((aColor.Red() >> KCellShift) << 10) | ((aColor.Green() >> KCellShift) << 5) | (aColor.Blue() >> KCellShift);
+	const TInt value = iCells[cell];
+	if (value < KMaxInversePaletteEntries)
+		return value;
+	const TUint32 list = iLists[value - KMaxInversePaletteEntries];
+	return NearestIndexLinear(aColor, iCandidates + (list >> 8), (list & 0xff) + 1);
+	}
+
+/**
+Compares aColor against aCount entries, the candidates listed in aCandidates or, if it is NULL,
+the first aCount entries.
+*/
+TInt RInversePalette::NearestIndexLinear(TRgb aColor, const TUint8* aCandidates, TInt aCount) const
+	{
+	TInt nearest = aCandidates ? aCandidates[0] : 0;
+	TInt nearestDifference = aColor.Difference(iPalette[nearest]);
+	for (TInt count = 1; count < aCount && nearestDifference > 0; count++)
+		{
+		const TInt index = aCandidates ? aCandidates[count] : count;
+		const TInt difference = aColor.Difference(iPalette[index]);
+		if (difference < nearestDifference)
+			{
+			nearest = index;
+			nearestDifference = difference;
+			}
+		}
+	return nearest;
+	}
+
+/**
+Converts a line of colours to palette indices, for WriteLine() and the alpha blending paths of
+palettised devices. Runs of identical colours are looked up once.
+@param aColors	Colours in EColor16MU format; the top byte is ignored
+@param aIndices	Receives the index of the entry nearest to each colour
+@param aLength	Number of colours
+*/
+void RInversePalette::NearestIndices(const TUint32* aColors, TUint8* aIndices, TInt aLength) const
+	{
+	const TUint32* const end = aColors + aLength;
+	TUint32 previous = 0;
+	TUint8 index = 0;
+	TBool valid = EFalse;
+	while (aColors < end)
+		{
+		const TUint32 color = *aColors++ & 0x00ffffff;
+		if (!valid || color != previous)
+			{
+			index = TUint8(NearestIndex(TRgb::_Color16MU(color)));
+			previous = color;
+			valid = ETrue;
+			}
+		*aIndices++ = index;
+		}
+	}
+
+/**
+Creates a copy of the palette, for CFbsDrawDevice::GetCustomPalette(). The caller takes
+ownership of the copy, so it is the only allocation.
+@param aPalette	Set to the new palette
+@return KErrNone, or KErrNoMemory
+*/
+TInt RInversePalette::GetPalette(CPalette*& aPalette) const
+	{
+	TRAPD(err, aPalette = CPalette::NewL(iEntries));
+	if (err == KErrNone)
+		{
+		for (TInt index = 0; index < iEntries; index++)
+			aPalette->SetEntry(index, iPalette[index]);
+		}
+	return err;
+	}
@@ -0,0 +1,83 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWPALETTE_H__
+#define __BITDRAWPALETTE_H__
+
+#include <gdi.h>
+
+/**
+Maximum number of entries of a palette handled by RInversePalette.
+@internalComponent
+*/
+const TInt KMaxInversePaletteEntries = 256;
+
+/**
+Inverse colour lookup for devices with a palette set by CFbsDrawDevice::SetCustomPalette().
+
+Create() is called when the palette is set and keeps a copy of it. NearestIndex() then returns
+the same index as CPalette::NearestIndex(): the lowest index of the entries with the smallest
+TRgb::Difference() from the colour.
+
+The RGB cube is divided into 32x32x32 cells. For every cell Create() keeps the entries that can
+be nearest to some colour of the cell: an entry is dropped if its smallest distance to the cell
+is larger than the largest distance of another entry. Most cells keep a single entry and are
+answered by one table read; cells on the border between entries compare the colour against
+their few remaining entries.
+
+If the cells cannot be allocated the lookup falls back to comparing against every entry, so
+NearestIndex() can always be used once Create() has been called.
+@internalComponent
+*/
+class RInversePalette
+	{
+public:
+	RInversePalette();
+	TInt Create(const CPalette& aPalette);
+	void Close();
+	TInt NearestIndex(TRgb aColor) const;
+	void NearestIndices(const TUint32* aColors, TUint8* aIndices, TInt aLength) const;
+	TInt GetPalette(CPalette*& aPalette) const;
+	inline TInt Entries() const;
+	inline TRgb Entry(TInt aIndex) const;
+private:
+	TInt BuildCells();
+	TInt NearestIndexLinear(TRgb aColor, const TUint8* aCandidates, TInt aCount) const;
+private:
+	TInt iEntries;
+	TRgb iPalette[KMaxInversePaletteEntries];
+	TUint16* iCells;
+	TUint32* iLists;
+	TUint8* iCandidates;
+	};
+
+/**
+@return Number of entries of the palette.
+*/
+inline TInt RInversePalette::Entries() const
+	{
+	return iEntries;
+	}
+
+/**
+@param aIndex	Index of an entry of the palette
+@return Colour of the entry.
+*/
+inline TRgb RInversePalette::Entry(TInt aIndex) const
+	{
+	return iPalette[aIndex];
+	}
+
+#endif
@@ -0,0 +1,268 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawParallel.h"
+#include "BitDrawDirectAccess.h"
+
+/** Cache line size assumed when choosing band boundaries. */
+const TInt KCacheLineBytes = 64;
+/** Bands per participating thread, so that threads finishing early have bands to steal. */
+const TInt KBandsPerThread = 4;
+
+LOCAL_C TInt GreatestCommonDivisor(TInt aValue1, TInt aValue2)
+	{
+	while (aValue2)
+		{
+		const TInt remainder = aValue1 % aValue2;
+		aValue1 = aValue2;
+		aValue2 = remainder;
+		}
+	return aValue1;
+	}
+
+/**
+Creates a bitmap device, as CFbsDrawDevice::NewBitmapDeviceL() does, with parallel
+execution of large-area primitives.
+@param aSize		Bitmap device size
+@param aDispMode	Bitmap display mode
+@param aDataStride	Bitmap data stride
+@param aThreadCount	Number of worker threads; 0 to use one less than the number of CPUs
+@return The new device
+@leave KErrNoMemory Not enough memory
+KErrArgument Invalid aSize value or negative aThreadCount
+*/
+CParallelDrawDevice* CParallelDrawDevice::NewBitmapDeviceL(const TSize& aSize, TDisplayMode aDispMode, TInt aDataStride, TInt aThreadCount)
+	{
+	CFbsDrawDevice* target = CFbsDrawDevice::NewBitmapDeviceL(aSize, aDispMode, aDataStride);
+	CleanupStack::PushL(target);
+	CParallelDrawDevice* self = NewL(target, aThreadCount);
+	CleanupStack::Pop(target);
+	return self;
+	}
+
+/**
+Wraps an existing bitmap device.
+@param aTarget		Device to draw to. Ownership is transferred if the function does not leave.
+@param aThreadCount	Number of worker threads; 0 to use one less than the number of CPUs
+@return The new device
+@leave KErrNoMemory Not enough memory
+KErrArgument Negative aThreadCount
+*/
+CParallelDrawDevice* CParallelDrawDevice::NewL(CFbsDrawDevice* aTarget, TInt aThreadCount)
+	{
+	CParallelDrawDevice* self = new(ELeave) CParallelDrawDevice(aTarget);
+	TRAPD(err, self->ConstructL(aThreadCount));
+	if (err != KErrNone)
+		{
+		// Ownership of aTarget stays with the caller.
+		self->iTarget = NULL;
+		delete self;
+		User::Leave(err);
+		}
+	return self;
+	}
+
+CParallelDrawDevice::CParallelDrawDevice(CFbsDrawDevice* aTarget):
+	CForwardingDrawDevice(aTarget),
+	iThreshold(KDefaultParallelThreshold),
+	iOrientation(EOrientationNormal),
+	iShadowMode(ENoShadow)
+	{
+	}
+
+void CParallelDrawDevice::ConstructL(TInt aThreadCount)
+	{
+	iPool = CDrawThreadPool::NewL(aThreadCount);
+	}
+
+CParallelDrawDevice::~CParallelDrawDevice()
+	{
+	delete iPool;
+	}
+
+/**
+Sets the area above which primitives are split into bands.
+@param aPixels Area in pixels; KMaxTInt to run everything on the calling thread.
+*/
+void CParallelDrawDevice::SetParallelThreshold(TInt aPixels)
+	{
+	iThreshold = aPixels;
+	}
+
+/**
+Alpha blends a block of aHeight lines, as aHeight calls of
+WriteRgbAlphaLine(TInt,TInt,TInt,TUint8*,TUint8*,CGraphicsContext::TDrawMode) would.
+@param aX			Logical X coordinate of the left edge of the block
+@param aY			Logical Y coordinate of the top line of the block
+@param aLength		Width of the block in pixels
+@param aHeight		Number of lines
+@param aRgbBuffer	First line of source pixels, in ERgb format
+@param aRgbStride	Bytes between source lines
+@param aMaskBuffer	First line of alpha values, in EGray256 format
+@param aMaskStride	Bytes between mask lines
+@param aDrawMode	Combination function for source and destination pixels
+*/
+void CParallelDrawDevice::WriteRgbAlphaBlock(TInt aX,TInt aY,TInt aLength,TInt aHeight,
+											 const TUint8* aRgbBuffer,TInt aRgbStride,
+											 const TUint8* aMaskBuffer,TInt aMaskStride,
+											 CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iRgbBuffer = aRgbBuffer;
+	iRgbStride = aRgbStride;
+	iMaskBuffer = aMaskBuffer;
+	iMaskStride = aMaskStride;
+	iDrawMode = aDrawMode;
+	if (iShadowMode == ENoShadow && !(iUnknownSettings & EUnknownShadowMode) && Run(EWriteRgbAlphaBlock, TRect(aX, aY, aX + aLength, aY + aHeight)))
+		return;
+	for (TInt line = 0; line < aHeight; line++)
+		{
+		iTarget->WriteRgbAlphaLine(aX, aY + line, aLength,
+								   const_cast<TUint8*>(aRgbBuffer + line * aRgbStride),
+								   const_cast<TUint8*>(aMaskBuffer + line * aMaskStride), aDrawMode);
+		}
+	}
+
+void CParallelDrawDevice::MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards)
+	{
+	iColors = aColors;
+	iNumPairs = aNumPairs;
+	iMapForwards = aMapForwards;
+	if (!Run(EMapColors, aRect))
+		iTarget->MapColors(aRect, aColors, aNumPairs, aMapForwards);
+	}
+
+TBool CParallelDrawDevice::SetOrientation(TOrientation aOrientation)
+	{
+	const TBool set = iTarget->SetOrientation(aOrientation);
+	if (set)
+		{
+		iOrientation = aOrientation;
+		iUnknownSettings &= ~EUnknownOrientation;
+		}
+	return set;
+	}
+
+/**
+The orientation taken from aDrawDevice is read back from the layout of the wrapped device, if it
+offers MDirectScanLineAccess. The shadow mode is not known until SetShadowMode() is called.
+*/
+void CParallelDrawDevice::SetDisplayMode(CFbsDrawDevice* aDrawDevice)
+	{
+	iTarget->SetDisplayMode(aDrawDevice);
+	iUnknownSettings = EUnknownOrientation | EUnknownShadowMode;
+	TAny* access = NULL;
+	TDirectScanLineInfo info;
+	if (iTarget->GetInterface(KDirectScanLineAccessInterfaceID, access) == KErrNone && access &&
+		static_cast<MDirectScanLineAccess*>(access)->GetScanLineInfo(info) == KErrNone)
+		{
+		iOrientation = info.iOrientation;
+		iUnknownSettings &= ~EUnknownOrientation;
+		}
+	}
+
+void CParallelDrawDevice::SetShadowMode(TShadowMode aShadowMode)
+	{
+	iTarget->SetShadowMode(aShadowMode);
+	iShadowMode = aShadowMode;
+	iUnknownSettings &= ~EUnknownShadowMode;
+	}
+
+void CParallelDrawDevice::WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iColor = aColor;
+	iDrawMode = aDrawMode;
+	if (!Run(EWriteRgbMulti, TRect(aX, aY, aX + aLength, aY + aHeight)))
+		iTarget->WriteRgbMulti(aX, aY, aLength, aHeight, aColor, aDrawMode);
+	}
+
+void CParallelDrawDevice::ShadowArea(const TRect& aRect)
+	{
+	if (!Run(EShadowArea, aRect))
+		iTarget->ShadowArea(aRect);
+	}
+
+/**
+Splits aRect into bands and runs aOperation on them in parallel, if aRect is large enough.
+@return ETrue if the operation was run, EFalse if the caller must forward it.
+*/
+TBool CParallelDrawDevice::Run(TOperation aOperation, const TRect& aRect)
+	{
+	if (iOrientation != EOrientationNormal || (iUnknownSettings & EUnknownOrientation) ||
+		iPool->ThreadCount() == 0 || aRect.IsEmpty())
+		return EFalse;
+	if (TInt64(aRect.Width()) * aRect.Height() <= iThreshold)
+		return EFalse;
+	const TInt alignment = RowAlignment();
+	const TInt bands = (iPool->ThreadCount() + 1) * KBandsPerThread;
+	TInt rows = (aRect.Height() + bands - 1) / bands;
+	rows = ((rows + alignment - 1) / alignment) * alignment;
+	const TInt alignedTop = ((aRect.iTl.iY + alignment - 1) / alignment) * alignment;
+	iOperation = aOperation;
+	iRect = aRect;
+	iRowsPerBand = rows;
+	// Band 0 also takes the rows above the first aligned boundary.
+	iFirstBoundary = alignedTop + rows;
+	TInt bandCount = 1;
+	if (aRect.iBr.iY > iFirstBoundary)
+		bandCount += (aRect.iBr.iY - iFirstBoundary + rows - 1) / rows;
+	iPool->Execute(*this, bandCount);
+	return ETrue;
+	}
+
+void CParallelDrawDevice::BandRows(TInt aBand, TInt& aTop, TInt& aBottom) const
+	{
+	aTop = aBand == 0 ? iRect.iTl.iY : iFirstBoundary + (aBand - 1) * iRowsPerBand;
+	aBottom = Min(iFirstBoundary + aBand * iRowsPerBand, iRect.iBr.iY);
+	}
+
+/**
+@return The smallest number of rows whose total size is a multiple of the cache line size.
+*/
+TInt CParallelDrawDevice::RowAlignment() const
+	{
+	const TInt stride = iTarget->ScanLineBytes();
+	if (stride <= 0)
+		return 1;
+	return KCacheLineBytes / GreatestCommonDivisor(stride, KCacheLineBytes);
+	}
+
+void CParallelDrawDevice::DoBand(TInt aBand)
+	{
+	TInt top;
+	TInt bottom;
+	BandRows(aBand, top, bottom);
+	const TRect band(iRect.iTl.iX, top, iRect.iBr.iX, bottom);
+	switch (iOperation)
+		{
+	case EWriteRgbMulti:
+		iTarget->WriteRgbMulti(band.iTl.iX, top, band.Width(), band.Height(), iColor, iDrawMode);
+		break;
+	case EMapColors:
+		iTarget->MapColors(band, iColors, iNumPairs, iMapForwards);
+		break;
+	case EShadowArea:
+		iTarget->ShadowArea(band);
+		break;
+	case EWriteRgbAlphaBlock:
+		for (TInt y = top; y < bottom; y++)
+			{
+			const TInt line = y - iRect.iTl.iY;
+			iTarget->WriteRgbAlphaLine(band.iTl.iX, y, band.Width(),
+									   const_cast<TUint8*>(iRgbBuffer + line * iRgbStride),
+									   const_cast<TUint8*>(iMaskBuffer + line * iMaskStride), iDrawMode);
+			}
+		break;
+		}
+	}
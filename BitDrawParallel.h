@@ -0,0 +1,116 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWPARALLEL_H__
+#define __BITDRAWPARALLEL_H__
+
+#include "BitDrawForwarding.h"
+#include "BitDrawThreadPool.h"
+
+/**
+Default area, in pixels, above which CParallelDrawDevice splits a primitive into bands.
+@internalComponent
+*/
+const TInt KDefaultParallelThreshold = 256 * 256;
+
+/**
+Bitmap device that runs large-area primitives on several threads.
+
+WriteRgbMulti(), MapColors(), ShadowArea() and WriteRgbAlphaBlock() calls covering more than
+the threshold area are split into bands of whole rows, which are passed to the wrapped device
+from the threads of a CDrawThreadPool. Band boundaries fall on rows whose start address is
+cache line aligned where the stride allows it, so no two threads write to the same cache line.
+Each pixel is still written by exactly one call of the wrapped device, so the result is
+byte-identical with single-threaded drawing. Every primitive returns only when all its bands
+have completed.
+
+Bands are only used while the orientation is EOrientationNormal; other orientations, and
+all other primitives, are forwarded on the calling thread. WriteRgbAlphaBlock() also runs on
+the calling thread while a shadow mode is set, since the wrapped device shadows the source
+through its single scan line buffer. SetDisplayMode() gives the wrapped device the orientation
+and shadow mode of the other device: the orientation is read back from the wrapped device if it
+offers MDirectScanLineAccess, and otherwise bands are not used until SetOrientation() is called;
+WriteRgbAlphaBlock() bands are not used until SetShadowMode() is called.
+@internalComponent
+*/
+class CParallelDrawDevice : public CForwardingDrawDevice, public MDrawBandJob
+	{
+public:
+	static CParallelDrawDevice* NewBitmapDeviceL(const TSize& aSize, TDisplayMode aDispMode, TInt aDataStride, TInt aThreadCount);
+	static CParallelDrawDevice* NewL(CFbsDrawDevice* aTarget, TInt aThreadCount);
+	~CParallelDrawDevice();
+	void SetParallelThreshold(TInt aPixels);
+	void WriteRgbAlphaBlock(TInt aX,TInt aY,TInt aLength,TInt aHeight,
+							const TUint8* aRgbBuffer,TInt aRgbStride,
+							const TUint8* aMaskBuffer,TInt aMaskStride,
+							CGraphicsContext::TDrawMode aDrawMode);
+public: // From CFbsDrawDevice
+	void MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards);
+	TBool SetOrientation(TOrientation aOrientation);
+	void SetDisplayMode(CFbsDrawDevice* aDrawDevice);
+	void SetShadowMode(TShadowMode aShadowMode);
+	void WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void ShadowArea(const TRect& aRect);
+private: // From MDrawBandJob
+	void DoBand(TInt aBand);
+private:
+	/**
+	Primitive being split into bands.
+	*/
+	enum TOperation
+		{
+		EWriteRgbMulti,
+		EMapColors,
+		EShadowArea,
+		EWriteRgbAlphaBlock
+		};
+	/**
+	Settings that are not known after SetDisplayMode(), until they are set again.
+	*/
+	enum TUnknownSetting
+		{
+		EUnknownOrientation = 0x01,
+		EUnknownShadowMode = 0x02
+		};
+private:
+	CParallelDrawDevice(CFbsDrawDevice* aTarget);
+	void ConstructL(TInt aThreadCount);
+	TBool Run(TOperation aOperation, const TRect& aRect);
+	void BandRows(TInt aBand, TInt& aTop, TInt& aBottom) const;
+	TInt RowAlignment() const;
+private:
+	CDrawThreadPool* iPool;
+	TInt iThreshold;
+	TOrientation iOrientation;
+	TShadowMode iShadowMode;
+	/** TUnknownSetting flags. */
+	TUint iUnknownSettings;
+	// Parameters of the primitive being run
+	TOperation iOperation;
+	TRect iRect;
+	TInt iFirstBoundary;
+	TInt iRowsPerBand;
+	TRgb iColor;
+	CGraphicsContext::TDrawMode iDrawMode;
+	const TRgb* iColors;
+	TInt iNumPairs;
+	TBool iMapForwards;
+	const TUint8* iRgbBuffer;
+	TInt iRgbStride;
+	const TUint8* iMaskBuffer;
+	TInt iMaskStride;
+	};
+
+#endif
@@ -0,0 +1,153 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWPIXELFORMAT_H__
+#define __BITDRAWPIXELFORMAT_H__
+
+#include <gdi.h>
+
+/**
+@return The number of bits a pixel of aDispMode takes in a scan line in memory. Unlike
+TDisplayModeUtils::NumDisplayModeBitsPerPixel(), this is 16 for EColor4K and 32 for ERgb, so it
+can be used to compute strides and pixel addresses.
+@internalComponent
+*/
+inline TInt BitsInMemory(TDisplayMode aDispMode)
+	{
+	switch (aDispMode)
+		{
+	case EColor4K:
+		return 16;
+	case ERgb:
+		return 32;
+	default:
+		return TDisplayModeUtils::NumDisplayModeBitsPerPixel(aDispMode);
+		}
+	}
+
+/**
+Reads and writes pixels of a given size in a scan line. Pixels under 8bpp are packed
+starting from the least significant bits of each byte; 24bpp pixels are stored blue first.
+@internalComponent
+*/
+template <TInt BITS>
+struct TPixelAccess
+	{
+	enum {EValueMask = (1 << BITS) - 1, EPixelsPerByte = 8 / BITS};
+	static inline TUint32 Read(const TAny* aScanLine, TInt aX)
+		{
+		const TUint8 byte = static_cast<const TUint8*>(aScanLine)[aX / EPixelsPerByte];
+		return (byte >> ((aX % EPixelsPerByte) * BITS)) & EValueMask;
+		}
+	static inline void Write(TAny* aScanLine, TInt aX, TUint32 aPixel)
+		{
+		TUint8& byte = static_cast<TUint8*>(aScanLine)[aX / EPixelsPerByte];
+		const TInt shift = (aX % EPixelsPerByte) * BITS;
+		byte = TUint8((byte & ~(EValueMask << shift)) | ((aPixel & EValueMask) << shift));
+		}
+	};
+
+template <>
+struct TPixelAccess<8>
+	{
+	static inline TUint32 Read(const TAny* aScanLine, TInt aX)
+		{
+		return static_cast<const TUint8*>(aScanLine)[aX];
+		}
+	static inline void Write(TAny* aScanLine, TInt aX, TUint32 aPixel)
+		{
+		static_cast<TUint8*>(aScanLine)[aX] = TUint8(aPixel);
+		}
+	};
+
+template <>
+struct TPixelAccess<16>
+	{
+	static inline TUint32 Read(const TAny* aScanLine, TInt aX)
+		{
+		return static_cast<const TUint16*>(aScanLine)[aX];
+		}
+	static inline void Write(TAny* aScanLine, TInt aX, TUint32 aPixel)
+		{
+		static_cast<TUint16*>(aScanLine)[aX] = TUint16(aPixel);
+		}
+	};
+
+template <>
+struct TPixelAccess<24>
+	{
+	static inline TUint32 Read(const TAny* aScanLine, TInt aX)
+		{
+		const TUint8* pixel = static_cast<const TUint8*>(aScanLine) + aX * 3;
+		return pixel[0] | (pixel[1] << 8) | (pixel[2] << 16);
+		}
+	static inline void Write(TAny* aScanLine, TInt aX, TUint32 aPixel)
+		{
+		TUint8* pixel = static_cast<TUint8*>(aScanLine) + aX * 3;
+		pixel[0] = TUint8(aPixel);
+		pixel[1] = TUint8(aPixel >> 8);
+		pixel[2] = TUint8(aPixel >> 16);
+		}
+	};
+
+template <>
+struct TPixelAccess<32>
+	{
+	static inline TUint32 Read(const TAny* aScanLine, TInt aX)
+		{
+		return static_cast<const TUint32*>(aScanLine)[aX];
+		}
+	static inline void Write(TAny* aScanLine, TInt aX, TUint32 aPixel)
+		{
+		static_cast<TUint32*>(aScanLine)[aX] = aPixel;
+		}
+	};
+
+/**
+Compile-time description of a display mode: pixel size, pixel access and conversion to and
+from TRgb. The conversions are those of the TRgb class, so that code built on these traits
+gives the same result as a per-pixel TRgb conversion.
+ERgb pixels are TRgb values, stored as returned by TRgb::Internal().
+@internalComponent
+*/
+template <TDisplayMode MODE>
+struct TPixelFormat;
+
+#define BITDRAW_PIXEL_FORMAT(aMode, aBits, aToRgb, aFromRgb) \
+template <> \
+struct TPixelFormat<aMode> : public TPixelAccess<aBits> \
+	{ \
+	enum {EBitsPerPixel = aBits}; \
+	static inline TRgb ToRgb(TUint32 aPixel) {return aToRgb;} \
+	static inline TUint32 FromRgb(TRgb aColor) {return aFromRgb;} \
+	}
+
+BITDRAW_PIXEL_FORMAT(EGray2, 1, TRgb::Gray2(aPixel), aColor.Gray2());
+BITDRAW_PIXEL_FORMAT(EGray4, 2, TRgb::Gray4(aPixel), aColor.Gray4());
+BITDRAW_PIXEL_FORMAT(EGray16, 4, TRgb::Gray16(aPixel), aColor.Gray16());
+BITDRAW_PIXEL_FORMAT(EGray256, 8, TRgb::Gray256(aPixel), aColor.Gray256());
+BITDRAW_PIXEL_FORMAT(EColor16, 4, TRgb::Color16(aPixel), aColor.Color16());
+BITDRAW_PIXEL_FORMAT(EColor256, 8, TRgb::Color256(aPixel), aColor.Color256());
+BITDRAW_PIXEL_FORMAT(EColor4K, 16, TRgb::Color4K(aPixel), aColor.Color4K());
+BITDRAW_PIXEL_FORMAT(EColor64K, 16, TRgb::Color64K(aPixel), aColor.Color64K());
+BITDRAW_PIXEL_FORMAT(EColor16M, 24, TRgb::Color16M(aPixel), aColor.Color16M());
+BITDRAW_PIXEL_FORMAT(ERgb, 32, TRgb(aPixel & 0x00ffffff, aPixel >> 24), aColor.Internal());
+BITDRAW_PIXEL_FORMAT(EColor16MU, 32, TRgb::_Color16MU(aPixel), aColor._Color16MU() | 0xff000000);
+BITDRAW_PIXEL_FORMAT(EColor16MA, 32, TRgb::_Color16MA(aPixel), aColor._Color16MA());
+BITDRAW_PIXEL_FORMAT(EColor16MAP, 32, TRgb::_Color16MAP(aPixel), aColor._Color16MAP());
+
+#undef BITDRAW_PIXEL_FORMAT
+
+#endif
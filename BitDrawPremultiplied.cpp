@@ -0,0 +1,97 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawPremultiplied.h"
+
+/** Pixels handled at once when a line is not contiguous in memory or is split for WriteRgbAlphaLine(). */
+const TInt KPremultipliedChunkPixels = 64;
+
+/**
+@return ETrue if Write() can compose into a device with layout aInfo.
+*/
+TBool TPremultipliedLine::IsSupported(const TDirectScanLineInfo& aInfo)
+	{
+	return aInfo.iFactorX == 1 && aInfo.iFactorY == 1 && TAlphaBlendSpan::IsPremultipliedModeSupported(aInfo.iDisplayMode);
+	}
+
+/**
+Composes a line of premultiplied pixels into the memory described by aInfo. Implements
+MPremultipliedAlphaBlending::WriteRgbAlphaLinePremultiplied() for devices with no shadowing or
+fading set.
+@param aInfo	Memory layout of the device
+@param aX		Logical x coordinate of the first pixel
+@param aY		Logical y coordinate of the line
+@param aLength	Number of pixels; the line must lie within the device
+@param aPixels	Source pixels in EColor16MAP format
+@return KErrNone, or KErrNotSupported if IsSupported() returns EFalse; nothing is drawn then.
+*/
+TInt TPremultipliedLine::Write(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength, const TUint32* aPixels) const
+	{
+	if (!IsSupported(aInfo))
+		return KErrNotSupported;
+	const TInt xStep = aInfo.iLogicalXStep.iX * 4 + aInfo.iLogicalXStep.iY * aInfo.iStride;
+	TUint8* dest = static_cast<TUint8*>(aInfo.PixelAddress(aX, aY));
+	if (xStep == 4)
+		{
+		iBlend.BlendPremultipliedLine(aInfo.iDisplayMode, dest, aPixels, aLength);
+		return KErrNone;
+		}
+	TUint32 gathered[KPremultipliedChunkPixels];
+	while (aLength > 0)
+		{
+		const TInt count = Min(aLength, KPremultipliedChunkPixels);
+		TUint8* pixel = dest;
+		for (TInt index = 0; index < count; index++, pixel += xStep)
+			gathered[index] = *reinterpret_cast<TUint32*>(pixel);
+		iBlend.BlendPremultipliedLine(aInfo.iDisplayMode, gathered, aPixels, count);
+		pixel = dest;
+		for (TInt index = 0; index < count; index++, pixel += xStep)
+			*reinterpret_cast<TUint32*>(pixel) = gathered[index];
+		dest += count * xStep;
+		aPixels += count;
+		aLength -= count;
+		}
+	return KErrNone;
+	}
+
+/**
+Composes a line of premultiplied pixels through WriteRgbAlphaLine() of aDevice. Implements
+MPremultipliedAlphaBlending::WriteRgbAlphaLinePremultiplied() for any device.
+@param aDevice	Device to draw to
+@param aX		Logical x coordinate of the first pixel
+@param aY		Logical y coordinate of the line
+@param aLength	Number of pixels
+@param aPixels	Source pixels in EColor16MAP format
+*/
+void TPremultipliedLine::WriteWithPrimitives(CFbsDrawDevice& aDevice, TInt aX, TInt aY, TInt aLength, const TUint32* aPixels)
+	{
+	TUint32 rgb[KPremultipliedChunkPixels];
+	TUint8 mask[KPremultipliedChunkPixels];
+	while (aLength > 0)
+		{
+		const TInt count = Min(aLength, KPremultipliedChunkPixels);
+		for (TInt index = 0; index < count; index++)
+			{
+			const TUint32 pixel = aPixels[index];
+			const TUint32 alpha = pixel >> 24;
+			mask[index] = TUint8(alpha);
+			rgb[index] = alpha == 0xff || alpha == 0 ? pixel & 0x00ffffff : TRgb::_Color16MAP(pixel)._Color16MU();
+			}
+		aDevice.WriteRgbAlphaLine(aX, aY, count, reinterpret_cast<TUint8*>(rgb), mask, CGraphicsContext::EDrawModePEN);
+		aX += count;
+		aPixels += count;
+		aLength -= count;
+		}
+	}
@@ -0,0 +1,70 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWPREMULTIPLIED_H__
+#define __BITDRAWPREMULTIPLIED_H__
+
+#include "BitDrawDirectAccess.h"
+#include "BitDrawAlphaBlend.h"
+
+/**
+Premultiplied alpha compositing for draw devices, retrieved with
+CFbsDrawDevice::GetInterface(KPremultipliedAlphaInterfaceID, ...).
+
+WriteRgbAlphaLine() takes the colour and the alpha of the source in separate buffers and divides
+by 255 per channel. Sources that are already premultiplied, such as EColor16MAP bitmaps, can be
+passed to this interface as they are, interleaved, and are composed src-over straight into the
+device.
+Screen devices must be told about the changed area with UpdateRegion().
+@see TPremultipliedLine
+@internalComponent
+*/
+class MPremultipliedAlphaBlending
+	{
+public:
+	/**
+	Composes a line of premultiplied pixels over the device (src-over).
+	@param aX		Logical x coordinate of the first pixel
+	@param aY		Logical y coordinate of the line
+	@param aLength	Number of pixels
+	@param aPixels	Source pixels in EColor16MAP format
+	*/
+	virtual void WriteRgbAlphaLinePremultiplied(TInt aX, TInt aY, TInt aLength, const TUint32* aPixels) = 0;
+	};
+
+/**
+Implementations of MPremultipliedAlphaBlending.
+
+Write() composes into the memory layout of an unscaled EColor16MU or EColor16MAP device, in any
+orientation, with the TAlphaBlendSpan kernels: in place for rows that are contiguous in memory and
+through a small buffer otherwise. Shadowing and fading are not applied, so a device must only use
+it with ENoShadow.
+
+WriteWithPrimitives() works on any device by splitting the pixels into the colour and mask
+buffers of WriteRgbAlphaLine(). Undoing the premultiplication costs a division per pixel and may
+differ from Write() by rounding.
+@internalComponent
+*/
+class TPremultipliedLine
+	{
+public:
+	static TBool IsSupported(const TDirectScanLineInfo& aInfo);
+	TInt Write(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength, const TUint32* aPixels) const;
+	static void WriteWithPrimitives(CFbsDrawDevice& aDevice, TInt aX, TInt aY, TInt aLength, const TUint32* aPixels);
+private:
+	TAlphaBlendSpan iBlend;
+	};
+
+#endif
@@ -0,0 +1,511 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawRasterOp.h"
+#include "BitDrawMapColors.h"
+#include "bitdraw.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define __BITDRAW_SSE2__
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define __BITDRAW_NEON__
+#include <arm_neon.h>
+#endif
+
+/**
+Operation CombineLine() applies between the destination and the source, after inverting them.
+*/
+enum TRasterCombine
+	{
+	ECombineNone,
+	ECombineCopy,
+	ECombineXor,
+	ECombineAnd,
+	ECombineOr
+	};
+
+LOCAL_C TInt BitsPerPixel(TDisplayMode aDispMode)
+	{
+	switch (aDispMode)
+		{
+	case EGray2:
+		return 1;
+	case EGray4:
+		return 2;
+	case EGray16:
+	case EColor16:
+		return 4;
+	case EGray256:
+	case EColor256:
+		return 8;
+	case EColor4K:
+	case EColor64K:
+		return 16;
+	case EColor16M:
+		return 24;
+	case EColor16MU:
+	case EColor16MA:
+	case EColor16MAP:
+		return 32;
+	default:
+		return 0;
+		}
+	}
+
+/**
+Repeats a pixel of aBits bits over three words, the first pixel in the least significant bits.
+*/
+LOCAL_C void Replicate(TUint32 aPixel, TInt aBits, TUint32 aWords[3])
+	{
+	if (aBits == 24)
+		{
+		aPixel &= 0x00ffffff;
+		aWords[0] = aPixel | (aPixel << 24);
+		aWords[1] = (aPixel >> 8) | (aPixel << 16);
+		aWords[2] = (aPixel >> 16) | (aPixel << 8);
+		return;
+		}
+	TUint32 word = aBits == 32 ? aPixel : aPixel & ((1u << aBits) - 1);
+	for (TInt bits = aBits; bits < 32; bits <<= 1)
+		word |= word << bits;
+	aWords[0] = aWords[1] = aWords[2] = word;
+	}
+
+/**
+Extracts aCount bits, at most 32, starting at bit aBit of aBuffer.
+*/
+LOCAL_C TUint32 ExtractBits(const TUint32* aBuffer, TInt aBit, TInt aCount)
+	{
+	const TInt shift = aBit & 31;
+	aBuffer += aBit >> 5;
+	TUint32 value = aBuffer[0] >> shift;
+	if (shift && shift + aCount > 32)
+		value |= aBuffer[1] << (32 - shift);
+	return aCount < 32 ? value & ((1u << aCount) - 1) : value;
+	}
+
+/**
+@return A mask of aCount bits, at most 32, starting at bit aShift.
+*/
+LOCAL_C inline TUint32 BitMask(TInt aShift, TInt aCount)
+	{
+	return (aCount < 32 ? (1u << aCount) - 1 : 0xffffffffu) << aShift;
+	}
+
+//
+// Combine kernels, one instantiation per logical operation.
+//
+
+template <TInt OP>
+LOCAL_C inline TUint32 Combine(TUint32 aDest, TUint32 aSrc, const TRasterOpMasks& aMasks)
+	{
+	const TUint32 dest = aDest ^ aMasks.iInvertDest;
+	const TUint32 src = aSrc ^ aMasks.iInvertSource;
+	TUint32 result;
+	switch (OP)
+		{
+	case ECombineCopy:
+		result = src;
+		break;
+	case ECombineXor:
+		result = dest ^ src;
+		break;
+	case ECombineAnd:
+		result = dest & src;
+		break;
+	case ECombineOr:
+		result = dest | src;
+		break;
+	default:
+		result = dest;
+		break;
+		}
+	return (result & aMasks.iKeep) | aMasks.iForce;
+	}
+
+#if defined(__BITDRAW_SSE2__)
+template <TInt OP>
+LOCAL_C inline __m128i CombineSse2(__m128i aDest, __m128i aSrc, __m128i aInvertDest, __m128i aInvertSource, __m128i aKeep, __m128i aForce)
+	{
+	const __m128i dest = _mm_xor_si128(aDest, aInvertDest);
+	const __m128i src = _mm_xor_si128(aSrc, aInvertSource);
+	__m128i result;
+	switch (OP)
+		{
+	case ECombineCopy:
+		result = src;
+		break;
+	case ECombineXor:
+		result = _mm_xor_si128(dest, src);
+		break;
+	case ECombineAnd:
+		result = _mm_and_si128(dest, src);
+		break;
+	case ECombineOr:
+		result = _mm_or_si128(dest, src);
+		break;
+	default:
+		result = dest;
+		break;
+		}
+	return _mm_or_si128(_mm_and_si128(result, aKeep), aForce);
+	}
+#elif defined(__BITDRAW_NEON__)
+template <TInt OP>
+LOCAL_C inline uint32x4_t CombineNeon(uint32x4_t aDest, uint32x4_t aSrc, uint32x4_t aInvertDest, uint32x4_t aInvertSource, uint32x4_t aKeep, uint32x4_t aForce)
+	{
+	const uint32x4_t dest = veorq_u32(aDest, aInvertDest);
+	const uint32x4_t src = veorq_u32(aSrc, aInvertSource);
+	uint32x4_t result;
+	switch (OP)
+		{
+	case ECombineCopy:
+		result = src;
+		break;
+	case ECombineXor:
+		result = veorq_u32(dest, src);
+		break;
+	case ECombineAnd:
+		result = vandq_u32(dest, src);
+		break;
+	case ECombineOr:
+		result = vorrq_u32(dest, src);
+		break;
+	default:
+		result = dest;
+		break;
+		}
+	return vorrq_u32(vandq_u32(result, aKeep), aForce);
+	}
+#endif
+
+/**
+Combines aCount bytes of aSrc into the bytes of aScanLine starting at byte aOffset, for
+modes of 8bpp or more. The masks repeat every word from the start of the scan line, which is
+word aligned.
+*/
+template <TInt OP>
+LOCAL_C void CombineBytes(TUint8* aScanLine, TInt aOffset, const TUint8* aSrc, TInt aCount, const TRasterOpMasks& aMasks)
+	{
+	TUint8* dest = aScanLine + aOffset;
+	TUint8* const end = dest + aCount;
+	// Bytes up to a word boundary, then words, then the bytes left.
+	for (; dest < end && (aOffset & 3); dest++, aSrc++, aOffset++)
+		{
+		const TInt shift = (aOffset & 3) * 8;
+		*dest = TUint8(Combine<OP>(TUint32(*dest) << shift, TUint32(*aSrc) << shift, aMasks) >> shift);
+		}
+	TUint32* words = reinterpret_cast<TUint32*>(dest);
+	TInt count = TInt(end - dest) >> 2;
+	TInt i = 0;
+#if defined(__BITDRAW_SSE2__)
+	const __m128i invertDest = _mm_set1_epi32(aMasks.iInvertDest);
+	const __m128i invertSource = _mm_set1_epi32(aMasks.iInvertSource);
+	const __m128i keep = _mm_set1_epi32(aMasks.iKeep);
+	const __m128i force = _mm_set1_epi32(aMasks.iForce);
+	for (; i + 4 <= count; i += 4)
+		{
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + i));
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i * 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(words + i), CombineSse2<OP>(d, s, invertDest, invertSource, keep, force));
+		}
+#elif defined(__BITDRAW_NEON__)
+	const uint32x4_t invertDest = vdupq_n_u32(aMasks.iInvertDest);
+	const uint32x4_t invertSource = vdupq_n_u32(aMasks.iInvertSource);
+	const uint32x4_t keep = vdupq_n_u32(aMasks.iKeep);
+	const uint32x4_t force = vdupq_n_u32(aMasks.iForce);
+	for (; i + 4 <= count; i += 4)
+		{
+		const uint32x4_t d = vld1q_u32(words + i);
+		const uint32x4_t s = vreinterpretq_u32_u8(vld1q_u8(aSrc + i * 4));
+		vst1q_u32(words + i, CombineNeon<OP>(d, s, invertDest, invertSource, keep, force));
+		}
+#endif
+	// The source is aligned like the destination only when aOffset is.
+	for (; i < count; i++)
+		{
+		const TUint8* src = aSrc + i * 4;
+		const TUint32 word = src[0] | (src[1] << 8) | (src[2] << 16) | (TUint32(src[3]) << 24);
+		words[i] = Combine<OP>(words[i], word, aMasks);
+		}
+	dest += count * 4;
+	aSrc += count * 4;
+	for (TInt shift = 0; dest < end; dest++, aSrc++, shift += 8)
+		*dest = TUint8(Combine<OP>(TUint32(*dest) << shift, TUint32(*aSrc) << shift, aMasks) >> shift);
+	}
+
+/**
+Combines aBits bits of aSrc into the bits of aScanLine starting at bit aBit, a word at a
+time, for sub-byte modes.
+*/
+template <TInt OP>
+LOCAL_C void CombineBits(TUint32* aScanLine, TInt aBit, const TUint32* aSrc, TInt aBits, const TRasterOpMasks& aMasks)
+	{
+	const TInt end = aBit + aBits;
+	for (TInt bit = aBit; bit < end; )
+		{
+		const TInt shift = bit & 31;
+		const TInt count = Min(32 - shift, end - bit);
+		const TUint32 mask = BitMask(shift, count);
+		TUint32& word = aScanLine[bit >> 5];
+		const TUint32 src = ExtractBits(aSrc, bit - aBit, count) << shift;
+		word = (word & ~mask) | (Combine<OP>(word, src, aMasks) & mask);
+		bit += count;
+		}
+	}
+
+template <TInt OP>
+LOCAL_C void CombineLine(TAny* aScanLine, TInt aX, const TAny* aSrc, TInt aLength, TInt aBitsPerPixel, const TRasterOpMasks& aMasks)
+	{
+	if (aBitsPerPixel >= 8)
+		{
+		const TInt bytes = aBitsPerPixel >> 3;
+		CombineBytes<OP>(static_cast<TUint8*>(aScanLine), aX * bytes, static_cast<const TUint8*>(aSrc), aLength * bytes, aMasks);
+		}
+	else
+		CombineBits<OP>(static_cast<TUint32*>(aScanLine), aX * aBitsPerPixel, static_cast<const TUint32*>(aSrc), aLength * aBitsPerPixel, aMasks);
+	}
+
+/**
+@return ETrue if Set() accepts aDrawMode for aDispMode, with an opaque colour for EPenmode.
+*/
+TBool TRasterOp::IsSupported(TDisplayMode aDispMode, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	if (aDispMode == EColor16MA || aDispMode == EColor16MAP)
+		return (aDrawMode & (CGraphicsContext::EPenmode | CGraphicsContext::EWriteAlpha)) != 0;
+	return BitsPerPixel(aDispMode) != 0;
+	}
+
+/**
+Prepares the raster operation of a draw mode and a colour.
+@param aDispMode	Display mode of the scan lines
+@param aDrawMode	Draw mode to apply
+@param aColor		Pen colour, ignored by CombineLine()
+@return KErrNone, or KErrNotSupported if IsSupported() returns EFalse or aDrawMode is
+		EPenmode with a colour that is not opaque; the operation is unchanged then.
+*/
+TInt TRasterOp::Set(TDisplayMode aDispMode, CGraphicsContext::TDrawMode aDrawMode, TRgb aColor)
+	{
+	const TBool write = (aDrawMode & (CGraphicsContext::EPenmode | CGraphicsContext::EWriteAlpha)) != 0;
+	if (!IsSupported(aDispMode, aDrawMode) ||
+		((aDrawMode & CGraphicsContext::EPenmode) && aColor.Alpha() != 0xff))
+		return KErrNotSupported;
+	iBitsPerPixel = BitsPerPixel(aDispMode);
+	iPixelMask = iBitsPerPixel == 32 ? 0xffffffffu : (1u << iBitsPerPixel) - 1;
+	iPeriod = iBitsPerPixel == 24 ? 3 : 1;
+	if (aDrawMode & CGraphicsContext::EInvertPen)
+		aColor = TRgb(0xff - aColor.Red(), 0xff - aColor.Green(), 0xff - aColor.Blue(), aColor.Alpha());
+	TUint32 pen[3];
+	TUint32 white[3];
+	Replicate(RDrawColorMap::RgbToPixel(aDispMode, aColor), iBitsPerPixel, pen);
+	Replicate(RDrawColorMap::RgbToPixel(aDispMode, KRgbWhite), iBitsPerPixel, white);
+	const TUint32 invertDest = aDrawMode & CGraphicsContext::EInvertScreen ? white[0] : 0;
+	const TBool opaque = aDispMode == EColor16MU;
+	for (TInt index = 0; index < 3; index++)
+		{
+		TUint32 andMask = 0xffffffffu;
+		TUint32 xorMask = 0;
+		if (write)
+			{
+			andMask = 0;
+			xorMask = pen[index];
+			}
+		else
+			{
+			if (aDrawMode & CGraphicsContext::EInvertScreen)
+				xorMask = white[index];
+			if (aDrawMode & CGraphicsContext::EXor)
+				xorMask ^= pen[index];
+			else if (aDrawMode & CGraphicsContext::EAnd)
+				{
+				andMask &= pen[index];
+				xorMask &= pen[index];
+				}
+			else if (aDrawMode & CGraphicsContext::EOr)
+				{
+				andMask &= ~pen[index];
+				xorMask = (xorMask & ~pen[index]) ^ pen[index];
+				}
+			}
+		iAnd[index] = opaque ? andMask & 0x00ffffff : andMask;
+		iXor[index] = opaque ? xorMask | 0xff000000 : xorMask;
+		}
+
+	if (write)
+		iCombine = ECombineCopy;
+	else if (aDrawMode & CGraphicsContext::EXor)
+		iCombine = ECombineXor;
+	else if (aDrawMode & CGraphicsContext::EAnd)
+		iCombine = ECombineAnd;
+	else if (aDrawMode & CGraphicsContext::EOr)
+		iCombine = ECombineOr;
+	else
+		iCombine = ECombineNone;
+	// The source of a line is in the display mode already: inverting it inverts the pixel.
+	iMasks.iInvertDest = write ? 0 : invertDest;
+	iMasks.iInvertSource = aDrawMode & CGraphicsContext::EInvertPen ? white[0] : 0;
+	iMasks.iKeep = opaque ? 0x00ffffff : 0xffffffffu;
+	iMasks.iForce = opaque ? 0xff000000 : 0;
+	return KErrNone;
+	}
+
+/**
+Applies the operation to the whole words aMask selects of aWord, for phase aPhase of the
+pattern.
+*/
+inline TUint32 TRasterOp::FillWord(TUint32 aWord, TUint32 aMask, TInt aPhase) const
+	{
+	return (aWord & ~aMask) | (((aWord & iAnd[aPhase]) ^ iXor[aPhase]) & aMask);
+	}
+
+void TRasterOp::FillWords(TUint32* aWords, TInt aCount, TInt aPhase) const
+	{
+	TInt i = 0;
+	if (iPeriod == 1)
+		{
+		const TUint32 andMask = iAnd[0];
+		const TUint32 xorMask = iXor[0];
+#if defined(__BITDRAW_SSE2__)
+		const __m128i andVector = _mm_set1_epi32(andMask);
+		const __m128i xorVector = _mm_set1_epi32(xorMask);
+		for (; i + 4 <= aCount; i += 4)
+			{
+			__m128i* words = reinterpret_cast<__m128i*>(aWords + i);
+			_mm_storeu_si128(words, _mm_xor_si128(_mm_and_si128(_mm_loadu_si128(words), andVector), xorVector));
+			}
+#elif defined(__BITDRAW_NEON__)
+		const uint32x4_t andVector = vdupq_n_u32(andMask);
+		const uint32x4_t xorVector = vdupq_n_u32(xorMask);
+		for (; i + 4 <= aCount; i += 4)
+			vst1q_u32(aWords + i, veorq_u32(vandq_u32(vld1q_u32(aWords + i), andVector), xorVector));
+#endif
+		for (; i < aCount; i++)
+			aWords[i] = (aWords[i] & andMask) ^ xorMask;
+		return;
+		}
+	for (; i < aCount; i++)
+		{
+		aWords[i] = (aWords[i] & iAnd[aPhase]) ^ iXor[aPhase];
+		if (++aPhase == iPeriod)
+			aPhase = 0;
+		}
+	}
+
+/**
+Applies the operation to aLength pixels of a scan line, from pixel aX.
+@param aScanLine	Word aligned scan line, in the display mode given to Set()
+@param aX			First pixel
+@param aLength		Number of pixels
+*/
+void TRasterOp::FillSpan(TAny* aScanLine, TInt aX, TInt aLength) const
+	{
+	TUint32* words = static_cast<TUint32*>(aScanLine);
+	TInt bit = aX * iBitsPerPixel;
+	const TInt end = bit + aLength * iBitsPerPixel;
+	if (bit >= end)
+		return;
+	if (bit & 31)
+		{
+		const TInt count = Min(32 - (bit & 31), end - bit);
+		const TInt word = bit >> 5;
+		words[word] = FillWord(words[word], BitMask(bit & 31, count), word % iPeriod);
+		bit += count;
+		}
+	const TInt first = bit >> 5;
+	const TInt last = end >> 5;
+	if (last > first)
+		FillWords(words + first, last - first, first % iPeriod);
+	if (bit < end && (end & 31))
+		words[last] = FillWord(words[last], BitMask(0, end & 31), last % iPeriod);
+	}
+
+/**
+Applies the operation to the pixels of a scan line whose bit is set in aBits, as WriteBinary()
+and WriteBinaryLine() do. Runs of set bits are filled as spans; EGray2 lines are masked a word
+at a time.
+@param aScanLine	Word aligned scan line, in the display mode given to Set()
+@param aX			Pixel of the first bit
+@param aBits		Bits, the first pixel in the least significant bit of the first word
+@param aLength		Number of bits
+*/
+void TRasterOp::FillBinary(TAny* aScanLine, TInt aX, const TUint32* aBits, TInt aLength) const
+	{
+	if (iBitsPerPixel == 1)
+		{
+		TUint32* words = static_cast<TUint32*>(aScanLine);
+		const TInt end = aX + aLength;
+		for (TInt bit = aX; bit < end; )
+			{
+			const TInt shift = bit & 31;
+			const TInt count = Min(32 - shift, end - bit);
+			const TUint32 mask = ExtractBits(aBits, bit - aX, count) << shift;
+			if (mask)
+				words[bit >> 5] = FillWord(words[bit >> 5], mask, 0);
+			bit += count;
+			}
+		return;
+		}
+	for (TInt index = 0; index < aLength; )
+		{
+		if (!(aBits[index >> 5] >> (index & 31)))
+			{
+			index = (index | 31) + 1;
+			continue;
+			}
+		if (!(aBits[index >> 5] & (1u << (index & 31))))
+			{
+			index++;
+			continue;
+			}
+		TInt end = index + 1;
+		while (end < aLength && (aBits[end >> 5] & (1u << (end & 31))))
+			end++;
+		FillSpan(aScanLine, aX + index, end - index);
+		index = end;
+		}
+	}
+
+/**
+Combines a line of pixels into a scan line with the logical operation of the draw mode, as
+WriteLine() does. The colour given to Set() is not used.
+@param aScanLine	Word aligned scan line, in the display mode given to Set()
+@param aX			First pixel of the scan line
+@param aSrc			Word aligned source pixels, in the same display mode, from its first pixel
+@param aLength		Number of pixels
+*/
+void TRasterOp::CombineLine(TAny* aScanLine, TInt aX, const TAny* aSrc, TInt aLength) const
+	{
+	switch (iCombine)
+		{
+	case ECombineCopy:
+		::CombineLine<ECombineCopy>(aScanLine, aX, aSrc, aLength, iBitsPerPixel, iMasks);
+		break;
+	case ECombineXor:
+		::CombineLine<ECombineXor>(aScanLine, aX, aSrc, aLength, iBitsPerPixel, iMasks);
+		break;
+	case ECombineAnd:
+		::CombineLine<ECombineAnd>(aScanLine, aX, aSrc, aLength, iBitsPerPixel, iMasks);
+		break;
+	case ECombineOr:
+		::CombineLine<ECombineOr>(aScanLine, aX, aSrc, aLength, iBitsPerPixel, iMasks);
+		break;
+	default:
+		::CombineLine<ECombineNone>(aScanLine, aX, aSrc, aLength, iBitsPerPixel, iMasks);
+		break;
+		}
+	}
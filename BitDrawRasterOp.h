@@ -0,0 +1,85 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWRASTEROP_H__
+#define __BITDRAWRASTEROP_H__
+
+#include <gdi.h>
+
+/**
+Masks applied by TRasterOp::CombineLine(), replicated to a 32 bit word.
+@internalComponent
+*/
+struct TRasterOpMasks
+	{
+	TUint32 iInvertDest;	///< XORed with the destination, for EInvertScreen
+	TUint32 iInvertSource;	///< XORed with the source, for EInvertPen
+	TUint32 iKeep;			///< ANDed with the result
+	TUint32 iForce;			///< ORed with the result
+	};
+
+/**
+Raster operations of CGraphicsContext::TDrawMode on scan lines, used to implement the draw
+modes of WriteRgb(), WriteRgbMulti(), WriteBinary(), WriteBinaryLine() and WriteLine().
+
+The draw mode is applied to pixel values, as CFbsDrawDevice does: EInvertPen inverts the
+colour before it is converted to the display mode, EInvertScreen XORs the destination with
+the pixel value of white, and then EXor, EAnd or EOr combine it with the pen, in that order
+of precedence. EPenmode and EWriteAlpha write the pen. EColor16MU pixels are left opaque.
+
+Set() reduces any draw mode and colour to dest = (dest AND a) XOR b, with a and b replicated
+to whole words, so FillSpan() processes 32 bits at a time whatever the pixel size, sub-byte
+modes included, and 16 bytes at a time with SSE2 or NEON for modes whose pattern fits a word;
+EColor16M patterns repeat every 3 words and are processed a word at a time. CombineLine() has
+a kernel specialized at compile time for each logical operation, with the same SIMD paths for
+modes of 8bpp or more and a word at a time for sub-byte modes.
+
+A pen with an alpha value other than 255 is blended rather than written by EPenmode, which
+Set() does not support. EColor16MA and EColor16MAP only support EPenmode and EWriteAlpha, as
+their logical operations would act on the alpha channel.
+@internalComponent
+*/
+class TRasterOp
+	{
+public:
+	static TBool IsSupported(TDisplayMode aDispMode, CGraphicsContext::TDrawMode aDrawMode);
+	TInt Set(TDisplayMode aDispMode, CGraphicsContext::TDrawMode aDrawMode, TRgb aColor);
+	inline TUint32 Pixel(TUint32 aDest) const;
+	void FillSpan(TAny* aScanLine, TInt aX, TInt aLength) const;
+	void FillBinary(TAny* aScanLine, TInt aX, const TUint32* aBits, TInt aLength) const;
+	void CombineLine(TAny* aScanLine, TInt aX, const TAny* aSrc, TInt aLength) const;
+private:
+	void FillWords(TUint32* aWords, TInt aCount, TInt aPhase) const;
+	inline TUint32 FillWord(TUint32 aWord, TUint32 aMask, TInt aPhase) const;
+private:
+	TInt iBitsPerPixel;
+	TUint32 iPixelMask;
+	TInt iPeriod;			///< Number of words after which iAnd and iXor repeat: 1, or 3 for EColor16M
+	TUint32 iAnd[3];
+	TUint32 iXor[3];
+	TInt iCombine;
+	TRasterOpMasks iMasks;
+	};
+
+/**
+@param aDest	A pixel of the display mode given to Set()
+@return The pixel left by the raster operation.
+*/
+inline TUint32 TRasterOp::Pixel(TUint32 aDest) const
+	{
+	return ((aDest & iAnd[0]) ^ iXor[0]) & iPixelMask;
+	}
+
+#endif
@@ -0,0 +1,600 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawRecording.h"
+#include "BitDrawPixelFormat.h"
+
+LOCAL_C inline TInt64 Area(const TRect& aRect)
+	{
+	return TInt64(aRect.Width()) * aRect.Height();
+	}
+
+LOCAL_C inline TBool Contains(const TRect& aOuter, const TRect& aInner)
+	{
+	return aInner.iTl.iX >= aOuter.iTl.iX && aInner.iBr.iX <= aOuter.iBr.iX &&
+		   aInner.iTl.iY >= aOuter.iTl.iY && aInner.iBr.iY <= aOuter.iBr.iY;
+	}
+
+/**
+Removes from aRect the part covered by aOccluder, if what is left is still a rectangle.
+*/
+LOCAL_C void Trim(TRect& aRect, const TRect& aOccluder)
+	{
+	if (!aRect.Intersects(aOccluder))
+		return;
+	if (aOccluder.iTl.iX <= aRect.iTl.iX && aOccluder.iBr.iX >= aRect.iBr.iX)
+		{
+		if (aOccluder.iTl.iY <= aRect.iTl.iY)
+			aRect.iTl.iY = aOccluder.iBr.iY;
+		else if (aOccluder.iBr.iY >= aRect.iBr.iY)
+			aRect.iBr.iY = aOccluder.iTl.iY;
+		}
+	else if (aOccluder.iTl.iY <= aRect.iTl.iY && aOccluder.iBr.iY >= aRect.iBr.iY)
+		{
+		if (aOccluder.iTl.iX <= aRect.iTl.iX)
+			aRect.iTl.iX = aOccluder.iBr.iX;
+		else if (aOccluder.iBr.iX >= aRect.iBr.iX)
+			aRect.iBr.iX = aOccluder.iTl.iX;
+		}
+	}
+
+/**
+Creates a recording device.
+@param aTarget Device the recorded primitives are replayed into. Ownership is transferred if
+the function does not leave.
+@return The new device
+@leave KErrNoMemory Not enough memory
+*/
+CRecordingDrawDevice* CRecordingDrawDevice::NewL(CFbsDrawDevice* aTarget)
+	{
+	CRecordingDrawDevice* self = new(ELeave) CRecordingDrawDevice(aTarget);
+	TRAPD(err, self->ConstructL());
+	if (err != KErrNone)
+		{
+		// Ownership of aTarget stays with the caller.
+		self->iTarget = NULL;
+		delete self;
+		User::Leave(err);
+		}
+	return self;
+	}
+
+CRecordingDrawDevice::CRecordingDrawDevice(CFbsDrawDevice* aTarget):
+	CForwardingDrawDevice(aTarget)
+	{
+	iTarget->SetAutoUpdate(EFalse);
+	}
+
+void CRecordingDrawDevice::ConstructL()
+	{
+	iCommands = new(ELeave) TCommand[KMaxRecordedCommands];
+	iData = static_cast<TUint8*>(User::AllocL(KMaxRecordedBytes));
+	}
+
+/**
+Replays any recorded commands before the target is destroyed.
+*/
+CRecordingDrawDevice::~CRecordingDrawDevice()
+	{
+	if (iTarget)
+		Replay();
+	delete [] iCommands;
+	User::Free(iData);
+	}
+
+/**
+Culls the recorded commands that later opaque fills overwrite, replays the rest into the target,
+passes it the area reported with UpdateRegion() and, if auto-update is on, updates the target.
+*/
+void CRecordingDrawDevice::Flush()
+	{
+	if (iCount == 0 && iUpdateRegion.IsEmpty())
+		return;
+	Replay();
+	if (iAutoUpdate)
+		iTarget->Update();
+	}
+
+void CRecordingDrawDevice::Replay()
+	{
+	Cull();
+	TInt index = 0;
+	while (index < iCount)
+		index = ReplayCommand(index);
+	iCount = 0;
+	iDataLength = 0;
+	const TRect* rect = iUpdateRegion.RectangleList();
+	for (TInt count = iUpdateRegion.Count(); count > 0; count--, rect++)
+		iTarget->UpdateRegion(*rect);
+	iUpdateRegion.Clear();
+	}
+
+/**
+Lets the const functions that read pixels flush the recorded commands first.
+*/
+void CRecordingDrawDevice::FlushConst() const
+	{
+	const_cast<CRecordingDrawDevice*>(this)->Flush();
+	}
+
+/**
+Walks the commands from the last to the first, remembering the opaque fills seen so far.
+Commands inside a remembered fill are marked as culled, fills partly inside one are trimmed.
+Commands in between that read the destination (blending, MapColors(), ShadowArea()) only read
+pixels inside the culled area that the later fill overwrites anyway.
+*/
+void CRecordingDrawDevice::Cull()
+	{
+	TRect occluders[KMaxOccluders];
+	TInt numOccluders = 0;
+	for (TInt index = iCount - 1; index >= 0; index--)
+		{
+		TCommand& command = iCommands[index];
+		for (TInt occluder = 0; occluder < numOccluders; occluder++)
+			{
+			if (Contains(occluders[occluder], command.iRect))
+				{
+				command.iFlags |= EFlagCulled;
+				break;
+				}
+			if (command.iType == ECommandFill)
+				{
+				Trim(command.iRect, occluders[occluder]);
+				if (command.iRect.IsEmpty())
+					{
+					command.iFlags |= EFlagCulled;
+					break;
+					}
+				}
+			}
+		if ((command.iFlags & EFlagCulled) || !IsOpaqueFill(command))
+			continue;
+		if (numOccluders < KMaxOccluders)
+			{
+			occluders[numOccluders++] = command.iRect;
+			continue;
+			}
+		// Keep the largest fills.
+		TInt smallest = 0;
+		for (TInt occluder = 1; occluder < KMaxOccluders; occluder++)
+			{
+			if (Area(occluders[occluder]) < Area(occluders[smallest]))
+				smallest = occluder;
+			}
+		if (Area(command.iRect) > Area(occluders[smallest]))
+			occluders[smallest] = command.iRect;
+		}
+	}
+
+/**
+Draws one command into the target, together with the following fills it can be merged with
+now that the commands between them have been culled.
+@return The index of the next command to replay.
+*/
+TInt CRecordingDrawDevice::ReplayCommand(TInt aIndex)
+	{
+	TCommand& command = iCommands[aIndex++];
+	if (command.iFlags & EFlagCulled)
+		return aIndex;
+	const TRect& rect = command.iRect;
+	const CGraphicsContext::TDrawMode drawMode = CGraphicsContext::TDrawMode(command.iDrawMode);
+	TUint8* data = iData + command.iDataOffset;
+	switch (command.iType)
+		{
+	case ECommandFill:
+		for (; aIndex < iCount; aIndex++)
+			{
+			const TCommand& next = iCommands[aIndex];
+			if (next.iFlags & EFlagCulled)
+				continue;
+			if (!CanMergeFills(next, rect, command.iColor, command.iDrawMode))
+				break;
+			command.iRect.BoundingRect(next.iRect);
+			}
+		iTarget->WriteRgbMulti(rect.iTl.iX, rect.iTl.iY, rect.Width(), rect.Height(), command.iColor, drawMode);
+		break;
+	case ECommandLine:
+		iTarget->WriteLine(rect.iTl.iX, rect.iTl.iY, rect.Width(), reinterpret_cast<TUint32*>(data), drawMode);
+		break;
+	case ECommandBinary:
+		iTarget->WriteBinary(rect.iTl.iX, rect.iTl.iY, reinterpret_cast<TUint32*>(data), rect.Width(), rect.Height(), command.iColor, drawMode);
+		break;
+	case ECommandBinaryLine:
+		iTarget->WriteBinaryLine(rect.iTl.iX, rect.iTl.iY, reinterpret_cast<TUint32*>(data), rect.Width(), command.iColor, drawMode);
+		break;
+	case ECommandBinaryLineVertical:
+		{
+		const TBool up = command.iFlags & EFlagDirection;
+		iTarget->WriteBinaryLineVertical(rect.iTl.iX, up ? rect.iBr.iY - 1 : rect.iTl.iY, reinterpret_cast<TUint32*>(data),
+										 rect.Height(), command.iColor, drawMode, up);
+		break;
+		}
+	case ECommandAlphaLine:
+		iTarget->WriteRgbAlphaLine(rect.iTl.iX, rect.iTl.iY, rect.Width(), data, data + rect.Width() * 4, drawMode);
+		break;
+	case ECommandAlphaLine2:
+		{
+		const TInt rgbBytes = rect.Width() * 4;
+		iTarget->WriteRgbAlphaLine(rect.iTl.iX, rect.iTl.iY, rect.Width(), data, data + rgbBytes,
+								   data + rgbBytes + command.iParam, drawMode);
+		break;
+		}
+	case ECommandAlphaMulti:
+		iTarget->WriteRgbAlphaMulti(rect.iTl.iX, rect.iTl.iY, rect.Width(), command.iColor, data);
+		break;
+	case ECommandMapColors:
+		iTarget->MapColors(rect, reinterpret_cast<TRgb*>(data), command.iParam, command.iFlags & EFlagDirection);
+		break;
+	case ECommandShadowArea:
+		iTarget->ShadowArea(rect);
+		break;
+	default:
+		break;
+		}
+	return aIndex;
+	}
+
+/**
+@return ETrue if the command overwrites every pixel of its area without reading it.
+*/
+TBool CRecordingDrawDevice::IsOpaqueFill(const TCommand& aCommand)
+	{
+	return aCommand.iType == ECommandFill &&
+		   (aCommand.iDrawMode == CGraphicsContext::EDrawModeWriteAlpha ||
+		    (aCommand.iDrawMode == CGraphicsContext::EDrawModePEN && aCommand.iColor.Alpha() == 0xff));
+	}
+
+/**
+@return ETrue if aCommand is a fill with aColor and aDrawMode that forms a rectangle with aRect.
+*/
+TBool CRecordingDrawDevice::CanMergeFills(const TCommand& aCommand, const TRect& aRect, TRgb aColor, TInt aDrawMode)
+	{
+	if (aCommand.iType != ECommandFill || aCommand.iDrawMode != aDrawMode || aCommand.iColor != aColor)
+		return EFalse;
+	const TRect& rect = aCommand.iRect;
+	if (rect.iTl.iX == aRect.iTl.iX && rect.iBr.iX == aRect.iBr.iX)
+		return rect.iBr.iY == aRect.iTl.iY || rect.iTl.iY == aRect.iBr.iY;
+	if (rect.iTl.iY == aRect.iTl.iY && rect.iBr.iY == aRect.iBr.iY)
+		return rect.iBr.iX == aRect.iTl.iX || rect.iTl.iX == aRect.iBr.iX;
+	return EFalse;
+	}
+
+/**
+@return The size in bytes of aLength pixels in the format of ScanLineDisplayMode(), rounded up to words.
+*/
+TInt CRecordingDrawDevice::LineBytes(TInt aLength) const
+	{
+	return ((aLength * BitsInMemory(iTarget->ScanLineDisplayMode()) + 31) >> 5) << 2;
+	}
+
+/**
+Adds a command, flushing first if the buffers are full.
+@param aBytes Size of the source data to copy to iData + iDataOffset of the returned command
+@return The new command, or NULL if aBytes is larger than the data buffer. The commands recorded
+so far have then been flushed, so the primitive can be drawn directly.
+*/
+CRecordingDrawDevice::TCommand* CRecordingDrawDevice::Record(TCommandType aType, const TRect& aRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode, TInt aBytes)
+	{
+	TInt offset = (iDataLength + 3) & ~3;
+	if (iCount == KMaxRecordedCommands || offset + aBytes > KMaxRecordedBytes)
+		{
+		Flush();
+		offset = 0;
+		if (aBytes > KMaxRecordedBytes)
+			return NULL;
+		}
+	TCommand& command = iCommands[iCount++];
+	command.iType = TUint8(aType);
+	command.iDrawMode = TUint8(aDrawMode);
+	command.iFlags = 0;
+	command.iRect = aRect;
+	command.iColor = aColor;
+	command.iDataOffset = offset;
+	command.iParam = 0;
+	iDataLength = offset + aBytes;
+	return &command;
+	}
+
+/**
+Merges a primitive into the last command, if the last command is of the same type and
+the result is a single primitive.
+@return ETrue if the primitive was merged.
+*/
+TBool CRecordingDrawDevice::Extend(TCommandType aType, const TRect& aRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode, const TAny* aData, TInt aBytes)
+	{
+	if (iCount == 0)
+		return EFalse;
+	TCommand& last = iCommands[iCount - 1];
+	if (aType == ECommandFill)
+		{
+		if (!CanMergeFills(last, aRect, aColor, aDrawMode))
+			return EFalse;
+		last.iRect.BoundingRect(aRect);
+		return ETrue;
+		}
+	// A span continuing the last span of the same row, whose data is at the end of iData.
+	if (last.iType != aType || last.iDrawMode != aDrawMode || last.iColor != aColor ||
+		last.iRect.iTl.iY != aRect.iTl.iY || last.iRect.iBr.iX != aRect.iTl.iX ||
+		iDataLength + aBytes > KMaxRecordedBytes)
+		return EFalse;
+	const TInt lastWidth = last.iRect.Width();
+	TInt lastBytes;
+	if (aType == ECommandLine)
+		{
+		// Only lines that end on a word boundary can be extended by appending words.
+		lastBytes = LineBytes(lastWidth);
+		if (lastBytes * 8 != lastWidth * BitsInMemory(iTarget->ScanLineDisplayMode()))
+			return EFalse;
+		}
+	else
+		lastBytes = lastWidth;
+	if (last.iDataOffset + lastBytes != iDataLength)
+		return EFalse;
+	Mem::Copy(iData + iDataLength, aData, aBytes);
+	iDataLength += aBytes;
+	last.iRect.iBr.iX = aRect.iBr.iX;
+	return ETrue;
+	}
+
+void CRecordingDrawDevice::MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards)
+	{
+	const TInt bytes = aNumPairs * 2 * sizeof(TRgb);
+	TCommand* command = Record(ECommandMapColors, aRect, TRgb(), CGraphicsContext::EDrawModePEN, bytes);
+	if (!command)
+		{
+		iTarget->MapColors(aRect, aColors, aNumPairs, aMapForwards);
+		return;
+		}
+	Mem::Copy(iData + command->iDataOffset, aColors, bytes);
+	command->iParam = aNumPairs;
+	if (aMapForwards)
+		command->iFlags |= EFlagDirection;
+	}
+
+void CRecordingDrawDevice::ReadLine(TInt aX,TInt aY,TInt aLength,TAny* aBuffer,TDisplayMode aDispMode) const
+	{
+	FlushConst();
+	iTarget->ReadLine(aX, aY, aLength, aBuffer, aDispMode);
+	}
+
+TRgb CRecordingDrawDevice::ReadPixel(TInt aX,TInt aY) const
+	{
+	FlushConst();
+	return iTarget->ReadPixel(aX, aY);
+	}
+
+TBool CRecordingDrawDevice::SetOrientation(TOrientation aOrientation)
+	{
+	Flush();
+	return iTarget->SetOrientation(aOrientation);
+	}
+
+void CRecordingDrawDevice::WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	const TInt bytes = aHeight * sizeof(TUint32);
+	TCommand* command = Record(ECommandBinary, TRect(aX, aY, aX + aLength, aY + aHeight), aColor, aDrawMode, bytes);
+	if (command)
+		Mem::Copy(iData + command->iDataOffset, aBuffer, bytes);
+	else
+		iTarget->WriteBinary(aX, aY, aBuffer, aLength, aHeight, aColor, aDrawMode);
+	}
+
+void CRecordingDrawDevice::WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	const TInt bytes = ((aLength + 31) >> 5) * sizeof(TUint32);
+	TCommand* command = Record(ECommandBinaryLine, TRect(aX, aY, aX + aLength, aY + 1), aColor, aDrawMode, bytes);
+	if (command)
+		Mem::Copy(iData + command->iDataOffset, aBuffer, bytes);
+	else
+		iTarget->WriteBinaryLine(aX, aY, aBuffer, aLength, aColor, aDrawMode);
+	}
+
+void CRecordingDrawDevice::WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp)
+	{
+	const TInt bytes = ((aHeight + 31) >> 5) * sizeof(TUint32);
+	const TRect rect(aUp ? TRect(aX, aY - aHeight + 1, aX + 1, aY + 1) : TRect(aX, aY, aX + 1, aY + aHeight));
+	TCommand* command = Record(ECommandBinaryLineVertical, rect, aColor, aDrawMode, bytes);
+	if (!command)
+		{
+		iTarget->WriteBinaryLineVertical(aX, aY, aBuffer, aHeight, aColor, aDrawMode, aUp);
+		return;
+		}
+	Mem::Copy(iData + command->iDataOffset, aBuffer, bytes);
+	if (aUp)
+		command->iFlags |= EFlagDirection;
+	}
+
+/**
+Recorded as a one pixel fill, so that runs of pixels merge into spans.
+*/
+void CRecordingDrawDevice::WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	WriteRgbMulti(aX, aY, 1, 1, aColor, aDrawMode);
+	}
+
+void CRecordingDrawDevice::WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	const TRect rect(aX, aY, aX + aLength, aY + aHeight);
+	if (!Extend(ECommandFill, rect, aColor, aDrawMode, NULL, 0))
+		Record(ECommandFill, rect, aColor, aDrawMode, 0);
+	}
+
+void CRecordingDrawDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	const TInt rgbBytes = aLength * 4;
+	TCommand* command = Record(ECommandAlphaLine, TRect(aX, aY, aX + aLength, aY + 1), TRgb(), aDrawMode, rgbBytes + aLength);
+	if (!command)
+		{
+		iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer, aMaskBuffer, aDrawMode);
+		return;
+		}
+	TUint8* data = iData + command->iDataOffset;
+	Mem::Copy(data, aRgbBuffer, rgbBytes);
+	Mem::Copy(data + rgbBytes, aMaskBuffer, aLength);
+	}
+
+void CRecordingDrawDevice::WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	const TRect rect(aX, aY, aX + aLength, aY + 1);
+	const TInt bytes = LineBytes(aLength);
+	if (Extend(ECommandLine, rect, TRgb(), aDrawMode, aBuffer, bytes))
+		return;
+	TCommand* command = Record(ECommandLine, rect, TRgb(), aDrawMode, bytes);
+	if (command)
+		Mem::Copy(iData + command->iDataOffset, aBuffer, bytes);
+	else
+		iTarget->WriteLine(aX, aY, aLength, aBuffer, aDrawMode);
+	}
+
+TInt CRecordingDrawDevice::InitScreen()
+	{
+	Flush();
+	const TInt err = iTarget->InitScreen();
+	iTarget->SetAutoUpdate(EFalse);
+	return err;
+	}
+
+/**
+Sets or unsets auto-update. With auto-update on, the target is updated after every flush.
+@param aValue ETrue, if the screen is set to auto-update; EFalse, otherwise.
+*/
+void CRecordingDrawDevice::SetAutoUpdate(TBool aValue)
+	{
+	iAutoUpdate = aValue;
+	}
+
+void CRecordingDrawDevice::SetBits(TAny* aBits)
+	{
+	Flush();
+	iTarget->SetBits(aBits);
+	}
+
+TInt CRecordingDrawDevice::SetCustomPalette(const CPalette* aPalette)
+	{
+	Flush();
+	return iTarget->SetCustomPalette(aPalette);
+	}
+
+void CRecordingDrawDevice::SetDisplayMode(CFbsDrawDevice* aDrawDevice)
+	{
+	Flush();
+	iTarget->SetDisplayMode(aDrawDevice);
+	}
+
+void CRecordingDrawDevice::SetDitherOrigin(const TPoint& aPoint)
+	{
+	Flush();
+	iTarget->SetDitherOrigin(aPoint);
+	}
+
+void CRecordingDrawDevice::SetUserDisplayMode(TDisplayMode aDisplayMode)
+	{
+	Flush();
+	iTarget->SetUserDisplayMode(aDisplayMode);
+	}
+
+void CRecordingDrawDevice::SetShadowMode(TShadowMode aShadowMode)
+	{
+	Flush();
+	iTarget->SetShadowMode(aShadowMode);
+	}
+
+void CRecordingDrawDevice::SetFadingParameters(TUint8 aBlackMap,TUint8 aWhiteMap)
+	{
+	Flush();
+	iTarget->SetFadingParameters(aBlackMap, aWhiteMap);
+	}
+
+void CRecordingDrawDevice::ShadowArea(const TRect& aRect)
+	{
+	Record(ECommandShadowArea, aRect, TRgb(), CGraphicsContext::EDrawModePEN, 0);
+	}
+
+/**
+Replays the recorded commands and updates the whole target.
+*/
+void CRecordingDrawDevice::Update()
+	{
+	Replay();
+	iTarget->Update();
+	}
+
+/**
+Replays the recorded commands and updates aRegion of the target.
+@param aRegion Region to update (logical coordinates)
+*/
+void CRecordingDrawDevice::Update(const TRegion& aRegion)
+	{
+	Replay();
+	iTarget->Update(aRegion);
+	}
+
+/**
+Records aRect, to be passed to the target once the commands are replayed by the next flush or update.
+@param aRect Rectangle to update (logical coordinates)
+*/
+void CRecordingDrawDevice::UpdateRegion(const TRect& aRect)
+	{
+	iUpdateRegion.AddRect(aRect);
+	}
+
+void CRecordingDrawDevice::WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer)
+	{
+	const TRect rect(aX, aY, aX + aLength, aY + 1);
+	if (Extend(ECommandAlphaMulti, rect, aColor, CGraphicsContext::EDrawModePEN, aMaskBuffer, aLength))
+		return;
+	TCommand* command = Record(ECommandAlphaMulti, rect, aColor, CGraphicsContext::EDrawModePEN, aLength);
+	if (command)
+		Mem::Copy(iData + command->iDataOffset, aMaskBuffer, aLength);
+	else
+		iTarget->WriteRgbAlphaMulti(aX, aY, aLength, aColor, aMaskBuffer);
+	}
+
+void CRecordingDrawDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+											 const TUint8* aRgbBuffer1,
+											 const TUint8* aBuffer2,
+											 const TUint8* aMaskBuffer,
+											 CGraphicsContext::TDrawMode aDrawMode)
+	{
+	const TInt rgbBytes = aLength * 4;
+	const TInt buffer2Bytes = LineBytes(aLength);
+	TCommand* command = Record(ECommandAlphaLine2, TRect(aX, aY, aX + aLength, aY + 1), TRgb(), aDrawMode,
+							   rgbBytes + buffer2Bytes + aLength);
+	if (!command)
+		{
+		iTarget->WriteRgbAlphaLine(aX, aY, aLength, aRgbBuffer1, aBuffer2, aMaskBuffer, aDrawMode);
+		return;
+		}
+	TUint8* data = iData + command->iDataOffset;
+	Mem::Copy(data, aRgbBuffer1, rgbBytes);
+	Mem::Copy(data + rgbBytes, aBuffer2, buffer2Bytes);
+	Mem::Copy(data + rgbBytes + buffer2Bytes, aMaskBuffer, aLength);
+	command->iParam = buffer2Bytes;
+	}
+
+/**
+Flushes before returning the interface, since it may give access to the pixels.
+*/
+TInt CRecordingDrawDevice::GetInterface(TInt aInterfaceId, TAny*& aInterface)
+	{
+	Flush();
+	return iTarget->GetInterface(aInterfaceId, aInterface);
+	}
+
+void CRecordingDrawDevice::SwapWidthAndHeight()
+	{
+	Flush();
+	iTarget->SwapWidthAndHeight();
+	}
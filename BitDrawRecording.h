@@ -0,0 +1,169 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWRECORDING_H__
+#define __BITDRAWRECORDING_H__
+
+#include "BitDrawForwarding.h"
+#include "BitDrawDamage.h"
+
+/**
+Number of bytes of source data a CRecordingDrawDevice holds before it flushes by itself.
+@internalComponent
+*/
+const TInt KMaxRecordedBytes = 64 * 1024;
+
+/**
+Number of commands a CRecordingDrawDevice holds before it flushes by itself.
+@internalComponent
+*/
+const TInt KMaxRecordedCommands = 1024;
+
+/**
+Number of opaque fills Flush() remembers at once when looking for commands to cull.
+@internalComponent
+*/
+const TInt KMaxOccluders = 16;
+
+/**
+Draw device that records drawing primitives, with a copy of their source data, instead of
+drawing them, and replays them into a target device when flushed.
+
+Before replaying, Flush() drops every command whose area is entirely overwritten by a later
+opaque fill: a WriteRgbMulti() or WriteRgb() with EDrawModeWriteAlpha, or with EDrawModePEN and
+an opaque colour. Fills partly covered by a later opaque fill are trimmed. While recording, fills
+of the same colour and draw mode that together form a rectangle are merged, as are WriteLine()
+and WriteRgbAlphaMulti() spans that continue the previous span of the same row.
+
+Reading pixels, changing the state of the device (shadow mode, orientation, bits...), Update()
+and GetInterface() flush first, so the result is the same as drawing straight to the target.
+UpdateRegion() only records the rectangle, which is passed to the target after the commands are
+next replayed.
+Pixels accessed through an interface returned by GetInterface() must not be used while
+commands are being recorded; call Flush() before using them again.
+The command and data buffers are allocated when the device is created, so recording never
+allocates memory. When either is full the device flushes; a primitive whose source data is larger
+than KMaxRecordedBytes is drawn directly.
+Auto-update is implemented by this device: the target is updated once per flush.
+@internalComponent
+*/
+class CRecordingDrawDevice : public CForwardingDrawDevice
+	{
+public:
+	static CRecordingDrawDevice* NewL(CFbsDrawDevice* aTarget);
+	~CRecordingDrawDevice();
+	void Flush();
+	inline TInt RecordedCount() const;
+public: // From CFbsDrawDevice
+	void MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards);
+	void ReadLine(TInt aX,TInt aY,TInt aLength,TAny* aBuffer,TDisplayMode aDispMode) const;
+	TRgb ReadPixel(TInt aX,TInt aY) const;
+	TBool SetOrientation(TOrientation aOrientation);
+	void WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp);
+	void WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode);
+	void WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode);
+	TInt InitScreen();
+	void SetAutoUpdate(TBool aValue);
+	void SetBits(TAny* aBits);
+	TInt SetCustomPalette(const CPalette* aPalette);
+	void SetDisplayMode(CFbsDrawDevice* aDrawDevice);
+	void SetDitherOrigin(const TPoint& aPoint);
+	void SetUserDisplayMode(TDisplayMode aDisplayMode);
+	void SetShadowMode(TShadowMode aShadowMode);
+	void SetFadingParameters(TUint8 aBlackMap,TUint8 aWhiteMap);
+	void ShadowArea(const TRect& aRect);
+	void Update();
+	void Update(const TRegion& aRegion);
+	void UpdateRegion(const TRect& aRect);
+	void WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+						   const TUint8* aRgbBuffer1,
+						   const TUint8* aBuffer2,
+						   const TUint8* aMaskBuffer,
+						   CGraphicsContext::TDrawMode aDrawMode);
+	TInt GetInterface(TInt aInterfaceId, TAny*& aInterface);
+	void SwapWidthAndHeight();
+private:
+	enum TCommandType
+		{
+		ECommandFill,
+		ECommandLine,
+		ECommandBinary,
+		ECommandBinaryLine,
+		ECommandBinaryLineVertical,
+		ECommandAlphaLine,
+		ECommandAlphaLine2,
+		ECommandAlphaMulti,
+		ECommandMapColors,
+		ECommandShadowArea
+		};
+	enum TCommandFlags
+		{
+		/** The command is entirely overwritten by a later command and is not replayed. */
+		EFlagCulled = 0x01,
+		/** aUp of WriteBinaryLineVertical(), or aMapForwards of MapColors(). */
+		EFlagDirection = 0x02
+		};
+	/**
+	One recorded primitive. Source data is kept in iData, at a word aligned offset.
+	*/
+	struct TCommand
+		{
+		TUint8 iType;
+		TUint8 iDrawMode;
+		TUint8 iFlags;
+		/** Area of the device the command writes to, in logical coordinates. */
+		TRect iRect;
+		TRgb iColor;
+		/** Offset of the source data in iData. */
+		TInt iDataOffset;
+		/** Number of colour pairs of ECommandMapColors. */
+		TInt iParam;
+		};
+private:
+	CRecordingDrawDevice(CFbsDrawDevice* aTarget);
+	void ConstructL();
+	TCommand* Record(TCommandType aType, const TRect& aRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode, TInt aBytes);
+	TBool Extend(TCommandType aType, const TRect& aRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode, const TAny* aData, TInt aBytes);
+	TInt LineBytes(TInt aLength) const;
+	void Cull();
+	void Replay();
+	TInt ReplayCommand(TInt aIndex);
+	void FlushConst() const;
+	static TBool IsOpaqueFill(const TCommand& aCommand);
+	static TBool CanMergeFills(const TCommand& aCommand, const TRect& aRect, TRgb aColor, TInt aDrawMode);
+private:
+	TCommand* iCommands;
+	TInt iCount;
+	TUint8* iData;
+	TInt iDataLength;
+	TBool iAutoUpdate;
+	/** Area reported with UpdateRegion() since the commands were last replayed. */
+	TDamageRegionFix<KMaxDamageRects> iUpdateRegion;
+	};
+
+/**
+@return The number of commands waiting to be replayed.
+*/
+inline TInt CRecordingDrawDevice::RecordedCount() const
+	{
+	return iCount;
+	}
+
+#endif
@@ -0,0 +1,362 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawRotatedBlock.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define __BITDRAW_SSE2__
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define __BITDRAW_NEON__
+#include <arm_neon.h>
+#endif
+
+/** Bytes covered by one row of a tile - one cache line. */
+const TInt KTileBytes = 64;
+/** Upper limit on the tile size, so that a tile of 8bpp pixels does not span 64 rows. */
+const TInt KMaxTileSize = 16;
+
+/**
+Memory steps for one logical pixel along x and y, and the address of the first pixel of a rectangle.
+*/
+class TBlockLayout
+	{
+public:
+	TBlockLayout(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aWidth, TInt aHeight);
+public:
+	TUint8* iFirst;
+	TInt iStepX;
+	TInt iStepY;
+	};
+
+TBlockLayout::TBlockLayout(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aWidth, TInt aHeight)
+	{
+	const TInt bytes = aInfo.iBitsPerPixel >> 3;
+	iStepX = aInfo.iLogicalXStep.iX * bytes + aInfo.iLogicalXStep.iY * aInfo.iStride;
+	iStepY = aInfo.iLogicalYStep.iX * bytes + aInfo.iLogicalYStep.iY * aInfo.iStride;
+	const TPoint first(aInfo.LogicalToPhysical(TPoint(aX, aY)));
+	const TPoint last(aInfo.LogicalToPhysical(TPoint(aX + aWidth - 1, aY + aHeight - 1)));
+	const TRect physical(aInfo.iPhysicalSize);
+	__ASSERT_ALWAYS(physical.Contains(first) && physical.Contains(last), Panic(EScreenDriverPanicOutOfBounds));
+	iFirst = aInfo.iBits + first.iY * aInfo.iStride + first.iX * bytes;
+	}
+
+template <TInt BYTES>
+LOCAL_C inline void CopyPixel(TUint8* aDest, const TUint8* aSrc)
+	{
+	for (TInt index = 0; index < BYTES; index++)
+		aDest[index] = aSrc[index];
+	}
+
+#if defined(__BITDRAW_SSE2__) || defined(__BITDRAW_NEON__)
+
+/**
+Transposes 4x4 32bpp pixels. Row k of the source is the 4 pixels at aSrc + k * aSrcStep, row k of
+the destination is stored at aDest + k * aDestStep. A reversed row runs towards lower addresses,
+so its 4 pixels end at the given address.
+*/
+LOCAL_C inline void TransposeTile4(const TUint8* aSrc, TInt aSrcStep, TBool aSrcReversed,
+								   TUint8* aDest, TInt aDestStep, TBool aDestReversed)
+	{
+	const TInt srcOffset = aSrcReversed ? -12 : 0;
+	const TInt destOffset = aDestReversed ? -12 : 0;
+#if defined(__BITDRAW_SSE2__)
+	__m128i rows[4];
+	for (TInt k = 0; k < 4; k++)
+		{
+		rows[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + k * aSrcStep + srcOffset));
+		if (aSrcReversed)
+			rows[k] = _mm_shuffle_epi32(rows[k], _MM_SHUFFLE(0, 1, 2, 3));
+		}
+	const __m128i t0 = _mm_unpacklo_epi32(rows[0], rows[1]);
+	const __m128i t1 = _mm_unpacklo_epi32(rows[2], rows[3]);
+	const __m128i t2 = _mm_unpackhi_epi32(rows[0], rows[1]);
+	const __m128i t3 = _mm_unpackhi_epi32(rows[2], rows[3]);
+	__m128i cols[4];
+	cols[0] = _mm_unpacklo_epi64(t0, t1);
+	cols[1] = _mm_unpackhi_epi64(t0, t1);
+	cols[2] = _mm_unpacklo_epi64(t2, t3);
+	cols[3] = _mm_unpackhi_epi64(t2, t3);
+	for (TInt k = 0; k < 4; k++)
+		{
+		if (aDestReversed)
+			cols[k] = _mm_shuffle_epi32(cols[k], _MM_SHUFFLE(0, 1, 2, 3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + k * aDestStep + destOffset), cols[k]);
+		}
+#else
+	uint32x4_t rows[4];
+	for (TInt k = 0; k < 4; k++)
+		{
+		rows[k] = vld1q_u32(reinterpret_cast<const uint32_t*>(aSrc + k * aSrcStep + srcOffset));
+		if (aSrcReversed)
+			{
+			rows[k] = vrev64q_u32(rows[k]);
+			rows[k] = vextq_u32(rows[k], rows[k], 2);
+			}
+		}
+	const uint32x4x2_t t01 = vtrnq_u32(rows[0], rows[1]);
+	const uint32x4x2_t t23 = vtrnq_u32(rows[2], rows[3]);
+	uint32x4_t cols[4];
+	cols[0] = vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0]));
+	cols[1] = vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1]));
+	cols[2] = vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0]));
+	cols[3] = vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1]));
+	for (TInt k = 0; k < 4; k++)
+		{
+		if (aDestReversed)
+			{
+			cols[k] = vrev64q_u32(cols[k]);
+			cols[k] = vextq_u32(cols[k], cols[k], 2);
+			}
+		vst1q_u32(reinterpret_cast<uint32_t*>(aDest + k * aDestStep + destOffset), cols[k]);
+		}
+#endif
+	}
+
+#endif // __BITDRAW_SSE2__ || __BITDRAW_NEON__
+
+/**
+Moves the pixels of one tile between the device memory and a linear buffer, walking the device
+memory sequentially. Only used when logical columns are physical rows, i.e. aStepY is +/-BYTES.
+*/
+template <TInt BYTES, TBool WRITE>
+LOCAL_C void TransferTile(TUint8* aPhysical, TInt aStepX, TInt aStepY, TUint8* aLinear, TInt aStride,
+						  TInt aWidth, TInt aHeight)
+	{
+#if defined(__BITDRAW_SSE2__) || defined(__BITDRAW_NEON__)
+	if (BYTES == 4 && (aWidth & 3) == 0 && (aHeight & 3) == 0)
+		{
+		const TBool reversed = aStepY < 0;
+		for (TInt j = 0; j < aHeight; j += 4)
+			{
+			for (TInt i = 0; i < aWidth; i += 4)
+				{
+				TUint8* physical = aPhysical + i * aStepX + j * aStepY;
+				TUint8* linear = aLinear + j * aStride + i * 4;
+				if (WRITE)
+					TransposeTile4(linear, aStride, EFalse, physical, aStepX, reversed);
+				else
+					TransposeTile4(physical, aStepX, reversed, linear, aStride, EFalse);
+				}
+			}
+		return;
+		}
+#endif
+	for (TInt i = 0; i < aWidth; i++)
+		{
+		TUint8* physical = aPhysical + i * aStepX;
+		TUint8* linear = aLinear + i * BYTES;
+		for (TInt j = 0; j < aHeight; j++, physical += aStepY, linear += aStride)
+			{
+			if (WRITE)
+				CopyPixel<BYTES>(physical, linear);
+			else
+				CopyPixel<BYTES>(linear, physical);
+			}
+		}
+	}
+
+/**
+Moves a rectangle between the device memory and a linear buffer. If logical rows are physical
+rows, each row is copied; if they are physical columns, the rectangle is split into tiles
+whose rows fit in one cache line, so each tile transposes through cache.
+*/
+template <TInt BYTES, TBool WRITE>
+LOCAL_C void Transfer(const TBlockLayout& aLayout, TUint8* aLinear, TInt aStride, TInt aWidth, TInt aHeight)
+	{
+	if (aLayout.iStepX == BYTES || aLayout.iStepX == -BYTES)
+		{
+		for (TInt j = 0; j < aHeight; j++)
+			{
+			TUint8* physical = aLayout.iFirst + j * aLayout.iStepY;
+			TUint8* linear = aLinear + j * aStride;
+			if (aLayout.iStepX == BYTES)
+				{
+				if (WRITE)
+					Mem::Copy(physical, linear, aWidth * BYTES);
+				else
+					Mem::Copy(linear, physical, aWidth * BYTES);
+				continue;
+				}
+			for (TInt i = 0; i < aWidth; i++, physical -= BYTES, linear += BYTES)
+				{
+				if (WRITE)
+					CopyPixel<BYTES>(physical, linear);
+				else
+					CopyPixel<BYTES>(linear, physical);
+				}
+			}
+		return;
+		}
+	const TInt tile = Min(KTileBytes / BYTES, KMaxTileSize);
+	for (TInt tileY = 0; tileY < aHeight; tileY += tile)
+		{
+		const TInt tileHeight = Min(tile, aHeight - tileY);
+		for (TInt tileX = 0; tileX < aWidth; tileX += tile)
+			{
+			TransferTile<BYTES, WRITE>(aLayout.iFirst + tileX * aLayout.iStepX + tileY * aLayout.iStepY,
+									   aLayout.iStepX, aLayout.iStepY,
+									   aLinear + tileY * aStride + tileX * BYTES, aStride,
+									   Min(tile, aWidth - tileX), tileHeight);
+			}
+		}
+	}
+
+template <TBool WRITE>
+LOCAL_C void Transfer(const TDirectScanLineInfo& aInfo, const TRect& aRect, TUint8* aLinear, TInt aStride)
+	{
+	const TBlockLayout layout(aInfo, aRect.iTl.iX, aRect.iTl.iY, aRect.Width(), aRect.Height());
+	switch (aInfo.iBitsPerPixel)
+		{
+	case 8:
+		Transfer<1, WRITE>(layout, aLinear, aStride, aRect.Width(), aRect.Height());
+		break;
+	case 16:
+		Transfer<2, WRITE>(layout, aLinear, aStride, aRect.Width(), aRect.Height());
+		break;
+	case 24:
+		Transfer<3, WRITE>(layout, aLinear, aStride, aRect.Width(), aRect.Height());
+		break;
+	default:
+		Transfer<4, WRITE>(layout, aLinear, aStride, aRect.Width(), aRect.Height());
+		break;
+		}
+	}
+
+/**
+Writes aPixel to the set bits of each line. Lines are walked in the order in which the device
+memory is sequential: column by column if logical columns are physical rows, row by row otherwise.
+*/
+template <TInt BYTES>
+LOCAL_C void WriteBinary(const TBlockLayout& aLayout, TInt aStepY, const TUint32* aBuffer, TInt aColumnWords,
+						 TInt aWidth, TInt aHeight, TUint32 aPixel)
+	{
+	TUint8 pixel[4];
+	for (TInt index = 0; index < 4; index++)
+		pixel[index] = TUint8(aPixel >> (index * 8));
+	if (aStepY == BYTES || aStepY == -BYTES)
+		{
+		for (TInt i = 0; i < aWidth; i++)
+			{
+			const TUint32* column = aBuffer + i * aColumnWords;
+			TUint8* physical = aLayout.iFirst + i * aLayout.iStepX;
+			for (TInt j = 0; j < aHeight; j++, physical += aStepY)
+				{
+				if (column[j >> 5] & (1u << (j & 31)))
+					CopyPixel<BYTES>(physical, pixel);
+				}
+			}
+		return;
+		}
+	for (TInt j = 0; j < aHeight; j++)
+		{
+		const TUint32* word = aBuffer + (j >> 5);
+		const TUint32 bit = 1u << (j & 31);
+		TUint8* physical = aLayout.iFirst + j * aStepY;
+		for (TInt i = 0; i < aWidth; i++, word += aColumnWords, physical += aLayout.iStepX)
+			{
+			if (*word & bit)
+				CopyPixel<BYTES>(physical, pixel);
+			}
+		}
+	}
+
+/**
+@param aInfo Memory layout of a device
+@return ETrue if the functions of this class can be used with aInfo.
+*/
+TBool TRotatedBlock::IsSupported(const TDirectScanLineInfo& aInfo)
+	{
+	return aInfo.iBits && aInfo.iFactorX == 1 && aInfo.iFactorY == 1 &&
+		   (aInfo.iBitsPerPixel == 8 || aInfo.iBitsPerPixel == 16 ||
+			aInfo.iBitsPerPixel == 24 || aInfo.iBitsPerPixel == 32);
+	}
+
+/**
+Implements MBlockAccess::WriteBlock().
+@param aInfo Memory layout of the device
+@see MBlockAccess::WriteBlock
+@panic EScreenDriverPanicOutOfBounds If aRect maps to an illegal physical coordinate
+*/
+TInt TRotatedBlock::WriteBlock(const TDirectScanLineInfo& aInfo, const TRect& aRect, const TAny* aBuffer, TInt aStride)
+	{
+	if (!IsSupported(aInfo))
+		return KErrNotSupported;
+	__ASSERT_DEBUG(aBuffer, Panic(EScreenDriverPanicNullPointer));
+	if (!aRect.IsEmpty())
+		Transfer<ETrue>(aInfo, aRect, static_cast<TUint8*>(const_cast<TAny*>(aBuffer)), aStride);
+	return KErrNone;
+	}
+
+/**
+Implements MBlockAccess::ReadBlock().
+@param aInfo Memory layout of the device
+@see MBlockAccess::ReadBlock
+@panic EScreenDriverPanicOutOfBounds If aRect maps to an illegal physical coordinate
+*/
+TInt TRotatedBlock::ReadBlock(const TDirectScanLineInfo& aInfo, const TRect& aRect, TAny* aBuffer, TInt aStride)
+	{
+	if (!IsSupported(aInfo))
+		return KErrNotSupported;
+	__ASSERT_DEBUG(aBuffer, Panic(EScreenDriverPanicNullPointer));
+	if (!aRect.IsEmpty())
+		Transfer<EFalse>(aInfo, aRect, static_cast<TUint8*>(aBuffer), aStride);
+	return KErrNone;
+	}
+
+/**
+Implements MBlockAccess::WriteBinaryBlockVertical().
+@param aInfo	Memory layout of the device
+@param aPixel	Colour to write, in the display mode of the device
+@see MBlockAccess::WriteBinaryBlockVertical
+@panic EScreenDriverPanicOutOfBounds If any line maps to an illegal physical coordinate
+*/
+TInt TRotatedBlock::WriteBinaryBlockVertical(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY,
+											 const TUint32* aBuffer, TInt aColumnWords,
+											 TInt aWidth, TInt aHeight, TUint32 aPixel, TBool aUp)
+	{
+	if (!IsSupported(aInfo))
+		return KErrNotSupported;
+	__ASSERT_DEBUG(aBuffer, Panic(EScreenDriverPanicNullPointer));
+	__ASSERT_DEBUG(aHeight <= aColumnWords * 32, Panic(EScreenDriverPanicOutOfBounds));
+	if (aWidth <= 0 || aHeight <= 0)
+		return KErrNone;
+	const TInt top = aUp ? aY - aHeight + 1 : aY;
+	TBlockLayout layout(aInfo, aX, top, aWidth, aHeight);
+	TInt stepY = layout.iStepY;
+	if (aUp)
+		{
+		layout.iFirst += (aHeight - 1) * stepY;
+		stepY = -stepY;
+		}
+	switch (aInfo.iBitsPerPixel)
+		{
+	case 8:
+		WriteBinary<1>(layout, stepY, aBuffer, aColumnWords, aWidth, aHeight, aPixel);
+		break;
+	case 16:
+		WriteBinary<2>(layout, stepY, aBuffer, aColumnWords, aWidth, aHeight, aPixel);
+		break;
+	case 24:
+		WriteBinary<3>(layout, stepY, aBuffer, aColumnWords, aWidth, aHeight, aPixel);
+		break;
+	default:
+		WriteBinary<4>(layout, stepY, aBuffer, aColumnWords, aWidth, aHeight, aPixel);
+		break;
+		}
+	return KErrNone;
+	}
@@ -0,0 +1,91 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWROTATEDBLOCK_H__
+#define __BITDRAWROTATEDBLOCK_H__
+
+#include "BitDrawDirectAccess.h"
+
+/**
+Batched rectangle access for draw devices, retrieved with
+CFbsDrawDevice::GetInterface(KBlockAccessInterfaceID, ...).
+
+In EOrientationRotated90 and EOrientationRotated270 every logical row is a physical column,
+so drawing a rectangle one logical line at a time touches a new cache line for every pixel.
+The functions of this interface move a whole rectangle at once, in square tiles, so that each
+cache line of the pixel memory is loaded once per tile. They may be used in any orientation.
+
+Pixels are in DisplayMode() format and replace the existing pixels; the draw mode, shadowing and
+fading are not applied. Screen devices must be told about the changed area with UpdateRegion().
+@see TRotatedBlock
+@internalComponent
+*/
+class MBlockAccess
+	{
+public:
+	/**
+	Writes a rectangle of pixels.
+	@param aRect	Logical rectangle to write
+	@param aBuffer	Pixels of the top row of aRect, followed by the other rows
+	@param aStride	Bytes between rows of aBuffer
+	@return KErrNone, or KErrNotSupported if the display mode or the current scaling settings
+	do not allow block access.
+	*/
+	virtual TInt WriteBlock(const TRect& aRect, const TAny* aBuffer, TInt aStride) = 0;
+	/**
+	Reads a rectangle of pixels.
+	@param aRect	Logical rectangle to read
+	@param aBuffer	Upon return contains the pixels of aRect, top row first
+	@param aStride	Bytes between rows of aBuffer
+	@return KErrNone, or KErrNotSupported if the display mode or the current scaling settings
+	do not allow block access.
+	*/
+	virtual TInt ReadBlock(const TRect& aRect, TAny* aBuffer, TInt aStride) const = 0;
+	/**
+	Writes aColor to the set bits of aWidth consecutive vertical lines, as aWidth calls of
+	WriteBinaryLineVertical() in EDrawModePEN would.
+	@param aX			Logical x coordinate of the first line
+	@param aY			Logical y coordinate of the first pixel of every line
+	@param aBuffer		Bit masks of the lines, aColumnWords words per line, bit 0 first
+	@param aColumnWords	Words between the starts of two lines in aBuffer
+	@param aWidth		Number of lines
+	@param aHeight		Number of pixels per line; at most aColumnWords * 32
+	@param aColor		Colour to write
+	@param aUp			ETrue if the lines are drawn upward (decreasing y)
+	@return KErrNone, or KErrNotSupported if the display mode or the current scaling settings
+	do not allow block access.
+	*/
+	virtual TInt WriteBinaryBlockVertical(TInt aX, TInt aY, const TUint32* aBuffer, TInt aColumnWords,
+										  TInt aWidth, TInt aHeight, TRgb aColor, TBool aUp) = 0;
+	};
+
+/**
+Tiled implementation of MBlockAccess over the memory layout of a device. Supports display modes
+of 8, 16, 24 and 32bpp on devices that are not scaled; 32bpp tiles are transposed with SSE2 or
+NEON where available.
+@internalComponent
+*/
+class TRotatedBlock
+	{
+public:
+	static TBool IsSupported(const TDirectScanLineInfo& aInfo);
+	static TInt WriteBlock(const TDirectScanLineInfo& aInfo, const TRect& aRect, const TAny* aBuffer, TInt aStride);
+	static TInt ReadBlock(const TDirectScanLineInfo& aInfo, const TRect& aRect, TAny* aBuffer, TInt aStride);
+	static TInt WriteBinaryBlockVertical(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY,
+										 const TUint32* aBuffer, TInt aColumnWords,
+										 TInt aWidth, TInt aHeight, TUint32 aPixel, TBool aUp);
+	};
+
+#endif
@@ -0,0 +1,506 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawScaled.h"
+#include "bitdraw.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define __BITDRAW_SSE2__
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define __BITDRAW_NEON__
+#include <arm_neon.h>
+#endif
+
+/** Physical pixels blended at once by WriteRgbAlphaLine(); also the largest horizontal factor supported. */
+const TInt KScaledChunkPixels = 256;
+
+//
+// Replication: every source pixel is written aFactor times, aCount destination pixels in all.
+// The last source pixel may be cut short when the line runs into the edge of the memory.
+//
+
+LOCAL_C void Replicate32(TUint32* aDest, const TUint32* aSrc, TInt aCount, TInt aFactor)
+	{
+	TInt i = 0;
+#if defined(__BITDRAW_SSE2__)
+	if (aFactor == 2)
+		{
+		for (; i + 8 <= aCount; i += 8, aSrc += 4)
+			{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), _mm_unpacklo_epi32(pixels, pixels));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i + 4), _mm_unpackhi_epi32(pixels, pixels));
+			}
+		}
+	else if (aFactor == 4)
+		{
+		for (; i + 16 <= aCount; i += 16, aSrc += 4)
+			{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 0, 0, 0)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i + 4), _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 1, 1, 1)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i + 8), _mm_shuffle_epi32(pixels, _MM_SHUFFLE(2, 2, 2, 2)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i + 12), _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 3)));
+			}
+		}
+#elif defined(__BITDRAW_NEON__)
+	if (aFactor == 2)
+		{
+		for (; i + 8 <= aCount; i += 8, aSrc += 4)
+			{
+			const uint32x4_t pixels = vld1q_u32(aSrc);
+			const uint32x4x2_t pairs = vzipq_u32(pixels, pixels);
+			vst1q_u32(aDest + i, pairs.val[0]);
+			vst1q_u32(aDest + i + 4, pairs.val[1]);
+			}
+		}
+	else if (aFactor == 4)
+		{
+		for (; i + 16 <= aCount; i += 16, aSrc += 4)
+			{
+			const uint32x4_t pixels = vld1q_u32(aSrc);
+			vst1q_u32(aDest + i, vdupq_lane_u32(vget_low_u32(pixels), 0));
+			vst1q_u32(aDest + i + 4, vdupq_lane_u32(vget_low_u32(pixels), 1));
+			vst1q_u32(aDest + i + 8, vdupq_lane_u32(vget_high_u32(pixels), 0));
+			vst1q_u32(aDest + i + 12, vdupq_lane_u32(vget_high_u32(pixels), 1));
+			}
+		}
+#endif
+	for (; i < aCount; aSrc++)
+		{
+		const TUint32 pixel = *aSrc;
+		for (TInt copy = 0; copy < aFactor && i < aCount; copy++)
+			aDest[i++] = pixel;
+		}
+	}
+
+LOCAL_C void Replicate16(TUint16* aDest, const TUint16* aSrc, TInt aCount, TInt aFactor)
+	{
+	TInt i = 0;
+#if defined(__BITDRAW_SSE2__)
+	if (aFactor == 2)
+		{
+		for (; i + 16 <= aCount; i += 16, aSrc += 8)
+			{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), _mm_unpacklo_epi16(pixels, pixels));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i + 8), _mm_unpackhi_epi16(pixels, pixels));
+			}
+		}
+	else if (aFactor == 4)
+		{
+		for (; i + 32 <= aCount; i += 32, aSrc += 8)
+			{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc));
+			const __m128i low = _mm_unpacklo_epi16(pixels, pixels);
+			const __m128i high = _mm_unpackhi_epi16(pixels, pixels);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), _mm_unpacklo_epi32(low, low));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i + 8), _mm_unpackhi_epi32(low, low));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i + 16), _mm_unpacklo_epi32(high, high));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i + 24), _mm_unpackhi_epi32(high, high));
+			}
+		}
+#elif defined(__BITDRAW_NEON__)
+	if (aFactor == 2)
+		{
+		for (; i + 16 <= aCount; i += 16, aSrc += 8)
+			{
+			const uint16x8_t pixels = vld1q_u16(aSrc);
+			const uint16x8x2_t pairs = vzipq_u16(pixels, pixels);
+			vst1q_u16(aDest + i, pairs.val[0]);
+			vst1q_u16(aDest + i + 8, pairs.val[1]);
+			}
+		}
+#endif
+	for (; i < aCount; aSrc++)
+		{
+		const TUint16 pixel = *aSrc;
+		for (TInt copy = 0; copy < aFactor && i < aCount; copy++)
+			aDest[i++] = pixel;
+		}
+	}
+
+LOCAL_C void Replicate(TUint8* aDest, const TUint8* aSrc, TInt aCount, TInt aFactor, TInt aBytesPerPixel)
+	{
+	switch (aBytesPerPixel)
+		{
+	case 4:
+		Replicate32(reinterpret_cast<TUint32*>(aDest), reinterpret_cast<const TUint32*>(aSrc), aCount, aFactor);
+		break;
+	case 2:
+		Replicate16(reinterpret_cast<TUint16*>(aDest), reinterpret_cast<const TUint16*>(aSrc), aCount, aFactor);
+		break;
+	case 1:
+		for (TInt i = 0; i < aCount; aSrc++)
+			{
+			for (TInt copy = 0; copy < aFactor && i < aCount; copy++)
+				aDest[i++] = *aSrc;
+			}
+		break;
+	default:
+		for (TInt i = 0; i < aCount; aSrc += aBytesPerPixel)
+			{
+			for (TInt copy = 0; copy < aFactor && i < aCount; copy++, i++)
+				Mem::Copy(aDest + i * aBytesPerPixel, aSrc, aBytesPerPixel);
+			}
+		break;
+		}
+	}
+
+//
+// Sampling: aLength pixels taken aFactor pixels apart.
+//
+
+LOCAL_C void Sample32(TUint32* aDest, const TUint32* aSrc, TInt aLength, TInt aFactor)
+	{
+	TInt i = 0;
+	if (aFactor == 1)
+		{
+		Mem::Copy(aDest, aSrc, aLength * sizeof(TUint32));
+		return;
+		}
+#if defined(__BITDRAW_SSE2__)
+	if (aFactor == 2)
+		{
+		// The last pair is read whole, so stop one vector early to stay within the line.
+		for (; i + 5 <= aLength; i += 4)
+			{
+			const __m128 first = _mm_loadu_ps(reinterpret_cast<const float*>(aSrc + i * 2));
+			const __m128 second = _mm_loadu_ps(reinterpret_cast<const float*>(aSrc + i * 2 + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i),
+							 _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0))));
+			}
+		}
+#elif defined(__BITDRAW_NEON__)
+	if (aFactor == 2)
+		{
+		for (; i + 5 <= aLength; i += 4)
+			vst1q_u32(aDest + i, vuzpq_u32(vld1q_u32(aSrc + i * 2), vld1q_u32(aSrc + i * 2 + 4)).val[0]);
+		}
+#endif
+	for (; i < aLength; i++)
+		aDest[i] = aSrc[i * aFactor];
+	}
+
+LOCAL_C void Sample16(TUint16* aDest, const TUint16* aSrc, TInt aLength, TInt aFactor)
+	{
+	TInt i = 0;
+	if (aFactor == 1)
+		{
+		Mem::Copy(aDest, aSrc, aLength * sizeof(TUint16));
+		return;
+		}
+#if defined(__BITDRAW_SSE2__)
+	if (aFactor == 2)
+		{
+		// Sign-extend the even pixels to 32 bits so that the signed pack keeps them intact.
+		for (; i + 9 <= aLength; i += 8)
+			{
+			const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i * 2));
+			const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i * 2 + 8));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i),
+							 _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(first, 16), 16),
+											 _mm_srai_epi32(_mm_slli_epi32(second, 16), 16)));
+			}
+		}
+#elif defined(__BITDRAW_NEON__)
+	if (aFactor == 2)
+		{
+		for (; i + 9 <= aLength; i += 8)
+			vst1q_u16(aDest + i, vuzpq_u16(vld1q_u16(aSrc + i * 2), vld1q_u16(aSrc + i * 2 + 8)).val[0]);
+		}
+#endif
+	for (; i < aLength; i++)
+		aDest[i] = aSrc[i * aFactor];
+	}
+
+LOCAL_C void Sample(TUint8* aDest, const TUint8* aSrc, TInt aLength, TInt aFactor, TInt aBytesPerPixel)
+	{
+	switch (aBytesPerPixel)
+		{
+	case 4:
+		Sample32(reinterpret_cast<TUint32*>(aDest), reinterpret_cast<const TUint32*>(aSrc), aLength, aFactor);
+		break;
+	case 2:
+		Sample16(reinterpret_cast<TUint16*>(aDest), reinterpret_cast<const TUint16*>(aSrc), aLength, aFactor);
+		break;
+	default:
+		for (TInt i = 0; i < aLength; i++)
+			Mem::Copy(aDest + i * aBytesPerPixel, aSrc + i * aFactor * aBytesPerPixel, aBytesPerPixel);
+		break;
+		}
+	}
+
+LOCAL_C void FillRow(TUint8* aDest, TInt aCount, TUint32 aPixel, TInt aBytesPerPixel)
+	{
+	switch (aBytesPerPixel)
+		{
+	case 1:
+		Mem::Fill(aDest, aCount, TUint8(aPixel));
+		break;
+	case 2:
+		{
+		TUint16* dest = reinterpret_cast<TUint16*>(aDest);
+		for (TInt i = 0; i < aCount; i++)
+			dest[i] = TUint16(aPixel);
+		}
+		break;
+	case 3:
+		for (TInt i = 0; i < aCount; i++, aDest += 3)
+			{
+			aDest[0] = TUint8(aPixel);
+			aDest[1] = TUint8(aPixel >> 8);
+			aDest[2] = TUint8(aPixel >> 16);
+			}
+		break;
+	default:
+		{
+		TUint32* dest = reinterpret_cast<TUint32*>(aDest);
+		for (TInt i = 0; i < aCount; i++)
+			dest[i] = aPixel;
+		}
+		break;
+		}
+	}
+
+//
+// Box filters: the average of aColumns x aRows physical pixels, rounded to nearest,
+// channel by channel.
+//
+
+LOCAL_C TUint32 Box32(const TUint8* aFirst, TInt aStride, TInt aColumns, TInt aRows)
+	{
+	const TUint32 count = aColumns * aRows;
+	TUint32 sum[4];
+#if defined(__BITDRAW_SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	__m128i total = zero;
+	for (TInt row = 0; row < aRows; row++, aFirst += aStride)
+		{
+		const TUint32* pixels = reinterpret_cast<const TUint32*>(aFirst);
+		TInt column = 0;
+		__m128i rowTotal = zero;
+		for (; column + 2 <= aColumns; column += 2)
+			rowTotal = _mm_add_epi16(rowTotal, _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels + column)), zero));
+		if (column < aColumns)
+			rowTotal = _mm_add_epi16(rowTotal, _mm_unpacklo_epi8(_mm_cvtsi32_si128(TInt(pixels[column])), zero));
+		// With at most KScaledChunkPixels columns no 16-bit lane sums more than 256 channel values.
+		rowTotal = _mm_add_epi16(rowTotal, _mm_srli_si128(rowTotal, 8));
+		total = _mm_add_epi32(total, _mm_unpacklo_epi16(rowTotal, zero));
+		}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sum), total);
+#elif defined(__BITDRAW_NEON__)
+	uint32x4_t total = vdupq_n_u32(0);
+	for (TInt row = 0; row < aRows; row++, aFirst += aStride)
+		{
+		const TUint32* pixels = reinterpret_cast<const TUint32*>(aFirst);
+		uint16x4_t rowTotal = vdup_n_u16(0);
+		for (TInt column = 0; column < aColumns; column++)
+			rowTotal = vadd_u16(rowTotal, vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(pixels[column])))));
+		total = vaddw_u16(total, rowTotal);
+		}
+	vst1q_u32(sum, total);
+#else
+	sum[0] = sum[1] = sum[2] = sum[3] = 0;
+	for (TInt row = 0; row < aRows; row++, aFirst += aStride)
+		{
+		const TUint32* pixels = reinterpret_cast<const TUint32*>(aFirst);
+		for (TInt column = 0; column < aColumns; column++)
+			{
+			const TUint32 pixel = pixels[column];
+			sum[0] += pixel & 0xff;
+			sum[1] += (pixel >> 8) & 0xff;
+			sum[2] += (pixel >> 16) & 0xff;
+			sum[3] += pixel >> 24;
+			}
+		}
+#endif
+	TUint32 result = 0;
+	for (TInt channel = 0; channel < 4; channel++)
+		result |= ((sum[channel] + count / 2) / count) << (channel * 8);
+	return result;
+	}
+
+LOCAL_C TUint16 Box64K(const TUint8* aFirst, TInt aStride, TInt aColumns, TInt aRows)
+	{
+	const TUint32 count = aColumns * aRows;
+	TUint32 red = 0;
+	TUint32 green = 0;
+	TUint32 blue = 0;
+	for (TInt row = 0; row < aRows; row++, aFirst += aStride)
+		{
+		const TUint16* pixels = reinterpret_cast<const TUint16*>(aFirst);
+		for (TInt column = 0; column < aColumns; column++)
+			{
+			const TUint32 pixel = pixels[column];
+			red += pixel >> 11;
+			green += (pixel >> 5) & 0x3f;
+			blue += pixel & 0x1f;
+			}
+		}
+	red = (red + count / 2) / count;
+	green = (green + count / 2) / count;
+	blue = (blue + count / 2) / count;
+	return TUint16((red << 11) | (green << 5) | blue);
+	}
+
+/**
+@return ETrue if the functions of this class can be used on a device with layout aInfo.
+The horizontal factor must be at most 256.
+*/
+TBool TScaledScanLine::IsSupported(const TDirectScanLineInfo& aInfo)
+	{
+	return aInfo.iBits && aInfo.iOrientation == CFbsDrawDevice::EOrientationNormal && aInfo.HasBytePixels() &&
+		   aInfo.iFactorX >= 1 && aInfo.iFactorX <= KScaledChunkPixels && aInfo.iFactorY >= 1;
+	}
+
+/**
+@return ETrue if ReadLineBoxFiltered() can be used on a device with layout aInfo: 32bpp
+and EColor64K display modes.
+*/
+TBool TScaledScanLine::IsBoxFilterSupported(const TDirectScanLineInfo& aInfo)
+	{
+	return IsSupported(aInfo) && (aInfo.iBitsPerPixel == 32 || aInfo.iDisplayMode == EColor64K);
+	}
+
+/**
+Reads a line, one physical pixel per logical pixel.
+@param aInfo	Memory layout of the device
+@param aX		Logical x coordinate of the first pixel
+@param aY		Logical y coordinate of the line
+@param aLength	Number of logical pixels
+@param aBuffer	Receives the pixels in DisplayMode() format
+*/
+void TScaledScanLine::ReadLine(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength, TAny* aBuffer)
+	{
+	const TInt bytesPerPixel = aInfo.iBitsPerPixel >> 3;
+	const TPoint start(aInfo.LogicalToPhysical(TPoint(aX, aY)));
+	__ASSERT_DEBUG(start.iX + (aLength - 1) * aInfo.iFactorX < aInfo.iPhysicalSize.iWidth, Panic(EScreenDriverPanicOutOfBounds));
+	Sample(static_cast<TUint8*>(aBuffer), aInfo.RowAddress(start.iY) + start.iX * bytesPerPixel,
+		   aLength, aInfo.iFactorX, bytesPerPixel);
+	}
+
+/**
+Reads a line, each logical pixel being the average of the physical pixels it covers.
+@param aInfo	Memory layout of the device; IsBoxFilterSupported() must return ETrue
+@param aX		Logical x coordinate of the first pixel
+@param aY		Logical y coordinate of the line
+@param aLength	Number of logical pixels
+@param aBuffer	Receives the pixels in DisplayMode() format
+*/
+void TScaledScanLine::ReadLineBoxFiltered(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength, TAny* aBuffer)
+	{
+	const TInt bytesPerPixel = aInfo.iBitsPerPixel >> 3;
+	const TPoint start(aInfo.LogicalToPhysical(TPoint(aX, aY)));
+	const TInt width = aInfo.iPhysicalSize.iWidth - start.iX;
+	const TInt rows = Min(aInfo.iFactorY, aInfo.iPhysicalSize.iHeight - start.iY);
+	const TUint8* first = aInfo.RowAddress(start.iY) + start.iX * bytesPerPixel;
+	for (TInt i = 0, x = 0; i < aLength; i++, x += aInfo.iFactorX)
+		{
+		const TInt columns = Min(aInfo.iFactorX, width - x);
+		if (bytesPerPixel == 4)
+			static_cast<TUint32*>(aBuffer)[i] = Box32(first + x * 4, aInfo.iStride, columns, rows);
+		else
+			static_cast<TUint16*>(aBuffer)[i] = Box64K(first + x * 2, aInfo.iStride, columns, rows);
+		}
+	}
+
+/**
+Writes a line of pixels, replacing the pixels of the device.
+@param aInfo	Memory layout of the device
+@param aX		Logical x coordinate of the first pixel
+@param aY		Logical y coordinate of the line
+@param aLength	Number of logical pixels
+@param aBuffer	Pixels in DisplayMode() format
+*/
+void TScaledScanLine::WriteLine(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength, const TAny* aBuffer)
+	{
+	const TInt bytesPerPixel = aInfo.iBitsPerPixel >> 3;
+	const TPoint start(aInfo.LogicalToPhysical(TPoint(aX, aY)));
+	const TInt count = Min(aLength * aInfo.iFactorX, aInfo.iPhysicalSize.iWidth - start.iX);
+	const TInt rows = Min(aInfo.iFactorY, aInfo.iPhysicalSize.iHeight - start.iY);
+	TUint8* first = aInfo.RowAddress(start.iY) + start.iX * bytesPerPixel;
+	Replicate(first, static_cast<const TUint8*>(aBuffer), count, aInfo.iFactorX, bytesPerPixel);
+	for (TInt row = 1; row < rows; row++)
+		Mem::Copy(first + row * aInfo.iStride, first, count * bytesPerPixel);
+	}
+
+/**
+Fills a rectangle with one pixel value.
+@param aInfo	Memory layout of the device
+@param aRect	Logical rectangle to fill
+@param aPixel	Pixel value in DisplayMode() format
+*/
+void TScaledScanLine::WriteRgbMulti(const TDirectScanLineInfo& aInfo, const TRect& aRect, TUint32 aPixel)
+	{
+	if (aRect.IsEmpty())
+		return;
+	const TInt bytesPerPixel = aInfo.iBitsPerPixel >> 3;
+	const TPoint start(aInfo.LogicalToPhysical(aRect.iTl));
+	const TInt count = Min(aRect.Width() * aInfo.iFactorX, aInfo.iPhysicalSize.iWidth - start.iX);
+	const TInt rows = Min(aRect.Height() * aInfo.iFactorY, aInfo.iPhysicalSize.iHeight - start.iY);
+	TUint8* first = aInfo.RowAddress(start.iY) + start.iX * bytesPerPixel;
+	FillRow(first, count, aPixel, bytesPerPixel);
+	for (TInt row = 1; row < rows; row++)
+		Mem::Copy(first + row * aInfo.iStride, first, count * bytesPerPixel);
+	}
+
+/**
+Blends a line of ERgb pixels into the device, as WriteRgbAlphaLine() does.
+@param aInfo		Memory layout of the device; the display mode must be supported by TAlphaBlendSpan
+@param aX			Logical x coordinate of the first pixel
+@param aY			Logical y coordinate of the line
+@param aLength		Number of logical pixels
+@param aRgbBuffer	Source pixels in ERgb format
+@param aMaskBuffer	Alpha values in EGray256 format
+@panic EScreenDriverPanicInvalidDisplayMode if TAlphaBlendSpan does not support the display mode
+*/
+void TScaledScanLine::WriteRgbAlphaLine(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength,
+										const TUint8* aRgbBuffer, const TUint8* aMaskBuffer) const
+	{
+	TUint32 rgb[KScaledChunkPixels];
+	TUint8 mask[KScaledChunkPixels];
+	TUint32 background[KScaledChunkPixels];
+	const TInt factor = aInfo.iFactorX;
+	const TInt bytesPerPixel = aInfo.iBitsPerPixel >> 3;
+	const TPoint start(aInfo.LogicalToPhysical(TPoint(aX, aY)));
+	const TInt count = Min(aLength * factor, aInfo.iPhysicalSize.iWidth - start.iX);
+	const TInt rows = Min(aInfo.iFactorY, aInfo.iPhysicalSize.iHeight - start.iY);
+	const TInt chunk = KScaledChunkPixels / factor * factor;
+	TUint8* const row = aInfo.RowAddress(start.iY) + start.iX * bytesPerPixel;
+	for (TInt done = 0; done < count; done += chunk)
+		{
+		const TInt length = Min(chunk, count - done);
+		const TInt bytes = length * bytesPerPixel;
+		const TInt logical = done / factor;
+		Replicate32(rgb, reinterpret_cast<const TUint32*>(aRgbBuffer) + logical, length, factor);
+		Replicate(mask, aMaskBuffer + logical, length, factor, 1);
+		TUint8* const first = row + done * bytesPerPixel;
+		if (rows > 1)
+			Mem::Copy(background, first, bytes);
+		iBlend.BlendLine(aInfo.iDisplayMode, first, reinterpret_cast<const TUint8*>(rgb), first, mask, length);
+		for (TInt index = 1; index < rows; index++)
+			{
+			TUint8* const dest = first + index * aInfo.iStride;
+			if (Mem::Compare(dest, bytes, reinterpret_cast<const TUint8*>(background), bytes) == 0)
+				Mem::Copy(dest, first, bytes);
+			else
+				iBlend.BlendLine(aInfo.iDisplayMode, dest, reinterpret_cast<const TUint8*>(rgb), dest, mask, length);
+			}
+		}
+	}
@@ -0,0 +1,59 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWSCALED_H__
+#define __BITDRAWSCALED_H__
+
+#include "BitDrawDirectAccess.h"
+#include "BitDrawAlphaBlend.h"
+
+/**
+Scan line kernels for scaled bitmap devices, where every logical pixel covers
+iFactorX x iFactorY physical pixels.
+
+The write functions replicate each logical pixel iFactorX times into the first physical row of
+the line, with vectorized kernels for the common factors, and then copy that row to the other
+iFactorY - 1 rows instead of computing them again. WriteRgbAlphaLine() only shares the blended
+row with the rows whose background was identical to the first one, so the result is the same
+as blending every physical pixel.
+
+ReadLine() samples the top-left physical pixel of every logical pixel, as
+CFbsDrawDevice::ReadLine() does on a scaled device. ReadLineBoxFiltered() averages all the
+physical pixels of each logical pixel instead, for thumbnails.
+
+The functions work on unscaled devices too. They require EOrientationNormal and a display mode of
+8bpp or more, and take pixels in DisplayMode() format; the coordinates are logical and must be
+within the draw rectangle. Physical pixels beyond the edge of the memory are clipped. Draw modes
+other than EDrawModePEN, shadowing and fading are not applied, so a device must only use the
+write functions when they are not in force.
+@see TDirectScanLineInfo
+@internalComponent
+*/
+class TScaledScanLine
+	{
+public:
+	static TBool IsSupported(const TDirectScanLineInfo& aInfo);
+	static TBool IsBoxFilterSupported(const TDirectScanLineInfo& aInfo);
+	static void ReadLine(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength, TAny* aBuffer);
+	static void ReadLineBoxFiltered(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength, TAny* aBuffer);
+	static void WriteLine(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength, const TAny* aBuffer);
+	static void WriteRgbMulti(const TDirectScanLineInfo& aInfo, const TRect& aRect, TUint32 aPixel);
+	void WriteRgbAlphaLine(const TDirectScanLineInfo& aInfo, TInt aX, TInt aY, TInt aLength,
+						   const TUint8* aRgbBuffer, const TUint8* aMaskBuffer) const;
+private:
+	TAlphaBlendSpan iBlend;
+	};
+
+#endif
@@ -0,0 +1,277 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawShadowFade.h"
+#include "BitDrawMapColors.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define __BITDRAW_SSE2__
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define __BITDRAW_NEON__
+#include <arm_neon.h>
+#endif
+
+/** Amount subtracted from each channel by EShadow. */
+const TInt KShadowOffset = 0x40;
+
+#if defined(__BITDRAW_SSE2__) || defined(__BITDRAW_NEON__)
+
+/**
+Processes 32bpp pixels arithmetically, 4 (SSE2) or 8 (NEON) at a time, and returns the number
+of pixels processed; the caller processes the rest through the channel table.
+aFactor must be in the range [1, 256], so that C * aFactor fits in 16 bits and the faded value
+cannot overflow. The alpha channel is kept where aKeepAlpha has bits set, then ORed with aForceAlpha.
+*/
+LOCAL_C TInt ShadowFadeThirtyTwoBpp(TUint32* aPixels, TInt aLength, TInt aFactor, TInt aOffset,
+									TInt aShadow, TUint32 aKeepAlpha, TUint32 aForceAlpha)
+	{
+	TInt i = 0;
+#if defined(__BITDRAW_SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i factor = _mm_set1_epi16(TInt16(aFactor));
+	const __m128i offset = _mm_set1_epi8(TInt8(aOffset));
+	const __m128i shadow = _mm_set1_epi8(TInt8(aShadow));
+	const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+	const __m128i keep = _mm_set1_epi32(TInt32(aKeepAlpha));
+	const __m128i force = _mm_set1_epi32(TInt32(aForceAlpha));
+	for (; i + 4 <= aLength; i += 4)
+		{
+		__m128i* const ptr = reinterpret_cast<__m128i*>(aPixels + i);
+		const __m128i pixels = _mm_loadu_si128(ptr);
+		const __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), factor), 8);
+		const __m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), factor), 8);
+		__m128i res = _mm_subs_epu8(_mm_add_epi8(_mm_packus_epi16(lo, hi), offset), shadow);
+		res = _mm_or_si128(_mm_and_si128(res, rgbMask), _mm_or_si128(_mm_and_si128(pixels, keep), force));
+		_mm_storeu_si128(ptr, res);
+		}
+#else
+	const uint16x8_t factor = vdupq_n_u16(TUint16(aFactor));
+	const uint8x8_t offset = vdup_n_u8(TUint8(aOffset));
+	const uint8x8_t shadow = vdup_n_u8(TUint8(aShadow));
+	const uint8x8_t keep = vdup_n_u8(TUint8(aKeepAlpha >> 24));
+	const uint8x8_t force = vdup_n_u8(TUint8(aForceAlpha >> 24));
+	for (; i + 8 <= aLength; i += 8)
+		{
+		TUint8* const ptr = reinterpret_cast<TUint8*>(aPixels + i);
+		uint8x8x4_t pixels = vld4_u8(ptr);
+		for (TInt channel = 0; channel < 3; channel++)
+			{
+			const uint8x8_t faded = vshrn_n_u16(vmulq_u16(vmovl_u8(pixels.val[channel]), factor), 8);
+			pixels.val[channel] = vqsub_u8(vadd_u8(faded, offset), shadow);
+			}
+		pixels.val[3] = vorr_u8(vand_u8(pixels.val[3], keep), force);
+		vst4_u8(ptr, pixels);
+		}
+#endif
+	return i;
+	}
+
+#endif // __BITDRAW_SSE2__ || __BITDRAW_NEON__
+
+RShadowFadeTables::RShadowFadeTables():
+	iShadowMode(CFbsDrawDevice::ENoShadow),
+	iBlackMap(KDefaultFadeBlackMap),
+	iWhiteMap(KDefaultFadeWhiteMap),
+	iBuilt(EFalse),
+	iBuiltShadowMode(CFbsDrawDevice::ENoShadow),
+	iBuiltBlackMap(0),
+	iBuiltWhiteMap(0),
+	iWordTable(NULL)
+	{
+	}
+
+/**
+Sets the display mode of the pixels that will be passed to ShadowLine().
+The shadow mode and fading parameters are kept.
+@param aDispMode Display mode of the draw device
+@return KErrNone, or KErrNoMemory if the EColor4K or EColor64K table could not be allocated,
+		in which case ShadowLine() processes pixels one at a time.
+@panic EScreenDriverPanicInvalidDisplayMode if aDispMode is not a draw device display mode
+*/
+TInt RShadowFadeTables::Create(TDisplayMode aDispMode)
+	{
+	Close();
+	SetDisplayMode(aDispMode);
+	if (iBitsPerPixel == 16)
+		{
+		iWordTable = new TUint16[aDispMode == EColor4K ? 0x1000 : 0x10000];
+		if (!iWordTable)
+			return KErrNoMemory;
+		}
+	return KErrNone;
+	}
+
+/**
+Frees the EColor4K or EColor64K table.
+*/
+void RShadowFadeTables::Close()
+	{
+	delete [] iWordTable;
+	iWordTable = NULL;
+	iBuilt = EFalse;
+	}
+
+/**
+Sets the processing applied by ShadowLine() and ShadowRgb().
+@param aShadowMode Shadow mode, as passed to CFbsDrawDevice::SetShadowMode()
+*/
+void RShadowFadeTables::SetShadowMode(CFbsDrawDevice::TShadowMode aShadowMode)
+	{
+	iShadowMode = aShadowMode;
+	}
+
+/**
+Sets the fading parameters used while the shadow mode includes EFade.
+@param aBlackMap Value black is mapped to
+@param aWhiteMap Value white is mapped to
+*/
+void RShadowFadeTables::SetFadingParameters(TUint8 aBlackMap, TUint8 aWhiteMap)
+	{
+	iBlackMap = aBlackMap;
+	iWhiteMap = aWhiteMap;
+	}
+
+TInt RShadowFadeTables::ShadowChannel(TInt aValue) const
+	{
+	if (iShadowMode & CFbsDrawDevice::EFade)
+		aValue = ((aValue * (iWhiteMap - iBlackMap + 1)) >> 8) + iBlackMap;
+	if (iShadowMode & CFbsDrawDevice::EShadow)
+		aValue -= KShadowOffset;
+	return Max(0, Min(aValue, 255));
+	}
+
+/**
+Applies the current shadow mode to a colour, for example the pen colour of a write primitive.
+@param aColor Colour to process
+@return The shadowed and/or faded colour, with the alpha channel of aColor
+*/
+TRgb RShadowFadeTables::ShadowRgb(TRgb aColor) const
+	{
+	if (iShadowMode == CFbsDrawDevice::ENoShadow)
+		return aColor;
+	return TRgb(ShadowChannel(aColor.Red()), ShadowChannel(aColor.Green()),
+				ShadowChannel(aColor.Blue()), aColor.Alpha());
+	}
+
+TUint32 RShadowFadeTables::ShadowPixel(TUint32 aPixel) const
+	{
+	return RDrawColorMap::RgbToPixel(iDispMode, ShadowRgb(RDrawColorMap::PixelToRgb(iDispMode, aPixel)));
+	}
+
+void RShadowFadeTables::Build()
+	{
+	for (TInt value = 0; value < 256; value++)
+		iChannelTable[value] = TUint8(ShadowChannel(value));
+	if (iBitsPerPixel <= 8)
+		{
+		const TInt numValues = 1 << iBitsPerPixel;
+		for (TInt value = 0; value < numValues; value++)
+			iPixelTable[value] = TUint8(ShadowPixel(value));
+		BuildByteTable();
+		}
+	else if (iWordTable)
+		{
+		const TInt numValues = iDispMode == EColor4K ? 0x1000 : 0x10000;
+		for (TInt value = 0; value < numValues; value++)
+			iWordTable[value] = TUint16(ShadowPixel(value));
+		}
+	iBuilt = ETrue;
+	iBuiltShadowMode = iShadowMode;
+	iBuiltBlackMap = iBlackMap;
+	iBuiltWhiteMap = iWhiteMap;
+	}
+
+/**
+Applies the current shadow mode to aLength pixels of one scan line.
+CFbsDrawDevice::ShadowBuffer(aLength, aBuffer) is ShadowLine(aBuffer, 0, aLength).
+@param aScanLine	Address of the scan line, in the display mode passed to Create()
+@param aX			Index of the first pixel to process within the scan line
+@param aLength		Number of pixels to process
+*/
+void RShadowFadeTables::ShadowLine(TAny* aScanLine, TInt aX, TInt aLength)
+	{
+	__ASSERT_DEBUG(aScanLine, Panic(EScreenDriverPanicNullPointer));
+	__ASSERT_DEBUG(aX >= 0 && aLength >= 0, Panic(EScreenDriverPanicOutOfBounds));
+	if (aLength <= 0 || iShadowMode == CFbsDrawDevice::ENoShadow)
+		return;
+	if (!iBuilt || iBuiltShadowMode != iShadowMode || iBuiltBlackMap != iBlackMap || iBuiltWhiteMap != iWhiteMap)
+		Build();
+	ProcessLine(aScanLine, aX, aLength);
+	}
+
+void RShadowFadeTables::ProcessSixteenBppLine(TUint16* aPixels, TInt aLength) const
+	{
+	TUint16* const limit = aPixels + aLength;
+	if (iWordTable)
+		{
+		// The EColor4K table only covers the low 12 bits, which are all the pixel holds.
+		const TUint32 valueMask = iDispMode == EColor4K ? 0x0fff : 0xffff;
+		for (; aPixels < limit; aPixels++)
+			*aPixels = iWordTable[*aPixels & valueMask];
+		return;
+		}
+	for (; aPixels < limit; aPixels++)
+		*aPixels = TUint16(ShadowPixel(*aPixels));
+	}
+
+/**
+EColor16M: every byte is a colour channel, so the channel table applies to the whole line.
+*/
+void RShadowFadeTables::ProcessTwentyFourBppLine(TUint8* aPixels, TInt aLength) const
+	{
+	TUint8* const limit = aPixels + aLength * 3;
+	for (; aPixels < limit; aPixels++)
+		*aPixels = iChannelTable[*aPixels];
+	}
+
+void RShadowFadeTables::ProcessThirtyTwoBppLine(TUint32* aPixels, TInt aLength) const
+	{
+	const TUint32 forceAlpha = iDispMode == EColor16MU ? 0xff000000 : 0;
+	TInt i = 0;
+	if (iDispMode == EColor16MAP)
+		{
+		// Premultiplied pixels are faded through TRgb unless they are opaque.
+		for (; i < aLength; i++)
+			{
+			const TUint32 pixel = aPixels[i];
+			const TUint32 alpha = pixel >> 24;
+			if (alpha == 0xff)
+				aPixels[i] = 0xff000000 | (iChannelTable[(pixel >> 16) & 0xff] << 16) |
+							 (iChannelTable[(pixel >> 8) & 0xff] << 8) | iChannelTable[pixel & 0xff];
+			else if (alpha != 0)
+				aPixels[i] = ShadowPixel(pixel);
+			}
+		return;
+		}
+#if defined(__BITDRAW_SSE2__) || defined(__BITDRAW_NEON__)
+	if (iWhiteMap >= iBlackMap)
+		{
+		const TBool fade = iShadowMode & CFbsDrawDevice::EFade;
+		i = ShadowFadeThirtyTwoBpp(aPixels, aLength,
+								   fade ? iWhiteMap - iBlackMap + 1 : 256, fade ? iBlackMap : 0,
+								   iShadowMode & CFbsDrawDevice::EShadow ? KShadowOffset : 0,
+								   forceAlpha ? 0 : 0xff000000, forceAlpha);
+		}
+#endif
+	for (; i < aLength; i++)
+		{
+		const TUint32 pixel = aPixels[i];
+		aPixels[i] = (pixel & 0xff000000) | forceAlpha | (iChannelTable[(pixel >> 16) & 0xff] << 16) |
+					 (iChannelTable[(pixel >> 8) & 0xff] << 8) | iChannelTable[pixel & 0xff];
+		}
+	}
@@ -0,0 +1,94 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWSHADOWFADE_H__
+#define __BITDRAWSHADOWFADE_H__
+
+#include <gdi.h>
+#include "bitdraw.h"
+#include "BitDrawLineTable.h"
+
+/**
+Default fading parameters, used until SetFadingParameters() is called.
+@internalComponent
+*/
+const TUint8 KDefaultFadeBlackMap = 128;
+const TUint8 KDefaultFadeWhiteMap = 255;
+
+/**
+Precomputed shadow and fade processing, used to implement CFbsDrawDevice::ShadowArea(),
+CFbsDrawDevice::ShadowBuffer() and the shadow/fade flag of the write primitives.
+
+Each colour channel C is processed as follows, fading first when both are set:
+	- EFade   - C = ((C * (aWhiteMap - aBlackMap + 1)) >> 8) + aBlackMap;
+	- EShadow - C = C - 0x40, or 0 if C is less than 0x40.
+Pixels are converted through TRgb, so palette and grey modes map to the nearest colour of the
+display mode. The alpha channel is left unchanged, except in EColor16MU where it is set to 0xFF.
+
+The tables are built on the first ShadowLine() call after the shadow mode or the fading
+parameters change, and kept while they stay the same:
+	- display modes up to 8bpp use a 256-entry byte table, which processes a whole byte
+	  (8, 4, 2 or 1 pixels) per lookup;
+	- EColor4K and EColor64K use a table indexed by pixel value;
+	- 24bpp and 32bpp modes use a 256-entry table per channel. EColor16MU and EColor16MA
+	  lines are processed 4 or 8 pixels at a time with SSE2 or NEON where available, which
+	  gives the same result as the table.
+If the EColor4K or EColor64K table cannot be allocated, pixels are processed one at a time.
+
+@see CFbsDrawDevice::SetShadowMode
+@see CFbsDrawDevice::SetFadingParameters
+@see TPixelLineTable
+@internalComponent
+*/
+class RShadowFadeTables : private TPixelLineTable
+	{
+public:
+	RShadowFadeTables();
+	TInt Create(TDisplayMode aDispMode);
+	void Close();
+	void SetShadowMode(CFbsDrawDevice::TShadowMode aShadowMode);
+	void SetFadingParameters(TUint8 aBlackMap, TUint8 aWhiteMap);
+	inline CFbsDrawDevice::TShadowMode ShadowMode() const;
+	TRgb ShadowRgb(TRgb aColor) const;
+	void ShadowLine(TAny* aScanLine, TInt aX, TInt aLength);
+private:
+	TInt ShadowChannel(TInt aValue) const;
+	TUint32 ShadowPixel(TUint32 aPixel) const;
+	void Build();
+private: // From TPixelLineTable
+	void ProcessSixteenBppLine(TUint16* aPixels, TInt aLength) const;
+	void ProcessTwentyFourBppLine(TUint8* aPixels, TInt aLength) const;
+	void ProcessThirtyTwoBppLine(TUint32* aPixels, TInt aLength) const;
+private:
+	CFbsDrawDevice::TShadowMode iShadowMode;
+	TUint8 iBlackMap;
+	TUint8 iWhiteMap;
+	TBool iBuilt;
+	CFbsDrawDevice::TShadowMode iBuiltShadowMode;
+	TUint8 iBuiltBlackMap;
+	TUint8 iBuiltWhiteMap;
+	TUint16* iWordTable;
+	TUint8 iChannelTable[256];
+	};
+
+/**
+@return The current shadow mode.
+*/
+inline CFbsDrawDevice::TShadowMode RShadowFadeTables::ShadowMode() const
+	{
+	return iShadowMode;
+	}
+
+#endif
@@ -0,0 +1,190 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include <hal.h>
+#include <e32atomics.h>
+#include "BitDrawThreadPool.h"
+#include "bitdraw.h"
+
+/**
+Creates a pool.
+@param aThreadCount Number of worker threads. If 0, one less than the number of CPUs is used,
+so that the calling thread and the workers together occupy every CPU.
+@return The new pool
+@leave KErrNoMemory Not enough memory
+KErrArgument aThreadCount is negative
+Any error returned by RThread::Create() or RSemaphore::CreateLocal()
+*/
+CDrawThreadPool* CDrawThreadPool::NewL(TInt aThreadCount)
+	{
+	if (aThreadCount < 0)
+		User::Leave(KErrArgument);
+	CDrawThreadPool* self = new(ELeave) CDrawThreadPool;
+	CleanupStack::PushL(self);
+	self->ConstructL(aThreadCount);
+	CleanupStack::Pop(self);
+	return self;
+	}
+
+CDrawThreadPool::CDrawThreadPool()
+	{
+	}
+
+void CDrawThreadPool::ConstructL(TInt aThreadCount)
+	{
+	if (aThreadCount == 0)
+		{
+		TInt cpus = 1;
+		if (HAL::Get(HALData::ENumCpus, cpus) != KErrNone || cpus < 1)
+			cpus = 1;
+		aThreadCount = cpus - 1;
+		}
+	iThreadCount = aThreadCount;
+	iQueueCount = aThreadCount + 1;
+	User::LeaveIfError(iWorkSemaphore.CreateLocal(0));
+	User::LeaveIfError(iDoneSemaphore.CreateLocal(0));
+	iQueues = new(ELeave) TWorkQueue[iQueueCount];
+	for (TInt index = 0; index < iQueueCount; index++)
+		{
+		iQueues[index].iJob = NULL;
+		iQueues[index].iNext = 0;
+		iQueues[index].iEnd = 0;
+		User::LeaveIfError(iQueues[index].iLock.CreateLocal());
+		}
+	iThreads = new(ELeave) RThread[iThreadCount];
+	for (; iThreadsCreated < iThreadCount; iThreadsCreated++)
+		{
+		RThread& thread = iThreads[iThreadsCreated];
+		User::LeaveIfError(thread.Create(KNullDesC, ThreadFunction, KDefaultStackSize, NULL, this));
+		thread.Resume();
+		}
+	}
+
+/**
+Stops and closes the worker threads. Must not be called while Execute() is running.
+*/
+CDrawThreadPool::~CDrawThreadPool()
+	{
+	iShutdown = ETrue;
+	// Any worker may take any signal, so wake them all before waiting for each one.
+	if (iThreadsCreated > 0)
+		iWorkSemaphore.Signal(iThreadsCreated);
+	for (TInt index = 0; index < iThreadsCreated; index++)
+		{
+		RThread& thread = iThreads[index];
+		TRequestStatus status;
+		thread.Logon(status);
+		User::WaitForRequest(status);
+		thread.Close();
+		}
+	delete [] iThreads;
+	if (iQueues)
+		{
+		for (TInt index = 0; index < iQueueCount; index++)
+			iQueues[index].iLock.Close();
+		delete [] iQueues;
+		}
+	iWorkSemaphore.Close();
+	iDoneSemaphore.Close();
+	}
+
+/**
+Runs every band of aJob and returns when all of them have completed.
+The calling thread takes part in the work. Must not be called concurrently from several threads.
+@param aJob			Job to run
+@param aBandCount	Number of bands in aJob
+*/
+void CDrawThreadPool::Execute(MDrawBandJob& aJob, TInt aBandCount)
+	{
+	if (aBandCount <= 0)
+		return;
+	if (iThreadCount == 0 || aBandCount == 1)
+		{
+		for (TInt band = 0; band < aBandCount; band++)
+			aJob.DoBand(band);
+		return;
+		}
+	__e32_atomic_store_rel32(&iRemaining, aBandCount);
+	const TInt perQueue = aBandCount / iQueueCount;
+	TInt extra = aBandCount % iQueueCount;
+	TInt next = 0;
+	for (TInt index = 0; index < iQueueCount; index++)
+		{
+		TWorkQueue& queue = iQueues[index];
+		const TInt count = perQueue + (extra-- > 0 ? 1 : 0);
+		queue.iLock.Wait();
+		queue.iJob = &aJob;
+		queue.iNext = next;
+		queue.iEnd = next + count;
+		queue.iLock.Signal();
+		next += count;
+		}
+	iWorkSemaphore.Signal(iThreadCount);
+	RunBands(iThreadCount);
+	iDoneSemaphore.Wait();
+	}
+
+TInt CDrawThreadPool::ThreadFunction(TAny* aPtr)
+	{
+	CDrawThreadPool* self = static_cast<CDrawThreadPool*>(aPtr);
+	self->WorkerLoop(__e32_atomic_add_ord32(&self->iNextWorker, 1));
+	return KErrNone;
+	}
+
+void CDrawThreadPool::WorkerLoop(TInt aQueue)
+	{
+	FOREVER
+		{
+		iWorkSemaphore.Wait();
+		if (iShutdown)
+			return;
+		RunBands(aQueue);
+		}
+	}
+
+/**
+Runs bands from the participant's own queue, then steals from the others until
+no bands are left. The participant that completes the last band signals Execute().
+*/
+void CDrawThreadPool::RunBands(TInt aQueue)
+	{
+	MDrawBandJob* job;
+	TInt band;
+	FOREVER
+		{
+		TBool found = TakeBand(aQueue, EFalse, job, band);
+		for (TInt offset = 1; !found && offset < iQueueCount; offset++)
+			found = TakeBand((aQueue + offset) % iQueueCount, ETrue, job, band);
+		if (!found)
+			return;
+		job->DoBand(band);
+		if (__e32_atomic_add_ord32(&iRemaining, TUint32(-1)) == 1)
+			iDoneSemaphore.Signal();
+		}
+	}
+
+TBool CDrawThreadPool::TakeBand(TInt aQueue, TBool aSteal, MDrawBandJob*& aJob, TInt& aBand)
+	{
+	TWorkQueue& queue = iQueues[aQueue];
+	queue.iLock.Wait();
+	const TBool found = queue.iNext < queue.iEnd;
+	if (found)
+		{
+		aJob = queue.iJob;
+		aBand = aSteal ? --queue.iEnd : queue.iNext++;
+		}
+	queue.iLock.Signal();
+	return found;
+	}
@@ -0,0 +1,92 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWTHREADPOOL_H__
+#define __BITDRAWTHREADPOOL_H__
+
+#include <e32base.h>
+
+/**
+A piece of drawing work split into independent bands.
+@see CDrawThreadPool::Execute
+@internalComponent
+*/
+class MDrawBandJob
+	{
+public:
+	/**
+	Processes one band. Called at most once per band, possibly from a worker thread and
+	concurrently with other bands of the same job. Must not leave.
+	@param aBand Index of the band, in the range [0, band count)
+	*/
+	virtual void DoBand(TInt aBand) = 0;
+	};
+
+/**
+Work-stealing pool of threads used to run the bands of a drawing job in parallel.
+
+Execute() splits the bands into one contiguous range per participant - every worker thread
+plus the calling thread. Each participant takes bands from the front of its own range and, once
+that is empty, steals from the back of the others'. Execute() returns only when every band
+has completed.
+@internalComponent
+*/
+class CDrawThreadPool : public CBase
+	{
+public:
+	static CDrawThreadPool* NewL(TInt aThreadCount);
+	~CDrawThreadPool();
+	void Execute(MDrawBandJob& aJob, TInt aBandCount);
+	inline TInt ThreadCount() const;
+private:
+	/**
+	Range of bands not yet taken from one participant's share of the current job.
+	*/
+	struct TWorkQueue
+		{
+		RFastLock iLock;
+		MDrawBandJob* iJob;
+		TInt iNext;
+		TInt iEnd;
+		};
+private:
+	CDrawThreadPool();
+	void ConstructL(TInt aThreadCount);
+	static TInt ThreadFunction(TAny* aPtr);
+	void WorkerLoop(TInt aQueue);
+	void RunBands(TInt aQueue);
+	TBool TakeBand(TInt aQueue, TBool aSteal, MDrawBandJob*& aJob, TInt& aBand);
+private:
+	TInt iThreadCount;
+	TInt iQueueCount;
+	TWorkQueue* iQueues;
+	RThread* iThreads;
+	TInt iThreadsCreated;
+	RSemaphore iWorkSemaphore;
+	RSemaphore iDoneSemaphore;
+	volatile TUint32 iRemaining;
+	volatile TUint32 iNextWorker;
+	volatile TBool iShutdown;
+	};
+
+/**
+@return The number of worker threads, not counting the thread calling Execute().
+*/
+inline TInt CDrawThreadPool::ThreadCount() const
+	{
+	return iThreadCount;
+	}
+
+#endif
@@ -0,0 +1,893 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#include "BitDrawTiled.h"
+#include "BitDrawConvert.h"
+#include "BitDrawPixelFormat.h"
+#include "BitDrawInterfaceId.h"
+#include "BitDrawScaling.h"
+#include "BitDrawOrigin.h"
+
+/** Number of pixels in a tile. */
+const TInt KTilePixels = KTileSize * KTileSize;
+
+/** Longest run of a run-length encoded tile. */
+const TInt KMaxTileRun = 256;
+
+/**
+@return The number of bytes a pixel of aDispMode takes in a tile, or 0 if tiles cannot hold it.
+*/
+LOCAL_C TInt TileBytesPerPixel(TDisplayMode aDispMode)
+	{
+	switch (aDispMode)
+		{
+	case EGray256:
+	case EColor256:
+		return 1;
+	case EColor4K:
+	case EColor64K:
+		return 2;
+	case EColor16M:
+		return 3;
+	case EColor16MU:
+	case EColor16MA:
+	case EColor16MAP:
+		return 4;
+	default:
+		return 0;
+		}
+	}
+
+/**
+Pixels are read and written a byte at a time, as compressed tiles do not align them.
+*/
+LOCAL_C inline TUint32 ReadUnit(const TUint8* aPixel, TInt aBytes)
+	{
+	TUint32 value = aPixel[0];
+	for (TInt index = 1; index < aBytes; index++)
+		value |= TUint32(aPixel[index]) << (index * 8);
+	return value;
+	}
+
+LOCAL_C inline void WriteUnit(TUint8* aPixel, TUint32 aValue, TInt aBytes)
+	{
+	for (TInt index = 0; index < aBytes; index++, aValue >>= 8)
+		aPixel[index] = TUint8(aValue);
+	}
+
+/**
+Sets aCount pixels of aBytes bytes each to aValue, doubling the part already written.
+*/
+LOCAL_C void FillUnits(TUint8* aDest, TInt aCount, TUint32 aValue, TInt aBytes)
+	{
+	if (aBytes == 1)
+		{
+		Mem::Fill(aDest, aCount, TUint8(aValue));
+		return;
+		}
+	WriteUnit(aDest, aValue, aBytes);
+	const TInt total = aCount * aBytes;
+	for (TInt filled = aBytes; filled < total; )
+		{
+		const TInt chunk = Min(filled, total - filled);
+		Mem::Copy(aDest + filled, aDest, chunk);
+		filled += chunk;
+		}
+	}
+
+/**
+Extracts aCount bits, at most 32, starting at bit aBit of aBuffer.
+*/
+LOCAL_C TUint32 ExtractBits(const TUint32* aBuffer, TInt aBit, TInt aCount)
+	{
+	const TInt shift = aBit & 31;
+	aBuffer += aBit >> 5;
+	TUint32 value = aBuffer[0] >> shift;
+	if (shift && shift + aCount > 32)
+		value |= aBuffer[1] << (32 - shift);
+	return aCount < 32 ? value & ((1u << aCount) - 1) : value;
+	}
+
+/**
+Run-length encodes a tile into aDest.
+@return The number of bytes written, or KErrOverflow if they would reach aLimit.
+*/
+LOCAL_C TInt EncodeRunLength(const TUint8* aPixels, TInt aBytes, TUint8* aDest, TInt aLimit)
+	{
+	TInt size = 0;
+	for (TInt index = 0; index < KTilePixels; )
+		{
+		if (size + 1 + aBytes >= aLimit)
+			return KErrOverflow;
+		const TUint32 pixel = ReadUnit(aPixels + index * aBytes, aBytes);
+		TInt run = 1;
+		while (run < KMaxTileRun && index + run < KTilePixels && ReadUnit(aPixels + (index + run) * aBytes, aBytes) == pixel)
+			run++;
+		aDest[size] = TUint8(run - 1);
+		WriteUnit(aDest + size + 1, pixel, aBytes);
+		size += 1 + aBytes;
+		index += run;
+		}
+	return size;
+	}
+
+/**
+Collects the distinct pixel values of a tile into aPalette.
+@return The number of values, or KErrOverflow if there are more than KMaxTilePaletteEntries.
+*/
+LOCAL_C TInt CollectPalette(const TUint8* aPixels, TInt aBytes, TUint32* aPalette)
+	{
+	TInt entries = 0;
+	for (TInt index = 0; index < KTilePixels; index++)
+		{
+		const TUint32 pixel = ReadUnit(aPixels + index * aBytes, aBytes);
+		TInt entry = 0;
+		while (entry < entries && aPalette[entry] != pixel)
+			entry++;
+		if (entry == entries)
+			{
+			if (entries == KMaxTilePaletteEntries)
+				return KErrOverflow;
+			aPalette[entries++] = pixel;
+			}
+		}
+	return entries;
+	}
+
+/**
+@return The size of a tile palette compressed with aEntries colours.
+*/
+LOCAL_C inline TInt PaletteSize(TInt aEntries, TInt aBytes)
+	{
+	return 1 + aEntries * aBytes + KTilePixels / 2;
+	}
+
+LOCAL_C void EncodePalette(const TUint8* aPixels, TInt aBytes, const TUint32* aPalette, TInt aEntries, TUint8* aDest)
+	{
+	*aDest++ = TUint8(aEntries);
+	for (TInt entry = 0; entry < aEntries; entry++, aDest += aBytes)
+		WriteUnit(aDest, aPalette[entry], aBytes);
+	Mem::FillZ(aDest, KTilePixels / 2);
+	for (TInt index = 0; index < KTilePixels; index++)
+		{
+		const TUint32 pixel = ReadUnit(aPixels + index * aBytes, aBytes);
+		TInt entry = 0;
+		while (aPalette[entry] != pixel)
+			entry++;
+		aDest[index >> 1] |= TUint8(entry << ((index & 1) << 2));
+		}
+	}
+
+/**
+Creates a tiled bitmap device. All pixels are initially 0.
+@param aSize		Size of the device in pixels
+@param aDispMode	Display mode of the device
+@return The new device
+@leave KErrNotSupported aDispMode takes less than 8 bits per pixel
+@leave KErrNoMemory Not enough memory, or any error from CFbsDrawDevice::NewBitmapDeviceL()
+@panic EScreenDriverPanicInvalidSize aSize is empty
+*/
+CTiledBitmapDevice* CTiledBitmapDevice::NewL(const TSize& aSize, TDisplayMode aDispMode)
+	{
+	__ASSERT_ALWAYS(aSize.iWidth > 0 && aSize.iHeight > 0, Panic(EScreenDriverPanicInvalidSize));
+	const TInt bytesPerPixel = TileBytesPerPixel(aDispMode);
+	if (bytesPerPixel == 0)
+		User::Leave(KErrNotSupported);
+	CFbsDrawDevice* tileDevice = CFbsDrawDevice::NewBitmapDeviceL(TSize(KTileSize, KTileSize), aDispMode, KTileSize * bytesPerPixel);
+	CleanupStack::PushL(tileDevice);
+	CTiledBitmapDevice* self = new(ELeave) CTiledBitmapDevice(tileDevice, aSize, bytesPerPixel);
+	CleanupStack::Pop(tileDevice);
+	CleanupStack::PushL(self);
+	self->ConstructL();
+	CleanupStack::Pop(self);
+	return self;
+	}
+
+CTiledBitmapDevice::CTiledBitmapDevice(CFbsDrawDevice* aTileDevice, const TSize& aSize, TInt aBytesPerPixel):
+	CForwardingDrawDevice(aTileDevice),
+	iSize(aSize),
+	iBytesPerPixel(aBytesPerPixel),
+	iTileBytes(KTilePixels * aBytesPerPixel),
+	iTilesAcross((aSize.iWidth + KTileSize - 1) / KTileSize),
+	iTilesDown((aSize.iHeight + KTileSize - 1) / KTileSize),
+	iScanLineBytes(((aSize.iWidth * aBytesPerPixel * 8 + 31) >> 5) << 2),
+	iBoundSlot(-1)
+	{
+	for (TInt slot = 0; slot < KTileWorkingSet; slot++)
+		{
+		iSlots[slot].iBits = NULL;
+		iSlots[slot].iTile = -1;
+		iSlots[slot].iLastUse = 0;
+		}
+	}
+
+void CTiledBitmapDevice::ConstructL()
+	{
+	const TInt tiles = iTilesAcross * iTilesDown;
+	iTiles = new(ELeave) TTile[tiles];
+	for (TInt index = 0; index < tiles; index++)
+		{
+		TTile& tile = iTiles[index];
+		tile.iFormat = ETileUniform;
+		tile.iSlot = -1;
+		tile.iPixel = 0;
+		tile.iData = NULL;
+		tile.iDataSize = 0;
+		}
+	for (TInt slot = 0; slot < KTileWorkingSet; slot++)
+		iSlots[slot].iBits = static_cast<TUint8*>(User::AllocL(iTileBytes));
+	iScratch = static_cast<TUint8*>(User::AllocZL(iTileBytes));
+	iCompressed = static_cast<TUint8*>(User::AllocL(iTileBytes));
+	// Large enough for either width, as SwapWidthAndHeight() keeps it.
+	iScanLine = new(ELeave) TUint32[Max(iSize.iWidth, iSize.iHeight)];
+	iTarget->SetBits(iScratch);
+	}
+
+CTiledBitmapDevice::~CTiledBitmapDevice()
+	{
+	if (iTiles)
+		ResetTiles();
+	delete [] iTiles;
+	for (TInt slot = 0; slot < KTileWorkingSet; slot++)
+		User::Free(iSlots[slot].iBits);
+	User::Free(iScratch);
+	User::Free(iCompressed);
+	delete [] iScanLine;
+	}
+
+/**
+Compresses the tiles of the working set, so that CompressedBytes() accounts for all of them.
+@return KErrNone, or KErrNoMemory if some tiles could not be compressed; they stay uncompressed.
+*/
+TInt CTiledBitmapDevice::Compact()
+	{
+	TInt err = KErrNone;
+	for (TInt slot = 0; slot < KTileWorkingSet; slot++)
+		{
+		if (iSlots[slot].iTile >= 0 && !StoreSlot(slot))
+			err = KErrNoMemory;
+		}
+	return err;
+	}
+
+/**
+@return The number of bytes held by compressed tiles. Uniform tiles and the working set buffers
+are not included.
+*/
+TInt CTiledBitmapDevice::CompressedBytes() const
+	{
+	const TInt tiles = iTilesAcross * iTilesDown;
+	TInt bytes = 0;
+	for (TInt index = 0; index < tiles; index++)
+		bytes += iTiles[index].iDataSize;
+	return bytes;
+	}
+
+/**
+@return ETrue if the rectangle of aWidth x aHeight pixels at [aX,aY] is within the device.
+*/
+TBool CTiledBitmapDevice::IsInside(TInt aX, TInt aY, TInt aWidth, TInt aHeight) const
+	{
+	return aX >= 0 && aY >= 0 && aWidth >= 0 && aHeight >= 0 &&
+		   aX + aWidth <= iSize.iWidth && aY + aHeight <= iSize.iHeight;
+	}
+
+/**
+@return The part of tile (aTileX, aTileY) within the device.
+*/
+TRect CTiledBitmapDevice::TileRect(TInt aTileX, TInt aTileY) const
+	{
+	const TInt left = aTileX * KTileSize;
+	const TInt top = aTileY * KTileSize;
+	return TRect(left, top, Min(left + KTileSize, iSize.iWidth), Min(top + KTileSize, iSize.iHeight));
+	}
+
+/**
+Points the tile device at the pixels of tile aTile, decompressing it into the working set if
+needed. A tile bound for writing loses its compressed copy.
+*/
+void CTiledBitmapDevice::BindTile(TInt aTile, TBool aWrite)
+	{
+	TTile& tile = iTiles[aTile];
+	if (tile.iSlot < 0)
+		{
+		const TInt slot = FreeSlot();
+		Expand(tile, iSlots[slot].iBits);
+		tile.iSlot = TInt8(slot);
+		iSlots[slot].iTile = aTile;
+		}
+	TTileSlot& slot = iSlots[tile.iSlot];
+	slot.iLastUse = ++iUseCount;
+	if (aWrite && tile.iFormat != ETileResident)
+		{
+		User::Free(tile.iData);
+		tile.iData = NULL;
+		tile.iDataSize = 0;
+		tile.iFormat = ETileResident;
+		}
+	if (iBoundSlot != tile.iSlot)
+		{
+		iTarget->SetBits(slot.iBits);
+		iBoundSlot = tile.iSlot;
+		}
+	}
+
+/**
+Points the tile device at the scratch buffer, with the first row set to aPixel, to work out
+what a primitive does to a uniform tile.
+*/
+void CTiledBitmapDevice::BindPixel(TUint32 aPixel)
+	{
+	FillUnits(iScratch, KTileSize, aPixel, iBytesPerPixel);
+	if (iBoundSlot != -1)
+		{
+		iTarget->SetBits(iScratch);
+		iBoundSlot = -1;
+		}
+	}
+
+/**
+@return A working set buffer that holds no tile, after compressing the least recently used tile
+if none is free. If that tile cannot be compressed, the next least recently used one is tried.
+@panic EScreenDriverPanicNoMemory No tile of the working set could be compressed
+*/
+TInt CTiledBitmapDevice::FreeSlot()
+	{
+	for (TInt slot = 0; slot < KTileWorkingSet; slot++)
+		{
+		if (iSlots[slot].iTile < 0)
+			return slot;
+		}
+	TUint32 tried = 0;
+	for (TInt attempt = 0; attempt < KTileWorkingSet; attempt++)
+		{
+		TInt victim = -1;
+		for (TInt slot = 0; slot < KTileWorkingSet; slot++)
+			{
+			if (!(tried & (1 << slot)) && (victim < 0 || iSlots[slot].iLastUse < iSlots[victim].iLastUse))
+				victim = slot;
+			}
+		tried |= 1 << victim;
+		if (StoreSlot(victim))
+			return victim;
+		}
+	Panic(EScreenDriverPanicNoMemory);
+	return KErrNotFound;
+	}
+
+/**
+Removes the tile held by working set buffer aSlot, compressing it if it was written to.
+@return EFalse if there was not enough memory; the tile stays in the buffer then.
+*/
+TBool CTiledBitmapDevice::StoreSlot(TInt aSlot)
+	{
+	TTileSlot& slot = iSlots[aSlot];
+	TTile& tile = iTiles[slot.iTile];
+	if (tile.iFormat == ETileResident &&
+		!Compress(tile, slot.iBits, TileRect(slot.iTile % iTilesAcross, slot.iTile / iTilesAcross).Size()))
+		return EFalse;
+	tile.iSlot = -1;
+	slot.iTile = -1;
+	return ETrue;
+	}
+
+/**
+Stores the pixels of a tile in the smallest format. A tile is uniform if the part of it within
+the device, of size aVisible, is; the other pixels are undefined.
+@return EFalse if the compressed data could not be allocated.
+*/
+TBool CTiledBitmapDevice::Compress(TTile& aTile, const TUint8* aBits, const TSize& aVisible)
+	{
+	const TInt bytes = iBytesPerPixel;
+	const TInt rowBytes = KTileSize * bytes;
+	const TInt visibleBytes = aVisible.iWidth * bytes;
+	const TUint32 first = ReadUnit(aBits, bytes);
+	TBool uniform = ETrue;
+	for (TInt offset = bytes; uniform && offset < visibleBytes; offset += bytes)
+		uniform = ReadUnit(aBits + offset, bytes) == first;
+	for (TInt row = 1; uniform && row < aVisible.iHeight; row++)
+		uniform = Mem::Compare(aBits + row * rowBytes, visibleBytes, aBits, visibleBytes) == 0;
+	if (uniform)
+		{
+		aTile.iFormat = ETileUniform;
+		aTile.iPixel = first;
+		return ETrue;
+		}
+
+	TUint32 palette[KMaxTilePaletteEntries];
+	const TInt entries = CollectPalette(aBits, bytes, palette);
+	const TInt paletteSize = entries > 0 ? PaletteSize(entries, bytes) : iTileBytes;
+	TTileFormat format = ETileRaw;
+	TInt size = EncodeRunLength(aBits, bytes, iCompressed, Min(paletteSize, iTileBytes));
+	if (size > 0)
+		format = ETileRunLength;
+	else if (paletteSize < iTileBytes)
+		{
+		EncodePalette(aBits, bytes, palette, entries, iCompressed);
+		format = ETilePalette;
+		size = paletteSize;
+		}
+	else
+		size = iTileBytes;
+	TUint8* data = static_cast<TUint8*>(User::Alloc(size));
+	if (!data)
+		return EFalse;
+	Mem::Copy(data, format == ETileRaw ? aBits : iCompressed, size);
+	aTile.iFormat = TUint8(format);
+	aTile.iData = data;
+	aTile.iDataSize = size;
+	return ETrue;
+	}
+
+/**
+Decompresses a stored tile into aBits.
+*/
+void CTiledBitmapDevice::Expand(const TTile& aTile, TUint8* aBits) const
+	{
+	const TInt bytes = iBytesPerPixel;
+	switch (aTile.iFormat)
+		{
+	case ETileUniform:
+		FillUnits(aBits, KTilePixels, aTile.iPixel, bytes);
+		break;
+	case ETileRunLength:
+		{
+		const TUint8* src = aTile.iData;
+		const TUint8* const end = src + aTile.iDataSize;
+		for (; src < end; src += 1 + bytes)
+			{
+			const TInt run = src[0] + 1;
+			FillUnits(aBits, run, ReadUnit(src + 1, bytes), bytes);
+			aBits += run * bytes;
+			}
+		break;
+		}
+	case ETilePalette:
+		{
+		const TInt entries = aTile.iData[0];
+		TUint32 palette[KMaxTilePaletteEntries];
+		for (TInt entry = 0; entry < entries; entry++)
+			palette[entry] = ReadUnit(aTile.iData + 1 + entry * bytes, bytes);
+		const TUint8* indices = aTile.iData + 1 + entries * bytes;
+		for (TInt index = 0; index < KTilePixels; index++, aBits += bytes)
+			WriteUnit(aBits, palette[(indices[index >> 1] >> ((index & 1) << 2)) & 0xf], bytes);
+		break;
+		}
+	default:
+		Mem::Copy(aBits, aTile.iData, iTileBytes);
+		break;
+		}
+	}
+
+/**
+Makes tile aTile uniform, dropping its pixels.
+*/
+void CTiledBitmapDevice::SetUniform(TInt aTile, TUint32 aPixel)
+	{
+	TTile& tile = iTiles[aTile];
+	if (tile.iSlot >= 0)
+		{
+		iSlots[tile.iSlot].iTile = -1;
+		tile.iSlot = -1;
+		}
+	User::Free(tile.iData);
+	tile.iData = NULL;
+	tile.iDataSize = 0;
+	tile.iFormat = ETileUniform;
+	tile.iPixel = aPixel;
+	}
+
+void CTiledBitmapDevice::ResetTiles()
+	{
+	const TInt tiles = iTilesAcross * iTilesDown;
+	for (TInt index = 0; index < tiles; index++)
+		SetUniform(index, 0);
+	}
+
+TInt CTiledBitmapDevice::LongWidth() const
+	{
+	return iScanLineBytes / iBytesPerPixel;
+	}
+
+void CTiledBitmapDevice::MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards)
+	{
+	if (aRect.IsEmpty())
+		return;
+	__ASSERT_DEBUG(IsInside(aRect.iTl.iX, aRect.iTl.iY, aRect.Width(), aRect.Height()), Panic(EScreenDriverPanicOutOfBounds));
+	for (TInt tileY = aRect.iTl.iY / KTileSize; tileY * KTileSize < aRect.iBr.iY; tileY++)
+		for (TInt tileX = aRect.iTl.iX / KTileSize; tileX * KTileSize < aRect.iBr.iX; tileX++)
+			{
+			const TInt index = tileY * iTilesAcross + tileX;
+			const TRect visible(TileRect(tileX, tileY));
+			TRect piece(visible);
+			piece.Intersection(aRect);
+			if (iTiles[index].iFormat == ETileUniform)
+				{
+				BindPixel(iTiles[index].iPixel);
+				iTarget->MapColors(TRect(0, 0, 1, 1), aColors, aNumPairs, aMapForwards);
+				const TUint32 pixel = ReadUnit(iScratch, iBytesPerPixel);
+				if (pixel == iTiles[index].iPixel)
+					continue;
+				if (piece == visible)
+					{
+					SetUniform(index, pixel);
+					continue;
+					}
+				}
+			BindTile(index, ETrue);
+			piece.Move(-tileX * KTileSize, -tileY * KTileSize);
+			iTarget->MapColors(piece, aColors, aNumPairs, aMapForwards);
+			}
+	}
+
+/**
+Reads uniform tiles without decompressing them.
+*/
+void CTiledBitmapDevice::ReadLine(TInt aX,TInt aY,TInt aLength,TAny* aBuffer,TDisplayMode aDispMode) const
+	{
+	__ASSERT_DEBUG(IsInside(aX, aY, aLength, 1), Panic(EScreenDriverPanicOutOfBounds));
+	CTiledBitmapDevice& self = *const_cast<CTiledBitmapDevice*>(this);
+	const TInt bits = BitsInMemory(aDispMode);
+	const TInt tileY = aY / KTileSize;
+	for (TInt offset = 0; offset < aLength; )
+		{
+		const TInt tileX = (aX + offset) / KTileSize;
+		const TInt index = tileY * iTilesAcross + tileX;
+		TInt x = aX + offset - tileX * KTileSize;
+		TInt y = aY - tileY * KTileSize;
+		const TInt length = Min(aLength - offset, KTileSize - x);
+		if (iTiles[index].iFormat == ETileUniform)
+			{
+			self.BindPixel(iTiles[index].iPixel);
+			x = 0;
+			y = 0;
+			}
+		else
+			self.BindTile(index, EFalse);
+		if (bits >= 8)
+			iTarget->ReadLine(x, y, length, static_cast<TUint8*>(aBuffer) + offset * (bits >> 3), aDispMode);
+		else
+			{
+			TUint32 line[KTileSize];
+			iTarget->ReadLine(x, y, length, line, aDispMode);
+			TScanLineConverter::Convert(aDispMode, line, 0, aDispMode, aBuffer, offset, length);
+			}
+		offset += length;
+		}
+	}
+
+TRgb CTiledBitmapDevice::ReadPixel(TInt aX,TInt aY) const
+	{
+	__ASSERT_DEBUG(IsInside(aX, aY, 1, 1), Panic(EScreenDriverPanicOutOfBounds));
+	CTiledBitmapDevice& self = *const_cast<CTiledBitmapDevice*>(this);
+	const TInt tileX = aX / KTileSize;
+	const TInt tileY = aY / KTileSize;
+	const TInt index = tileY * iTilesAcross + tileX;
+	if (iTiles[index].iFormat == ETileUniform)
+		{
+		self.BindPixel(iTiles[index].iPixel);
+		return iTarget->ReadPixel(0, 0);
+		}
+	self.BindTile(index, EFalse);
+	return iTarget->ReadPixel(aX - tileX * KTileSize, aY - tileY * KTileSize);
+	}
+
+TUint32* CTiledBitmapDevice::ScanLineBuffer() const
+	{
+	return iScanLine;
+	}
+
+TInt CTiledBitmapDevice::ScanLineBytes() const
+	{
+	return iScanLineBytes;
+	}
+
+TSize CTiledBitmapDevice::SizeInPixels() const
+	{
+	return iSize;
+	}
+
+void CTiledBitmapDevice::OrientationsAvailable(TBool aOrientation[4])
+	{
+	aOrientation[EOrientationNormal] = ETrue;
+	aOrientation[EOrientationRotated90] = EFalse;
+	aOrientation[EOrientationRotated180] = EFalse;
+	aOrientation[EOrientationRotated270] = EFalse;
+	}
+
+TBool CTiledBitmapDevice::SetOrientation(TOrientation aOrientation)
+	{
+	return aOrientation == EOrientationNormal;
+	}
+
+/**
+Rows of aBuffer are shifted to the origin of each tile; tiles with no bit set are not touched.
+*/
+void CTiledBitmapDevice::WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	const TRect rect(TPoint(aX, aY), TSize(aLength, aHeight));
+	if (rect.IsEmpty())
+		return;
+	__ASSERT_DEBUG(IsInside(aX, aY, aLength, aHeight), Panic(EScreenDriverPanicOutOfBounds));
+	TUint32 rows[KTileSize];
+	for (TInt tileY = aY / KTileSize; tileY * KTileSize < rect.iBr.iY; tileY++)
+		for (TInt tileX = aX / KTileSize; tileX * KTileSize < rect.iBr.iX; tileX++)
+			{
+			TRect piece(TileRect(tileX, tileY));
+			piece.Intersection(rect);
+			const TInt shift = piece.iTl.iX - aX;
+			const TInt width = piece.Width();
+			const TInt height = piece.Height();
+			const TUint32 mask = width < 32 ? (1u << width) - 1 : 0xffffffff;
+			TUint32 any = 0;
+			for (TInt row = 0; row < height; row++)
+				{
+				rows[row] = (aBuffer[piece.iTl.iY - aY + row] >> shift) & mask;
+				any |= rows[row];
+				}
+			if (!any)
+				continue;
+			BindTile(tileY * iTilesAcross + tileX, ETrue);
+			iTarget->WriteBinary(piece.iTl.iX - tileX * KTileSize, piece.iTl.iY - tileY * KTileSize,
+								 rows, width, height, aColor, aDrawMode);
+			}
+	}
+
+void CTiledBitmapDevice::WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	__ASSERT_DEBUG(IsInside(aX, aY, aLength, 1), Panic(EScreenDriverPanicOutOfBounds));
+	const TInt tileY = aY / KTileSize;
+	for (TInt offset = 0; offset < aLength; )
+		{
+		const TInt tileX = (aX + offset) / KTileSize;
+		const TInt x = aX + offset - tileX * KTileSize;
+		const TInt length = Min(aLength - offset, KTileSize - x);
+		TUint32 bits = ExtractBits(aBuffer, offset, length);
+		if (bits)
+			{
+			BindTile(tileY * iTilesAcross + tileX, ETrue);
+			iTarget->WriteBinaryLine(x, aY - tileY * KTileSize, &bits, length, aColor, aDrawMode);
+			}
+		offset += length;
+		}
+	}
+
+void CTiledBitmapDevice::WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp)
+	{
+	__ASSERT_DEBUG(IsInside(aX, aUp ? aY - aHeight + 1 : aY, 1, aHeight), Panic(EScreenDriverPanicOutOfBounds));
+	const TInt tileX = aX / KTileSize;
+	for (TInt offset = 0; offset < aHeight; )
+		{
+		const TInt tileY = (aUp ? aY - offset : aY + offset) / KTileSize;
+		const TInt y = (aUp ? aY - offset : aY + offset) - tileY * KTileSize;
+		const TInt length = Min(aHeight - offset, aUp ? y + 1 : KTileSize - y);
+		TUint32 bits = ExtractBits(aBuffer, offset, length);
+		if (bits)
+			{
+			BindTile(tileY * iTilesAcross + tileX, ETrue);
+			iTarget->WriteBinaryLineVertical(aX - tileX * KTileSize, y, &bits, length, aColor, aDrawMode, aUp);
+			}
+		offset += length;
+		}
+	}
+
+/**
+Writing to a uniform tile decompresses it only if the pixel changes.
+*/
+void CTiledBitmapDevice::WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	__ASSERT_DEBUG(IsInside(aX, aY, 1, 1), Panic(EScreenDriverPanicOutOfBounds));
+	const TInt tileX = aX / KTileSize;
+	const TInt tileY = aY / KTileSize;
+	const TInt index = tileY * iTilesAcross + tileX;
+	if (iTiles[index].iFormat == ETileUniform)
+		{
+		BindPixel(iTiles[index].iPixel);
+		iTarget->WriteRgb(0, 0, aColor, aDrawMode);
+		if (ReadUnit(iScratch, iBytesPerPixel) == iTiles[index].iPixel)
+			return;
+		}
+	BindTile(index, ETrue);
+	iTarget->WriteRgb(aX - tileX * KTileSize, aY - tileY * KTileSize, aColor, aDrawMode);
+	}
+
+/**
+Tiles covered entirely by an opaque fill, or uniform before any fill, are uniform afterwards, so
+only their value changes.
+*/
+void CTiledBitmapDevice::WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	const TRect rect(TPoint(aX, aY), TSize(aLength, aHeight));
+	if (rect.IsEmpty())
+		return;
+	__ASSERT_DEBUG(IsInside(aX, aY, aLength, aHeight), Panic(EScreenDriverPanicOutOfBounds));
+	const TBool opaque = aDrawMode == CGraphicsContext::EDrawModeWriteAlpha ||
+						 (aDrawMode == CGraphicsContext::EDrawModePEN && aColor.Alpha() == 0xff);
+	for (TInt tileY = aY / KTileSize; tileY * KTileSize < rect.iBr.iY; tileY++)
+		for (TInt tileX = aX / KTileSize; tileX * KTileSize < rect.iBr.iX; tileX++)
+			{
+			const TInt index = tileY * iTilesAcross + tileX;
+			const TRect visible(TileRect(tileX, tileY));
+			TRect piece(visible);
+			piece.Intersection(rect);
+			const TBool uniform = iTiles[index].iFormat == ETileUniform;
+			if (uniform || (opaque && piece == visible))
+				{
+				const TUint32 previous = uniform ? iTiles[index].iPixel : 0;
+				BindPixel(previous);
+				iTarget->WriteRgbMulti(0, 0, 1, 1, aColor, aDrawMode);
+				const TUint32 pixel = ReadUnit(iScratch, iBytesPerPixel);
+				if (uniform && pixel == previous)
+					continue;
+				if (piece == visible)
+					{
+					SetUniform(index, pixel);
+					continue;
+					}
+				}
+			BindTile(index, ETrue);
+			iTarget->WriteRgbMulti(piece.iTl.iX - tileX * KTileSize, piece.iTl.iY - tileY * KTileSize,
+								   piece.Width(), piece.Height(), aColor, aDrawMode);
+			}
+	}
+
+void CTiledBitmapDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	__ASSERT_DEBUG(IsInside(aX, aY, aLength, 1), Panic(EScreenDriverPanicOutOfBounds));
+	const TInt tileY = aY / KTileSize;
+	for (TInt offset = 0; offset < aLength; )
+		{
+		const TInt tileX = (aX + offset) / KTileSize;
+		const TInt x = aX + offset - tileX * KTileSize;
+		const TInt length = Min(aLength - offset, KTileSize - x);
+		BindTile(tileY * iTilesAcross + tileX, ETrue);
+		iTarget->WriteRgbAlphaLine(x, aY - tileY * KTileSize, length, aRgbBuffer + offset * 4, aMaskBuffer + offset, aDrawMode);
+		offset += length;
+		}
+	}
+
+void CTiledBitmapDevice::WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode)
+	{
+	__ASSERT_DEBUG(IsInside(aX, aY, aLength, 1), Panic(EScreenDriverPanicOutOfBounds));
+	const TInt bytes = BitsInMemory(iTarget->ScanLineDisplayMode()) >> 3;
+	const TInt tileY = aY / KTileSize;
+	for (TInt offset = 0; offset < aLength; )
+		{
+		const TInt tileX = (aX + offset) / KTileSize;
+		const TInt x = aX + offset - tileX * KTileSize;
+		const TInt length = Min(aLength - offset, KTileSize - x);
+		BindTile(tileY * iTilesAcross + tileX, ETrue);
+		iTarget->WriteLine(x, aY - tileY * KTileSize, length,
+						   reinterpret_cast<TUint32*>(reinterpret_cast<TUint8*>(aBuffer) + offset * bytes), aDrawMode);
+		offset += length;
+		}
+	}
+
+/**
+The memory of the device is owned by the device, so this does nothing.
+*/
+void CTiledBitmapDevice::SetBits(TAny* /*aBits*/)
+	{
+	}
+
+/**
+The tile device takes the settings of aDrawDevice, and is then put back to EOrientationNormal with
+no scaling, as the tiles are laid out for that alone.
+*/
+void CTiledBitmapDevice::SetDisplayMode(CFbsDrawDevice* aDrawDevice)
+	{
+	iTarget->SetDisplayMode(aDrawDevice);
+	iTarget->SetOrientation(EOrientationNormal);
+	TAny* interface = NULL;
+	if (iTarget->GetInterface(KScalingSettingsInterfaceID, interface) == KErrNone)
+		static_cast<MScalingSettings*>(interface)->Set(1, 1, 1, 1);
+	interface = NULL;
+	if (iTarget->GetInterface(KDrawDeviceOriginInterfaceID, interface) == KErrNone)
+		static_cast<MDrawDeviceOrigin*>(interface)->Set(TPoint(0, 0));
+	}
+
+void CTiledBitmapDevice::ShadowArea(const TRect& aRect)
+	{
+	if (aRect.IsEmpty())
+		return;
+	__ASSERT_DEBUG(IsInside(aRect.iTl.iX, aRect.iTl.iY, aRect.Width(), aRect.Height()), Panic(EScreenDriverPanicOutOfBounds));
+	for (TInt tileY = aRect.iTl.iY / KTileSize; tileY * KTileSize < aRect.iBr.iY; tileY++)
+		for (TInt tileX = aRect.iTl.iX / KTileSize; tileX * KTileSize < aRect.iBr.iX; tileX++)
+			{
+			const TInt index = tileY * iTilesAcross + tileX;
+			const TRect visible(TileRect(tileX, tileY));
+			TRect piece(visible);
+			piece.Intersection(aRect);
+			if (iTiles[index].iFormat == ETileUniform)
+				{
+				BindPixel(iTiles[index].iPixel);
+				iTarget->ShadowArea(TRect(0, 0, 1, 1));
+				const TUint32 pixel = ReadUnit(iScratch, iBytesPerPixel);
+				if (pixel == iTiles[index].iPixel)
+					continue;
+				if (piece == visible)
+					{
+					SetUniform(index, pixel);
+					continue;
+					}
+				}
+			BindTile(index, ETrue);
+			piece.Move(-tileX * KTileSize, -tileY * KTileSize);
+			iTarget->ShadowArea(piece);
+			}
+	}
+
+void CTiledBitmapDevice::WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer)
+	{
+	__ASSERT_DEBUG(IsInside(aX, aY, aLength, 1), Panic(EScreenDriverPanicOutOfBounds));
+	const TInt tileY = aY / KTileSize;
+	for (TInt offset = 0; offset < aLength; )
+		{
+		const TInt tileX = (aX + offset) / KTileSize;
+		const TInt x = aX + offset - tileX * KTileSize;
+		const TInt length = Min(aLength - offset, KTileSize - x);
+		BindTile(tileY * iTilesAcross + tileX, ETrue);
+		iTarget->WriteRgbAlphaMulti(x, aY - tileY * KTileSize, length, aColor, aMaskBuffer + offset);
+		offset += length;
+		}
+	}
+
+void CTiledBitmapDevice::WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+										   const TUint8* aRgbBuffer1,
+										   const TUint8* aBuffer2,
+										   const TUint8* aMaskBuffer,
+										   CGraphicsContext::TDrawMode aDrawMode)
+	{
+	__ASSERT_DEBUG(IsInside(aX, aY, aLength, 1), Panic(EScreenDriverPanicOutOfBounds));
+	const TInt bytes = BitsInMemory(iTarget->ScanLineDisplayMode()) >> 3;
+	const TInt tileY = aY / KTileSize;
+	for (TInt offset = 0; offset < aLength; )
+		{
+		const TInt tileX = (aX + offset) / KTileSize;
+		const TInt x = aX + offset - tileX * KTileSize;
+		const TInt length = Min(aLength - offset, KTileSize - x);
+		BindTile(tileY * iTilesAcross + tileX, ETrue);
+		iTarget->WriteRgbAlphaLine(x, aY - tileY * KTileSize, length, aRgbBuffer1 + offset * 4,
+								   aBuffer2 + offset * bytes, aMaskBuffer + offset, aDrawMode);
+		offset += length;
+		}
+	}
+
+/**
+The pixels are not addressable, so no interface is supported.
+*/
+TInt CTiledBitmapDevice::GetInterface(TInt /*aInterfaceId*/, TAny*& aInterface)
+	{
+	aInterface = NULL;
+	return KErrNotSupported;
+	}
+
+void CTiledBitmapDevice::GetDrawRect(TRect& aDrawRect) const
+	{
+	aDrawRect = TRect(iSize);
+	}
+
+/**
+Swaps the width and the height of the device. The pixels are lost, as the tiles are laid out
+again; all pixels are 0 afterwards.
+*/
+void CTiledBitmapDevice::SwapWidthAndHeight()
+	{
+	ResetTiles();
+	iSize = TSize(iSize.iHeight, iSize.iWidth);
+	iTilesAcross = (iSize.iWidth + KTileSize - 1) / KTileSize;
+	iTilesDown = (iSize.iHeight + KTileSize - 1) / KTileSize;
+	iScanLineBytes = ((iSize.iWidth * iBytesPerPixel * 8 + 31) >> 5) << 2;
+	}
@@ -0,0 +1,155 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+//
+
+#ifndef __BITDRAWTILED_H__
+#define __BITDRAWTILED_H__
+
+#include "BitDrawForwarding.h"
+
+/**
+Width and height of a tile of a CTiledBitmapDevice, in pixels. A row of a tile fits in the
+32 bit word of WriteBinaryLine().
+@internalComponent
+*/
+const TInt KTileSize = 32;
+
+/**
+Number of tiles a CTiledBitmapDevice holds uncompressed at once.
+@internalComponent
+*/
+const TInt KTileWorkingSet = 8;
+
+/**
+Most colours a tile may have to be stored palette compressed.
+@internalComponent
+*/
+const TInt KMaxTilePaletteEntries = 16;
+
+/**
+Bitmap device that stores its pixels as compressed tiles of KTileSize x KTileSize pixels, for
+off-screen surfaces that are mostly plain.
+
+A tile whose pixels all have the same value is held as that value alone. Any other tile is
+stored run-length encoded, as 4 bit indices into a palette of up to KMaxTilePaletteEntries
+colours, or uncompressed, whichever is smallest. A primitive decompresses the tiles it touches
+into a working set of KTileWorkingSet buffers, and the least recently used tile is compressed
+again when a buffer is needed for another one. A tile that was only read keeps its compressed
+copy while it is in the working set, so evicting it costs nothing.
+
+WriteRgbMulti() with EDrawModeWriteAlpha, or with EDrawModePEN and an opaque colour, only
+changes the value of the tiles it covers entirely, and leaves uniform tiles of the same colour
+alone. Reading, shadowing and mapping the colours of uniform tiles does not decompress them.
+
+The primitives are drawn, clipped to each tile, by a bitmap device of the size of a tile pointed
+at the working set buffers, so the pixels are the same as on a device from
+CFbsDrawDevice::NewBitmapDeviceL(). The display mode must be stored in 8 bits per pixel or more,
+and only EOrientationNormal is available. The pixels are not accessible: SetBits() is ignored
+and GetInterface() supports no interface. SetDisplayMode() takes the shadow mode, fading
+parameters, dither origin and user display mode of the other device, but not its orientation or
+scaling. Primitives panic with EScreenDriverPanicOutOfBounds in debug builds if any part of them
+is outside the device.
+If the working set cannot be compressed for lack of memory, the device panics with
+EScreenDriverPanicNoMemory.
+@internalComponent
+*/
+class CTiledBitmapDevice : public CForwardingDrawDevice
+	{
+public:
+	static CTiledBitmapDevice* NewL(const TSize& aSize, TDisplayMode aDispMode);
+	~CTiledBitmapDevice();
+	TInt Compact();
+	TInt CompressedBytes() const;
+public: // From CFbsDrawDevice
+	TInt LongWidth() const;
+	void MapColors(const TRect& aRect,const TRgb* aColors,TInt aNumPairs,TBool aMapForwards);
+	void ReadLine(TInt aX,TInt aY,TInt aLength,TAny* aBuffer,TDisplayMode aDispMode) const;
+	TRgb ReadPixel(TInt aX,TInt aY) const;
+	TUint32* ScanLineBuffer() const;
+	TInt ScanLineBytes() const;
+	TSize SizeInPixels() const;
+	void OrientationsAvailable(TBool aOrientation[4]);
+	TBool SetOrientation(TOrientation aOrientation);
+	void WriteBinary(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLine(TInt aX,TInt aY,TUint32* aBuffer,TInt aLength,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteBinaryLineVertical(TInt aX,TInt aY,TUint32* aBuffer,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode,TBool aUp);
+	void WriteRgb(TInt aX,TInt aY,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbMulti(TInt aX,TInt aY,TInt aLength,TInt aHeight,TRgb aColor,CGraphicsContext::TDrawMode aDrawMode);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,TUint8* aRgbBuffer,TUint8* aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode);
+	void WriteLine(TInt aX,TInt aY,TInt aLength,TUint32* aBuffer,CGraphicsContext::TDrawMode aDrawMode);
+	void SetBits(TAny* aBits);
+	void SetDisplayMode(CFbsDrawDevice* aDrawDevice);
+	void ShadowArea(const TRect& aRect);
+	void WriteRgbAlphaMulti(TInt aX,TInt aY,TInt aLength,TRgb aColor,const TUint8* aMaskBuffer);
+	void WriteRgbAlphaLine(TInt aX,TInt aY,TInt aLength,
+						   const TUint8* aRgbBuffer1,
+						   const TUint8* aBuffer2,
+						   const TUint8* aMaskBuffer,
+						   CGraphicsContext::TDrawMode aDrawMode);
+	TInt GetInterface(TInt aInterfaceId, TAny*& aInterface);
+	void GetDrawRect(TRect& aDrawRect) const;
+	void SwapWidthAndHeight();
+private:
+	enum TTileFormat
+		{
+		ETileUniform,		///< All pixels are iPixel
+		ETileRunLength,		///< iData holds runs of up to 256 pixels: the length minus one, then the pixel
+		ETilePalette,		///< iData holds the number of colours, the colours and two indices per byte
+		ETileRaw,			///< iData holds the pixels
+		ETileResident		///< Only the working set buffer holds the pixels
+		};
+	struct TTile
+		{
+		TUint8 iFormat;
+		TInt8 iSlot;		///< Working set buffer holding the tile, or -1
+		TUint32 iPixel;
+		TUint8* iData;
+		TInt iDataSize;
+		};
+	struct TTileSlot
+		{
+		TUint8* iBits;
+		TInt iTile;			///< Tile held, or -1
+		TUint32 iLastUse;
+		};
+private:
+	CTiledBitmapDevice(CFbsDrawDevice* aTileDevice, const TSize& aSize, TInt aBytesPerPixel);
+	void ConstructL();
+	TBool IsInside(TInt aX, TInt aY, TInt aWidth, TInt aHeight) const;
+	TRect TileRect(TInt aTileX, TInt aTileY) const;
+	void BindTile(TInt aTile, TBool aWrite);
+	void BindPixel(TUint32 aPixel);
+	TInt FreeSlot();
+	TBool StoreSlot(TInt aSlot);
+	TBool Compress(TTile& aTile, const TUint8* aBits, const TSize& aVisible);
+	void Expand(const TTile& aTile, TUint8* aBits) const;
+	void SetUniform(TInt aTile, TUint32 aPixel);
+	void ResetTiles();
+private:
+	TSize iSize;
+	TInt iBytesPerPixel;
+	TInt iTileBytes;
+	TInt iTilesAcross;
+	TInt iTilesDown;
+	TInt iScanLineBytes;
+	TTile* iTiles;
+	TTileSlot iSlots[KTileWorkingSet];
+	TInt iBoundSlot;			///< Slot whose buffer the tile device draws to, or -1 for iScratch
+	TUint32 iUseCount;
+	TUint8* iScratch;
+	TUint8* iCompressed;
+	TUint32* iScanLine;
+	};
+
+#endif
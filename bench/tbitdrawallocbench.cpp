@@ -0,0 +1,340 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Create/destroy benchmark of short-lived off-screen bitmap devices. Each round creates a batch of
+// devices of mixed sizes, as a layout pass does, draws a pixel to each and destroys them all; the
+// devices come either from CFbsDrawDevice::NewBitmapDeviceL() with pixel memory from the heap, or
+// from a CDrawDeviceArena. Taking and returning scan line buffers is timed the same way, from the
+// heap and from a RScanLineBufferPool.
+//
+// Usage: tbitdrawallocbench [-o <results file>]
+//	-o	File the results are written to, default KDefaultResultsFile
+//
+// Results are written as comma separated values, one line per measurement:
+//	operation,display_mode,allocator,kops_per_s
+// where an op is the creation and destruction of one device, or the allocation and freeing of one
+// buffer.
+//
+
+#include <e32base.h>
+#include <e32debug.h>
+#include <f32file.h>
+#include <bacline.h>
+#include <hal.h>
+#include "bitdraw.h"
+#include "BitDrawAllocator.h"
+#include "BitDrawPixelFormat.h"
+
+_LIT(KDefaultResultsFile, "c:\\data\\tbitdrawallocbench.csv");
+_LIT8(KResultsHeader, "operation,display_mode,allocator,kops_per_s\n");
+
+/** Devices or buffers created by one round. */
+const TInt KBatchSize = 64;
+/** Minimum duration of one measurement, in microseconds. */
+const TInt KMinSampleTime = 20000;
+
+/** Sizes of the devices of a round, taken in turn. */
+LOCAL_D const TInt KDeviceWidths[] = {16, 96, 48, 200, 320};
+LOCAL_D const TInt KDeviceHeights[] = {16, 24, 48, 32, 64};
+const TInt KDeviceSizeCount = sizeof(KDeviceWidths) / sizeof(KDeviceWidths[0]);
+
+/**
+Operations benchmarked.
+*/
+enum TBenchOperation
+	{
+	EBenchCreateDestroy,
+	EBenchScanLineBuffer,
+	EBenchOperationCount
+	};
+
+LOCAL_D const TText8* const KOperationNames[EBenchOperationCount] =
+	{
+	_S8("CreateDestroy"),
+	_S8("ScanLineBuffer")
+	};
+
+/**
+Where devices and buffers come from.
+*/
+enum TBenchAllocator
+	{
+	EBenchHeap,
+	EBenchPooled,
+	EBenchAllocatorCount
+	};
+
+LOCAL_D const TText8* const KAllocatorNames[EBenchOperationCount][EBenchAllocatorCount] =
+	{
+	{_S8("Heap"), _S8("Arena")},
+	{_S8("Heap"), _S8("Pool")}
+	};
+
+/** Display modes benchmarked. */
+LOCAL_D const TDisplayMode KDisplayModes[] =
+	{
+	EGray2, EColor256, EColor64K, EColor16MU
+	};
+
+LOCAL_D const TText8* const KDisplayModeNames[EColorLast] =
+	{
+	_S8("ENone"), _S8("EGray2"), _S8("EGray4"), _S8("EGray16"), _S8("EGray256"), _S8("EColor16"),
+	_S8("EColor256"), _S8("EColor64K"), _S8("EColor16M"), _S8("ERgb"), _S8("EColor4K"),
+	_S8("EColor16MU"), _S8("EColor16MA"), _S8("EColor16MAP")
+	};
+
+/**
+One measurement.
+*/
+class TAllocResult
+	{
+public:
+	TBenchOperation iOperation;
+	TDisplayMode iDisplayMode;
+	TBenchAllocator iAllocator;
+	TInt64 iKOpsPerSecond;
+	};
+
+/**
+Runs the benchmark and writes its results.
+*/
+class CAllocBench : public CBase
+	{
+public:
+	static CAllocBench* NewLC();
+	~CAllocBench();
+	void RunL();
+	void WriteResultsL(RFs& aFs, const TDesC& aFileName) const;
+private:
+	CAllocBench();
+	void ConstructL();
+	void MeasureL(TBenchOperation aOperation, TDisplayMode aDispMode, TBenchAllocator aAllocator);
+	TInt RoundL(TBenchOperation aOperation, TDisplayMode aDispMode, TBenchAllocator aAllocator);
+	void DestroyBatch();
+	static TSize DeviceSize(TInt aIndex);
+private:
+	TInt iFrequency;
+	TBool iCountsUp;
+	RArray<TAllocResult> iResults;
+	CDrawDeviceArena* iArena;
+	RScanLineBufferPool iPool;
+	CFbsDrawDevice* iDevices[KBatchSize];
+	TAny* iBuffers[KBatchSize];
+	TBenchAllocator iBatchAllocator;
+	};
+
+CAllocBench* CAllocBench::NewLC()
+	{
+	CAllocBench* self = new(ELeave) CAllocBench;
+	CleanupStack::PushL(self);
+	self->ConstructL();
+	return self;
+	}
+
+CAllocBench::CAllocBench():
+	iCountsUp(ETrue)
+	{
+	}
+
+void CAllocBench::ConstructL()
+	{
+	User::LeaveIfError(HAL::Get(HALData::EFastCounterFrequency, iFrequency));
+	TInt countsUp;
+	if (HAL::Get(HALData::EFastCounterCountsUp, countsUp) == KErrNone)
+		iCountsUp = countsUp;
+	// Keep every device and buffer of a round, as the round is repeated.
+	iArena = CDrawDeviceArena::NewL(KBatchSize);
+	User::LeaveIfError(iPool.Create(KBatchSize));
+	}
+
+CAllocBench::~CAllocBench()
+	{
+	DestroyBatch();
+	delete iArena;
+	iPool.Close();
+	iResults.Close();
+	}
+
+/**
+Measures every operation in every display mode, from the heap and then pooled.
+*/
+void CAllocBench::RunL()
+	{
+	const TInt numModes = sizeof(KDisplayModes) / sizeof(KDisplayModes[0]);
+	for (TInt index = 0; index < numModes; index++)
+		{
+		for (TInt allocator = 0; allocator < EBenchAllocatorCount; allocator++)
+			MeasureL(EBenchCreateDestroy, KDisplayModes[index], TBenchAllocator(allocator));
+		}
+	// Scan line buffers do not depend on the display mode; 32 bits per pixel covers them all.
+	for (TInt allocator = 0; allocator < EBenchAllocatorCount; allocator++)
+		MeasureL(EBenchScanLineBuffer, EColor16MU, TBenchAllocator(allocator));
+	}
+
+/**
+Repeats a round until at least KMinSampleTime has elapsed, doubling the number of rounds between
+timings, and records the throughput. The first round is not timed, so that the arena and the pool
+start warm, as they are from the second frame of a layout pass on.
+*/
+void CAllocBench::MeasureL(TBenchOperation aOperation, TDisplayMode aDispMode, TBenchAllocator aAllocator)
+	{
+	RoundL(aOperation, aDispMode, aAllocator);
+	const TInt64 minTicks = TInt64(iFrequency) * KMinSampleTime / 1000000;
+	TInt rounds = 1;
+	TInt64 ops = 0;
+	TInt64 ticks = 0;
+	FOREVER
+		{
+		ops = 0;
+		const TUint32 start = User::FastCounter();
+		for (TInt round = 0; round < rounds; round++)
+			ops += RoundL(aOperation, aDispMode, aAllocator);
+		const TUint32 end = User::FastCounter();
+		ticks = iCountsUp ? end - start : start - end;
+		if (ticks >= minTicks || rounds >= KMaxTInt / 2)
+			break;
+		rounds *= 2;
+		}
+	TAllocResult result;
+	result.iOperation = aOperation;
+	result.iDisplayMode = aDispMode;
+	result.iAllocator = aAllocator;
+	result.iKOpsPerSecond = ticks > 0 ? ops * iFrequency / ticks / 1000 : 0;
+	// A failed append loses one measurement; the run carries on.
+	iResults.Append(result);
+	iArena->Trim();
+	iPool.Trim();
+	}
+
+/**
+Creates a batch of devices and draws a pixel to each, or allocates a batch of scan line buffers,
+then destroys or frees them all.
+@return The number of devices or buffers.
+*/
+TInt CAllocBench::RoundL(TBenchOperation aOperation, TDisplayMode aDispMode, TBenchAllocator aAllocator)
+	{
+	iBatchAllocator = aAllocator;
+	const TInt bpp = BitsInMemory(aDispMode);
+	for (TInt index = 0; index < KBatchSize; index++)
+		{
+		const TSize size = DeviceSize(index);
+		const TInt stride = ((size.iWidth * bpp + 31) >> 5) << 2;
+		if (aOperation == EBenchScanLineBuffer)
+			{
+			if (aAllocator == EBenchPooled)
+				iBuffers[index] = iPool.AllocL(stride);
+			else
+				iBuffers[index] = User::AllocL(stride);
+			continue;
+			}
+		if (aAllocator == EBenchPooled)
+			iDevices[index] = iArena->NewBitmapDeviceL(size, aDispMode);
+		else
+			{
+			iBuffers[index] = User::AllocL(stride * size.iHeight);
+			iDevices[index] = CFbsDrawDevice::NewBitmapDeviceL(size, aDispMode, stride);
+			iDevices[index]->SetBits(iBuffers[index]);
+			}
+		iDevices[index]->WriteRgb(0, 0, KRgbBlack, CGraphicsContext::EDrawModePEN);
+		}
+	DestroyBatch();
+	return KBatchSize;
+	}
+
+/**
+Destroys the devices and frees the buffers of the current round, including those created before
+a round left.
+*/
+void CAllocBench::DestroyBatch()
+	{
+	for (TInt index = 0; index < KBatchSize; index++)
+		{
+		// Devices first, as they may still point to the buffers.
+		delete iDevices[index];
+		iDevices[index] = NULL;
+		}
+	for (TInt index = 0; index < KBatchSize; index++)
+		{
+		if (iBatchAllocator == EBenchPooled)
+			iPool.Free(iBuffers[index]);
+		else
+			User::Free(iBuffers[index]);
+		iBuffers[index] = NULL;
+		}
+	}
+
+TSize CAllocBench::DeviceSize(TInt aIndex)
+	{
+	const TInt sizeIndex = aIndex % KDeviceSizeCount;
+	return TSize(KDeviceWidths[sizeIndex], KDeviceHeights[sizeIndex]);
+	}
+
+void CAllocBench::WriteResultsL(RFs& aFs, const TDesC& aFileName) const
+	{
+	RFile file;
+	User::LeaveIfError(file.Replace(aFs, aFileName, EFileWrite | EFileStreamText));
+	CleanupClosePushL(file);
+	User::LeaveIfError(file.Write(KResultsHeader));
+	TBuf8<80> line;
+	for (TInt index = 0; index < iResults.Count(); index++)
+		{
+		const TAllocResult& result = iResults[index];
+		line.Format(_L8("%s,%s,%s,%Ld\n"),
+					KOperationNames[result.iOperation],
+					result.iOperation == EBenchScanLineBuffer ? _S8("-") : KDisplayModeNames[result.iDisplayMode],
+					KAllocatorNames[result.iOperation][result.iAllocator],
+					result.iKOpsPerSecond);
+		User::LeaveIfError(file.Write(line));
+		}
+	CleanupStack::PopAndDestroy(&file);
+	}
+
+LOCAL_C TInt MainL()
+	{
+	CCommandLineArguments* args = CCommandLineArguments::NewLC();
+	TFileName resultsFile(KDefaultResultsFile);
+	for (TInt index = 1; index < args->Count(); index++)
+		{
+		const TPtrC arg(args->Arg(index));
+		if (arg == _L("-o") && index + 1 < args->Count())
+			resultsFile = args->Arg(++index);
+		else
+			User::Leave(KErrArgument);
+		}
+	CleanupStack::PopAndDestroy(args);
+
+	RFs fs;
+	User::LeaveIfError(fs.Connect());
+	CleanupClosePushL(fs);
+	CAllocBench* bench = CAllocBench::NewLC();
+	bench->RunL();
+	bench->WriteResultsL(fs, resultsFile);
+	CleanupStack::PopAndDestroy(2, &fs);
+	return KErrNone;
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	TInt result = KErrNoMemory;
+	if (cleanup)
+		{
+		TRAP(result, MainL());
+		if (result != KErrNone)
+			RDebug::Printf("tbitdrawallocbench: failed (%d)", result);
+		delete cleanup;
+		}
+	__UHEAP_MARKEND;
+	return result;
+	}
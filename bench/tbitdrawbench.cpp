@@ -0,0 +1,585 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Throughput benchmark of the CFbsDrawDevice drawing primitives of the bitmap devices
+// created by CFbsDrawDevice::NewBitmapDeviceL(), in every display mode.
+//
+// Usage: tbitdrawbench [-o <results file>] [-b <baseline file>] [-c <comparison file>] [-t <percent>] [-q]
+//	-o	File the results are written to, default KDefaultResultsFile
+//	-b	Results of an earlier run to compare against
+//	-c	File the comparison is written to, default KDefaultCompareFile
+//	-t	Change in throughput, in percent, reported by the comparison (default 5)
+//	-q	Quick run: normal orientation and one span length only
+//
+// Results are written as comma separated values, one line per measurement:
+//	primitive,display_mode,orientation,shadow_mode,draw_mode,length,mpixels_per_s
+// with the throughput in megapixels per second to three decimal places. The results are written
+// with or without a baseline, so that any run can be the baseline of the next one. The comparison
+// writes one line per measurement that changed by more than the threshold,
+//	primitive,display_mode,orientation,shadow_mode,draw_mode,length,baseline,current,percent
+// followed by the number of regressions, and the process exit code is the number of regressions.
+//
+
+#include <e32base.h>
+#include <e32debug.h>
+#include <f32file.h>
+#include <bacline.h>
+#include <hal.h>
+#include "bitdraw.h"
+#include "BitDrawPixelFormat.h"
+
+_LIT(KDefaultResultsFile, "c:\\data\\tbitdrawbench.csv");
+_LIT(KDefaultCompareFile, "c:\\data\\tbitdrawbench_compare.csv");
+_LIT8(KResultsHeader, "primitive,display_mode,orientation,shadow_mode,draw_mode,length,mpixels_per_s\n");
+_LIT8(KCompareHeader, "primitive,display_mode,orientation,shadow_mode,draw_mode,length,baseline,current,percent\n");
+
+/** Physical size of the benchmarked bitmap devices. */
+const TInt KDeviceWidth = 320;
+const TInt KDeviceHeight = 240;
+/** Rows drawn by the primitives that draw a rectangle. */
+const TInt KBlockRows = 16;
+/** Minimum duration of one measurement, in microseconds. */
+const TInt KMinSampleTime = 20000;
+/** Default threshold of the comparison, in percent. */
+const TInt KDefaultThreshold = 5;
+
+/**
+Primitives benchmarked.
+*/
+enum TBenchPrimitive
+	{
+	EBenchWriteRgb,
+	EBenchWriteRgbMulti,
+	EBenchWriteLine,
+	EBenchWriteBinary,
+	EBenchWriteBinaryLine,
+	EBenchWriteBinaryLineVertical,
+	EBenchWriteRgbAlphaLine,
+	EBenchWriteRgbAlphaLine2,
+	EBenchWriteRgbAlphaMulti,
+	EBenchMapColors,
+	EBenchShadowArea,
+	EBenchReadLine,
+	EBenchReadLine16MU,
+	EBenchReadPixel,
+	EBenchPrimitiveCount
+	};
+
+LOCAL_D const TText8* const KPrimitiveNames[EBenchPrimitiveCount] =
+	{
+	_S8("WriteRgb"),
+	_S8("WriteRgbMulti"),
+	_S8("WriteLine"),
+	_S8("WriteBinary"),
+	_S8("WriteBinaryLine"),
+	_S8("WriteBinaryLineVertical"),
+	_S8("WriteRgbAlphaLine"),
+	_S8("WriteRgbAlphaLine2"),
+	_S8("WriteRgbAlphaMulti"),
+	_S8("MapColors"),
+	_S8("ShadowArea"),
+	_S8("ReadLine"),
+	_S8("ReadLine16MU"),
+	_S8("ReadPixel")
+	};
+
+/** Display modes benchmarked. */
+LOCAL_D const TDisplayMode KDisplayModes[] =
+	{
+	EGray2, EGray4, EGray16, EGray256, EColor16, EColor256, EColor4K,
+	EColor64K, EColor16M, EColor16MU, EColor16MA, EColor16MAP
+	};
+
+LOCAL_D const TText8* const KDisplayModeNames[EColorLast] =
+	{
+	_S8("ENone"), _S8("EGray2"), _S8("EGray4"), _S8("EGray16"), _S8("EGray256"), _S8("EColor16"),
+	_S8("EColor256"), _S8("EColor64K"), _S8("EColor16M"), _S8("ERgb"), _S8("EColor4K"),
+	_S8("EColor16MU"), _S8("EColor16MA"), _S8("EColor16MAP")
+	};
+
+/** Draw modes benchmarked, for the primitives that take one. */
+LOCAL_D const CGraphicsContext::TDrawMode KDrawModes[] =
+	{
+	CGraphicsContext::EDrawModePEN,
+	CGraphicsContext::EDrawModeAND,
+	CGraphicsContext::EDrawModeOR,
+	CGraphicsContext::EDrawModeXOR,
+	CGraphicsContext::EDrawModeNOTPEN,
+	CGraphicsContext::EDrawModeWriteAlpha
+	};
+
+LOCAL_D const TText8* const KDrawModeNames[] =
+	{
+	_S8("PEN"), _S8("AND"), _S8("OR"), _S8("XOR"), _S8("NOTPEN"), _S8("WriteAlpha")
+	};
+
+LOCAL_D const TText8* const KShadowModeNames[] =
+	{
+	_S8("ENoShadow"), _S8("EShadow"), _S8("EFade"), _S8("EShadowFade")
+	};
+
+LOCAL_D const TText8* const KOrientationNames[] =
+	{
+	_S8("Normal"), _S8("Rotated90"), _S8("Rotated180"), _S8("Rotated270")
+	};
+
+/** Span lengths benchmarked. The first one is used by the quick run. */
+LOCAL_D const TInt KSpanLengths[] = {64, 1, 8, 32, 240};
+
+/**
+One measurement.
+*/
+class TBenchResult
+	{
+public:
+	TBenchPrimitive iPrimitive;
+	TDisplayMode iDisplayMode;
+	CFbsDrawDevice::TOrientation iOrientation;
+	CFbsDrawDevice::TShadowMode iShadowMode;
+	TInt iDrawModeIndex;
+	TInt iLength;
+	TInt64 iKPixelsPerSecond;
+	};
+
+/**
+Runs the benchmark, and writes its results and compares them with an earlier run.
+*/
+class CDrawBench : public CBase
+	{
+public:
+	static CDrawBench* NewLC(TBool aQuick);
+	~CDrawBench();
+	void RunL();
+	void WriteResultsL(RFs& aFs, const TDesC& aFileName) const;
+	TInt CompareL(RFs& aFs, const TDesC& aBaselineFile, const TDesC& aCompareFile, TInt aThreshold) const;
+private:
+	CDrawBench(TBool aQuick);
+	void ConstructL();
+	void BenchDeviceL(TDisplayMode aDispMode);
+	void BenchOrientation(CFbsDrawDevice& aDevice, TDisplayMode aDispMode, CFbsDrawDevice::TOrientation aOrientation);
+	void Measure(CFbsDrawDevice& aDevice, TBenchPrimitive aPrimitive, TInt aLength,
+				 CFbsDrawDevice::TShadowMode aShadowMode, TInt aDrawModeIndex);
+	TInt DoPrimitive(CFbsDrawDevice& aDevice, TBenchPrimitive aPrimitive, TInt aLength,
+					 CGraphicsContext::TDrawMode aDrawMode, TInt aIteration);
+	static TBool HasDrawMode(TBenchPrimitive aPrimitive);
+	static void FormatKey(TDes8& aLine, const TBenchResult& aResult);
+	static void AppendMPixels(TDes8& aLine, TInt64 aKPixels);
+private:
+	TBool iQuick;
+	TInt iFrequency;
+	TBool iCountsUp;
+	TSize iLogicalSize;
+	TDisplayMode iDisplayMode;
+	CFbsDrawDevice::TOrientation iOrientation;
+	RArray<TBenchResult> iResults;
+	TUint32* iLineBuffer;
+	TUint8* iMaskBuffer;
+	TUint32* iBinaryBuffer;
+	TRgb iColors[8];
+	};
+
+CDrawBench* CDrawBench::NewLC(TBool aQuick)
+	{
+	CDrawBench* self = new(ELeave) CDrawBench(aQuick);
+	CleanupStack::PushL(self);
+	self->ConstructL();
+	return self;
+	}
+
+CDrawBench::CDrawBench(TBool aQuick):
+	iQuick(aQuick),
+	iCountsUp(ETrue)
+	{
+	}
+
+void CDrawBench::ConstructL()
+	{
+	User::LeaveIfError(HAL::Get(HALData::EFastCounterFrequency, iFrequency));
+	TInt countsUp;
+	if (HAL::Get(HALData::EFastCounterCountsUp, countsUp) == KErrNone)
+		iCountsUp = countsUp;
+	const TInt maxLength = Max(KDeviceWidth, KDeviceHeight);
+	// Large enough for one line of 32bpp pixels, twice for the background of WriteRgbAlphaLine2.
+	iLineBuffer = new(ELeave) TUint32[maxLength * 2];
+	iMaskBuffer = new(ELeave) TUint8[maxLength];
+	iBinaryBuffer = new(ELeave) TUint32[maxLength];
+	for (TInt index = 0; index < maxLength * 2; index++)
+		iLineBuffer[index] = 0x01000193 * (index + 1);
+	for (TInt index = 0; index < maxLength; index++)
+		{
+		// A ramp, so that transparent, opaque and blended mask values all occur.
+		iMaskBuffer[index] = TUint8(index * 255 / (maxLength - 1));
+		iBinaryBuffer[index] = 0x5a5aa5a5 ^ (index * 0x9e3779b1);
+		}
+	for (TInt index = 0; index < 8; index++)
+		iColors[index] = TRgb(index * 32, 255 - index * 32, index * 16);
+	}
+
+CDrawBench::~CDrawBench()
+	{
+	iResults.Close();
+	delete [] iLineBuffer;
+	delete [] iMaskBuffer;
+	delete [] iBinaryBuffer;
+	}
+
+/**
+Benchmarks every display mode for which a bitmap device can be created.
+*/
+void CDrawBench::RunL()
+	{
+	const TInt numModes = sizeof(KDisplayModes) / sizeof(KDisplayModes[0]);
+	for (TInt index = 0; index < numModes; index++)
+		{
+		TRAPD(err, BenchDeviceL(KDisplayModes[index]));
+		if (err == KErrNoMemory)
+			User::Leave(err);
+		if (err != KErrNone)
+			RDebug::Printf("tbitdrawbench: %s skipped (%d)", KDisplayModeNames[KDisplayModes[index]], err);
+		}
+	}
+
+void CDrawBench::BenchDeviceL(TDisplayMode aDispMode)
+	{
+	const TSize size(KDeviceWidth, KDeviceHeight);
+	// Bitmap scan lines are padded to a whole number of 32-bit words; EColor4K pixels take 16 bits.
+	const TInt bpp = BitsInMemory(aDispMode);
+	const TInt stride = ((KDeviceWidth * bpp + 31) / 32) * 4;
+	TUint32* bits = new(ELeave) TUint32[stride / 4 * KDeviceHeight];
+	CleanupArrayDeletePushL(bits);
+	Mem::FillZ(bits, stride * KDeviceHeight);
+	CFbsDrawDevice* device = CFbsDrawDevice::NewBitmapDeviceL(size, aDispMode, stride);
+	CleanupStack::PushL(device);
+	device->SetBits(bits);
+	TBool available[4];
+	device->OrientationsAvailable(available);
+	const TInt numOrientations = iQuick ? 1 : 4;
+	for (TInt orientation = 0; orientation < numOrientations; orientation++)
+		{
+		if (available[orientation] && device->SetOrientation(CFbsDrawDevice::TOrientation(orientation)))
+			BenchOrientation(*device, aDispMode, CFbsDrawDevice::TOrientation(orientation));
+		}
+	CleanupStack::PopAndDestroy(2, bits);
+	}
+
+/**
+Every primitive is measured at every span length: with each draw mode and no shadowing,
+then with each shadow mode and EDrawModePEN.
+*/
+void CDrawBench::BenchOrientation(CFbsDrawDevice& aDevice, TDisplayMode aDispMode, CFbsDrawDevice::TOrientation aOrientation)
+	{
+	iDisplayMode = aDispMode;
+	iOrientation = aOrientation;
+	iLogicalSize = aDevice.SizeInPixels();
+	const TInt numLengths = iQuick ? 1 : sizeof(KSpanLengths) / sizeof(KSpanLengths[0]);
+	const TInt numDrawModes = sizeof(KDrawModes) / sizeof(KDrawModes[0]);
+	for (TInt primitive = 0; primitive < EBenchPrimitiveCount; primitive++)
+		{
+		const TBenchPrimitive benchPrimitive = TBenchPrimitive(primitive);
+		for (TInt lengthIndex = 0; lengthIndex < numLengths; lengthIndex++)
+			{
+			const TInt length = KSpanLengths[lengthIndex];
+			const TInt drawModes = HasDrawMode(benchPrimitive) ? numDrawModes : 1;
+			// ShadowArea does nothing without a shadow mode.
+			if (benchPrimitive != EBenchShadowArea)
+				{
+				for (TInt drawMode = 0; drawMode < drawModes; drawMode++)
+					Measure(aDevice, benchPrimitive, length, CFbsDrawDevice::ENoShadow, drawMode);
+				}
+			for (TInt shadowMode = CFbsDrawDevice::EShadow; shadowMode <= CFbsDrawDevice::EShadowFade; shadowMode++)
+				Measure(aDevice, benchPrimitive, length, CFbsDrawDevice::TShadowMode(shadowMode), 0);
+			}
+		}
+	aDevice.SetShadowMode(CFbsDrawDevice::ENoShadow);
+	}
+
+/**
+Calls a primitive until at least KMinSampleTime has elapsed, doubling the number of calls
+between timings, and records the throughput.
+*/
+void CDrawBench::Measure(CFbsDrawDevice& aDevice, TBenchPrimitive aPrimitive, TInt aLength,
+						 CFbsDrawDevice::TShadowMode aShadowMode, TInt aDrawModeIndex)
+	{
+	aDevice.SetShadowMode(aShadowMode);
+	const CGraphicsContext::TDrawMode drawMode = KDrawModes[aDrawModeIndex];
+	const TInt64 minTicks = TInt64(iFrequency) * KMinSampleTime / 1000000;
+	TInt calls = 1;
+	TInt64 pixels = 0;
+	TInt64 ticks = 0;
+	FOREVER
+		{
+		pixels = 0;
+		const TUint32 start = User::FastCounter();
+		for (TInt call = 0; call < calls; call++)
+			pixels += DoPrimitive(aDevice, aPrimitive, aLength, drawMode, call);
+		const TUint32 end = User::FastCounter();
+		ticks = iCountsUp ? end - start : start - end;
+		if (ticks >= minTicks || calls >= KMaxTInt / 2)
+			break;
+		calls *= 2;
+		}
+	TBenchResult result;
+	result.iPrimitive = aPrimitive;
+	result.iDisplayMode = iDisplayMode;
+	result.iOrientation = iOrientation;
+	result.iShadowMode = aShadowMode;
+	result.iDrawModeIndex = aDrawModeIndex;
+	result.iLength = aLength;
+	result.iKPixelsPerSecond = ticks > 0 ? pixels * iFrequency / ticks / 1000 : 0;
+	// A failed append loses one measurement; the run carries on.
+	iResults.Append(result);
+	}
+
+/**
+Calls a primitive once, on a row that moves down the device with aIteration.
+@return The number of pixels the call covered.
+*/
+TInt CDrawBench::DoPrimitive(CFbsDrawDevice& aDevice, TBenchPrimitive aPrimitive, TInt aLength,
+							 CGraphicsContext::TDrawMode aDrawMode, TInt aIteration)
+	{
+	const TInt length = Min(aLength, iLogicalSize.iWidth);
+	const TInt rows = Min(KBlockRows, iLogicalSize.iHeight);
+	const TInt y = aIteration % (iLogicalSize.iHeight - rows + 1);
+	const TRgb color = iColors[aIteration & 7];
+	TUint8* const rgb = reinterpret_cast<TUint8*>(iLineBuffer);
+	switch (aPrimitive)
+		{
+	case EBenchWriteRgb:
+		for (TInt x = 0; x < length; x++)
+			aDevice.WriteRgb(x, y, color, aDrawMode);
+		return length;
+	case EBenchWriteRgbMulti:
+		aDevice.WriteRgbMulti(0, y, length, rows, color, aDrawMode);
+		return length * rows;
+	case EBenchWriteLine:
+		aDevice.WriteLine(0, y, length, iLineBuffer, aDrawMode);
+		return length;
+	case EBenchWriteBinary:
+		{
+		const TInt width = Min(length, 32);
+		aDevice.WriteBinary(0, y, iBinaryBuffer, width, rows, color, aDrawMode);
+		return width * rows;
+		}
+	case EBenchWriteBinaryLine:
+		aDevice.WriteBinaryLine(0, y, iBinaryBuffer, length, color, aDrawMode);
+		return length;
+	case EBenchWriteBinaryLineVertical:
+		{
+		const TInt height = Min(aLength, iLogicalSize.iHeight);
+		aDevice.WriteBinaryLineVertical(aIteration % iLogicalSize.iWidth, 0, iBinaryBuffer, height, color, aDrawMode, EFalse);
+		return height;
+		}
+	case EBenchWriteRgbAlphaLine:
+		aDevice.WriteRgbAlphaLine(0, y, length, rgb, iMaskBuffer, aDrawMode);
+		return length;
+	case EBenchWriteRgbAlphaLine2:
+		aDevice.WriteRgbAlphaLine(0, y, length, rgb, rgb + length * 4, iMaskBuffer, aDrawMode);
+		return length;
+	case EBenchWriteRgbAlphaMulti:
+		aDevice.WriteRgbAlphaMulti(0, y, length, color, iMaskBuffer);
+		return length;
+	case EBenchMapColors:
+		aDevice.MapColors(TRect(0, y, length, y + rows), iColors, 4, ETrue);
+		return length * rows;
+	case EBenchShadowArea:
+		aDevice.ShadowArea(TRect(0, y, length, y + rows));
+		return length * rows;
+	case EBenchReadLine:
+		aDevice.ReadLine(0, y, length, iLineBuffer, iDisplayMode);
+		return length;
+	case EBenchReadLine16MU:
+		aDevice.ReadLine(0, y, length, iLineBuffer, EColor16MU);
+		return length;
+	default:
+		{
+		TUint32 sum = 0;
+		for (TInt x = 0; x < length; x++)
+			sum += aDevice.ReadPixel(x, y).Internal();
+		iLineBuffer[0] = sum;
+		return length;
+		}
+		}
+	}
+
+TBool CDrawBench::HasDrawMode(TBenchPrimitive aPrimitive)
+	{
+	return aPrimitive <= EBenchWriteRgbAlphaLine2;
+	}
+
+/**
+Formats the fields that identify a measurement, each followed by a comma.
+*/
+void CDrawBench::FormatKey(TDes8& aLine, const TBenchResult& aResult)
+	{
+	aLine.Format(_L8("%s,%s,%s,%s,%s,%d,"),
+				 KPrimitiveNames[aResult.iPrimitive],
+				 KDisplayModeNames[aResult.iDisplayMode],
+				 KOrientationNames[aResult.iOrientation],
+				 KShadowModeNames[aResult.iShadowMode],
+				 HasDrawMode(aResult.iPrimitive) ? KDrawModeNames[aResult.iDrawModeIndex] : _S8("-"),
+				 aResult.iLength);
+	}
+
+/**
+Appends a throughput in kilopixels per second as megapixels per second, to three decimal places.
+*/
+void CDrawBench::AppendMPixels(TDes8& aLine, TInt64 aKPixels)
+	{
+	aLine.AppendFormat(_L8("%Ld.%03Ld"), aKPixels / 1000, aKPixels % 1000);
+	}
+
+void CDrawBench::WriteResultsL(RFs& aFs, const TDesC& aFileName) const
+	{
+	RFile file;
+	User::LeaveIfError(file.Replace(aFs, aFileName, EFileWrite | EFileStreamText));
+	CleanupClosePushL(file);
+	User::LeaveIfError(file.Write(KResultsHeader));
+	TBuf8<160> line;
+	for (TInt index = 0; index < iResults.Count(); index++)
+		{
+		FormatKey(line, iResults[index]);
+		AppendMPixels(line, iResults[index].iKPixelsPerSecond);
+		line.Append('\n');
+		User::LeaveIfError(file.Write(line));
+		}
+	CleanupStack::PopAndDestroy(&file);
+	}
+
+/**
+Compares the results with those of an earlier run, writing the changes to aCompareFile.
+@return The number of measurements whose throughput fell by more than aThreshold percent.
+*/
+TInt CDrawBench::CompareL(RFs& aFs, const TDesC& aBaselineFile, const TDesC& aCompareFile, TInt aThreshold) const
+	{
+	RFile baselineFile;
+	User::LeaveIfError(baselineFile.Open(aFs, aBaselineFile, EFileRead | EFileShareReadersOnly));
+	CleanupClosePushL(baselineFile);
+	TInt size;
+	User::LeaveIfError(baselineFile.Size(size));
+	HBufC8* baseline = HBufC8::NewLC(size);
+	TPtr8 baselinePtr(baseline->Des());
+	User::LeaveIfError(baselineFile.Read(baselinePtr));
+
+	RFile file;
+	User::LeaveIfError(file.Replace(aFs, aCompareFile, EFileWrite | EFileStreamText));
+	CleanupClosePushL(file);
+	User::LeaveIfError(file.Write(KCompareHeader));
+	TInt regressions = 0;
+	TBuf8<160> key;
+	TBuf8<200> line;
+	for (TInt index = 0; index < iResults.Count(); index++)
+		{
+		const TBenchResult& result = iResults[index];
+		FormatKey(key, result);
+		// Look for a line starting with the same key, at the start of the file or after a newline.
+		TPtrC8 rest(*baseline);
+		TInt64 before = -1;
+		FOREVER
+			{
+			const TInt found = rest.Find(key);
+			if (found == KErrNotFound)
+				break;
+			const TInt offset = rest.Ptr() - baseline->Ptr() + found;
+			rest.Set(rest.Mid(found + key.Length()));
+			if (offset == 0 || (*baseline)[offset - 1] == '\n')
+				{
+				TLex8 lex(rest);
+				TReal mpixels;
+				if (lex.Val(mpixels, '.') == KErrNone)
+					before = TInt64(mpixels * 1000 + 0.5);
+				break;
+				}
+			}
+		if (before <= 0)
+			continue;
+		const TInt64 change = (result.iKPixelsPerSecond - before) * 100 / before;
+		if (change > aThreshold || change < -aThreshold)
+			{
+			if (change < 0)
+				regressions++;
+			line.Copy(key);
+			AppendMPixels(line, before);
+			line.Append(',');
+			AppendMPixels(line, result.iKPixelsPerSecond);
+			line.AppendFormat(_L8(",%Ld\n"), change);
+			User::LeaveIfError(file.Write(line));
+			}
+		}
+	line.Format(_L8("regressions,%d\n"), regressions);
+	User::LeaveIfError(file.Write(line));
+	CleanupStack::PopAndDestroy(3, &baselineFile);
+	return regressions;
+	}
+
+LOCAL_C TInt MainL()
+	{
+	CCommandLineArguments* args = CCommandLineArguments::NewLC();
+	TFileName resultsFile(KDefaultResultsFile);
+	TFileName baselineFile;
+	TFileName compareFile(KDefaultCompareFile);
+	TInt threshold = KDefaultThreshold;
+	TBool quick = EFalse;
+	for (TInt index = 1; index < args->Count(); index++)
+		{
+		const TPtrC arg(args->Arg(index));
+		const TBool hasValue = index + 1 < args->Count();
+		if (arg == _L("-q"))
+			quick = ETrue;
+		else if (arg == _L("-o") && hasValue)
+			resultsFile = args->Arg(++index);
+		else if (arg == _L("-b") && hasValue)
+			baselineFile = args->Arg(++index);
+		else if (arg == _L("-c") && hasValue)
+			compareFile = args->Arg(++index);
+		else if (arg == _L("-t") && hasValue)
+			{
+			TLex lex(args->Arg(++index));
+			User::LeaveIfError(lex.Val(threshold));
+			}
+		else
+			User::Leave(KErrArgument);
+		}
+	CleanupStack::PopAndDestroy(args);
+
+	RFs fs;
+	User::LeaveIfError(fs.Connect());
+	CleanupClosePushL(fs);
+	CDrawBench* bench = CDrawBench::NewLC(quick);
+	bench->RunL();
+	TInt regressions = 0;
+	// Compare first, so that the baseline may be replaced by the results of this run.
+	if (baselineFile.Length() > 0)
+		regressions = bench->CompareL(fs, baselineFile, compareFile, threshold);
+	bench->WriteResultsL(fs, resultsFile);
+	CleanupStack::PopAndDestroy(2, &fs);
+	return regressions;
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	TInt result = KErrNoMemory;
+	if (cleanup)
+		{
+		TRAPD(err, result = MainL());
+		if (err != KErrNone)
+			{
+			RDebug::Printf("tbitdrawbench: failed (%d)", err);
+			result = err;
+			}
+		delete cleanup;
+		}
+	__UHEAP_MARKEND;
+	return result;
+	}
@@ -37,7 +37,8 @@ enum TScreenDriverPanic
 	EScreenDriverPanicInvalidSize,
 	EScreenDriverPanicInvalidHalValue,
 	EScreenDriverPanicInvalidScreenNo,
-	EScreenDriverPanicIncompatiblePreviousDevice		//<The previous device in SetDisplayMode was not compatible
+	EScreenDriverPanicIncompatiblePreviousDevice,		//<The previous device in SetDisplayMode was not compatible
+	EScreenDriverPanicNoMemory		//<A device that cannot leave ran out of memory
 	};
 
 /**
@@ -515,6 +516,7 @@ public:
 	@param aInterface Address of pointer variable that retrieves the specified interface.
 	@return KErrNone If the interface is supported, KErrNotSupported otherwise.
 	@see BitDrawInterfaceId.h file for the IDs of supported interfaces
+	@see BitDrawExtInterfaceId.h file for the IDs of the extensions declared in this component
 	*/
 	virtual TInt GetInterface(TInt aInterfaceId, TAny*& aInterface) = 0;
 	
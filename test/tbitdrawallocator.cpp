@@ -0,0 +1,458 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks RScanLineBufferPool, CDrawDeviceArena and CThreadScanLineDevice.
+//	- The pool hands a freed buffer back to the next request of its size class without going to
+//	  the heap, keeps no more free buffers per class than it was created with, and gives buffers
+//	  beyond the largest class back to the heap.
+//	- The arena reuses the slot of a deleted device and, for the same size and display mode,
+//	  the bitmap device it wrapped without going to the heap. It keeps no more released devices
+//	  than it was created with, and destroys those whose palette was changed.
+//	- A device reused after its orientation, width and height, shadow mode, fading, dither
+//	  origin, user display mode, scaling and origin were changed draws the same pixels as a new
+//	  bitmap device.
+//	- Threads drawing at once each get a scan line buffer of their own, which stays theirs until
+//	  they release it; threads beyond KMaxScanLineBufferThreads get the buffer of the wrapped
+//	  device, and a released buffer goes to the next thread.
+// Heap failures are simulated with __UHEAP_FAILNEXT to tell reuse from allocation.
+//
+// Usage: tbitdrawallocator
+// The process panics at the first failure.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "BitDrawAllocator.h"
+#include "BitDrawInterfaceId.h"
+#include "BitDrawScaling.h"
+#include "BitDrawOrigin.h"
+#include "BitDrawPixelFormat.h"
+
+LOCAL_D RTest test(_L("TBitDrawAllocator"));
+
+/** Number of threads drawing at once in TestThreadsL(). */
+const TInt KConcurrentThreads = 8;
+const TInt KThreadIterations = 200;
+
+LOCAL_D const TDisplayMode KDisplayModes[] = { EColor256, EColor64K, EColor16MU };
+const TInt KDisplayModeCount = sizeof(KDisplayModes) / sizeof(KDisplayModes[0]);
+
+LOCAL_D TInt64 TheSeed = 0x5eeda110;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C TInt Random(TInt aLow, TInt aHigh)
+	{
+	return aLow + TInt(Random() % TUint32(aHigh - aLow));
+	}
+
+LOCAL_C void TestPool()
+	{
+	RScanLineBufferPool pool;
+	test(pool.Create(2) == KErrNone);
+
+	// Sizes of the same class share buffers, which are 8 byte aligned and as large as the class.
+	TAny* buffer = pool.Alloc(65);
+	test(buffer != NULL);
+	test((TUint(buffer) & 7) == 0);
+	Mem::Fill(buffer, 128, 0xa5);
+	pool.Free(buffer);
+	__UHEAP_FAILNEXT(1);
+	test(pool.Alloc(128) == buffer);
+	__UHEAP_RESET;
+	pool.Free(buffer);
+	TAny* other = pool.Alloc(64);
+	test(other != NULL && other != buffer);
+	pool.Free(other);
+
+	// No more free buffers per class than the pool was created with.
+	TAny* buffers[3];
+	for (TInt index = 0; index < 3; index++)
+		{
+		buffers[index] = pool.Alloc(1000);
+		test(buffers[index] != NULL);
+		}
+	for (TInt index = 0; index < 3; index++)
+		pool.Free(buffers[index]);
+	__UHEAP_FAILNEXT(1);
+	TAny* first = pool.Alloc(1000);
+	TAny* second = pool.Alloc(1000);
+	TAny* third = pool.Alloc(1000);
+	__UHEAP_RESET;
+	test(first == buffers[1] && second == buffers[0] && third == NULL);
+	pool.Free(first);
+	pool.Free(second);
+
+	// Buffers larger than the largest class come from the heap every time.
+	const TInt largeBytes = (1 << (KPooledBufferMinShift + KPooledBufferSizeClasses - 1)) + 1;
+	TAny* large = pool.Alloc(largeBytes);
+	test(large != NULL);
+	Mem::FillZ(large, largeBytes);
+	pool.Free(large);
+	__UHEAP_FAILNEXT(1);
+	test(pool.Alloc(largeBytes) == NULL);
+	__UHEAP_RESET;
+
+	// Trimming frees the kept buffers.
+	pool.Trim();
+	__UHEAP_FAILNEXT(1);
+	test(pool.Alloc(1000) == NULL);
+	__UHEAP_RESET;
+	pool.Close();
+	}
+
+LOCAL_C void TestArenaL()
+	{
+	CDrawDeviceArena* arena = CDrawDeviceArena::NewL(2);
+	CleanupStack::PushL(arena);
+	const TSize sizeA(37, 20);
+	const TSize sizeB(64, 9);
+	const TSize sizeC(5, 70);
+
+	// The slot and the bitmap device of a deleted device are reused without going to the heap.
+	CFbsDrawDevice* device = arena->NewBitmapDeviceL(sizeA, EColor64K);
+	device->WriteRgb(3, 4, KRgbWhite, CGraphicsContext::EDrawModePEN);
+	CFbsDrawDevice* const deleted = device;
+	delete device;
+	test(arena->CachedDeviceCount() == 1);
+	__UHEAP_FAILNEXT(1);
+	TRAPD(err, device = arena->NewBitmapDeviceL(sizeA, EColor64K));
+	__UHEAP_RESET;
+	test(err == KErrNone);
+	test(device == deleted);
+	test(arena->CachedDeviceCount() == 0);
+	test(device->SizeInPixels() == sizeA && device->DisplayMode() == EColor64K);
+	// The pixels of a reused device are undefined, but here they are those of the deleted one.
+	test(device->ReadPixel(3, 4) == KRgbWhite);
+	delete device;
+
+	// Another size or display mode needs a new bitmap device.
+	__UHEAP_FAILNEXT(1);
+	TRAP(err, device = arena->NewBitmapDeviceL(sizeA, EColor16MU));
+	__UHEAP_RESET;
+	test(err == KErrNoMemory);
+	test(arena->CachedDeviceCount() == 1);
+
+	// Only the most recently released devices are kept.
+	CFbsDrawDevice* devices[3];
+	devices[0] = arena->NewBitmapDeviceL(sizeB, EColor64K);
+	devices[1] = arena->NewBitmapDeviceL(sizeC, EColor64K);
+	devices[2] = arena->NewBitmapDeviceL(sizeA, EColor64K);
+	test(arena->CachedDeviceCount() == 0);
+	for (TInt index = 0; index < 3; index++)
+		delete devices[index];
+	test(arena->CachedDeviceCount() == 2);
+	__UHEAP_FAILNEXT(1);
+	TRAP(err, device = arena->NewBitmapDeviceL(sizeB, EColor64K));
+	__UHEAP_RESET;
+	test(err == KErrNoMemory);
+	__UHEAP_FAILNEXT(1);
+	TRAP(err, device = arena->NewBitmapDeviceL(sizeC, EColor64K));
+	__UHEAP_RESET;
+	test(err == KErrNone);
+	delete device;
+
+	// A device whose palette was changed is destroyed.
+	arena->Trim();
+	device = arena->NewBitmapDeviceL(sizeA, EColor256);
+	CPalette* palette = CPalette::NewDefaultL(EColor256);
+	err = device->SetCustomPalette(palette);
+	delete palette;
+	delete device;
+	test(arena->CachedDeviceCount() == (err == KErrNone ? 0 : 1));
+
+	// More devices than a block of slots holds.
+	const TInt numDevices = KArenaBlockDevices * 2 + 3;
+	CFbsDrawDevice* many[numDevices];
+	for (TInt index = 0; index < numDevices; index++)
+		{
+		many[index] = arena->NewBitmapDeviceL(TSize(index + 1, 3), EColor16MU);
+		for (TInt previous = 0; previous < index; previous++)
+			test(many[previous] != many[index]);
+		many[index]->WriteRgbMulti(0, 0, index + 1, 3, KRgbWhite, CGraphicsContext::EDrawModePEN);
+		}
+	for (TInt index = 0; index < numDevices; index++)
+		{
+		test(many[index]->ReadPixel(index, 2) == KRgbWhite);
+		delete many[index];
+		}
+	test(arena->CachedDeviceCount() == 2);
+	CleanupStack::PopAndDestroy(arena);
+	}
+
+/**
+Draws the same pixels into aDevice and aReference, and compares them.
+*/
+LOCAL_C void DrawAndCompare(CFbsDrawDevice& aDevice, CFbsDrawDevice& aReference)
+	{
+	const TSize size = aReference.SizeInPixels();
+	test(aDevice.SizeInPixels() == size);
+	TUint32 buffer[64];
+	CFbsDrawDevice* devices[2] = { &aDevice, &aReference };
+	const TInt64 seed = TheSeed;
+	for (TInt index = 0; index < 2; index++)
+		{
+		TheSeed = seed;
+		CFbsDrawDevice& device = *devices[index];
+		device.WriteRgbMulti(0, 0, size.iWidth, size.iHeight, KRgbBlack, CGraphicsContext::EDrawModePEN);
+		for (TInt count = 0; count < 40; count++)
+			{
+			const TInt x = Random(0, size.iWidth);
+			const TInt y = Random(0, size.iHeight);
+			const TInt length = Random(1, Min(size.iWidth - x, 64) + 1);
+			const TRgb color(Random() & 0xff, Random() & 0xff, Random() & 0xff);
+			for (TInt pixel = 0; pixel < length; pixel++)
+				buffer[pixel] = Random() | 0xff000000;
+			if (count & 1)
+				device.WriteRgbMulti(x, y, length, 1, color, CGraphicsContext::EDrawModePEN);
+			else
+				device.WriteLine(x, y, length, buffer, CGraphicsContext::EDrawModePEN);
+			}
+		}
+	for (TInt y = 0; y < size.iHeight; y++)
+		{
+		for (TInt x = 0; x < size.iWidth; x++)
+			{
+			const TRgb reused = aDevice.ReadPixel(x, y);
+			const TRgb expected = aReference.ReadPixel(x, y);
+			if (reused != expected)
+				{
+				test.Printf(_L("[%d,%d] is %08x, %08x in a new device\n"), x, y, reused.Internal(), expected.Internal());
+				test(EFalse);
+				}
+			}
+		}
+	}
+
+LOCAL_C void TestResetL()
+	{
+	CDrawDeviceArena* arena = CDrawDeviceArena::NewL(1);
+	CleanupStack::PushL(arena);
+	const TSize size(40, 24);
+	for (TInt modeIndex = 0; modeIndex < KDisplayModeCount; modeIndex++)
+		{
+		const TDisplayMode mode = KDisplayModes[modeIndex];
+		const TInt stride = ((size.iWidth * BitsInMemory(mode) + 31) >> 5) << 2;
+		TAny* bits = User::AllocZL(stride * size.iHeight);
+		CleanupStack::PushL(bits);
+		CFbsDrawDevice* reference = CFbsDrawDevice::NewBitmapDeviceL(size, mode, stride);
+		CleanupStack::PushL(reference);
+		reference->SetBits(bits);
+
+		CFbsDrawDevice* device = arena->NewBitmapDeviceL(size, mode);
+		TBool orientations[4];
+		device->OrientationsAvailable(orientations);
+		if (orientations[CFbsDrawDevice::EOrientationRotated90])
+			test(device->SetOrientation(CFbsDrawDevice::EOrientationRotated90));
+		device->SwapWidthAndHeight();
+		device->SetShadowMode(CFbsDrawDevice::EFade);
+		device->SetFadingParameters(0x40, 0x80);
+		device->SetDitherOrigin(TPoint(1, 1));
+		device->SetUserDisplayMode(EGray2);
+		TAny* interface = NULL;
+		if (device->GetInterface(KScalingSettingsInterfaceID, interface) == KErrNone)
+			static_cast<MScalingSettings*>(interface)->Set(2, 2, 1, 1);
+		if (device->GetInterface(KDrawDeviceOriginInterfaceID, interface) == KErrNone)
+			static_cast<MDrawDeviceOrigin*>(interface)->Set(TPoint(3, 2));
+		CFbsDrawDevice* const deleted = device;
+		delete device;
+		test(arena->CachedDeviceCount() == 1);
+
+		device = arena->NewBitmapDeviceL(size, mode);
+		test(device == deleted);
+		test(arena->CachedDeviceCount() == 0);
+		DrawAndCompare(*device, *reference);
+		delete device;
+		CleanupStack::PopAndDestroy(2, bits);
+		}
+	CleanupStack::PopAndDestroy(arena);
+	}
+
+/**
+What a thread of TestThreadsL() is given and reports.
+*/
+class TThreadParams
+	{
+public:
+	CThreadScanLineDevice* iDevice;
+	/** Number of words of the buffer written. */
+	TInt iBufferWords;
+	/** Pattern written to the buffer, different in every thread. */
+	TUint32 iPattern;
+	/** Draws KThreadIterations times if ETrue, once otherwise. */
+	TBool iConcurrent;
+	TBool iRelease;
+	TUint32* iBuffer;
+	};
+
+/**
+Fills the scan line buffer of the thread with a pattern of its own, lets the other threads run,
+and checks that the buffer and its pattern stayed the same.
+*/
+LOCAL_C TInt ThreadFunction(TAny* aParams)
+	{
+	TThreadParams& params = *static_cast<TThreadParams*>(aParams);
+	params.iBuffer = params.iDevice->ScanLineBuffer();
+	const TInt iterations = params.iConcurrent ? KThreadIterations : 1;
+	for (TInt iteration = 0; iteration < iterations; iteration++)
+		{
+		TUint32* buffer = params.iDevice->ScanLineBuffer();
+		if (buffer != params.iBuffer)
+			return KErrGeneral;
+		const TUint32 pattern = params.iPattern + iteration;
+		for (TInt index = 0; index < params.iBufferWords; index++)
+			buffer[index] = pattern + index;
+		if (params.iConcurrent)
+			User::After(0);
+		for (TInt index = 0; index < params.iBufferWords; index++)
+			{
+			if (buffer[index] != pattern + index)
+				return KErrCorrupt;
+			}
+		}
+	if (params.iRelease)
+		params.iDevice->ReleaseThreadBuffer();
+	return KErrNone;
+	}
+
+/**
+Runs aCount threads at once, and waits for all of them.
+*/
+LOCAL_C void RunThreadsL(TThreadParams* aParams, TInt aCount)
+	{
+	RThread threads[KConcurrentThreads];
+	TRequestStatus status[KConcurrentThreads];
+	for (TInt index = 0; index < aCount; index++)
+		{
+		User::LeaveIfError(threads[index].Create(KNullDesC, ThreadFunction, KDefaultStackSize, NULL, aParams + index));
+		threads[index].Logon(status[index]);
+		}
+	for (TInt index = 0; index < aCount; index++)
+		threads[index].Resume();
+	for (TInt index = 0; index < aCount; index++)
+		{
+		User::WaitForRequest(status[index]);
+		test(status[index].Int() == KErrNone);
+		threads[index].Close();
+		}
+	}
+
+LOCAL_C void TestThreadsL()
+	{
+	const TSize size(50, 90);
+	const TInt stride = size.iWidth * 4;
+	TAny* bits = User::AllocZL(stride * size.iHeight);
+	CleanupStack::PushL(bits);
+	RScanLineBufferPool pool;
+	User::LeaveIfError(pool.Create());
+	CleanupClosePushL(pool);
+	CFbsDrawDevice* target = CFbsDrawDevice::NewBitmapDeviceL(size, EColor16MU, stride);
+	target->SetBits(bits);
+	CleanupStack::PushL(target);
+	CThreadScanLineDevice* device = CThreadScanLineDevice::NewL(target, pool);
+	CleanupStack::Pop(target);
+	CleanupStack::PushL(device);
+	TUint32* const targetBuffer = target->ScanLineBuffer();
+
+	// The buffer of this thread holds a line along either dimension, before and after swapping them.
+	TUint32* const ownBuffer = device->ScanLineBuffer();
+	test(ownBuffer != NULL && ownBuffer != targetBuffer);
+	const TInt bufferWords = Max(size.iWidth, size.iHeight);
+	Mem::FillZ(ownBuffer, bufferWords * 4);
+	device->SwapWidthAndHeight();
+	test(device->ScanLineBuffer() == ownBuffer);
+	Mem::FillZ(ownBuffer, bufferWords * 4);
+	device->SwapWidthAndHeight();
+
+	// Threads drawing at once, which keep their buffers.
+	TThreadParams params[KMaxScanLineBufferThreads];
+	for (TInt index = 0; index < KMaxScanLineBufferThreads; index++)
+		{
+		params[index].iDevice = device;
+		// Threads run one at a time may get the buffer of the wrapped device.
+		params[index].iBufferWords = index < KConcurrentThreads ? bufferWords : target->ScanLineBytes() / 4;
+		params[index].iPattern = TUint32(index) << 24;
+		params[index].iConcurrent = index < KConcurrentThreads;
+		params[index].iRelease = EFalse;
+		params[index].iBuffer = NULL;
+		}
+	RunThreadsL(params, KConcurrentThreads);
+	for (TInt index = 0; index < KConcurrentThreads; index++)
+		{
+		test(params[index].iBuffer != ownBuffer && params[index].iBuffer != targetBuffer);
+		for (TInt previous = 0; previous < index; previous++)
+			test(params[index].iBuffer != params[previous].iBuffer);
+		}
+
+	// Threads that release their buffers leave the entries for other threads.
+	TThreadParams released = params[KConcurrentThreads];
+	released.iPattern = 0xff000000;
+	released.iRelease = ETrue;
+	for (TInt count = 0; count < KMaxScanLineBufferThreads; count++)
+		{
+		released.iBuffer = NULL;
+		RunThreadsL(&released, 1);
+		test(released.iBuffer != ownBuffer && released.iBuffer != targetBuffer);
+		}
+
+	// Once every entry is taken, threads get the buffer of the wrapped device.
+	const TInt remaining = KMaxScanLineBufferThreads - KConcurrentThreads - 1;
+	for (TInt index = KConcurrentThreads; index < KMaxScanLineBufferThreads; index++)
+		{
+		RunThreadsL(params + index, 1);
+		if (index < KConcurrentThreads + remaining)
+			test(params[index].iBuffer != targetBuffer);
+		else
+			test(params[index].iBuffer == targetBuffer);
+		}
+
+	// A released buffer goes to the next thread.
+	device->ReleaseThreadBuffer();
+	TThreadParams next = params[KConcurrentThreads];
+	next.iBuffer = NULL;
+	RunThreadsL(&next, 1);
+	test(next.iBuffer == ownBuffer);
+	test(device->ScanLineBuffer() == targetBuffer);
+
+	CleanupStack::PopAndDestroy(3, bits);
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	test.Start(_L("Buffer pool"));
+	TestPool();
+	test.Next(_L("Reuse of arena devices"));
+	TestArenaL();
+	test.Next(_L("State of reused devices"));
+	TestResetL();
+	test.Next(_L("Scan line buffers of threads"));
+	TestThreadsL();
+	test.End();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
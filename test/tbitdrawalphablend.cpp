@@ -0,0 +1,304 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks that every alpha blending kernel the running CPU supports gives the same result as the
+// scalar kernels. Lines of random pixels are blended over random masks, made of runs of
+// transparent, opaque and partly transparent values, for every span length from 0 to KMaxLength,
+// which covers several whole vectors of every implementation and every possible tail. Pixels
+// beyond the end of the span must be left unchanged.
+// The premultiplied src-over kernels of every implementation, the scalar ones included, are
+// checked against the per-pixel formula documented by BlendPremultipliedLine().
+//
+// Usage: tbitdrawalphablend
+// The process panics at the first difference, after printing the kernel, mode and length.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "bitdraw.h"
+#include "BitDrawAlphaBlend.h"
+
+LOCAL_D RTest test(_L("TBitDrawAlphaBlend"));
+
+/** Longest span checked: 8 AVX2 or NEON vectors of 8 pixels and the longest tail. */
+const TInt KMaxLength = 67;
+/** Random spans checked for each length. */
+const TInt KSpansPerLength = 32;
+/** Pixels after the end of each span that must be left unchanged. */
+const TInt KGuardPixels = 4;
+/** Maximum offset of a span from the start of its buffer, so that spans are not all aligned. */
+const TInt KMaxOffset = 3;
+const TInt KBufferPixels = KMaxOffset + KMaxLength + KGuardPixels;
+
+LOCAL_D const TText* const KImplementationNames[] =
+	{
+	_S("Scalar"), _S("SSE2"), _S("AVX2"), _S("NEON")
+	};
+
+/** Destination modes checked. */
+LOCAL_D const TDisplayMode KBlendModes[] =
+	{
+	EColor64K, EColor16MU, EColor16MA, EColor16MAP
+	};
+
+/** Destination modes of the premultiplied kernels. */
+LOCAL_D const TDisplayMode KPremultipliedModes[] =
+	{
+	EColor16MU, EColor16MAP
+	};
+
+LOCAL_D TInt64 TheSeed = 0x5eed1234;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C void FillRandom(TAny* aBuffer, TInt aBytes)
+	{
+	TUint8* byte = static_cast<TUint8*>(aBuffer);
+	for (TInt index = 0; index < aBytes; index++)
+		byte[index] = TUint8(Random() >> 8);
+	}
+
+/**
+Fills a mask with runs of 0, of 255 and of random values, so that the kernels take both their
+copy and their blend paths, and switch between them inside a vector.
+*/
+LOCAL_C void FillMask(TUint8* aMask, TInt aLength)
+	{
+	TInt index = 0;
+	while (index < aLength)
+		{
+		const TInt kind = Random() % 3;
+		const TInt run = 1 + Random() % 12;
+		const TInt end = Min(index + run, aLength);
+		for (; index < end; index++)
+			aMask[index] = TUint8(kind == 0 ? 0 : kind == 1 ? 0xff : Random() >> 8);
+		}
+	}
+
+/**
+Checks one span: aDest is blended by the scalar kernels and by aKernels, starting from the same
+pixels, and the two results must be identical, including the guard pixels.
+@param aInPlace If ETrue the destination is also the background, as for the three-buffer
+				WriteRgbAlphaLine; otherwise the background is a separate line.
+@param aColor	If ETrue BlendColor() is checked, otherwise BlendLine().
+*/
+LOCAL_C TBool CheckSpan(const TAlphaBlendSpan& aScalar, const TAlphaBlendSpan& aKernels, TDisplayMode aMode,
+						TInt aLength, TBool aInPlace, TBool aColor)
+	{
+	const TInt bytesPerPixel = aMode == EColor64K ? 2 : 4;
+	const TInt offset = Random() % (KMaxOffset + 1);
+	TUint32 src[KBufferPixels];
+	TUint32 background[KBufferPixels];
+	TUint32 expected[KBufferPixels];
+	TUint32 actual[KBufferPixels];
+	TUint8 mask[KBufferPixels];
+	FillRandom(src, sizeof(src));
+	FillRandom(background, sizeof(background));
+	FillRandom(expected, sizeof(expected));
+	FillMask(mask, KBufferPixels);
+	Mem::Copy(actual, expected, sizeof(expected));
+	const TRgb color(Random());
+	TUint8* expectedStart = reinterpret_cast<TUint8*>(expected) + offset * bytesPerPixel;
+	TUint8* actualStart = reinterpret_cast<TUint8*>(actual) + offset * bytesPerPixel;
+	const TUint8* srcStart = reinterpret_cast<const TUint8*>(src + offset);
+	const TUint8* maskStart = mask + offset;
+	if (aColor)
+		{
+		aScalar.BlendColor(aMode, expectedStart, color, maskStart, aLength);
+		aKernels.BlendColor(aMode, actualStart, color, maskStart, aLength);
+		}
+	else if (aInPlace)
+		{
+		aScalar.BlendLine(aMode, expectedStart, srcStart, expectedStart, maskStart, aLength);
+		aKernels.BlendLine(aMode, actualStart, srcStart, actualStart, maskStart, aLength);
+		}
+	else
+		{
+		const TUint8* backgroundStart = reinterpret_cast<const TUint8*>(background) + offset * bytesPerPixel;
+		aScalar.BlendLine(aMode, expectedStart, srcStart, backgroundStart, maskStart, aLength);
+		aKernels.BlendLine(aMode, actualStart, srcStart, backgroundStart, maskStart, aLength);
+		}
+	return Mem::Compare(reinterpret_cast<const TUint8*>(expected), sizeof(expected),
+						reinterpret_cast<const TUint8*>(actual), sizeof(actual)) == 0;
+	}
+
+/**
+Returns a random premultiplied pixel. Runs of transparent and of opaque pixels are produced
+by the caller; one pixel in 16 has colour channels greater than its alpha, which the kernels
+must saturate rather than wrap.
+*/
+LOCAL_C TUint32 RandomPremultiplied()
+	{
+	const TUint32 pixel = Random();
+	if (Random() % 16 == 0)
+		return pixel;
+	return TRgb(pixel & 0x00ffffff, pixel >> 24)._Color16MAP();
+	}
+
+/**
+Fills a line of premultiplied source pixels with runs of transparent, opaque and partly
+transparent pixels.
+*/
+LOCAL_C void FillPremultiplied(TUint32* aPixels, TInt aLength)
+	{
+	TInt index = 0;
+	while (index < aLength)
+		{
+		const TInt kind = Random() % 3;
+		const TInt run = 1 + Random() % 12;
+		const TInt end = Min(index + run, aLength);
+		for (; index < end; index++)
+			aPixels[index] = kind == 0 ? 0 : kind == 1 ? Random() | 0xff000000 : RandomPremultiplied();
+		}
+	}
+
+/**
+Src-over of one premultiplied pixel as documented by BlendPremultipliedLine():
+Cs + Cd * (255 - As) / 255 on every channel, saturated, with the alpha of an EColor16MU
+destination set to 0xFF.
+*/
+LOCAL_C TUint32 OverPixel(TDisplayMode aMode, TUint32 aSrc, TUint32 aDest)
+	{
+	const TUint32 inv = 255 - (aSrc >> 24);
+	TUint32 result = 0;
+	for (TInt shift = 0; shift < 32; shift += 8)
+		{
+		const TUint32 channel = ((aSrc >> shift) & 0xff) + Div255(((aDest >> shift) & 0xff) * inv);
+		result |= Min(channel, TUint32(0xff)) << shift;
+		}
+	return aMode == EColor16MU ? result | 0xff000000 : result;
+	}
+
+/**
+Checks one span of BlendPremultipliedLine() against OverPixel(), including the guard pixels.
+*/
+LOCAL_C TBool CheckPremultipliedSpan(const TAlphaBlendSpan& aKernels, TDisplayMode aMode, TInt aLength)
+	{
+	const TInt offset = Random() % (KMaxOffset + 1);
+	TUint32 src[KBufferPixels];
+	TUint32 expected[KBufferPixels];
+	TUint32 actual[KBufferPixels];
+	FillPremultiplied(src, KBufferPixels);
+	for (TInt index = 0; index < KBufferPixels; index++)
+		expected[index] = aMode == EColor16MAP ? RandomPremultiplied() : Random();
+	Mem::Copy(actual, expected, sizeof(expected));
+	for (TInt index = offset; index < offset + aLength; index++)
+		expected[index] = OverPixel(aMode, src[index], expected[index]);
+	aKernels.BlendPremultipliedLine(aMode, actual + offset, src + offset, aLength);
+	return Mem::Compare(reinterpret_cast<const TUint8*>(expected), sizeof(expected),
+						reinterpret_cast<const TUint8*>(actual), sizeof(actual)) == 0;
+	}
+
+/**
+Checks BlendPremultipliedLine() of aImplementation in every destination mode and for every
+span length.
+*/
+LOCAL_C void TestPremultiplied(TBlendImplementation aImplementation)
+	{
+	const TAlphaBlendSpan kernels(aImplementation);
+	test(kernels.Implementation() == aImplementation);
+	const TInt numModes = sizeof(KPremultipliedModes) / sizeof(KPremultipliedModes[0]);
+	for (TInt index = 0; index < numModes; index++)
+		{
+		const TDisplayMode mode = KPremultipliedModes[index];
+		test(TAlphaBlendSpan::IsPremultipliedModeSupported(mode));
+		for (TInt length = 0; length <= KMaxLength; length++)
+			{
+			for (TInt span = 0; span < KSpansPerLength; span++)
+				{
+				const TBool same = CheckPremultipliedSpan(kernels, mode, length);
+				if (!same)
+					test.Printf(_L("%s premultiplied: mode %d, length %d\n"),
+								KImplementationNames[aImplementation], mode, length);
+				test(same);
+				}
+			}
+		}
+	}
+
+/**
+Checks BlendLine() and BlendColor() of aImplementation against the scalar kernels in every
+destination mode and for every span length.
+*/
+LOCAL_C void TestImplementation(TBlendImplementation aImplementation)
+	{
+	const TAlphaBlendSpan scalar(EBlendImplScalar);
+	const TAlphaBlendSpan kernels(aImplementation);
+	test(kernels.Implementation() == aImplementation);
+	const TInt numModes = sizeof(KBlendModes) / sizeof(KBlendModes[0]);
+	for (TInt index = 0; index < numModes; index++)
+		{
+		const TDisplayMode mode = KBlendModes[index];
+		for (TInt length = 0; length <= KMaxLength; length++)
+			{
+			for (TInt span = 0; span < KSpansPerLength; span++)
+				{
+				for (TInt variant = 0; variant < 3; variant++)
+					{
+					const TBool same = CheckSpan(scalar, kernels, mode, length, variant == 1, variant == 2);
+					if (!same)
+						test.Printf(_L("%s: mode %d, length %d, variant %d\n"),
+									KImplementationNames[aImplementation], mode, length, variant);
+					test(same);
+					}
+				}
+			}
+		}
+	}
+
+LOCAL_C void DoTests()
+	{
+	test.Start(_L("Scalar kernels are always available"));
+	test(TAlphaBlendSpan::IsImplementationAvailable(EBlendImplScalar));
+	test(TAlphaBlendSpan(EBlendImplScalar).Implementation() == EBlendImplScalar);
+
+	test.Next(_L("Scalar premultiplied kernels against src-over"));
+	test(!TAlphaBlendSpan::IsPremultipliedModeSupported(EColor16MA));
+	test(!TAlphaBlendSpan::IsPremultipliedModeSupported(EColor64K));
+	TestPremultiplied(EBlendImplScalar);
+
+	const TBlendImplementation implementations[] = {EBlendImplSse2, EBlendImplAvx2, EBlendImplNeon};
+	const TInt numImplementations = sizeof(implementations) / sizeof(implementations[0]);
+	for (TInt index = 0; index < numImplementations; index++)
+		{
+		const TBlendImplementation implementation = implementations[index];
+		if (!TAlphaBlendSpan::IsImplementationAvailable(implementation))
+			{
+			// An unavailable implementation falls back to the scalar kernels.
+			test(TAlphaBlendSpan(implementation).Implementation() == EBlendImplScalar);
+			test.Printf(_L("%s kernels not available\n"), KImplementationNames[implementation]);
+			continue;
+			}
+		test.Next(_L("Vector kernels against scalar kernels"));
+		test.Printf(_L("%s\n"), KImplementationNames[implementation]);
+		TestImplementation(implementation);
+		TestPremultiplied(implementation);
+		}
+	test.End();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	DoTests();
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
@@ -0,0 +1,223 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks every converter of TScanLineConverter against the conversion it is documented to
+// be equivalent to: a copy of the pixel values between two scan lines of the same mode, and
+// otherwise a conversion of each pixel through TRgb, with the TPixelFormat traits. Random
+// source lines are converted for every span length from 0 to KMaxLength, at source and
+// destination offsets that are not byte or vector aligned. Pixels outside the destination
+// span must be left unchanged.
+//
+// Usage: tbitdrawconvert
+// The process panics at the first difference, after printing the modes and the span.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "bitdraw.h"
+#include "BitDrawConvert.h"
+#include "BitDrawPixelFormat.h"
+
+LOCAL_D RTest test(_L("TBitDrawConvert"));
+
+/** Longest span checked: several vectors of every converter and the longest tail. */
+const TInt KMaxLength = 67;
+/** Random spans checked for each pair of modes and each length. */
+const TInt KSpansPerLength = 4;
+/** Maximum pixel offset of a span in its scan line; covers every position within a byte. */
+const TInt KMaxOffset = 9;
+/** Bytes of each scan line: KMaxOffset + KMaxLength 32bpp pixels and a guard. */
+const TInt KLineBytes = (KMaxOffset + KMaxLength + 4) * 4;
+
+/** Reference conversion of one pixel of a scan line to TRgb, and of TRgb to a pixel. */
+typedef TUint32 (*TReadPixelFunction)(const TAny* aScanLine, TInt aX);
+typedef void (*TWritePixelFunction)(TAny* aScanLine, TInt aX, TUint32 aPixel);
+typedef TRgb (*TReadRgbFunction)(const TAny* aScanLine, TInt aX);
+typedef void (*TWriteRgbFunction)(TAny* aScanLine, TInt aX, TRgb aColor);
+
+template <TDisplayMode MODE>
+LOCAL_C TUint32 ReadPixel(const TAny* aScanLine, TInt aX)
+	{
+	return TPixelFormat<MODE>::Read(aScanLine, aX);
+	}
+
+template <TDisplayMode MODE>
+LOCAL_C void WritePixel(TAny* aScanLine, TInt aX, TUint32 aPixel)
+	{
+	TPixelFormat<MODE>::Write(aScanLine, aX, aPixel);
+	}
+
+template <TDisplayMode MODE>
+LOCAL_C TRgb ReadRgb(const TAny* aScanLine, TInt aX)
+	{
+	return TPixelFormat<MODE>::ToRgb(TPixelFormat<MODE>::Read(aScanLine, aX));
+	}
+
+template <TDisplayMode MODE>
+LOCAL_C void WriteRgb(TAny* aScanLine, TInt aX, TRgb aColor)
+	{
+	TPixelFormat<MODE>::Write(aScanLine, aX, TPixelFormat<MODE>::FromRgb(aColor));
+	}
+
+/**
+Per-pixel reference functions of one display mode.
+*/
+struct TModeFunctions
+	{
+	TDisplayMode iMode;
+	const TText* iName;
+	TReadPixelFunction iReadPixel;
+	TWritePixelFunction iWritePixel;
+	TReadRgbFunction iReadRgb;
+	TWriteRgbFunction iWriteRgb;
+	};
+
+#define MODE_FUNCTIONS(aMode) {aMode, _S(#aMode), ReadPixel<aMode>, WritePixel<aMode>, ReadRgb<aMode>, WriteRgb<aMode>}
+
+LOCAL_D const TModeFunctions KModes[] =
+	{
+	MODE_FUNCTIONS(EGray2),
+	MODE_FUNCTIONS(EGray4),
+	MODE_FUNCTIONS(EGray16),
+	MODE_FUNCTIONS(EGray256),
+	MODE_FUNCTIONS(EColor16),
+	MODE_FUNCTIONS(EColor256),
+	MODE_FUNCTIONS(EColor64K),
+	MODE_FUNCTIONS(EColor16M),
+	MODE_FUNCTIONS(ERgb),
+	MODE_FUNCTIONS(EColor4K),
+	MODE_FUNCTIONS(EColor16MU),
+	MODE_FUNCTIONS(EColor16MA),
+	MODE_FUNCTIONS(EColor16MAP)
+	};
+
+#undef MODE_FUNCTIONS
+
+const TInt KModeCount = sizeof(KModes) / sizeof(KModes[0]);
+
+LOCAL_D TInt64 TheSeed = 0x5eed1234;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C void FillRandom(TAny* aBuffer, TInt aBytes)
+	{
+	TUint8* byte = static_cast<TUint8*>(aBuffer);
+	for (TInt index = 0; index < aBytes; index++)
+		byte[index] = TUint8(Random() >> 8);
+	}
+
+/**
+Fills a source scan line with random pixels that are valid in its display mode: EColor4K
+pixels have the top 4 bits clear and EColor16MAP pixels are premultiplied. Runs of identical
+pixels are included, as some converters look them up once per run.
+*/
+LOCAL_C void FillSource(const TModeFunctions& aMode, TAny* aScanLine, TInt aPixels)
+	{
+	FillRandom(aScanLine, KLineBytes);
+	for (TInt x = 0; x < aPixels; x++)
+		{
+		if (x > 0 && Random() % 4 == 0)
+			aMode.iWritePixel(aScanLine, x, aMode.iReadPixel(aScanLine, x - 1));
+		else if (aMode.iMode == EColor4K)
+			aMode.iWritePixel(aScanLine, x, aMode.iReadPixel(aScanLine, x) & 0x0fff);
+		else if (aMode.iMode == EColor16MAP)
+			{
+			const TUint32 pixel = aMode.iReadPixel(aScanLine, x);
+			aMode.iWriteRgb(aScanLine, x, TRgb(pixel & 0x00ffffff, pixel >> 24));
+			}
+		}
+	}
+
+/**
+Checks the converter from aSrc to aDest on every span length.
+*/
+LOCAL_C void TestPair(const TModeFunctions& aSrc, const TModeFunctions& aDest)
+	{
+	const TConvertSpanFunction function = TScanLineConverter::Function(aSrc.iMode, aDest.iMode);
+	test(function != NULL);
+	TUint32 src[KLineBytes / 4];
+	TUint32 expected[KLineBytes / 4];
+	TUint32 actual[KLineBytes / 4];
+	for (TInt length = 0; length <= KMaxLength; length++)
+		{
+		for (TInt span = 0; span < KSpansPerLength; span++)
+			{
+			const TInt srcX = Random() % (KMaxOffset + 1);
+			const TInt destX = Random() % (KMaxOffset + 1);
+			FillSource(aSrc, src, KMaxOffset + KMaxLength);
+			FillRandom(expected, KLineBytes);
+			Mem::Copy(actual, expected, KLineBytes);
+			for (TInt index = 0; index < length; index++)
+				{
+				if (aSrc.iMode == aDest.iMode)
+					aDest.iWritePixel(expected, destX + index, aSrc.iReadPixel(src, srcX + index));
+				else
+					aDest.iWriteRgb(expected, destX + index, aSrc.iReadRgb(src, srcX + index));
+				}
+			function(src, srcX, actual, destX, length);
+			const TBool same = Mem::Compare(reinterpret_cast<const TUint8*>(expected), KLineBytes,
+											reinterpret_cast<const TUint8*>(actual), KLineBytes) == 0;
+			if (!same)
+				test.Printf(_L("%s to %s: source %d, destination %d, length %d\n"),
+							aSrc.iName, aDest.iName, srcX, destX, length);
+			test(same);
+			}
+		}
+	}
+
+LOCAL_C void DoTests()
+	{
+	test.Start(_L("Supported display modes"));
+	test(!TScanLineConverter::IsDisplayModeSupported(ENone));
+	test(!TScanLineConverter::IsDisplayModeSupported(EColorLast));
+	test(TScanLineConverter::Function(ENone, EColor16MU) == NULL);
+	test(TScanLineConverter::Function(EColor16MU, ENone) == NULL);
+	for (TInt index = 0; index < KModeCount; index++)
+		test(TScanLineConverter::IsDisplayModeSupported(KModes[index].iMode));
+
+	test.Next(_L("Converters against per-pixel conversion"));
+	for (TInt srcIndex = 0; srcIndex < KModeCount; srcIndex++)
+		{
+		for (TInt destIndex = 0; destIndex < KModeCount; destIndex++)
+			TestPair(KModes[srcIndex], KModes[destIndex]);
+		}
+
+	test.Next(_L("Convert() uses the converter of the pair"));
+	TUint32 src[KLineBytes / 4];
+	TUint32 expected[KLineBytes / 4];
+	TUint32 actual[KLineBytes / 4];
+	FillSource(KModes[0], src, KMaxOffset + KMaxLength);
+	FillRandom(expected, KLineBytes);
+	Mem::Copy(actual, expected, KLineBytes);
+	TScanLineConverter::Function(EGray2, EColor64K)(src, 3, expected, 1, KMaxLength);
+	TScanLineConverter::Convert(EGray2, src, 3, EColor64K, actual, 1, KMaxLength);
+	test(Mem::Compare(reinterpret_cast<const TUint8*>(expected), KLineBytes,
+					  reinterpret_cast<const TUint8*>(actual), KLineBytes) == 0);
+	test.End();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	DoTests();
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
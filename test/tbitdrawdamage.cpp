@@ -0,0 +1,387 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks TDamageRegion and CDamageTrackingDrawDevice.
+//	- The merge cost: rectangles are merged exactly when the pixels their bounding rectangle
+//	  wastes, times the pixel cost, do not exceed the rectangle cost. Contained rectangles and
+//	  rectangles that abut along a whole edge are always merged, and a rectangle that grows by
+//	  merging absorbs the rectangles it now reaches.
+//	- The cap: the region never holds more than MaxRects() rectangles, the pair that wastes the
+//	  fewest pixels is merged to stay within it, SetMaxRects() merges rectangles already in the
+//	  region, and GetRegion() falls back to the bounding rectangle if the TRegion is too small.
+//	- Random rectangles under random costs and caps: every added pixel stays covered and, while
+//	  the cap has not been reached, no two rectangles of the region should have been merged.
+//	- Random primitives on a damage tracking device over a bitmap device: every pixel that
+//	  changed since the last Update() is covered by the damage, within the cap.
+//
+// Usage: tbitdrawdamage
+// The process panics at the first failure, after printing the rectangles involved.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "BitDrawDamage.h"
+
+LOCAL_D RTest test(_L("TBitDrawDamage"));
+
+/** Size of the area random rectangles are taken from. */
+const TInt KAreaSize = 64;
+const TInt KIterations = 400;
+const TInt KRectsPerRegion = 40;
+/** Size of the device checked. */
+const TInt KDeviceWidth = 96;
+const TInt KDeviceHeight = 80;
+
+LOCAL_D TInt64 TheSeed = 0x5eedda3a;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C TInt Random(TInt aLow, TInt aHigh)
+	{
+	return aLow + TInt(Random() % TUint32(aHigh - aLow));
+	}
+
+LOCAL_C TRect RandomRect(TInt aWidth, TInt aHeight)
+	{
+	const TInt x = Random(0, aWidth);
+	const TInt y = Random(0, aHeight);
+	// Mostly small rectangles, as drawn by widgets, and some large ones.
+	const TInt maxSize = Random() % 4 ? 12 : Max(aWidth, aHeight);
+	return TRect(x, y, Min(aWidth, x + Random(1, maxSize + 1)), Min(aHeight, y + Random(1, maxSize + 1)));
+	}
+
+LOCAL_C TInt64 Area(const TRect& aRect)
+	{
+	return TInt64(aRect.Width()) * aRect.Height();
+	}
+
+/**
+@return The pixels the bounding rectangle of aRect1 and aRect2 covers that neither does.
+*/
+LOCAL_C TInt64 WastedPixels(const TRect& aRect1, const TRect& aRect2)
+	{
+	TRect bounds(aRect1);
+	bounds.BoundingRect(aRect2);
+	TRect overlap(aRect1);
+	overlap.Intersection(aRect2);
+	return Area(bounds) - Area(aRect1) - Area(aRect2) + (aRect1.Intersects(aRect2) ? Area(overlap) : 0);
+	}
+
+LOCAL_C TBool Covers(const TDamageRegion& aRegion, TInt aX, TInt aY)
+	{
+	const TRect* rect = aRegion.RectangleList();
+	for (TInt count = aRegion.Count(); count > 0; count--, rect++)
+		{
+		if (rect->Contains(TPoint(aX, aY)))
+			return ETrue;
+		}
+	return EFalse;
+	}
+
+LOCAL_C TBool HasRect(const TDamageRegion& aRegion, const TRect& aRect)
+	{
+	const TRect* rect = aRegion.RectangleList();
+	for (TInt count = aRegion.Count(); count > 0; count--, rect++)
+		{
+		if (*rect == aRect)
+			return ETrue;
+		}
+	return EFalse;
+	}
+
+LOCAL_C void PrintRegion(const TDamageRegion& aRegion)
+	{
+	const TRect* rect = aRegion.RectangleList();
+	for (TInt count = aRegion.Count(); count > 0; count--, rect++)
+		test.Printf(_L("  [%d,%d %d,%d]\n"), rect->iTl.iX, rect->iTl.iY, rect->iBr.iX, rect->iBr.iY);
+	}
+
+/**
+The cost decides every merge, at its boundary included.
+*/
+LOCAL_C void TestCost()
+	{
+	TDamageRegionFix<KMaxDamageRects> region;
+	const TRect left(0, 0, 10, 10);
+	// 10 pixels apart: the bounding rectangle wastes 10 x 10 pixels.
+	const TRect right(20, 0, 30, 10);
+	test(WastedPixels(left, right) == 100);
+
+	region.SetCost(TDamageCost(1, 100));
+	region.AddRect(left);
+	region.AddRect(right);
+	test(region.Count() == 1 && region.RectangleList()[0] == TRect(0, 0, 30, 10));
+	region.Clear();
+	test(region.IsEmpty());
+	region.SetCost(TDamageCost(1, 99));
+	region.AddRect(left);
+	region.AddRect(right);
+	test(region.Count() == 2 && HasRect(region, left) && HasRect(region, right));
+	region.Clear();
+	region.SetCost(TDamageCost(2, 200));
+	region.AddRect(left);
+	region.AddRect(right);
+	test(region.Count() == 1);
+	region.Clear();
+	region.SetCost(TDamageCost(2, 199));
+	region.AddRect(left);
+	region.AddRect(right);
+	test(region.Count() == 2);
+
+	// Rectangles that waste nothing are merged even when pixels cost more than rectangles.
+	region.Clear();
+	region.SetCost(TDamageCost(1, 0));
+	region.AddRect(left);
+	region.AddRect(TRect(2, 2, 5, 5));
+	test(region.Count() == 1 && region.RectangleList()[0] == left);
+	region.AddRect(TRect(-5, -5, 15, 15));
+	test(region.Count() == 1 && region.RectangleList()[0] == TRect(-5, -5, 15, 15));
+	region.AddRect(TRect(15, -5, 20, 15));
+	test(region.Count() == 1 && region.RectangleList()[0] == TRect(-5, -5, 20, 15));
+	region.AddRect(TRect(-5, 15, 20, 16));
+	test(region.Count() == 1 && region.RectangleList()[0] == TRect(-5, -5, 20, 16));
+	// Overlapping rectangles waste the two corners of their bounding rectangle.
+	region.AddRect(TRect(10, 10, 30, 30));
+	test(region.Count() == 2);
+	test(WastedPixels(TRect(-5, -5, 20, 16), TRect(10, 10, 30, 30)) == 10 * 15 + 15 * 14);
+	// Empty rectangles are ignored.
+	region.AddRect(TRect(50, 50, 50, 60));
+	test(region.Count() == 2);
+
+	// A rectangle that bridges two others absorbs both.
+	region.Clear();
+	region.AddRect(TRect(0, 0, 10, 10));
+	region.AddRect(TRect(20, 0, 30, 10));
+	test(region.Count() == 2);
+	region.AddRect(TRect(10, 0, 20, 10));
+	test(region.Count() == 1 && region.RectangleList()[0] == TRect(0, 0, 30, 10));
+	}
+
+/**
+The cap merges the pair that wastes the fewest pixels.
+*/
+LOCAL_C void TestCap()
+	{
+	TDamageRegionFix<KMaxDamageRects> region;
+	region.SetCost(TDamageCost(1, 0));
+	test(region.MaxRects() == KMaxDamageRects);
+	region.SetMaxRects(2);
+	test(region.MaxRects() == 2);
+	region.AddRect(TRect(0, 0, 10, 10));
+	region.AddRect(TRect(100, 0, 110, 10));
+	// 2 pixels from the first: merging the new rectangle with it wastes the least.
+	region.AddRect(TRect(12, 0, 22, 10));
+	test(region.Count() == 2);
+	test(HasRect(region, TRect(0, 0, 22, 10)) && HasRect(region, TRect(100, 0, 110, 10)));
+	// 1 pixel from the second: merging the new rectangle with it wastes the least.
+	region.AddRect(TRect(111, 0, 121, 10));
+	test(region.Count() == 2);
+	test(HasRect(region, TRect(0, 0, 22, 10)) && HasRect(region, TRect(100, 0, 121, 10)));
+	// Far from both: the two existing rectangles are merged instead.
+	region.AddRect(TRect(0, 200, 10, 210));
+	test(region.Count() == 2);
+	test(HasRect(region, TRect(0, 0, 121, 10)) && HasRect(region, TRect(0, 200, 10, 210)));
+
+	// Lowering the cap merges what is already there.
+	region.Clear();
+	region.SetMaxRects(4);
+	region.AddRect(TRect(0, 0, 10, 10));
+	region.AddRect(TRect(40, 0, 50, 10));
+	region.AddRect(TRect(0, 40, 10, 50));
+	// 2 pixels from the third: the cheapest pair to merge.
+	region.AddRect(TRect(12, 40, 50, 50));
+	test(region.Count() == 4);
+	region.SetMaxRects(3);
+	test(region.Count() == 3);
+	test(HasRect(region, TRect(0, 0, 10, 10)) && HasRect(region, TRect(40, 0, 50, 10)));
+	test(HasRect(region, TRect(0, 40, 50, 50)));
+	region.SetMaxRects(1);
+	test(region.Count() == 1 && region.RectangleList()[0] == TRect(0, 0, 50, 50));
+
+	// A TRegion too small for the rectangles receives their bounding rectangle.
+	region.Clear();
+	region.SetMaxRects(KMaxDamageRects);
+	region.AddRect(TRect(0, 0, 10, 10));
+	region.AddRect(TRect(40, 0, 50, 10));
+	region.AddRect(TRect(0, 40, 10, 50));
+	TRegionFix<2> small;
+	region.GetRegion(small);
+	test(small.Count() == 1 && small.RectangleList()[0] == TRect(0, 0, 50, 50));
+	TRegionFix<KMaxDamageRects> large;
+	region.GetRegion(large);
+	test(large.Count() == 3);
+	}
+
+/**
+Random rectangles: everything added stays covered, the cap holds, and below it no two rectangles
+of the region are left that the cost would merge.
+*/
+LOCAL_C void TestRandom()
+	{
+	TDamageRegionFix<KMaxDamageRects> region;
+	for (TInt iteration = 0; iteration < KIterations; iteration++)
+		{
+		const TDamageCost cost(Random(1, 4), Random() % 3 ? Random(0, 200) : 0);
+		const TInt maxRects = Random(1, KMaxDamageRects + 1);
+		region.Clear();
+		region.SetCost(cost);
+		region.SetMaxRects(maxRects);
+		TRect added[KRectsPerRegion];
+		TBool capped = EFalse;
+		for (TInt index = 0; index < KRectsPerRegion; index++)
+			{
+			added[index] = RandomRect(KAreaSize, KAreaSize);
+			region.AddRect(added[index]);
+			test(region.Count() <= maxRects);
+			capped = capped || region.Count() == maxRects;
+			for (TInt previous = 0; previous <= index; previous++)
+				{
+				const TRect& rect = added[previous];
+				for (TInt y = rect.iTl.iY; y < rect.iBr.iY; y++)
+					{
+					for (TInt x = rect.iTl.iX; x < rect.iBr.iX; x++)
+						{
+						if (!Covers(region, x, y))
+							{
+							test.Printf(_L("iteration %d: [%d,%d] not covered by\n"), iteration, x, y);
+							PrintRegion(region);
+							test(EFalse);
+							}
+						}
+					}
+				}
+			if (capped)
+				continue;
+			const TRect* rects = region.RectangleList();
+			for (TInt first = 0; first < region.Count(); first++)
+				{
+				for (TInt second = first + 1; second < region.Count(); second++)
+					{
+					if (cost.ShouldMerge(WastedPixels(rects[first], rects[second])))
+						{
+						test.Printf(_L("iteration %d: cost %d/%d, rectangles %d and %d not merged in\n"),
+									iteration, cost.iPixelCost, cost.iRectCost, first, second);
+						PrintRegion(region);
+						test(EFalse);
+						}
+					}
+				}
+			}
+		}
+	}
+
+/**
+Pixels changed by random primitives are covered by the damage of the tracking device.
+*/
+LOCAL_C void TestDeviceL()
+	{
+	const TSize size(KDeviceWidth, KDeviceHeight);
+	const TInt stride = size.iWidth * 4;
+	TUint8* memory = static_cast<TUint8*>(User::AllocZL(stride * size.iHeight));
+	CleanupStack::PushL(memory);
+	CFbsDrawDevice* target = CFbsDrawDevice::NewBitmapDeviceL(size, EColor16MU, stride);
+	CleanupStack::PushL(target);
+	target->SetBits(memory);
+	CDamageTrackingDrawDevice* device = CDamageTrackingDrawDevice::NewL(target);
+	CleanupStack::Pop(target);
+	CleanupStack::PushL(device);
+	TUint32* shown = static_cast<TUint32*>(User::AllocL(size.iWidth * size.iHeight * sizeof(TUint32)));
+	CleanupStack::PushL(shown);
+	TUint32 buffer[KDeviceWidth];
+	TUint8 mask[KDeviceWidth];
+	for (TInt iteration = 0; iteration < KIterations / 4; iteration++)
+		{
+		device->SetDamageCost(TDamageCost(1, Random(0, 512)));
+		device->SetMaxDamageRects(Random(1, KMaxDamageRects + 1));
+		device->Update();
+		test(device->Damage().IsEmpty());
+		for (TInt y = 0; y < size.iHeight; y++)
+			for (TInt x = 0; x < size.iWidth; x++)
+				shown[y * size.iWidth + x] = device->ReadPixel(x, y).Internal();
+		for (TInt index = 0; index < KDeviceWidth; index++)
+			{
+			buffer[index] = Random() | 0xff000000;
+			mask[index] = TUint8(Random());
+			}
+		for (TInt count = Random(1, 12); count > 0; count--)
+			{
+			const TRect rect(RandomRect(size.iWidth, size.iHeight));
+			const TRgb color(Random() & 0xff, Random() & 0xff, Random() & 0xff);
+			switch (Random() % 5)
+				{
+			case 0:
+				device->WriteRgbMulti(rect.iTl.iX, rect.iTl.iY, rect.Width(), rect.Height(), color,
+									  CGraphicsContext::EDrawModePEN);
+				break;
+			case 1:
+				device->WriteLine(rect.iTl.iX, rect.iTl.iY, rect.Width(), buffer, CGraphicsContext::EDrawModePEN);
+				break;
+			case 2:
+				device->WriteBinary(rect.iTl.iX, rect.iTl.iY, buffer, Min(rect.Width(), 32), rect.Height(), color,
+									CGraphicsContext::EDrawModePEN);
+				break;
+			case 3:
+				device->WriteRgbAlphaMulti(rect.iTl.iX, rect.iTl.iY, rect.Width(), color, mask);
+				break;
+			default:
+				device->ShadowArea(rect);
+				break;
+				}
+			}
+		const TDamageRegion& damage = device->Damage();
+		test(damage.Count() <= damage.MaxRects());
+		for (TInt y = 0; y < size.iHeight; y++)
+			{
+			for (TInt x = 0; x < size.iWidth; x++)
+				{
+				if (device->ReadPixel(x, y).Internal() != shown[y * size.iWidth + x] && !Covers(damage, x, y))
+					{
+					test.Printf(_L("iteration %d: [%d,%d] changed outside\n"), iteration, x, y);
+					PrintRegion(damage);
+					test(EFalse);
+					}
+				}
+			}
+		}
+	CleanupStack::PopAndDestroy(3, memory);
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	test.Start(_L("Merge cost"));
+	TestCost();
+	test.Next(_L("Rectangle cap"));
+	TestCap();
+	test.Next(_L("Random rectangles"));
+	TestRandom();
+	test.Next(_L("Damage of a tracking device"));
+	TestDeviceL();
+	test.End();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
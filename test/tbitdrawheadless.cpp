@@ -0,0 +1,500 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks the interfaces CHeadlessScreenDevice offers itself against the primitives of a bitmap
+// device of the same display mode and size, drawing into memory of its own:
+//	- MGlyphRunDrawing against TGlyphRun::DrawWithPrimitives();
+//	- MPremultipliedAlphaBlending against TPremultipliedLine::WriteWithPrimitives(), within
+//	  KPremultipliedTolerance per channel, as undoing the premultiplication rounds;
+//	- MBatchedPlotting against the TBatchedPlot WithPrimitives() functions, and ReadPixels()
+//	  against ReadPixel();
+//	- ShadowArea() against the arithmetic RShadowFadeTables documents for every pixel, with
+//	  random shadow modes and fading parameters, converted to the nearest colour of the
+//	  display mode.
+// Each call starts from the same random pixels in both devices, and every logical pixel is then
+// compared with ReadPixel(). The calls are made in the normal orientation, where the headless
+// device writes into the mapped memory, and with shadowing or a rotated orientation, where it
+// goes through the primitives of its bitmap device.
+//
+// Usage: tbitdrawheadless
+// The file /dev/shm/tbitdrawheadless is created and deleted. The process panics at the first
+// difference, after printing the function, mode and case.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include <unistd.h>
+#include "BitDrawHeadless.h"
+#include "BitDrawExtInterfaceId.h"
+#include "BitDrawPixelFormat.h"
+#include "BitDrawMapColors.h"
+
+LOCAL_D RTest test(_L("TBitDrawHeadless"));
+
+_LIT8(KScreenPath, "/dev/shm/tbitdrawheadless");
+
+const TInt KScreenNo = 0;
+const TInt KWidth = 61;
+const TInt KHeight = 47;
+/** Calls checked per function, mode and case. */
+const TInt KIterations = 60;
+/** Largest difference per channel allowed between the premultiplied paths. */
+const TInt KPremultipliedTolerance = 1;
+const TInt KMaxGlyphs = 4;
+const TInt KMaxGlyphSize = 20;
+const TInt KMaxPoints = 40;
+
+/** Display modes checked. */
+LOCAL_D const TDisplayMode KModes[] =
+	{
+	EColor256, EColor64K, EColor16MU
+	};
+
+LOCAL_D const CGraphicsContext::TDrawMode KDrawModes[] =
+	{
+	CGraphicsContext::EDrawModePEN, CGraphicsContext::EDrawModeXOR,
+	CGraphicsContext::EDrawModeAND, CGraphicsContext::EDrawModeNOTOR
+	};
+
+/**
+Functions checked.
+*/
+enum THeadlessFunction
+	{
+	EDrawGlyphRun,
+	EWriteRgbAlphaLinePremultiplied,
+	EWritePoints,
+	EWriteSpans,
+	EReadPixels,
+	EShadowArea,
+	EHeadlessFunctionCount
+	};
+
+LOCAL_D const TText* const KFunctionNames[EHeadlessFunctionCount] =
+	{
+	_S("DrawGlyphRun"), _S("WriteRgbAlphaLinePremultiplied"), _S("WritePoints"), _S("WriteSpans"), _S("ReadPixels"),
+	_S("ShadowArea")
+	};
+
+/**
+Settings the functions are checked with.
+*/
+enum THeadlessCase
+	{
+	ENormal,
+	EShadowed,
+	ERotated,
+	EHeadlessCaseCount
+	};
+
+LOCAL_D const TText* const KCaseNames[EHeadlessCaseCount] =
+	{
+	_S("normal"), _S("shadowed"), _S("rotated")
+	};
+
+LOCAL_D TInt64 TheSeed = 0x5eed4e4d;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C TInt Random(TInt aLow, TInt aHigh)
+	{
+	return aLow + TInt(Random() % TUint32(aHigh - aLow));
+	}
+
+/**
+@return An opaque colour, or a translucent one once in four times if aTranslucent is ETrue.
+*/
+LOCAL_C TRgb RandomColor(TBool aTranslucent)
+	{
+	const TInt alpha = aTranslucent && (Random() & 3) == 0 ? TInt(Random() & 0xff) : 0xff;
+	return TRgb(Random() & 0xff, Random() & 0xff, Random() & 0xff, alpha);
+	}
+
+/**
+The headless device, the bitmap device it is checked against, and the memory of the latter.
+*/
+class THeadlessDevices
+	{
+public:
+	THeadlessDevices();
+	inline TDisplayMode DisplayMode() const;
+	void CreateL(TDisplayMode aMode);
+	void Close();
+	TBool SetCase(THeadlessCase aCase);
+	void Reset();
+	TRect RandomClipRect() const;
+	TBool IsExpected(TInt aTolerance) const;
+public:
+	CHeadlessScreenDevice* iHeadless;
+	CFbsDrawDevice* iReference;
+	TUint8* iMemory;
+	TInt iMemoryBytes;
+	TSize iSize;
+	};
+
+THeadlessDevices::THeadlessDevices():
+	iHeadless(NULL),
+	iReference(NULL),
+	iMemory(NULL),
+	iMemoryBytes(0)
+	{
+	}
+
+inline TDisplayMode THeadlessDevices::DisplayMode() const
+	{
+	return iReference->DisplayMode();
+	}
+
+void THeadlessDevices::CreateL(TDisplayMode aMode)
+	{
+	iHeadless = CHeadlessScreenDevice::NewL(KScreenNo, aMode, TSize(KWidth, KHeight), KScreenPath);
+	const TInt stride = iHeadless->Header().iStride;
+	iMemoryBytes = stride * KHeight;
+	iMemory = static_cast<TUint8*>(User::AllocL(iMemoryBytes));
+	iReference = CFbsDrawDevice::NewBitmapDeviceL(TSize(KWidth, KHeight), aMode, stride);
+	iReference->SetBits(iMemory);
+	}
+
+void THeadlessDevices::Close()
+	{
+	delete iHeadless;
+	iHeadless = NULL;
+	delete iReference;
+	iReference = NULL;
+	User::Free(iMemory);
+	iMemory = NULL;
+	unlink(reinterpret_cast<const char*>(TBuf8<KMaxFileName + 1>(KScreenPath).PtrZ()));
+	}
+
+/**
+Sets the orientation and shadow mode of both devices.
+@return EFalse if the bitmap device does not support the orientation of aCase.
+*/
+TBool THeadlessDevices::SetCase(THeadlessCase aCase)
+	{
+	const CFbsDrawDevice::TOrientation orientation = aCase == ERotated ?
+		CFbsDrawDevice::EOrientationRotated90 : CFbsDrawDevice::EOrientationNormal;
+	if (!iReference->SetOrientation(orientation))
+		return EFalse;
+	test(iHeadless->SetOrientation(orientation));
+	const CFbsDrawDevice::TShadowMode shadowMode = aCase == EShadowed ?
+		CFbsDrawDevice::EShadow : CFbsDrawDevice::ENoShadow;
+	iReference->SetShadowMode(shadowMode);
+	iHeadless->SetShadowMode(shadowMode);
+	iSize = iReference->SizeInPixels();
+	test(iHeadless->SizeInPixels() == iSize);
+	return ETrue;
+	}
+
+/**
+Fills both devices with the same random pixels. For the 32bpp mode the alpha channel is 0xFF,
+as in an EColor16MU device.
+*/
+void THeadlessDevices::Reset()
+	{
+	for (TInt index = 0; index < iMemoryBytes; index++)
+		iMemory[index] = TUint8(Random() >> 8);
+	if (BitsInMemory(DisplayMode()) == 32)
+		{
+		for (TInt index = 3; index < iMemoryBytes; index += 4)
+			iMemory[index] = 0xff;
+		}
+	const TSharedScreenHeader& header = iHeadless->Header();
+	TUint8* pixels = reinterpret_cast<TUint8*>(const_cast<TSharedScreenHeader*>(&header)) + header.iHeaderSize;
+	Mem::Copy(pixels, iMemory, iMemoryBytes);
+	}
+
+/**
+@return A clipping rectangle within the logical size, at least one pixel wide and high.
+*/
+TRect THeadlessDevices::RandomClipRect() const
+	{
+	const TInt left = Random(0, iSize.iWidth / 3);
+	const TInt top = Random(0, iSize.iHeight / 3);
+	return TRect(left, top, Random(left + 1, iSize.iWidth + 1), Random(top + 1, iSize.iHeight + 1));
+	}
+
+/**
+@return ETrue if every logical pixel of the two devices differs by no more than aTolerance in
+each channel.
+*/
+TBool THeadlessDevices::IsExpected(TInt aTolerance) const
+	{
+	for (TInt y = 0; y < iSize.iHeight; y++)
+		{
+		for (TInt x = 0; x < iSize.iWidth; x++)
+			{
+			const TRgb actual(iHeadless->ReadPixel(x, y));
+			const TRgb expected(iReference->ReadPixel(x, y));
+			if (Abs(actual.Red() - expected.Red()) > aTolerance ||
+				Abs(actual.Green() - expected.Green()) > aTolerance ||
+				Abs(actual.Blue() - expected.Blue()) > aTolerance)
+				{
+				return EFalse;
+				}
+			}
+		}
+	return ETrue;
+	}
+
+/**
+Draws a random glyph run through MGlyphRunDrawing and through the primitives.
+*/
+LOCAL_C TBool CheckGlyphRun(THeadlessDevices& aDevices, MGlyphRunDrawing& aDrawing)
+	{
+	TUint8 coverage[KMaxGlyphs][KMaxGlyphSize * KMaxGlyphSize];
+	TGlyphRunEntry glyphs[KMaxGlyphs];
+	const TInt count = Random(1, KMaxGlyphs + 1);
+	for (TInt index = 0; index < count; index++)
+		{
+		for (TInt byte = 0; byte < KMaxGlyphSize * KMaxGlyphSize; byte++)
+			coverage[index][byte] = TUint8(Random() % 3 ? Random() >> 8 : 0);
+		TGlyphRunEntry& glyph = glyphs[index];
+		glyph.iPosition.SetXY(Random(-4, aDevices.iSize.iWidth), Random(-4, aDevices.iSize.iHeight));
+		glyph.iSize.SetSize(Random(1, KMaxGlyphSize + 1), Random(1, KMaxGlyphSize + 1));
+		glyph.iCoverage = coverage[index];
+		glyph.iStride = KMaxGlyphSize;
+		}
+	const TGlyphCoverage format = Random() & 1 ? EGlyphCoverageGray256 : EGlyphCoverageMono;
+	const TRect clipRect(aDevices.RandomClipRect());
+	const TRgb color(RandomColor(format == EGlyphCoverageGray256));
+	aDrawing.DrawGlyphRun(glyphs, count, format, clipRect, color, CGraphicsContext::EDrawModePEN);
+	TGlyphRun::DrawWithPrimitives(*aDevices.iReference, glyphs, count, format, clipRect,
+								  color, CGraphicsContext::EDrawModePEN);
+	return aDevices.IsExpected(0);
+	}
+
+/**
+Composes a random line of premultiplied pixels, transparent and opaque ones included, through
+MPremultipliedAlphaBlending and through the primitives.
+*/
+LOCAL_C TBool CheckPremultiplied(THeadlessDevices& aDevices, MPremultipliedAlphaBlending& aBlending)
+	{
+	TUint32 pixels[KWidth + KHeight];
+	const TInt x = Random(0, aDevices.iSize.iWidth);
+	const TInt y = Random(0, aDevices.iSize.iHeight);
+	const TInt length = Random(1, aDevices.iSize.iWidth - x + 1);
+	for (TInt index = 0; index < length; index++)
+		{
+		const TUint32 choice = Random() % 3;
+		const TUint32 alpha = choice == 0 ? 0 : (choice == 1 ? 0xff : Random() & 0xff);
+		TUint32 pixel = alpha << 24;
+		for (TInt shift = 0; shift < 24; shift += 8)
+			pixel |= (((Random() >> 8) & 0xff) * alpha / 0xff) << shift;
+		pixels[index] = pixel;
+		}
+	aBlending.WriteRgbAlphaLinePremultiplied(x, y, length, pixels);
+	TPremultipliedLine::WriteWithPrimitives(*aDevices.iReference, x, y, length, pixels);
+	return aDevices.IsExpected(KPremultipliedTolerance);
+	}
+
+/**
+Writes random points or spans, some outside the clipping rectangle and the device, in a random
+draw mode and in one colour or a colour each, through MBatchedPlotting and through the primitives.
+*/
+LOCAL_C TBool CheckBatched(THeadlessDevices& aDevices, MBatchedPlotting& aPlotting, THeadlessFunction aFunction)
+	{
+	TPoint points[KMaxPoints];
+	TPlotSpan spans[KMaxPoints];
+	TRgb colors[KMaxPoints];
+	const TInt count = Random(1, KMaxPoints + 1);
+	for (TInt index = 0; index < count; index++)
+		{
+		points[index].SetXY(Random(-3, aDevices.iSize.iWidth + 3), Random(-3, aDevices.iSize.iHeight + 3));
+		spans[index].iX = points[index].iX;
+		spans[index].iY = points[index].iY;
+		spans[index].iLength = Random(0, aDevices.iSize.iWidth);
+		colors[index] = RandomColor(ETrue);
+		}
+	const CGraphicsContext::TDrawMode drawMode = KDrawModes[Random() % (sizeof(KDrawModes) / sizeof(KDrawModes[0]))];
+	const TRect clipRect(aDevices.RandomClipRect());
+	const TInt colorStep = Random() & 1;
+	CFbsDrawDevice& reference = *aDevices.iReference;
+	if (aFunction == EWritePoints)
+		{
+		if (colorStep)
+			aPlotting.WritePoints(points, colors, count, clipRect, drawMode);
+		else
+			aPlotting.WritePoints(points, count, clipRect, colors[0], drawMode);
+		TBatchedPlot::WritePointsWithPrimitives(reference, points, count, colors, colorStep, clipRect, drawMode);
+		}
+	else
+		{
+		if (colorStep)
+			aPlotting.WriteSpans(spans, colors, count, clipRect, drawMode);
+		else
+			aPlotting.WriteSpans(spans, count, clipRect, colors[0], drawMode);
+		TBatchedPlot::WriteSpansWithPrimitives(reference, spans, count, colors, colorStep, clipRect, drawMode);
+		}
+	return aDevices.IsExpected(0);
+	}
+
+/**
+Reads random points through MBatchedPlotting and with ReadPixel().
+*/
+LOCAL_C TBool CheckReadPixels(THeadlessDevices& aDevices, const MBatchedPlotting& aPlotting)
+	{
+	TPoint points[KMaxPoints];
+	TRgb colors[KMaxPoints];
+	const TInt count = Random(1, KMaxPoints + 1);
+	for (TInt index = 0; index < count; index++)
+		points[index].SetXY(Random(0, aDevices.iSize.iWidth), Random(0, aDevices.iSize.iHeight));
+	aPlotting.ReadPixels(points, count, colors);
+	for (TInt index = 0; index < count; index++)
+		{
+		if (colors[index] != aDevices.iHeadless->ReadPixel(points[index].iX, points[index].iY))
+			return EFalse;
+		}
+	return ETrue;
+	}
+
+/**
+One channel processed as RShadowFadeTables documents it: faded first, then shadowed.
+*/
+LOCAL_C TInt ShadowChannel(TInt aValue, CFbsDrawDevice::TShadowMode aShadowMode, TInt aBlackMap, TInt aWhiteMap)
+	{
+	if (aShadowMode & CFbsDrawDevice::EFade)
+		aValue = ((aValue * (aWhiteMap - aBlackMap + 1)) >> 8) + aBlackMap;
+	if (aShadowMode & CFbsDrawDevice::EShadow)
+		aValue -= 0x40;
+	return Max(0, Min(aValue, 0xff));
+	}
+
+/**
+Shadows a random rectangle of the headless device with a random shadow mode and fading
+parameters, and checks every pixel against the same pixel of the reference device, processed
+channel by channel inside the rectangle and unchanged outside. The shadow mode of aCase is set
+again afterwards.
+*/
+LOCAL_C TBool CheckShadowArea(THeadlessDevices& aDevices, THeadlessCase aCase)
+	{
+	const CFbsDrawDevice::TShadowMode shadowMode = CFbsDrawDevice::TShadowMode(Random() % 4);
+	const TInt blackMap = Random() & 0xff;
+	const TInt whiteMap = Random(blackMap, 0x100);
+	const TRect rect(aDevices.RandomClipRect());
+	CHeadlessScreenDevice& headless = *aDevices.iHeadless;
+	headless.SetFadingParameters(TUint8(blackMap), TUint8(whiteMap));
+	headless.SetShadowMode(shadowMode);
+	headless.ShadowArea(rect);
+	headless.SetFadingParameters(KDefaultFadeBlackMap, KDefaultFadeWhiteMap);
+	headless.SetShadowMode(aCase == EShadowed ? CFbsDrawDevice::EShadow : CFbsDrawDevice::ENoShadow);
+	const TDisplayMode mode = aDevices.DisplayMode();
+	for (TInt y = 0; y < aDevices.iSize.iHeight; y++)
+		{
+		for (TInt x = 0; x < aDevices.iSize.iWidth; x++)
+			{
+			TRgb expected(aDevices.iReference->ReadPixel(x, y));
+			if (rect.Contains(TPoint(x, y)) && shadowMode != CFbsDrawDevice::ENoShadow)
+				{
+				expected = TRgb(ShadowChannel(expected.Red(), shadowMode, blackMap, whiteMap),
+								ShadowChannel(expected.Green(), shadowMode, blackMap, whiteMap),
+								ShadowChannel(expected.Blue(), shadowMode, blackMap, whiteMap));
+				expected = RDrawColorMap::PixelToRgb(mode, RDrawColorMap::RgbToPixel(mode, expected));
+				}
+			const TRgb actual(headless.ReadPixel(x, y));
+			if (actual.Red() != expected.Red() || actual.Green() != expected.Green() ||
+				actual.Blue() != expected.Blue())
+				{
+				test.Printf(_L("shadow mode %d, fading %d-%d: [%d,%d] is %06x, expected %06x\n"),
+							shadowMode, blackMap, whiteMap, x, y,
+							actual.Internal() & 0xffffff, expected.Internal() & 0xffffff);
+				return EFalse;
+				}
+			}
+		}
+	return ETrue;
+	}
+
+LOCAL_C void TestMode(THeadlessDevices& aDevices, TDisplayMode aMode)
+	{
+	TAny* interface = NULL;
+	test(aDevices.iHeadless->GetInterface(KGlyphRunInterfaceID, interface) == KErrNone);
+	MGlyphRunDrawing& drawing = *static_cast<MGlyphRunDrawing*>(interface);
+	test(aDevices.iHeadless->GetInterface(KPremultipliedAlphaInterfaceID, interface) == KErrNone);
+	MPremultipliedAlphaBlending& blending = *static_cast<MPremultipliedAlphaBlending*>(interface);
+	test(aDevices.iHeadless->GetInterface(KBatchedPlottingInterfaceID, interface) == KErrNone);
+	MBatchedPlotting& plotting = *static_cast<MBatchedPlotting*>(interface);
+
+	for (TInt testCase = 0; testCase < EHeadlessCaseCount; testCase++)
+		{
+		if (!aDevices.SetCase(THeadlessCase(testCase)))
+			continue;
+		for (TInt function = 0; function < EHeadlessFunctionCount; function++)
+			{
+			for (TInt iteration = 0; iteration < KIterations; iteration++)
+				{
+				aDevices.Reset();
+				TBool same = EFalse;
+				switch (function)
+					{
+				case EDrawGlyphRun:
+					same = CheckGlyphRun(aDevices, drawing);
+					break;
+				case EWriteRgbAlphaLinePremultiplied:
+					same = CheckPremultiplied(aDevices, blending);
+					break;
+				case EWritePoints:
+				case EWriteSpans:
+					same = CheckBatched(aDevices, plotting, THeadlessFunction(function));
+					break;
+				case EReadPixels:
+					same = CheckReadPixels(aDevices, plotting);
+					break;
+				default:
+					same = CheckShadowArea(aDevices, THeadlessCase(testCase));
+					break;
+					}
+				if (!same)
+					test.Printf(_L("%s: mode %d, %s, iteration %d\n"),
+								KFunctionNames[function], aMode, KCaseNames[testCase], iteration);
+				test(same);
+				}
+			}
+		}
+	aDevices.SetCase(ENormal);
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	THeadlessDevices devices;
+	test.Start(_L("Headless interfaces against per-primitive results"));
+	const TInt numModes = sizeof(KModes) / sizeof(KModes[0]);
+	for (TInt index = 0; index < numModes; index++)
+		{
+		const TDisplayMode mode = KModes[index];
+		test.Printf(_L("mode %d\n"), mode);
+		TRAPD(err, devices.CreateL(mode));
+		if (err == KErrNone)
+			TestMode(devices, mode);
+		devices.Close();
+		test(err == KErrNone);
+		}
+	test.End();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
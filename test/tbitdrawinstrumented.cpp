@@ -0,0 +1,369 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks the counters of CInstrumentedDrawDevice, over a target device that draws nothing and
+// whose display mode can be changed between calls.
+//	- Nothing is counted until counting is enabled, nor after it is disabled; the counters are
+//	  kept while it is disabled and cleared by ResetCounters().
+//	- Every primitive is counted under its draw mode and the display mode of the target, or the
+//	  requested display mode for ReadLine(), with the pixels it covers.
+//	- Once the hash table holds its limit of combinations, new combinations are counted per
+//	  primitive under ENone, while the combinations already in the table go on being counted
+//	  on their own. No call or pixel is lost, and ResetCounters() empties the table again.
+//
+// Usage: tbitdrawinstrumented
+// The process panics at the first failure, after printing the counter involved.
+//
+
+#include <e32test.h>
+#include "BitDrawInstrumented.h"
+
+LOCAL_D RTest test(_L("TBitDrawInstrumented"));
+
+const TInt KWidth = 64;
+const TInt KHeight = 32;
+/** Combinations counted on their own before new ones go to the overflow counters. */
+const TInt KMaxUsedCounters = KMaxDrawCounters * 3 / 4;
+
+LOCAL_D const CGraphicsContext::TDrawMode KDrawModes[] =
+	{
+	CGraphicsContext::EDrawModeAND, CGraphicsContext::EDrawModeNOTAND, CGraphicsContext::EDrawModePEN,
+	CGraphicsContext::EDrawModeANDNOT, CGraphicsContext::EDrawModeXOR, CGraphicsContext::EDrawModeOR,
+	CGraphicsContext::EDrawModeNOTANDNOT, CGraphicsContext::EDrawModeNOTXOR, CGraphicsContext::EDrawModeNOTSCREEN,
+	CGraphicsContext::EDrawModeNOTOR, CGraphicsContext::EDrawModeNOTPEN, CGraphicsContext::EDrawModeORNOT,
+	CGraphicsContext::EDrawModeNOTORNOT, CGraphicsContext::EDrawModeWriteAlpha
+	};
+const TInt KDrawModeCount = sizeof(KDrawModes) / sizeof(KDrawModes[0]);
+
+LOCAL_D const TDisplayMode KDisplayModes[] =
+	{
+	EGray2, EGray4, EGray16, EGray256, EColor16, EColor256, EColor4K, EColor64K,
+	EColor16M, EColor16MU, EColor16MA, EColor16MAP
+	};
+const TInt KDisplayModeCount = sizeof(KDisplayModes) / sizeof(KDisplayModes[0]);
+
+/**
+Target device that draws nothing, so that calls may be made in any display mode.
+*/
+class CNullDrawDevice : public CFbsDrawDevice
+	{
+public:
+	inline void SetMode(TDisplayMode aDispMode);
+public: // From CFbsDrawDevice
+	TDisplayMode DisplayMode() const { return iDispMode; }
+	TInt LongWidth() const { return KWidth; }
+	void MapColors(const TRect&,const TRgb*,TInt,TBool) {}
+	void ReadLine(TInt,TInt,TInt,TAny*,TDisplayMode) const {}
+	TRgb ReadPixel(TInt,TInt) const { return KRgbBlack; }
+	TUint32* ScanLineBuffer() const { return const_cast<TUint32*>(iScanLine); }
+	TInt ScanLineBytes() const { return sizeof(iScanLine); }
+	TDisplayMode ScanLineDisplayMode() const { return EColor16MU; }
+	TSize SizeInPixels() const { return TSize(KWidth, KHeight); }
+	TInt HorzTwipsPerThousandPixels() const { return 0; }
+	TInt VertTwipsPerThousandPixels() const { return 0; }
+	void OrientationsAvailable(TBool aOrientation[4]) { aOrientation[0] = ETrue; aOrientation[1] = aOrientation[2] = aOrientation[3] = EFalse; }
+	TBool SetOrientation(TOrientation aOrientation) { return aOrientation == EOrientationNormal; }
+	void WriteBinary(TInt,TInt,TUint32*,TInt,TInt,TRgb,CGraphicsContext::TDrawMode) {}
+	void WriteBinaryLine(TInt,TInt,TUint32*,TInt,TRgb,CGraphicsContext::TDrawMode) {}
+	void WriteBinaryLineVertical(TInt,TInt,TUint32*,TInt,TRgb,CGraphicsContext::TDrawMode,TBool) {}
+	void WriteRgb(TInt,TInt,TRgb,CGraphicsContext::TDrawMode) {}
+	void WriteRgbMulti(TInt,TInt,TInt,TInt,TRgb,CGraphicsContext::TDrawMode) {}
+	void WriteRgbAlphaLine(TInt,TInt,TInt,TUint8*,TUint8*,CGraphicsContext::TDrawMode) {}
+	void WriteLine(TInt,TInt,TInt,TUint32*,CGraphicsContext::TDrawMode) {}
+	void WriteRgbAlphaMulti(TInt,TInt,TInt,TRgb,const TUint8*) {}
+	void WriteRgbAlphaLine(TInt,TInt,TInt,const TUint8*,const TUint8*,const TUint8*,CGraphicsContext::TDrawMode) {}
+	TInt GetInterface(TInt,TAny*&) { return KErrNotSupported; }
+	void GetDrawRect(TRect& aDrawRect) const { aDrawRect.SetRect(0, 0, KWidth, KHeight); }
+	void SwapWidthAndHeight() {}
+private:
+	TDisplayMode iDispMode;
+	TUint32 iScanLine[KWidth];
+	};
+
+inline void CNullDrawDevice::SetMode(TDisplayMode aDispMode)
+	{
+	iDispMode = aDispMode;
+	}
+
+/**
+The instrumented device, its target and the counters it hands out.
+*/
+class TInstrumentedDevices
+	{
+public:
+	TInstrumentedDevices();
+	void CreateL();
+	void Close();
+	void GetCountersL();
+	const TDrawCounter* Find(TDrawPrimitive aPrimitive, TInt aDrawMode, TDisplayMode aDispMode) const;
+	TBool Check(TDrawPrimitive aPrimitive, TInt aDrawMode, TDisplayMode aDispMode, TUint32 aCalls, TInt64 aPixels) const;
+public:
+	CInstrumentedDrawDevice* iDevice;
+	CNullDrawDevice* iTarget;
+	MDrawDeviceCounters* iCounters;
+	RArray<TDrawCounter> iSnapshot;
+	};
+
+TInstrumentedDevices::TInstrumentedDevices():
+	iDevice(NULL),
+	iTarget(NULL),
+	iCounters(NULL)
+	{
+	}
+
+void TInstrumentedDevices::CreateL()
+	{
+	CNullDrawDevice* target = new(ELeave) CNullDrawDevice;
+	CleanupStack::PushL(target);
+	iDevice = CInstrumentedDrawDevice::NewL(target);
+	CleanupStack::Pop(target);
+	iTarget = target;
+	iTarget->SetMode(EColor64K);
+	TAny* interface = NULL;
+	User::LeaveIfError(iDevice->GetInterface(KDrawDeviceCountersInterfaceID, interface));
+	iCounters = static_cast<MDrawDeviceCounters*>(interface);
+	}
+
+void TInstrumentedDevices::Close()
+	{
+	delete iDevice;
+	iDevice = NULL;
+	iTarget = NULL;
+	iCounters = NULL;
+	iSnapshot.Close();
+	}
+
+void TInstrumentedDevices::GetCountersL()
+	{
+	User::LeaveIfError(iCounters->GetCounters(iSnapshot));
+	}
+
+/**
+@return The counter of the combination in the last snapshot, or NULL if it has none.
+*/
+const TDrawCounter* TInstrumentedDevices::Find(TDrawPrimitive aPrimitive, TInt aDrawMode, TDisplayMode aDispMode) const
+	{
+	for (TInt index = 0; index < iSnapshot.Count(); index++)
+		{
+		const TDrawCounter& counter = iSnapshot[index];
+		if (counter.iPrimitive == aPrimitive && counter.iDrawMode == aDrawMode && counter.iDisplayMode == aDispMode)
+			return &counter;
+		}
+	return NULL;
+	}
+
+TBool TInstrumentedDevices::Check(TDrawPrimitive aPrimitive, TInt aDrawMode, TDisplayMode aDispMode,
+								  TUint32 aCalls, TInt64 aPixels) const
+	{
+	const TDrawCounter* counter = Find(aPrimitive, aDrawMode, aDispMode);
+	const TBool same = counter && counter->iCalls == aCalls && counter->iPixels == aPixels &&
+					   counter->iMicroSeconds >= 0;
+	if (!same)
+		{
+		test.Printf(_L("primitive %d, draw mode %d, display mode %d: %d calls, %d pixels, expected %d, %d\n"),
+					aPrimitive, aDrawMode, aDispMode, counter ? TInt(counter->iCalls) : -1,
+					counter ? I64INT(counter->iPixels) : -1, aCalls, I64INT(aPixels));
+		}
+	return same;
+	}
+
+/**
+Every primitive is counted under its combination, with the pixels it covers.
+*/
+LOCAL_C void TestPrimitivesL(TInstrumentedDevices& aDevices)
+	{
+	CInstrumentedDrawDevice& device = *aDevices.iDevice;
+	TUint32 buffer[KWidth];
+	TUint8 mask[KWidth];
+	Mem::FillZ(buffer, sizeof(buffer));
+	Mem::FillZ(mask, sizeof(mask));
+	const TRgb map[2] = { KRgbBlack, KRgbWhite };
+	const CGraphicsContext::TDrawMode pen = CGraphicsContext::EDrawModePEN;
+	const CGraphicsContext::TDrawMode xorMode = CGraphicsContext::EDrawModeXOR;
+
+	test(!aDevices.iCounters->CountersEnabled());
+	device.WriteRgbMulti(0, 0, 10, 10, KRgbWhite, pen);
+	aDevices.GetCountersL();
+	test(aDevices.iSnapshot.Count() == 0);
+
+	aDevices.iCounters->SetCountersEnabled(ETrue);
+	test(aDevices.iCounters->CountersEnabled());
+	device.WriteRgb(1, 1, KRgbWhite, pen);
+	device.WriteRgbMulti(0, 0, 10, 3, KRgbWhite, pen);
+	device.WriteRgbMulti(0, 0, 7, 2, KRgbWhite, pen);
+	device.WriteRgbMulti(0, 0, 5, 5, KRgbWhite, xorMode);
+	device.WriteLine(0, 0, 20, buffer, pen);
+	device.WriteBinary(0, 0, buffer, 32, 4, KRgbWhite, pen);
+	device.WriteBinaryLine(0, 0, buffer, 40, KRgbWhite, pen);
+	device.WriteBinaryLineVertical(0, 0, buffer, 9, KRgbWhite, pen, EFalse);
+	device.WriteRgbAlphaLine(0, 0, 11, reinterpret_cast<TUint8*>(buffer), mask, pen);
+	device.WriteRgbAlphaLine(0, 0, 12, reinterpret_cast<TUint8*>(buffer), reinterpret_cast<TUint8*>(buffer), mask, pen);
+	device.WriteRgbAlphaMulti(0, 0, 13, KRgbWhite, mask);
+	device.MapColors(TRect(0, 0, 6, 4), map, 1, ETrue);
+	device.ShadowArea(TRect(2, 2, 5, 9));
+	device.ReadLine(0, 0, 14, buffer, EColor16MU);
+	device.ReadLine(0, 0, 15, buffer, EGray256);
+	aDevices.iTarget->SetMode(EColor16MU);
+	device.WriteRgbMulti(0, 0, 4, 4, KRgbWhite, pen);
+	aDevices.GetCountersL();
+
+	test(aDevices.Check(EPrimitiveWriteRgb, pen, EColor64K, 1, 1));
+	test(aDevices.Check(EPrimitiveWriteRgbMulti, pen, EColor64K, 2, 30 + 14));
+	test(aDevices.Check(EPrimitiveWriteRgbMulti, xorMode, EColor64K, 1, 25));
+	test(aDevices.Check(EPrimitiveWriteRgbMulti, pen, EColor16MU, 1, 16));
+	test(aDevices.Check(EPrimitiveWriteLine, pen, EColor64K, 1, 20));
+	test(aDevices.Check(EPrimitiveWriteBinary, pen, EColor64K, 1, 32 * 4));
+	test(aDevices.Check(EPrimitiveWriteBinaryLine, pen, EColor64K, 1, 40));
+	test(aDevices.Check(EPrimitiveWriteBinaryLineVertical, pen, EColor64K, 1, 9));
+	test(aDevices.Check(EPrimitiveWriteRgbAlphaLine, pen, EColor64K, 1, 11));
+	test(aDevices.Check(EPrimitiveWriteRgbAlphaLine2, pen, EColor64K, 1, 12));
+	test(aDevices.Check(EPrimitiveWriteRgbAlphaMulti, 0, EColor64K, 1, 13));
+	test(aDevices.Check(EPrimitiveMapColors, 0, EColor64K, 1, 24));
+	test(aDevices.Check(EPrimitiveShadowArea, 0, EColor64K, 1, 21));
+	test(aDevices.Check(EPrimitiveReadLine, 0, EColor16MU, 1, 14));
+	test(aDevices.Check(EPrimitiveReadLine, 0, EGray256, 1, 15));
+	test(aDevices.iSnapshot.Count() == 15);
+
+	// Disabled counting keeps the counters.
+	aDevices.iCounters->SetCountersEnabled(EFalse);
+	device.WriteRgbMulti(0, 0, 4, 4, KRgbWhite, pen);
+	aDevices.GetCountersL();
+	test(aDevices.Check(EPrimitiveWriteRgbMulti, pen, EColor16MU, 1, 16));
+	test(aDevices.iSnapshot.Count() == 15);
+
+	aDevices.iCounters->ResetCounters();
+	aDevices.GetCountersL();
+	test(aDevices.iSnapshot.Count() == 0);
+	}
+
+/**
+Calls WriteRgbMulti() in the combination numbered aIndex, over aIndex + 1 pixels.
+*/
+LOCAL_C void CallCombination(TInstrumentedDevices& aDevices, TInt aIndex)
+	{
+	aDevices.iTarget->SetMode(KDisplayModes[(aIndex / KDrawModeCount) % KDisplayModeCount]);
+	const CGraphicsContext::TDrawMode drawMode = KDrawModes[aIndex % KDrawModeCount];
+	if (aIndex < KDrawModeCount * KDisplayModeCount)
+		aDevices.iDevice->WriteRgbMulti(0, 0, aIndex + 1, 1, KRgbWhite, drawMode);
+	else
+		aDevices.iDevice->WriteLine(0, 0, aIndex + 1 - KDrawModeCount * KDisplayModeCount, NULL, drawMode);
+	}
+
+LOCAL_C TDrawPrimitive CombinationPrimitive(TInt aIndex)
+	{
+	return aIndex < KDrawModeCount * KDisplayModeCount ? EPrimitiveWriteRgbMulti : EPrimitiveWriteLine;
+	}
+
+LOCAL_C TInt CombinationPixels(TInt aIndex)
+	{
+	return aIndex < KDrawModeCount * KDisplayModeCount ? aIndex + 1 : aIndex + 1 - KDrawModeCount * KDisplayModeCount;
+	}
+
+/**
+Combinations beyond the limit of the table go to the overflow counters.
+*/
+LOCAL_C void TestOverflowL(TInstrumentedDevices& aDevices)
+	{
+	// WriteRgbMulti() in every draw mode and display mode, then WriteLine() in some more.
+	const TInt numCombinations = KMaxUsedCounters + 40;
+	test(numCombinations <= 2 * KDrawModeCount * KDisplayModeCount);
+	aDevices.iCounters->ResetCounters();
+	aDevices.iCounters->SetCountersEnabled(ETrue);
+	for (TInt index = 0; index < numCombinations; index++)
+		CallCombination(aDevices, index);
+	// Combinations already in the table are still counted on their own.
+	CallCombination(aDevices, 0);
+	CallCombination(aDevices, KMaxUsedCounters - 1);
+	aDevices.GetCountersL();
+
+	TInt counted = 0;
+	TInt64 totalPixels = 0;
+	TUint32 totalCalls = 0;
+	TUint32 overflowCalls[EDrawPrimitiveCount];
+	TInt64 overflowPixels[EDrawPrimitiveCount];
+	Mem::FillZ(overflowCalls, sizeof(overflowCalls));
+	Mem::FillZ(overflowPixels, sizeof(overflowPixels));
+	for (TInt index = 0; index < numCombinations; index++)
+		{
+		CNullDrawDevice* target = aDevices.iTarget;
+		target->SetMode(KDisplayModes[(index / KDrawModeCount) % KDisplayModeCount]);
+		const TUint32 calls = index == 0 || index == KMaxUsedCounters - 1 ? 2 : 1;
+		const TInt pixels = CombinationPixels(index);
+		totalCalls += calls;
+		totalPixels += calls * pixels;
+		if (index < KMaxUsedCounters)
+			{
+			test(aDevices.Check(CombinationPrimitive(index), KDrawModes[index % KDrawModeCount],
+								target->DisplayMode(), calls, calls * pixels));
+			}
+		else
+			{
+			test(aDevices.Find(CombinationPrimitive(index), KDrawModes[index % KDrawModeCount],
+							   target->DisplayMode()) == NULL);
+			overflowCalls[CombinationPrimitive(index)] += calls;
+			overflowPixels[CombinationPrimitive(index)] += calls * pixels;
+			}
+		}
+	for (TInt primitive = 0; primitive < EDrawPrimitiveCount; primitive++)
+		{
+		if (overflowCalls[primitive])
+			test(aDevices.Check(TDrawPrimitive(primitive), 0, ENone, overflowCalls[primitive], overflowPixels[primitive]));
+		else
+			test(aDevices.Find(TDrawPrimitive(primitive), 0, ENone) == NULL);
+		}
+	for (TInt index = 0; index < aDevices.iSnapshot.Count(); index++)
+		{
+		const TDrawCounter& counter = aDevices.iSnapshot[index];
+		if (counter.iDisplayMode != ENone)
+			counted++;
+		totalCalls -= counter.iCalls;
+		totalPixels -= counter.iPixels;
+		}
+	test(counted == KMaxUsedCounters);
+	test(totalCalls == 0 && totalPixels == 0);
+
+	// Resetting frees the table for new combinations.
+	aDevices.iCounters->ResetCounters();
+	CallCombination(aDevices, numCombinations - 1);
+	aDevices.GetCountersL();
+	test(aDevices.iSnapshot.Count() == 1);
+	test(aDevices.iSnapshot[0].iDisplayMode != ENone);
+	aDevices.iCounters->SetCountersEnabled(EFalse);
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	TInstrumentedDevices devices;
+	CleanupClosePushL(devices);
+	devices.CreateL();
+	test.Start(_L("Counting every primitive"));
+	TestPrimitivesL(devices);
+	test.Next(_L("Overflow of the combinations"));
+	TestOverflowL(devices);
+	test.End();
+	CleanupStack::PopAndDestroy(&devices);
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
@@ -0,0 +1,352 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks RDrawColorMap against mapping every pixel on its own the way CFbsDrawDevice::MapColors()
+// is specified: the pixel is converted to TRgb, the first pair whose colour to match equals it
+// wins, and unmatched pixels are left unchanged.
+//	- Every draw device display mode, through each lookup it can use: the byte table up to 8bpp,
+//	  the direct table and the hash in 16bpp, the hash in 24bpp and 32bpp, and comparing against
+//	  every pair when the lookup cannot be allocated.
+//	- Colour maps of one to KMaxPairs pairs, in which colours to match repeat with different
+//	  replacements, and lines of runs of one pixel value, mapped from a random pixel offset.
+//	- EColor4K pixels with bits set above bit 11, which are ignored when matching.
+//	- EColor256 with a custom palette, through which pixels are converted and replacements are
+//	  chosen with CPalette::NearestIndex().
+//
+// Usage: tbitdrawmapcolors
+// The process panics at the first difference, after printing the mode, lookup and pixel.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "BitDrawMapColors.h"
+
+LOCAL_D RTest test(_L("TBitDrawMapColors"));
+
+const TInt KLineLength = 300;
+const TInt KMaxPairs = 300;
+const TInt KIterations = 40;
+/** Number of pixels for which a 16bpp map uses the direct table. */
+const TInt KDirectTablePixels = 0x10000;
+
+LOCAL_D const TDisplayMode KModes[] =
+	{
+	EGray2, EGray4, EGray16, EGray256, EColor16, EColor256, EColor4K, EColor64K,
+	EColor16M, EColor16MU, EColor16MA, EColor16MAP
+	};
+
+/**
+Ways of creating the map, one for each lookup it may use.
+*/
+enum TLookupCase
+	{
+	/** As many pixels as the line holds: the byte table or the hash. */
+	ELookupLine,
+	/** Enough pixels for the direct table in 16bpp modes. */
+	ELookupDirect,
+	/** The lookup cannot be allocated, so every pair is compared. */
+	ELookupNoMemory,
+	ELookupCaseCount
+	};
+
+LOCAL_D const TText* const KLookupNames[ELookupCaseCount] =
+	{
+	_S("line"), _S("direct"), _S("no memory")
+	};
+
+LOCAL_D TInt64 TheSeed = 0x5eedc010;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C TRgb RandomColor()
+	{
+	return TRgb(Random() & 0xff, Random() & 0xff, Random() & 0xff);
+	}
+
+LOCAL_C TInt BitsPerPixel(TDisplayMode aMode)
+	{
+	switch (aMode)
+		{
+	case EGray2:
+		return 1;
+	case EGray4:
+		return 2;
+	case EGray16:
+	case EColor16:
+		return 4;
+	case EGray256:
+	case EColor256:
+		return 8;
+	case EColor4K:
+	case EColor64K:
+		return 16;
+	case EColor16M:
+		return 24;
+	default:
+		return 32;
+		}
+	}
+
+/**
+@return A random pixel value; EColor4K pixels may have bits set above bit 11, and 32bpp pixels any
+top byte.
+*/
+LOCAL_C TUint32 RandomPixel(TDisplayMode aMode)
+	{
+	const TInt bits = BitsPerPixel(aMode);
+	const TUint32 pixel = Random() ^ (Random() << 16);
+	return bits == 32 ? pixel : pixel & ((1u << bits) - 1);
+	}
+
+LOCAL_C TUint32 GetPixel(const TUint8* aLine, TDisplayMode aMode, TInt aX)
+	{
+	const TInt bits = BitsPerPixel(aMode);
+	switch (bits)
+		{
+	case 16:
+		return reinterpret_cast<const TUint16*>(aLine)[aX];
+	case 24:
+		return aLine[aX * 3] | (aLine[aX * 3 + 1] << 8) | (aLine[aX * 3 + 2] << 16);
+	case 32:
+		return reinterpret_cast<const TUint32*>(aLine)[aX];
+	default:
+		return (aLine[aX * bits / 8] >> (aX * bits % 8)) & ((1 << bits) - 1);
+		}
+	}
+
+LOCAL_C void SetPixel(TUint8* aLine, TDisplayMode aMode, TInt aX, TUint32 aPixel)
+	{
+	const TInt bits = BitsPerPixel(aMode);
+	switch (bits)
+		{
+	case 16:
+		reinterpret_cast<TUint16*>(aLine)[aX] = TUint16(aPixel);
+		break;
+	case 24:
+		aLine[aX * 3] = TUint8(aPixel);
+		aLine[aX * 3 + 1] = TUint8(aPixel >> 8);
+		aLine[aX * 3 + 2] = TUint8(aPixel >> 16);
+		break;
+	case 32:
+		reinterpret_cast<TUint32*>(aLine)[aX] = aPixel;
+		break;
+	default:
+		{
+		const TInt shift = aX * bits % 8;
+		const TInt mask = ((1 << bits) - 1) << shift;
+		TUint8& byte = aLine[aX * bits / 8];
+		byte = TUint8((byte & ~mask) | ((aPixel << shift) & mask));
+		break;
+		}
+		}
+	}
+
+/**
+A colour map and the pixels it is applied to.
+*/
+class TMapCase
+	{
+public:
+	void Generate(TDisplayMode aMode, const CPalette* aPalette);
+	TRgb ToRgb(TUint32 aPixel) const;
+	TUint32 Expected(TUint32 aPixel) const;
+public:
+	TDisplayMode iMode;
+	const CPalette* iPalette;
+	TRgb iColors[KMaxPairs * 2];
+	TInt iNumPairs;
+	TBool iForwards;
+	TUint32 iLine[KLineLength];
+	};
+
+/**
+The colour of a pixel, as MapColors() compares it.
+*/
+TRgb TMapCase::ToRgb(TUint32 aPixel) const
+	{
+	if (iPalette && TInt(aPixel) < iPalette->Entries())
+		return iPalette->GetEntry(aPixel);
+	return RDrawColorMap::PixelToRgb(iMode, aPixel);
+	}
+
+/**
+@return The pixel mapped on its own: replaced by the first matching pair, if any.
+*/
+TUint32 TMapCase::Expected(TUint32 aPixel) const
+	{
+	const TInt match = iForwards ? 0 : 1;
+	const TRgb color(ToRgb(aPixel));
+	for (TInt pair = 0; pair < iNumPairs; pair++)
+		{
+		if (iColors[pair * 2 + match] == color)
+			{
+			const TRgb replacement(iColors[pair * 2 + 1 - match]);
+			return iPalette ? iPalette->NearestIndex(replacement) : RDrawColorMap::RgbToPixel(iMode, replacement);
+			}
+		}
+	return aPixel;
+	}
+
+/**
+Most colours to match are the colours of pixels in the line, some of them repeated with another
+replacement so that only the first may win, and the rest are random.
+*/
+void TMapCase::Generate(TDisplayMode aMode, const CPalette* aPalette)
+	{
+	iMode = aMode;
+	iPalette = aPalette;
+	iNumPairs = 1 + Random() % (Random() & 1 ? KMaxPairs : 8);
+	iForwards = Random() & 1;
+	const TInt match = iForwards ? 0 : 1;
+	TUint32 matched[KMaxPairs];
+	for (TInt pair = 0; pair < iNumPairs; pair++)
+		{
+		matched[pair] = RandomPixel(aMode);
+		TRgb color(ToRgb(matched[pair]));
+		const TUint32 kind = Random() % 8;
+		if (kind == 0)
+			color = RandomColor();
+		else if (kind == 1 && pair > 0)
+			{
+			matched[pair] = matched[Random() % pair];
+			color = ToRgb(matched[pair]);
+			}
+		iColors[pair * 2 + match] = color;
+		iColors[pair * 2 + 1 - match] = RandomColor();
+		}
+	TUint32 pixel = 0;
+	for (TInt index = 0; index < KLineLength; index++)
+		{
+		if (index == 0 || Random() % 4 == 0)
+			{
+			pixel = Random() & 1 ? matched[Random() % iNumPairs] : RandomPixel(aMode);
+			if (aMode == EColor4K)
+				pixel |= (Random() & 0xf) << 12;
+			}
+		iLine[index] = pixel;
+		}
+	}
+
+/**
+Maps part of the line of aCase through a map created for aLookup, and checks every pixel.
+*/
+LOCAL_C TBool CheckMap(const TMapCase& aCase, const RInversePalette* aInverse, TLookupCase aLookup)
+	{
+	TUint8 line[KLineLength * 4];
+	Mem::FillZ(line, sizeof(line));
+	for (TInt index = 0; index < KLineLength; index++)
+		SetPixel(line, aCase.iMode, index, aCase.iLine[index]);
+	const TInt x = Random() % KLineLength;
+	const TInt length = 1 + Random() % (KLineLength - x);
+
+	RDrawColorMap map;
+	TInt err = KErrNone;
+	switch (aLookup)
+		{
+	case ELookupLine:
+		err = map.Create(aCase.iMode, aCase.iColors, aCase.iNumPairs, aCase.iForwards, length, aInverse);
+		break;
+	case ELookupDirect:
+		err = map.Create(aCase.iMode, aCase.iColors, aCase.iNumPairs, aCase.iForwards, KDirectTablePixels, aInverse);
+		break;
+	default:
+		__UHEAP_FAILNEXT(1);
+		err = map.Create(aCase.iMode, aCase.iColors, aCase.iNumPairs, aCase.iForwards, length, aInverse);
+		__UHEAP_RESET;
+		// The map is still usable, and compares every pixel against every pair.
+		err = err == KErrNoMemory ? KErrNone : KErrGeneral;
+		break;
+		}
+	if (err != KErrNone)
+		{
+		test.Printf(_L("mode %d, %s lookup: Create() returned %d\n"), aCase.iMode, KLookupNames[aLookup], err);
+		return EFalse;
+		}
+	map.MapLine(line, x, length);
+	map.Close();
+
+	for (TInt index = 0; index < KLineLength; index++)
+		{
+		const TUint32 pixel = aCase.iLine[index];
+		const TUint32 expected = index >= x && index < x + length ? aCase.Expected(pixel) : pixel;
+		const TUint32 actual = GetPixel(line, aCase.iMode, index);
+		if (actual != expected)
+			{
+			test.Printf(_L("mode %d, %s lookup, %d pairs: pixel %d of %08x is %08x, expected %08x\n"),
+						aCase.iMode, KLookupNames[aLookup], aCase.iNumPairs, index, pixel, actual, expected);
+			return EFalse;
+			}
+		}
+	return ETrue;
+	}
+
+LOCAL_C void TestMode(TDisplayMode aMode, const CPalette* aPalette, const RInversePalette* aInverse)
+	{
+	TMapCase* mapCase = new TMapCase;
+	test(mapCase != NULL);
+	for (TInt iteration = 0; iteration < KIterations; iteration++)
+		{
+		mapCase->Generate(aMode, aPalette);
+		for (TInt lookup = 0; lookup < ELookupCaseCount; lookup++)
+			{
+			// Only maps which allocate their lookup fall back when they cannot.
+			if (lookup == ELookupNoMemory && BitsPerPixel(aMode) <= 8)
+				continue;
+			test(CheckMap(*mapCase, aInverse, TLookupCase(lookup)));
+			}
+		}
+	delete mapCase;
+	}
+
+LOCAL_C void TestCustomPaletteL()
+	{
+	const TInt entries = 1 + Random() % KMaxInversePaletteEntries;
+	CPalette* palette = CPalette::NewL(entries);
+	CleanupStack::PushL(palette);
+	for (TInt index = 0; index < entries; index++)
+		palette->SetEntry(index, RandomColor());
+	RInversePalette inverse;
+	test(inverse.Create(*palette) == KErrNone);
+	TestMode(EColor256, palette, &inverse);
+	inverse.Close();
+	CleanupStack::PopAndDestroy(palette);
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	test.Start(_L("Every display mode and lookup against mapping each pixel"));
+	const TInt numModes = sizeof(KModes) / sizeof(KModes[0]);
+	for (TInt index = 0; index < numModes; index++)
+		TestMode(KModes[index], NULL, NULL);
+	test.Next(_L("EColor256 with a custom palette"));
+	for (TInt count = 0; count < 4; count++)
+		TestCustomPaletteL();
+	test.End();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
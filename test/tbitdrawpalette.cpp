@@ -0,0 +1,287 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks RInversePalette against CPalette::NearestIndex(), which it must match exactly, ties
+// included: the lowest index of the nearest entries wins.
+//	- Random palettes of 1 to 256 entries, palettes on a coarse grid with entries repeated at
+//	  higher indices, and palettes whose entries are two apart so that the colours between them
+//	  are equally near to both, are checked over a grid of every KGridStep-th colour, every
+//	  entry and its neighbours, and random colours.
+//	- NearestIndices() is checked against NearestIndex() on lines with runs of one colour.
+//	- RDrawColorMap in EColor256 with an inverse palette is checked against mapping every pixel
+//	  on its own through the palette: the first matching pair wins, and the replacement is the
+//	  entry CPalette::NearestIndex() returns.
+//
+// Usage: tbitdrawpalette
+// The process panics at the first difference, after printing the palette and colour.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "BitDrawPalette.h"
+#include "BitDrawMapColors.h"
+
+LOCAL_D RTest test(_L("TBitDrawPalette"));
+
+/** Distance between the colours of the grid along each channel. */
+const TInt KGridStep = 9;
+const TInt KRandomColors = 5000;
+const TInt KRandomPalettes = 12;
+const TInt KLineLength = 300;
+const TInt KMaxPairs = 24;
+
+/**
+Kinds of palette checked.
+*/
+enum TPaletteKind
+	{
+	/** Random entries. */
+	EPaletteRandom,
+	/** Entries on a 4x4x4 grid, repeated in reverse order at the higher indices. */
+	EPaletteRepeated,
+	/** Entries two apart along one channel, in descending order. */
+	EPaletteTies,
+	/** A single entry. */
+	EPaletteSingle,
+	EPaletteKindCount
+	};
+
+LOCAL_D const TText* const KPaletteNames[EPaletteKindCount] =
+	{
+	_S("random"), _S("repeated"), _S("ties"), _S("single")
+	};
+
+LOCAL_D TInt64 TheSeed = 0x5eed9a1e;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C TRgb RandomColor()
+	{
+	return TRgb(Random() & 0xff, Random() & 0xff, Random() & 0xff);
+	}
+
+/**
+@return A new palette of the given kind; the caller takes ownership.
+*/
+LOCAL_C CPalette* NewPaletteL(TPaletteKind aKind)
+	{
+	TInt entries = 1;
+	switch (aKind)
+		{
+	case EPaletteRandom:
+		entries = 1 + Random() % KMaxInversePaletteEntries;
+		break;
+	case EPaletteRepeated:
+		entries = 128;
+		break;
+	case EPaletteTies:
+		entries = 128;
+		break;
+	default:
+		break;
+		}
+	CPalette* palette = CPalette::NewL(entries);
+	for (TInt index = 0; index < entries; index++)
+		{
+		TRgb color;
+		switch (aKind)
+			{
+		case EPaletteRepeated:
+			{
+			// Index 64 + i repeats index 63 - i, so the copies lose every tie.
+			const TInt cell = index < 64 ? index : 127 - index;
+			color = TRgb((cell & 3) * 85, ((cell >> 2) & 3) * 85, (cell >> 4) * 85);
+			break;
+			}
+		case EPaletteTies:
+			color = TRgb(254 - index * 2, 0x40, 0x80);
+			break;
+		default:
+			color = RandomColor();
+			break;
+			}
+		palette->SetEntry(index, color);
+		}
+	return palette;
+	}
+
+LOCAL_C TBool CheckColor(const RInversePalette& aInverse, const CPalette& aPalette, TRgb aColor)
+	{
+	const TInt expected = aPalette.NearestIndex(aColor);
+	const TInt actual = aInverse.NearestIndex(aColor);
+	if (actual != expected)
+		{
+		test.Printf(_L("colour %06x: index %d, expected %d\n"), aColor.Internal() & 0xffffff, actual, expected);
+		return EFalse;
+		}
+	return ETrue;
+	}
+
+/**
+Checks NearestIndex() over the grid, every entry and its neighbours along each channel, and random
+colours.
+*/
+LOCAL_C TBool CheckNearestIndex(const RInversePalette& aInverse, const CPalette& aPalette)
+	{
+	for (TInt red = 0; red < 0x100; red += KGridStep)
+		{
+		for (TInt green = 0; green < 0x100; green += KGridStep)
+			{
+			for (TInt blue = 0; blue < 0x100; blue += KGridStep)
+				{
+				if (!CheckColor(aInverse, aPalette, TRgb(red, green, blue)))
+					return EFalse;
+				}
+			}
+		}
+	for (TInt index = 0; index < aPalette.Entries(); index++)
+		{
+		const TRgb entry(aPalette.GetEntry(index));
+		for (TInt delta = -1; delta <= 1; delta++)
+			{
+			const TRgb neighbours[3] =
+				{
+				TRgb(Max(0, Min(0xff, entry.Red() + delta)), entry.Green(), entry.Blue()),
+				TRgb(entry.Red(), Max(0, Min(0xff, entry.Green() + delta)), entry.Blue()),
+				TRgb(entry.Red(), entry.Green(), Max(0, Min(0xff, entry.Blue() + delta)))
+				};
+			for (TInt channel = 0; channel < 3; channel++)
+				{
+				if (!CheckColor(aInverse, aPalette, neighbours[channel]))
+					return EFalse;
+				}
+			}
+		}
+	for (TInt count = 0; count < KRandomColors; count++)
+		{
+		if (!CheckColor(aInverse, aPalette, RandomColor()))
+			return EFalse;
+		}
+	return ETrue;
+	}
+
+/**
+Checks NearestIndices() on a line of runs of random colours, with random top bytes.
+*/
+LOCAL_C TBool CheckNearestIndices(const RInversePalette& aInverse)
+	{
+	TUint32 colors[KLineLength];
+	TUint8 indices[KLineLength];
+	TUint32 color = Random();
+	for (TInt index = 0; index < KLineLength; index++)
+		{
+		if (Random() % 5 == 0)
+			color = Random();
+		colors[index] = (color & 0x00ffffff) | (Random() << 24);
+		}
+	aInverse.NearestIndices(colors, indices, KLineLength);
+	for (TInt index = 0; index < KLineLength; index++)
+		{
+		if (indices[index] != aInverse.NearestIndex(TRgb::_Color16MU(colors[index] & 0x00ffffff)))
+			return EFalse;
+		}
+	return ETrue;
+	}
+
+/**
+Maps a line of random EColor256 pixels with RDrawColorMap and checks every pixel against the
+palette. The colours to match are palette entries, some repeated in later pairs, and some colours
+that are not in the palette.
+*/
+LOCAL_C TBool CheckColorMap(const RInversePalette& aInverse, const CPalette& aPalette)
+	{
+	TRgb colors[KMaxPairs * 2];
+	const TInt numPairs = 1 + Random() % KMaxPairs;
+	for (TInt index = 0; index < numPairs * 2; index++)
+		{
+		if (Random() % 4 == 0)
+			colors[index] = RandomColor();
+		else
+			colors[index] = aPalette.GetEntry(Random() % aPalette.Entries());
+		}
+	const TBool forwards = Random() & 1;
+	TUint8 pixels[KLineLength];
+	TUint8 expected[KLineLength];
+	for (TInt index = 0; index < KLineLength; index++)
+		{
+		pixels[index] = TUint8(Random() % aPalette.Entries());
+		const TRgb color(aPalette.GetEntry(pixels[index]));
+		expected[index] = pixels[index];
+		for (TInt pair = 0; pair < numPairs; pair++)
+			{
+			if (colors[pair * 2 + (forwards ? 0 : 1)] == color)
+				{
+				expected[index] = TUint8(aPalette.NearestIndex(colors[pair * 2 + (forwards ? 1 : 0)]));
+				break;
+				}
+			}
+		}
+	RDrawColorMap map;
+	map.Create(EColor256, colors, numPairs, forwards, KLineLength, &aInverse);
+	map.MapLine(pixels, 0, KLineLength);
+	map.Close();
+	return Mem::Compare(pixels, KLineLength, expected, KLineLength) == 0;
+	}
+
+LOCAL_C void TestPaletteL(TPaletteKind aKind)
+	{
+	CPalette* palette = NewPaletteL(aKind);
+	CleanupStack::PushL(palette);
+	RInversePalette inverse;
+	test(inverse.Create(*palette) == KErrNone);
+	test(inverse.Entries() == palette->Entries());
+	const TBool same = CheckNearestIndex(inverse, *palette);
+	if (!same)
+		test.Printf(_L("%s palette of %d entries\n"), KPaletteNames[aKind], palette->Entries());
+	test(same);
+	test(CheckNearestIndices(inverse));
+	test(CheckColorMap(inverse, *palette));
+	// Setting the same palette again keeps the lookup.
+	test(inverse.Create(*palette) == KErrNone);
+	test(CheckNearestIndex(inverse, *palette));
+	// Without its cells the lookup compares against every entry.
+	inverse.Close();
+	test(CheckNearestIndex(inverse, *palette));
+	test(CheckColorMap(inverse, *palette));
+	CleanupStack::PopAndDestroy(palette);
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	test.Start(_L("Ties resolve to the lowest index"));
+	TestPaletteL(EPaletteTies);
+	TestPaletteL(EPaletteRepeated);
+	test.Next(_L("A single entry"));
+	TestPaletteL(EPaletteSingle);
+	test.Next(_L("Random palettes against CPalette::NearestIndex()"));
+	for (TInt count = 0; count < KRandomPalettes; count++)
+		TestPaletteL(EPaletteRandom);
+	test.End();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
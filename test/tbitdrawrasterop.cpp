@@ -0,0 +1,295 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks TRasterOp against the per-pixel semantics of the draw modes it documents: EInvertPen
+// inverts the pen colour before it is converted to the display mode, or the source pixel of a
+// line; EInvertScreen XORs the destination with the pixel value of white; then EXor, EAnd or
+// EOr combine it with the pen, in that order of precedence; EPenmode and EWriteAlpha write the
+// pen; EColor16MU pixels are left opaque.
+// Every draw mode IsSupported() accepts is checked in every display mode, with random pens and
+// random scan lines, through Pixel(), FillSpan(), FillBinary() and CombineLine(), for every span
+// length from 0 to KMaxLength at offsets that are not byte or word aligned. Pixels outside the
+// span must be left unchanged.
+//
+// Usage: tbitdrawrasterop
+// The process panics at the first difference, after printing the function, modes and span.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "bitdraw.h"
+#include "BitDrawRasterOp.h"
+#include "BitDrawPixelFormat.h"
+
+LOCAL_D RTest test(_L("TBitDrawRasterOp"));
+
+/** Longest span checked: several SSE2 or NEON vectors and the longest tail. */
+const TInt KMaxLength = 67;
+/** Random spans checked for each mode, draw mode, function and length. */
+const TInt KSpansPerLength = 2;
+/** Maximum pixel offset of a span in its scan line; covers every position within a word. */
+const TInt KMaxOffset = 33;
+/** Words of each scan line: KMaxOffset + KMaxLength 32bpp pixels and a guard. */
+const TInt KLineWords = KMaxOffset + KMaxLength + 4;
+/** Words of the bits passed to FillBinary(). */
+const TInt KBinaryWords = (KMaxLength + 31) / 32;
+
+typedef TUint32 (*TReadPixelFunction)(const TAny* aScanLine, TInt aX);
+typedef void (*TWritePixelFunction)(TAny* aScanLine, TInt aX, TUint32 aPixel);
+typedef TUint32 (*TFromRgbFunction)(TRgb aColor);
+
+template <TDisplayMode MODE>
+LOCAL_C TUint32 ReadPixel(const TAny* aScanLine, TInt aX)
+	{
+	return TPixelFormat<MODE>::Read(aScanLine, aX);
+	}
+
+template <TDisplayMode MODE>
+LOCAL_C void WritePixel(TAny* aScanLine, TInt aX, TUint32 aPixel)
+	{
+	TPixelFormat<MODE>::Write(aScanLine, aX, aPixel);
+	}
+
+template <TDisplayMode MODE>
+LOCAL_C TUint32 FromRgb(TRgb aColor)
+	{
+	return TPixelFormat<MODE>::FromRgb(aColor);
+	}
+
+/**
+Per-pixel reference functions of one display mode.
+*/
+struct TModeFunctions
+	{
+	TDisplayMode iMode;
+	const TText* iName;
+	TInt iBitsPerPixel;
+	TReadPixelFunction iReadPixel;
+	TWritePixelFunction iWritePixel;
+	TFromRgbFunction iFromRgb;
+	};
+
+#define MODE_FUNCTIONS(aMode) \
+	{aMode, _S(#aMode), TPixelFormat<aMode>::EBitsPerPixel, ReadPixel<aMode>, WritePixel<aMode>, FromRgb<aMode>}
+
+LOCAL_D const TModeFunctions KModes[] =
+	{
+	MODE_FUNCTIONS(EGray2),
+	MODE_FUNCTIONS(EGray4),
+	MODE_FUNCTIONS(EGray16),
+	MODE_FUNCTIONS(EGray256),
+	MODE_FUNCTIONS(EColor16),
+	MODE_FUNCTIONS(EColor256),
+	MODE_FUNCTIONS(EColor4K),
+	MODE_FUNCTIONS(EColor64K),
+	MODE_FUNCTIONS(EColor16M),
+	MODE_FUNCTIONS(EColor16MU),
+	MODE_FUNCTIONS(EColor16MA),
+	MODE_FUNCTIONS(EColor16MAP)
+	};
+
+#undef MODE_FUNCTIONS
+
+LOCAL_D const CGraphicsContext::TDrawMode KDrawModes[] =
+	{
+	CGraphicsContext::EDrawModeAND,
+	CGraphicsContext::EDrawModeNOTAND,
+	CGraphicsContext::EDrawModePEN,
+	CGraphicsContext::EDrawModeANDNOT,
+	CGraphicsContext::EDrawModeXOR,
+	CGraphicsContext::EDrawModeOR,
+	CGraphicsContext::EDrawModeNOTANDNOT,
+	CGraphicsContext::EDrawModeNOTXOR,
+	CGraphicsContext::EDrawModeNOTSCREEN,
+	CGraphicsContext::EDrawModeNOTOR,
+	CGraphicsContext::EDrawModeNOTPEN,
+	CGraphicsContext::EDrawModeORNOT,
+	CGraphicsContext::EDrawModeNOTORNOT,
+	CGraphicsContext::EDrawModeWriteAlpha
+	};
+
+/**
+Functions checked.
+*/
+enum TRasterFunction
+	{
+	EFillSpan,
+	EFillBinary,
+	ECombineLine,
+	ERasterFunctionCount
+	};
+
+LOCAL_D const TText* const KFunctionNames[ERasterFunctionCount] =
+	{
+	_S("FillSpan"), _S("FillBinary"), _S("CombineLine")
+	};
+
+LOCAL_D TInt64 TheSeed = 0x5eed1234;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C void FillRandom(TAny* aBuffer, TInt aBytes)
+	{
+	TUint8* byte = static_cast<TUint8*>(aBuffer);
+	for (TInt index = 0; index < aBytes; index++)
+		byte[index] = TUint8(Random() >> 8);
+	}
+
+/**
+The documented effect of aDrawMode on one pixel.
+@param aDest	Destination pixel
+@param aPen		Pen pixel, already inverted for EInvertPen, or source pixel of a line
+@param aLine	ETrue if aPen is a source pixel, which EInvertPen inverts here
+*/
+LOCAL_C TUint32 ReferencePixel(const TModeFunctions& aMode, CGraphicsContext::TDrawMode aDrawMode,
+							   TUint32 aDest, TUint32 aPen, TBool aLine)
+	{
+	const TUint32 white = aMode.iFromRgb(KRgbWhite);
+	if (aLine && (aDrawMode & CGraphicsContext::EInvertPen))
+		aPen ^= white;
+	TUint32 result;
+	if (aDrawMode & (CGraphicsContext::EPenmode | CGraphicsContext::EWriteAlpha))
+		result = aPen;
+	else
+		{
+		result = aDrawMode & CGraphicsContext::EInvertScreen ? aDest ^ white : aDest;
+		if (aDrawMode & CGraphicsContext::EXor)
+			result ^= aPen;
+		else if (aDrawMode & CGraphicsContext::EAnd)
+			result &= aPen;
+		else if (aDrawMode & CGraphicsContext::EOr)
+			result |= aPen;
+		}
+	if (aMode.iMode == EColor16MU)
+		result = (result & 0x00ffffff) | 0xff000000;
+	return aMode.iBitsPerPixel == 32 ? result : result & ((1u << aMode.iBitsPerPixel) - 1);
+	}
+
+/**
+Checks one span of aFunction against ReferencePixel(), including the pixels around it.
+*/
+LOCAL_C TBool CheckSpan(const TModeFunctions& aMode, CGraphicsContext::TDrawMode aDrawMode,
+						const TRasterOp& aOp, TUint32 aPen, TRasterFunction aFunction, TInt aX, TInt aLength)
+	{
+	TUint32 expected[KLineWords];
+	TUint32 actual[KLineWords];
+	TUint32 src[KLineWords];
+	TUint32 bits[KBinaryWords];
+	FillRandom(expected, sizeof(expected));
+	FillRandom(src, sizeof(src));
+	FillRandom(bits, sizeof(bits));
+	if (aMode.iMode == EColor16MU)
+		{
+		for (TInt index = 0; index < KLineWords; index++)
+			expected[index] |= 0xff000000;
+		}
+	Mem::Copy(actual, expected, sizeof(expected));
+	for (TInt index = 0; index < aLength; index++)
+		{
+		const TUint32 dest = aMode.iReadPixel(expected, aX + index);
+		if (aFunction == ECombineLine)
+			aMode.iWritePixel(expected, aX + index, ReferencePixel(aMode, aDrawMode, dest, aMode.iReadPixel(src, index), ETrue));
+		else if (aFunction == EFillSpan || (bits[index >> 5] & (1u << (index & 31))))
+			aMode.iWritePixel(expected, aX + index, ReferencePixel(aMode, aDrawMode, dest, aPen, EFalse));
+		}
+	switch (aFunction)
+		{
+	case EFillSpan:
+		aOp.FillSpan(actual, aX, aLength);
+		break;
+	case EFillBinary:
+		aOp.FillBinary(actual, aX, bits, aLength);
+		break;
+	default:
+		aOp.CombineLine(actual, aX, src, aLength);
+		break;
+		}
+	return Mem::Compare(reinterpret_cast<const TUint8*>(expected), sizeof(expected),
+						reinterpret_cast<const TUint8*>(actual), sizeof(actual)) == 0;
+	}
+
+/**
+Checks every function of the raster operation of aDrawMode in aMode.
+*/
+LOCAL_C void TestDrawMode(const TModeFunctions& aMode, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	for (TInt length = 0; length <= KMaxLength; length++)
+		{
+		for (TInt span = 0; span < KSpansPerLength; span++)
+			{
+			const TRgb color(Random() & 0x00ffffff, 0xff);
+			TRasterOp op;
+			test(op.Set(aMode.iMode, aDrawMode, color) == KErrNone);
+			const TRgb pen(aDrawMode & CGraphicsContext::EInvertPen ?
+						   TRgb(0xff - color.Red(), 0xff - color.Green(), 0xff - color.Blue()) : color);
+			const TUint32 penPixel = aMode.iFromRgb(pen);
+
+			TUint32 dest = 0;
+			FillRandom(&dest, sizeof(dest));
+			dest &= aMode.iBitsPerPixel == 32 ? 0xffffffffu : (1u << aMode.iBitsPerPixel) - 1;
+			test(op.Pixel(dest) == ReferencePixel(aMode, aDrawMode, dest, penPixel, EFalse));
+
+			for (TInt function = 0; function < ERasterFunctionCount; function++)
+				{
+				const TInt x = Random() % (KMaxOffset + 1);
+				const TBool same = CheckSpan(aMode, aDrawMode, op, penPixel, TRasterFunction(function), x, length);
+				if (!same)
+					test.Printf(_L("%s: %s, draw mode %d, x %d, length %d\n"),
+								KFunctionNames[function], aMode.iName, aDrawMode, x, length);
+				test(same);
+				}
+			}
+		}
+	}
+
+LOCAL_C void DoTests()
+	{
+	test.Start(_L("Supported draw modes"));
+	test(TRasterOp::IsSupported(EColor16MA, CGraphicsContext::EDrawModePEN));
+	test(TRasterOp::IsSupported(EColor16MAP, CGraphicsContext::EDrawModeWriteAlpha));
+	test(!TRasterOp::IsSupported(EColor16MA, CGraphicsContext::EDrawModeXOR));
+	test(!TRasterOp::IsSupported(EColor16MAP, CGraphicsContext::EDrawModeAND));
+	test(!TRasterOp::IsSupported(ENone, CGraphicsContext::EDrawModePEN));
+	TRasterOp op;
+	test(op.Set(EColor16MU, CGraphicsContext::EDrawModePEN, TRgb(0x123456, 0x80)) == KErrNotSupported);
+	test(op.Set(EColor16MA, CGraphicsContext::EDrawModeOR, KRgbWhite) == KErrNotSupported);
+
+	test.Next(_L("Raster operations against per-pixel semantics"));
+	const TInt numModes = sizeof(KModes) / sizeof(KModes[0]);
+	const TInt numDrawModes = sizeof(KDrawModes) / sizeof(KDrawModes[0]);
+	for (TInt index = 0; index < numModes; index++)
+		{
+		for (TInt drawMode = 0; drawMode < numDrawModes; drawMode++)
+			{
+			if (TRasterOp::IsSupported(KModes[index].iMode, KDrawModes[drawMode]))
+				TestDrawMode(KModes[index], KDrawModes[drawMode]);
+			}
+		}
+	test.End();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	DoTests();
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
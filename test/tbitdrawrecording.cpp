@@ -0,0 +1,525 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks CRecordingDrawDevice against a bitmap device of the same size drawn directly. The
+// recording device replays into a CInstrumentedDrawDevice over its own bitmap device, whose
+// counters show which primitives reach the target.
+//	- Culling: commands entirely inside a later opaque fill are dropped, fills partly covered
+//	  by one are trimmed, and fills that blend or combine with the destination cull nothing.
+//	- Merging: a fill that forms a rectangle with the previous fill of the same colour and draw
+//	  mode, and WriteLine() and WriteRgbAlphaMulti() spans that continue the previous span of the
+//	  row, are recorded as one command; fills that form a rectangle once the commands between
+//	  them are culled are replayed as one.
+//	- Flushing: reads and state changes replay the commands, UpdateRegion() does not, and
+//	  full buffers flush by themselves.
+//	- Random primitives, with many opaque fills and with the source buffers changed after
+//	  every call, flushed at random points.
+// After each case every pixel is compared with ReadPixel().
+//
+// Usage: tbitdrawrecording
+// The process panics at the first failure, after printing the pixel or counter involved.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "BitDrawRecording.h"
+#include "BitDrawInstrumented.h"
+
+LOCAL_D RTest test(_L("TBitDrawRecording"));
+
+/** Size of the devices checked. */
+const TInt KDeviceWidth = 72;
+const TInt KDeviceHeight = 48;
+const TInt KIterations = 200;
+
+LOCAL_D TInt64 TheSeed = 0x5eed4ec0;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C TInt Random(TInt aLow, TInt aHigh)
+	{
+	return aLow + TInt(Random() % TUint32(aHigh - aLow));
+	}
+
+LOCAL_C TRect RandomRect()
+	{
+	const TInt x = Random(0, KDeviceWidth);
+	const TInt y = Random(0, KDeviceHeight);
+	// Mostly small rectangles, and some large ones to cull them.
+	const TInt maxSize = Random() % 4 ? 12 : KDeviceWidth;
+	return TRect(x, y, Min(KDeviceWidth, x + Random(1, maxSize + 1)), Min(KDeviceHeight, y + Random(1, maxSize + 1)));
+	}
+
+/**
+A recording device and a bitmap device drawn directly, with the counters of the primitives
+the recording device replays.
+*/
+class TRecordingDevices
+	{
+public:
+	TRecordingDevices();
+	void CreateL();
+	void Close();
+	void Clear();
+	void Compare(const TText* aCase);
+	void CheckReplayed(TDrawPrimitive aPrimitive, TUint32 aCalls, TInt64 aPixels);
+public:
+	CRecordingDrawDevice* iRecording;
+	CFbsDrawDevice* iDirect;
+	MDrawDeviceCounters* iCounters;
+private:
+	TUint8* iRecordingBits;
+	TUint8* iDirectBits;
+	RArray<TDrawCounter> iSnapshot;
+	};
+
+TRecordingDevices::TRecordingDevices():
+	iRecording(NULL),
+	iDirect(NULL),
+	iCounters(NULL),
+	iRecordingBits(NULL),
+	iDirectBits(NULL)
+	{
+	}
+
+void TRecordingDevices::CreateL()
+	{
+	const TSize size(KDeviceWidth, KDeviceHeight);
+	const TInt stride = KDeviceWidth * 4;
+	iRecordingBits = static_cast<TUint8*>(User::AllocZL(stride * KDeviceHeight));
+	iDirectBits = static_cast<TUint8*>(User::AllocZL(stride * KDeviceHeight));
+	iDirect = CFbsDrawDevice::NewBitmapDeviceL(size, EColor16MU, stride);
+	iDirect->SetBits(iDirectBits);
+	CFbsDrawDevice* target = CFbsDrawDevice::NewBitmapDeviceL(size, EColor16MU, stride);
+	CleanupStack::PushL(target);
+	target->SetBits(iRecordingBits);
+	CInstrumentedDrawDevice* instrumented = CInstrumentedDrawDevice::NewL(target);
+	CleanupStack::Pop(target);
+	CleanupStack::PushL(instrumented);
+	iRecording = CRecordingDrawDevice::NewL(instrumented);
+	CleanupStack::Pop(instrumented);
+	instrumented->SetCountersEnabled(ETrue);
+	iCounters = instrumented;
+	}
+
+void TRecordingDevices::Close()
+	{
+	delete iRecording;
+	iRecording = NULL;
+	delete iDirect;
+	iDirect = NULL;
+	iCounters = NULL;
+	User::Free(iRecordingBits);
+	iRecordingBits = NULL;
+	User::Free(iDirectBits);
+	iDirectBits = NULL;
+	iSnapshot.Close();
+	}
+
+/**
+Flushes, then fills both devices with the same random pixels and resets the counters.
+*/
+void TRecordingDevices::Clear()
+	{
+	iRecording->Flush();
+	TUint32* recordingPixels = reinterpret_cast<TUint32*>(iRecordingBits);
+	TUint32* directPixels = reinterpret_cast<TUint32*>(iDirectBits);
+	for (TInt index = 0; index < KDeviceWidth * KDeviceHeight; index++)
+		recordingPixels[index] = directPixels[index] = Random() | 0xff000000;
+	iCounters->ResetCounters();
+	}
+
+/**
+Flushes the recording device and compares every pixel with the direct device.
+*/
+void TRecordingDevices::Compare(const TText* aCase)
+	{
+	iRecording->Flush();
+	test(iRecording->RecordedCount() == 0);
+	for (TInt y = 0; y < KDeviceHeight; y++)
+		{
+		for (TInt x = 0; x < KDeviceWidth; x++)
+			{
+			const TRgb recorded = iRecording->ReadPixel(x, y);
+			const TRgb direct = iDirect->ReadPixel(x, y);
+			if (recorded != direct)
+				{
+				test.Printf(_L("%s: [%d,%d] is %08x, drawn directly %08x\n"), aCase, x, y,
+							recorded.Internal(), direct.Internal());
+				test(EFalse);
+				}
+			}
+		}
+	}
+
+/**
+Checks the calls of aPrimitive that reached the target since the counters were reset.
+*/
+void TRecordingDevices::CheckReplayed(TDrawPrimitive aPrimitive, TUint32 aCalls, TInt64 aPixels)
+	{
+	iRecording->Flush();
+	test(iCounters->GetCounters(iSnapshot) == KErrNone);
+	TUint32 calls = 0;
+	TInt64 pixels = 0;
+	for (TInt index = 0; index < iSnapshot.Count(); index++)
+		{
+		if (iSnapshot[index].iPrimitive == aPrimitive)
+			{
+			calls += iSnapshot[index].iCalls;
+			pixels += iSnapshot[index].iPixels;
+			}
+		}
+	if (calls != aCalls || pixels != aPixels)
+		{
+		test.Printf(_L("primitive %d: %d calls, %d pixels replayed, expected %d, %d\n"),
+					aPrimitive, calls, I64INT(pixels), aCalls, I64INT(aPixels));
+		test(EFalse);
+		}
+	}
+
+/**
+Draws a fill into both devices.
+*/
+LOCAL_C void Fill(TRecordingDevices& aDevices, const TRect& aRect, TRgb aColor,
+				  CGraphicsContext::TDrawMode aDrawMode = CGraphicsContext::EDrawModePEN)
+	{
+	aDevices.iRecording->WriteRgbMulti(aRect.iTl.iX, aRect.iTl.iY, aRect.Width(), aRect.Height(), aColor, aDrawMode);
+	aDevices.iDirect->WriteRgbMulti(aRect.iTl.iX, aRect.iTl.iY, aRect.Width(), aRect.Height(), aColor, aDrawMode);
+	}
+
+LOCAL_C void Line(TRecordingDevices& aDevices, TInt aX, TInt aY, TInt aLength, TUint32* aBuffer)
+	{
+	aDevices.iRecording->WriteLine(aX, aY, aLength, aBuffer, CGraphicsContext::EDrawModePEN);
+	aDevices.iDirect->WriteLine(aX, aY, aLength, aBuffer, CGraphicsContext::EDrawModePEN);
+	}
+
+LOCAL_C void AlphaMulti(TRecordingDevices& aDevices, TInt aX, TInt aY, TInt aLength, TRgb aColor, const TUint8* aMask)
+	{
+	aDevices.iRecording->WriteRgbAlphaMulti(aX, aY, aLength, aColor, aMask);
+	aDevices.iDirect->WriteRgbAlphaMulti(aX, aY, aLength, aColor, aMask);
+	}
+
+LOCAL_C void TestCull(TRecordingDevices& aDevices)
+	{
+	TUint32 buffer[KDeviceWidth];
+	TUint8 mask[KDeviceWidth];
+	for (TInt index = 0; index < KDeviceWidth; index++)
+		{
+		buffer[index] = Random() | 0xff000000;
+		mask[index] = TUint8(Random());
+		}
+	const TRgb mapping[2] = { KRgbRed, KRgbBlue };
+
+	// A fill inside a later opaque fill.
+	aDevices.Clear();
+	Fill(aDevices, TRect(4, 4, 20, 10), KRgbRed);
+	Fill(aDevices, TRect(2, 2, 30, 20), KRgbGreen);
+	test(aDevices.iRecording->RecordedCount() == 2);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 1, 28 * 18);
+	aDevices.Compare(_S("covered fill"));
+
+	// Every kind of command inside a later fill with EDrawModeWriteAlpha.
+	aDevices.Clear();
+	Line(aDevices, 5, 5, 20, buffer);
+	aDevices.iRecording->WriteBinary(5, 6, buffer, 20, 3, KRgbBlue, CGraphicsContext::EDrawModeXOR);
+	aDevices.iDirect->WriteBinary(5, 6, buffer, 20, 3, KRgbBlue, CGraphicsContext::EDrawModeXOR);
+	AlphaMulti(aDevices, 5, 9, 20, KRgbYellow, mask);
+	aDevices.iRecording->MapColors(TRect(5, 10, 25, 15), mapping, 1, ETrue);
+	aDevices.iDirect->MapColors(TRect(5, 10, 25, 15), mapping, 1, ETrue);
+	aDevices.iRecording->ShadowArea(TRect(5, 5, 25, 15));
+	aDevices.iDirect->ShadowArea(TRect(5, 5, 25, 15));
+	Fill(aDevices, TRect(5, 5, 25, 15), TRgb(0x123456, 0x40), CGraphicsContext::EDrawModeWriteAlpha);
+	aDevices.CheckReplayed(EPrimitiveWriteLine, 0, 0);
+	aDevices.CheckReplayed(EPrimitiveWriteBinary, 0, 0);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbAlphaMulti, 0, 0);
+	aDevices.CheckReplayed(EPrimitiveMapColors, 0, 0);
+	aDevices.CheckReplayed(EPrimitiveShadowArea, 0, 0);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 1, 20 * 10);
+	aDevices.Compare(_S("covered commands"));
+
+	// Fills trimmed by a later fill across their top, bottom, left and right.
+	aDevices.Clear();
+	Fill(aDevices, TRect(10, 10, 30, 30), KRgbRed);
+	Fill(aDevices, TRect(40, 10, 60, 30), KRgbRed);
+	Fill(aDevices, TRect(8, 0, 32, 15), KRgbGreen);
+	Fill(aDevices, TRect(38, 25, 62, 40), KRgbBlue);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 4, 20 * 15 + 20 * 15 + 24 * 15 + 24 * 15);
+	aDevices.Compare(_S("trimmed vertically"));
+	aDevices.Clear();
+	Fill(aDevices, TRect(10, 10, 30, 30), KRgbRed);
+	Fill(aDevices, TRect(40, 10, 60, 30), KRgbRed);
+	Fill(aDevices, TRect(0, 5, 20, 35), KRgbGreen);
+	Fill(aDevices, TRect(50, 5, 70, 35), KRgbBlue);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 4, 10 * 20 + 10 * 20 + 20 * 30 + 20 * 30);
+	aDevices.Compare(_S("trimmed horizontally"));
+
+	// A later fill over a corner leaves an L shape, which is drawn whole.
+	aDevices.Clear();
+	Fill(aDevices, TRect(10, 10, 30, 30), KRgbRed);
+	Fill(aDevices, TRect(20, 20, 40, 40), KRgbGreen);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 2, 400 + 400);
+	aDevices.Compare(_S("corner"));
+
+	// Fills that read the destination, or are not opaque, cull nothing.
+	aDevices.Clear();
+	Line(aDevices, 5, 5, 20, buffer);
+	Fill(aDevices, TRect(0, 0, 30, 10), TRgb(0x808080, 0x80));
+	Line(aDevices, 5, 6, 20, buffer);
+	Fill(aDevices, TRect(0, 0, 30, 10), KRgbWhite, CGraphicsContext::EDrawModeXOR);
+	Line(aDevices, 5, 7, 20, buffer);
+	Fill(aDevices, TRect(0, 0, 30, 10), KRgbWhite, CGraphicsContext::EDrawModeOR);
+	aDevices.CheckReplayed(EPrimitiveWriteLine, 3, 60);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 3, 900);
+	aDevices.Compare(_S("blending fills"));
+
+	// A command only partly covered is replayed whole.
+	aDevices.Clear();
+	Fill(aDevices, TRect(0, 0, 10, 10), KRgbRed);
+	Line(aDevices, 0, 5, 30, buffer);
+	Fill(aDevices, TRect(0, 0, 20, 20), KRgbBlue, CGraphicsContext::EDrawModeXOR);
+	Fill(aDevices, TRect(0, 0, 20, 20), KRgbGreen);
+	aDevices.CheckReplayed(EPrimitiveWriteLine, 1, 30);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 1, 400);
+	aDevices.Compare(_S("partly covered line"));
+	}
+
+LOCAL_C void TestMerge(TRecordingDevices& aDevices)
+	{
+	TUint32 buffer[KDeviceWidth];
+	TUint8 mask[KDeviceWidth];
+	for (TInt index = 0; index < KDeviceWidth; index++)
+		{
+		buffer[index] = Random() | 0xff000000;
+		mask[index] = TUint8(Random());
+		}
+
+	// Pixels merge into a span while recording, and the spans of the rows into a rectangle when
+	// they are replayed.
+	aDevices.Clear();
+	for (TInt y = 3; y < 6; y++)
+		{
+		for (TInt x = 10; x < 20; x++)
+			{
+			aDevices.iRecording->WriteRgb(x, y, KRgbRed, CGraphicsContext::EDrawModeXOR);
+			aDevices.iDirect->WriteRgb(x, y, KRgbRed, CGraphicsContext::EDrawModeXOR);
+			}
+		}
+	test(aDevices.iRecording->RecordedCount() == 3);
+	aDevices.CheckReplayed(EPrimitiveWriteRgb, 0, 0);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 1, 30);
+	aDevices.Compare(_S("pixels"));
+
+	// Fills that differ in colour or draw mode, or do not form a rectangle, are not merged.
+	aDevices.Clear();
+	Fill(aDevices, TRect(0, 0, 10, 5), KRgbRed);
+	Fill(aDevices, TRect(10, 0, 20, 5), KRgbBlue);
+	Fill(aDevices, TRect(20, 0, 30, 5), KRgbBlue, CGraphicsContext::EDrawModeXOR);
+	Fill(aDevices, TRect(30, 0, 40, 6), KRgbBlue, CGraphicsContext::EDrawModeXOR);
+	Fill(aDevices, TRect(30, 7, 40, 9), KRgbBlue, CGraphicsContext::EDrawModeXOR);
+	test(aDevices.iRecording->RecordedCount() == 5);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 5, 50 + 50 + 50 + 60 + 20);
+	aDevices.Compare(_S("unmerged fills"));
+
+	// Fills of the same colour merge once the fill between them is culled.
+	aDevices.Clear();
+	Fill(aDevices, TRect(0, 0, 10, 2), KRgbRed);
+	Fill(aDevices, TRect(0, 2, 10, 4), KRgbGreen);
+	Fill(aDevices, TRect(0, 2, 10, 4), KRgbRed);
+	test(aDevices.iRecording->RecordedCount() == 3);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbMulti, 1, 40);
+	aDevices.Compare(_S("merged after culling"));
+
+	// Continuing spans of a row merge, a gap or another row starts a new span.
+	aDevices.Clear();
+	Line(aDevices, 0, 5, 7, buffer);
+	Line(aDevices, 7, 5, 13, buffer + 7);
+	Line(aDevices, 20, 5, 13, buffer + 20);
+	test(aDevices.iRecording->RecordedCount() == 1);
+	Line(aDevices, 34, 5, 10, buffer);
+	Line(aDevices, 44, 6, 10, buffer);
+	test(aDevices.iRecording->RecordedCount() == 3);
+	aDevices.CheckReplayed(EPrimitiveWriteLine, 3, 53);
+	aDevices.Compare(_S("lines"));
+	aDevices.Clear();
+	AlphaMulti(aDevices, 0, 5, 7, KRgbRed, mask);
+	AlphaMulti(aDevices, 7, 5, 13, KRgbRed, mask + 7);
+	AlphaMulti(aDevices, 20, 5, 13, KRgbBlue, mask + 20);
+	test(aDevices.iRecording->RecordedCount() == 2);
+	AlphaMulti(aDevices, 33, 5, 10, KRgbBlue, mask);
+	test(aDevices.iRecording->RecordedCount() == 2);
+	aDevices.CheckReplayed(EPrimitiveWriteRgbAlphaMulti, 2, 43);
+	aDevices.Compare(_S("alpha spans"));
+	}
+
+LOCAL_C void TestFlush(TRecordingDevices& aDevices)
+	{
+	CRecordingDrawDevice& device = *aDevices.iRecording;
+	aDevices.Clear();
+	Fill(aDevices, TRect(0, 0, 10, 10), KRgbRed);
+	device.UpdateRegion(TRect(0, 0, 10, 10));
+	test(device.RecordedCount() == 1);
+	test(device.ReadPixel(5, 5) == aDevices.iDirect->ReadPixel(5, 5));
+	test(device.RecordedCount() == 0);
+
+	TUint32 buffer[KDeviceWidth];
+	Fill(aDevices, TRect(0, 0, 10, 10), KRgbBlue);
+	device.ReadLine(0, 0, KDeviceWidth, buffer, EColor16MU);
+	test(device.RecordedCount() == 0);
+	Fill(aDevices, TRect(0, 0, 10, 10), KRgbGreen);
+	device.SetShadowMode(CFbsDrawDevice::ENoShadow);
+	test(device.RecordedCount() == 0);
+	Fill(aDevices, TRect(0, 0, 10, 10), KRgbYellow);
+	device.Update();
+	test(device.RecordedCount() == 0);
+	aDevices.Compare(_S("flushing calls"));
+
+	// Full command buffer.
+	aDevices.Clear();
+	for (TInt index = 0; index <= KMaxRecordedCommands; index++)
+		{
+		const TInt x = index % KDeviceWidth;
+		const TInt y = (index / KDeviceWidth) % KDeviceHeight;
+		Fill(aDevices, TRect(x, y, x + 1, y + 1), index & 1 ? KRgbRed : KRgbBlue, CGraphicsContext::EDrawModeXOR);
+		}
+	test(device.RecordedCount() == 1);
+	aDevices.Compare(_S("full commands"));
+
+	// Full data buffer.
+	aDevices.Clear();
+	const TInt lineBytes = KDeviceWidth * 4;
+	const TInt numLines = KMaxRecordedBytes / lineBytes + 1;
+	for (TInt index = 0; index < numLines; index++)
+		{
+		for (TInt x = 0; x < KDeviceWidth; x++)
+			buffer[x] = Random() | 0xff000000;
+		Line(aDevices, 0, index % KDeviceHeight, KDeviceWidth, buffer);
+		}
+	test(device.RecordedCount() == 1);
+	aDevices.Compare(_S("full data"));
+	}
+
+LOCAL_C void TestRandom(TRecordingDevices& aDevices)
+	{
+	CFbsDrawDevice* devices[2] = { aDevices.iRecording, aDevices.iDirect };
+	TUint32 buffer[KDeviceWidth * 2];
+	TUint32 background[KDeviceWidth];
+	TUint8 mask[KDeviceWidth];
+	TRgb mapping[4];
+	for (TInt iteration = 0; iteration < KIterations; iteration++)
+		{
+		aDevices.Clear();
+		for (TInt count = Random(1, 40); count > 0; count--)
+			{
+			// The recording device must copy the source data, so it changes after every call.
+			for (TInt index = 0; index < KDeviceWidth; index++)
+				{
+				buffer[index] = Random() | 0xff000000;
+				buffer[KDeviceWidth + index] = Random();
+				background[index] = Random() | 0xff000000;
+				mask[index] = TUint8(Random());
+				}
+			const TRect rect(RandomRect());
+			const TRgb color(Random() & 0xff, Random() & 0xff, Random() & 0xff, Random() % 3 ? 0xff : Random() & 0xff);
+			const CGraphicsContext::TDrawMode drawMode = Random() % 3 ? CGraphicsContext::EDrawModePEN :
+														 CGraphicsContext::EDrawModeXOR;
+			const TInt primitive = Random() % 13;
+			const TBool flag = Random() & 1;
+			for (TInt pair = 0; pair < 4; pair++)
+				mapping[pair] = TRgb(buffer[pair]);
+			for (TInt index = 0; index < 2; index++)
+				{
+				CFbsDrawDevice& device = *devices[index];
+				switch (primitive)
+					{
+				case 0:
+				case 1:
+				case 2:
+					device.WriteRgbMulti(rect.iTl.iX, rect.iTl.iY, rect.Width(), rect.Height(), color, drawMode);
+					break;
+				case 3:
+					device.WriteRgb(rect.iTl.iX, rect.iTl.iY, color, drawMode);
+					break;
+				case 4:
+					device.WriteLine(rect.iTl.iX, rect.iTl.iY, rect.Width(), buffer, drawMode);
+					break;
+				case 5:
+					device.WriteBinary(rect.iTl.iX, rect.iTl.iY, buffer + KDeviceWidth, Min(rect.Width(), 32), rect.Height(),
+									   color, drawMode);
+					break;
+				case 6:
+					device.WriteBinaryLine(rect.iTl.iX, rect.iTl.iY, buffer + KDeviceWidth, rect.Width(), color, drawMode);
+					break;
+				case 7:
+					if (flag)
+						device.WriteBinaryLineVertical(rect.iTl.iX, rect.iBr.iY - 1, buffer + KDeviceWidth, rect.Height(), color, drawMode, ETrue);
+					else
+						device.WriteBinaryLineVertical(rect.iTl.iX, rect.iTl.iY, buffer + KDeviceWidth, rect.Height(), color, drawMode, EFalse);
+					break;
+				case 8:
+					device.WriteRgbAlphaLine(rect.iTl.iX, rect.iTl.iY, rect.Width(), reinterpret_cast<TUint8*>(buffer), mask, drawMode);
+					break;
+				case 9:
+					device.WriteRgbAlphaLine(rect.iTl.iX, rect.iTl.iY, rect.Width(), reinterpret_cast<TUint8*>(buffer),
+											 reinterpret_cast<TUint8*>(background), mask, CGraphicsContext::EDrawModePEN);
+					break;
+				case 10:
+					device.WriteRgbAlphaMulti(rect.iTl.iX, rect.iTl.iY, rect.Width(), color, mask);
+					break;
+				default:
+					if (primitive == 11)
+						device.ShadowArea(rect);
+					else
+						device.MapColors(rect, mapping, 2, flag);
+					break;
+					}
+				}
+			if (Random() % 16 == 0)
+				aDevices.iRecording->Flush();
+			}
+		aDevices.Compare(_S("random primitives"));
+		}
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	TRecordingDevices devices;
+	CleanupClosePushL(devices);
+	devices.CreateL();
+	test.Start(_L("Culling"));
+	TestCull(devices);
+	test.Next(_L("Merging"));
+	TestMerge(devices);
+	test.Next(_L("Flushing"));
+	TestFlush(devices);
+	test.Next(_L("Random primitives"));
+	TestRandom(devices);
+	test.End();
+	CleanupStack::PopAndDestroy(&devices);
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
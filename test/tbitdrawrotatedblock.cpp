@@ -0,0 +1,353 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks the tiled transposes of TRotatedBlock against reading and writing every logical pixel on
+// its own through TDirectScanLineInfo::PixelAddress():
+//	- WriteBlock() sets each pixel of the rectangle to the pixel of the buffer at the same place;
+//	- ReadBlock() returns each pixel of the rectangle, leaving the padding between buffer rows
+//	  unchanged;
+//	- WriteBinaryBlockVertical() sets the pixels of the set bits of each line, upward or downward.
+// Pixel memory of KPhysicalWidth x KPhysicalHeight pixels, filled with random pixels, is accessed
+// in every orientation through a TDirectScanLineInfo, with rectangles of random size and position
+// that are mostly not multiples of the tile size. Pixels outside the rectangle must be left
+// unchanged. Scaled and sub-byte layouts must be refused.
+//
+// Usage: tbitdrawrotatedblock
+// The process panics at the first difference, after printing the function, mode, orientation
+// and rectangle.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "BitDrawRotatedBlock.h"
+#include "BitDrawPixelFormat.h"
+
+LOCAL_D RTest test(_L("TBitDrawRotatedBlock"));
+
+const TInt KPhysicalWidth = 83;
+const TInt KPhysicalHeight = 71;
+/** Bytes between physical rows: a little more than a row of 32bpp pixels. */
+const TInt KStride = KPhysicalWidth * 4 + 8;
+const TInt KMemoryBytes = KStride * KPhysicalHeight;
+/** Largest padding at the end of each row of the linear buffer, in bytes. */
+const TInt KMaxPadding = 7;
+const TInt KBufferBytes = (KPhysicalWidth * 4 + KMaxPadding) * KPhysicalWidth;
+/** Largest number of words for each line of WriteBinaryBlockVertical(). */
+const TInt KMaxColumnWords = (KPhysicalWidth + 31) / 32 + 1;
+const TInt KIterations = 60;
+
+/** Display modes checked, one per pixel size. */
+LOCAL_D const TDisplayMode KModes[] =
+	{
+	EColor256, EColor64K, EColor16M, EColor16MU
+	};
+
+LOCAL_D const CFbsDrawDevice::TOrientation KOrientations[] =
+	{
+	CFbsDrawDevice::EOrientationNormal, CFbsDrawDevice::EOrientationRotated90,
+	CFbsDrawDevice::EOrientationRotated180, CFbsDrawDevice::EOrientationRotated270
+	};
+
+/**
+Functions checked.
+*/
+enum TBlockFunction
+	{
+	EWriteBlock,
+	EReadBlock,
+	EWriteBinaryBlockVertical,
+	EBlockFunctionCount
+	};
+
+LOCAL_D const TText* const KFunctionNames[EBlockFunctionCount] =
+	{
+	_S("WriteBlock"), _S("ReadBlock"), _S("WriteBinaryBlockVertical")
+	};
+
+LOCAL_D TInt64 TheSeed = 0x5eed7a90;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C TInt Random(TInt aLow, TInt aHigh)
+	{
+	return aLow + TInt(Random() % TUint32(aHigh - aLow));
+	}
+
+LOCAL_C void FillRandom(TAny* aBuffer, TInt aBytes)
+	{
+	TUint8* byte = static_cast<TUint8*>(aBuffer);
+	for (TInt index = 0; index < aBytes; index++)
+		byte[index] = TUint8(Random() >> 8);
+	}
+
+/**
+Pixel memory and its layout, and a copy of the memory that the reference implementation
+is applied to.
+*/
+class TBlockMemory
+	{
+public:
+	TBlockMemory(TUint8* aMemory, TUint8* aExpected);
+	void Reset(TDisplayMode aMode, CFbsDrawDevice::TOrientation aOrientation);
+	TRect RandomRect() const;
+	TUint8* Expected(TInt aLogicalX, TInt aLogicalY) const;
+	TBool IsExpected() const;
+public:
+	TDirectScanLineInfo iInfo;
+	TUint8* iMemory;
+	TUint8* iExpected;
+	TSize iLogicalSize;
+	TInt iBytesPerPixel;
+	};
+
+TBlockMemory::TBlockMemory(TUint8* aMemory, TUint8* aExpected):
+	iMemory(aMemory),
+	iExpected(aExpected),
+	iBytesPerPixel(0)
+	{
+	}
+
+/**
+Sets up the layout of an unscaled device in aOrientation, and fills the memory with random pixels.
+Logical rows run down the physical columns in Rotated90, right to left in Rotated180 and up the
+physical columns in Rotated270.
+*/
+void TBlockMemory::Reset(TDisplayMode aMode, CFbsDrawDevice::TOrientation aOrientation)
+	{
+	iBytesPerPixel = BitsInMemory(aMode) >> 3;
+	iInfo.iBits = iMemory;
+	iInfo.iStride = KStride;
+	iInfo.iDisplayMode = aMode;
+	iInfo.iBitsPerPixel = iBytesPerPixel * 8;
+	iInfo.iPhysicalSize = TSize(KPhysicalWidth, KPhysicalHeight);
+	iInfo.iOrientation = aOrientation;
+	iInfo.iFactorX = 1;
+	iInfo.iFactorY = 1;
+	switch (aOrientation)
+		{
+	case CFbsDrawDevice::EOrientationRotated90:
+		iInfo.iPhysicalOrigin = TPoint(KPhysicalWidth - 1, 0);
+		iInfo.iLogicalXStep = TPoint(0, 1);
+		iInfo.iLogicalYStep = TPoint(-1, 0);
+		break;
+	case CFbsDrawDevice::EOrientationRotated180:
+		iInfo.iPhysicalOrigin = TPoint(KPhysicalWidth - 1, KPhysicalHeight - 1);
+		iInfo.iLogicalXStep = TPoint(-1, 0);
+		iInfo.iLogicalYStep = TPoint(0, -1);
+		break;
+	case CFbsDrawDevice::EOrientationRotated270:
+		iInfo.iPhysicalOrigin = TPoint(0, KPhysicalHeight - 1);
+		iInfo.iLogicalXStep = TPoint(0, -1);
+		iInfo.iLogicalYStep = TPoint(1, 0);
+		break;
+	default:
+		iInfo.iPhysicalOrigin = TPoint(0, 0);
+		iInfo.iLogicalXStep = TPoint(1, 0);
+		iInfo.iLogicalYStep = TPoint(0, 1);
+		break;
+		}
+	const TBool swapped = iInfo.iLogicalXStep.iX == 0;
+	iLogicalSize = swapped ? TSize(KPhysicalHeight, KPhysicalWidth) : TSize(KPhysicalWidth, KPhysicalHeight);
+	FillRandom(iMemory, KMemoryBytes);
+	Mem::Copy(iExpected, iMemory, KMemoryBytes);
+	}
+
+/**
+@return A logical rectangle of at least one pixel within the device; a third of them are
+no more than one tile wide or high.
+*/
+TRect TBlockMemory::RandomRect() const
+	{
+	const TInt maxWidth = Random() % 3 ? iLogicalSize.iWidth : 16;
+	const TInt maxHeight = Random() % 3 ? iLogicalSize.iHeight : 16;
+	const TInt width = Random(1, maxWidth + 1);
+	const TInt height = Random(1, maxHeight + 1);
+	const TPoint topLeft(Random(0, iLogicalSize.iWidth - width + 1), Random(0, iLogicalSize.iHeight - height + 1));
+	return TRect(topLeft, TSize(width, height));
+	}
+
+/**
+@return The address in the expected memory of the logical pixel [aLogicalX,aLogicalY].
+*/
+TUint8* TBlockMemory::Expected(TInt aLogicalX, TInt aLogicalY) const
+	{
+	TDirectScanLineInfo expected(iInfo);
+	expected.iBits = iExpected;
+	return static_cast<TUint8*>(expected.PixelAddress(aLogicalX, aLogicalY));
+	}
+
+TBool TBlockMemory::IsExpected() const
+	{
+	return Mem::Compare(iMemory, KMemoryBytes, iExpected, KMemoryBytes) == 0;
+	}
+
+LOCAL_C TBool CheckWriteBlock(TBlockMemory& aMemory, const TRect& aRect, TUint8* aBuffer)
+	{
+	const TInt bytes = aMemory.iBytesPerPixel;
+	const TInt stride = aRect.Width() * bytes + Random(0, KMaxPadding + 1);
+	FillRandom(aBuffer, stride * aRect.Height());
+	if (TRotatedBlock::WriteBlock(aMemory.iInfo, aRect, aBuffer, stride) != KErrNone)
+		return EFalse;
+	for (TInt j = 0; j < aRect.Height(); j++)
+		{
+		for (TInt i = 0; i < aRect.Width(); i++)
+			Mem::Copy(aMemory.Expected(aRect.iTl.iX + i, aRect.iTl.iY + j), aBuffer + j * stride + i * bytes, bytes);
+		}
+	return aMemory.IsExpected();
+	}
+
+LOCAL_C TBool CheckReadBlock(TBlockMemory& aMemory, const TRect& aRect, TUint8* aBuffer, TUint8* aExpectedBuffer)
+	{
+	const TInt bytes = aMemory.iBytesPerPixel;
+	const TInt stride = aRect.Width() * bytes + Random(0, KMaxPadding + 1);
+	const TInt bufferBytes = stride * aRect.Height();
+	FillRandom(aBuffer, bufferBytes);
+	Mem::Copy(aExpectedBuffer, aBuffer, bufferBytes);
+	if (TRotatedBlock::ReadBlock(aMemory.iInfo, aRect, aBuffer, stride) != KErrNone)
+		return EFalse;
+	for (TInt j = 0; j < aRect.Height(); j++)
+		{
+		for (TInt i = 0; i < aRect.Width(); i++)
+			Mem::Copy(aExpectedBuffer + j * stride + i * bytes, aMemory.Expected(aRect.iTl.iX + i, aRect.iTl.iY + j), bytes);
+		}
+	return aMemory.IsExpected() && Mem::Compare(aBuffer, bufferBytes, aExpectedBuffer, bufferBytes) == 0;
+	}
+
+/**
+The lines start on the top row of aRect when drawn downward, and on its bottom row when drawn upward.
+*/
+LOCAL_C TBool CheckWriteBinaryBlockVertical(TBlockMemory& aMemory, const TRect& aRect, TBool aUp)
+	{
+	TUint32 buffer[KPhysicalWidth * KMaxColumnWords];
+	const TInt height = aRect.Height();
+	const TInt columnWords = (height + 31) / 32 + Random(0, 2);
+	for (TInt index = 0; index < aRect.Width() * columnWords; index++)
+		buffer[index] = Random() ^ (Random() << 16);
+	const TUint32 pixel = Random() ^ (Random() << 16);
+	const TInt y = aUp ? aRect.iBr.iY - 1 : aRect.iTl.iY;
+	if (TRotatedBlock::WriteBinaryBlockVertical(aMemory.iInfo, aRect.iTl.iX, y, buffer, columnWords,
+												aRect.Width(), height, pixel, aUp) != KErrNone)
+		{
+		return EFalse;
+		}
+	for (TInt i = 0; i < aRect.Width(); i++)
+		{
+		const TUint32* column = buffer + i * columnWords;
+		for (TInt j = 0; j < height; j++)
+			{
+			if (column[j >> 5] & (1u << (j & 31)))
+				{
+				TUint8* expected = aMemory.Expected(aRect.iTl.iX + i, aUp ? y - j : y + j);
+				for (TInt byte = 0; byte < aMemory.iBytesPerPixel; byte++)
+					expected[byte] = TUint8(pixel >> (byte * 8));
+				}
+			}
+		}
+	return aMemory.IsExpected();
+	}
+
+LOCAL_C void TestFunction(TBlockMemory& aMemory, TBlockFunction aFunction, TDisplayMode aMode,
+						  CFbsDrawDevice::TOrientation aOrientation, TUint8* aBuffer, TUint8* aExpectedBuffer)
+	{
+	for (TInt iteration = 0; iteration < KIterations; iteration++)
+		{
+		const TRect rect(aMemory.RandomRect());
+		TBool same = EFalse;
+		switch (aFunction)
+			{
+		case EWriteBlock:
+			same = CheckWriteBlock(aMemory, rect, aBuffer);
+			break;
+		case EReadBlock:
+			same = CheckReadBlock(aMemory, rect, aBuffer, aExpectedBuffer);
+			break;
+		default:
+			same = CheckWriteBinaryBlockVertical(aMemory, rect, iteration & 1);
+			break;
+			}
+		if (!same)
+			{
+			test.Printf(_L("%s: mode %d, orientation %d, [%d,%d %d,%d]\n"), KFunctionNames[aFunction], aMode,
+						aOrientation, rect.iTl.iX, rect.iTl.iY, rect.iBr.iX, rect.iBr.iY);
+			}
+		test(same);
+		}
+	}
+
+/**
+Layouts whose pixels are not whole bytes, or which are scaled, are refused without touching memory.
+*/
+LOCAL_C void TestUnsupported(TBlockMemory& aMemory, TUint8* aBuffer)
+	{
+	aMemory.Reset(EColor16MU, CFbsDrawDevice::EOrientationRotated90);
+	const TRect rect(0, 0, 4, 4);
+	const TUint32 bits[4] = { 0xf, 0xf, 0xf, 0xf };
+	test(TRotatedBlock::IsSupported(aMemory.iInfo));
+	aMemory.iInfo.iFactorX = 2;
+	test(!TRotatedBlock::IsSupported(aMemory.iInfo));
+	test(TRotatedBlock::WriteBlock(aMemory.iInfo, rect, aBuffer, 16) == KErrNotSupported);
+	aMemory.iInfo.iFactorX = 1;
+	aMemory.iInfo.iDisplayMode = EColor16;
+	aMemory.iInfo.iBitsPerPixel = 4;
+	test(!TRotatedBlock::IsSupported(aMemory.iInfo));
+	test(TRotatedBlock::ReadBlock(aMemory.iInfo, rect, aBuffer, 16) == KErrNotSupported);
+	test(TRotatedBlock::WriteBinaryBlockVertical(aMemory.iInfo, 0, 0, bits, 1, 4, 4, 0, EFalse) == KErrNotSupported);
+	test(aMemory.IsExpected());
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	TUint8* memory = static_cast<TUint8*>(User::AllocLC(KMemoryBytes));
+	TUint8* expected = static_cast<TUint8*>(User::AllocLC(KMemoryBytes));
+	TUint8* buffer = static_cast<TUint8*>(User::AllocLC(KBufferBytes));
+	TUint8* expectedBuffer = static_cast<TUint8*>(User::AllocLC(KBufferBytes));
+	TBlockMemory blockMemory(memory, expected);
+
+	test.Start(_L("Unsupported layouts"));
+	TestUnsupported(blockMemory, buffer);
+	const TInt numModes = sizeof(KModes) / sizeof(KModes[0]);
+	const TInt numOrientations = sizeof(KOrientations) / sizeof(KOrientations[0]);
+	for (TInt function = 0; function < EBlockFunctionCount; function++)
+		{
+		test.Next(_L("Tiled transposes against per-pixel results"));
+		test.Printf(_L("%s\n"), KFunctionNames[function]);
+		for (TInt index = 0; index < numModes; index++)
+			{
+			for (TInt orientation = 0; orientation < numOrientations; orientation++)
+				{
+				blockMemory.Reset(KModes[index], KOrientations[orientation]);
+				TestFunction(blockMemory, TBlockFunction(function), KModes[index], KOrientations[orientation],
+							 buffer, expectedBuffer);
+				}
+			}
+		}
+	test.End();
+	CleanupStack::PopAndDestroy(4, memory);
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
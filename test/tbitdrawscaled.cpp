@@ -0,0 +1,400 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks the TScaledScanLine kernels against what they are documented to do to every physical
+// pixel of a scaled device:
+//	- ReadLine() returns the top-left physical pixel of each logical pixel;
+//	- ReadLineBoxFiltered() returns the rounded average of each channel of the physical pixels
+//	  a logical pixel covers;
+//	- WriteLine() and WriteRgbMulti() set every physical pixel a logical pixel covers;
+//	- WriteRgbAlphaLine() gives the same result as blending every physical pixel on its own.
+// Pixel memory of KPhysicalWidth x KPhysicalHeight pixels, filled with random pixels, is accessed
+// through a TDirectScanLineInfo with every factor from 1 to KMaxFactor along x and from 1 to
+// KMaxFactorY along y, at random logical origins, for every span length from 0 to KMaxLength
+// that fits. Spans reach the edge of the memory, where physical pixels are clipped, and
+// WriteRgbAlphaLine() spans cross its chunks of KScaledChunkPixels. Pixels outside the span
+// must be left unchanged.
+//
+// Usage: tbitdrawscaled
+// The process panics at the first difference, after printing the function, mode and span.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "BitDrawScaled.h"
+#include "BitDrawPixelFormat.h"
+
+LOCAL_D RTest test(_L("TBitDrawScaled"));
+
+const TInt KPhysicalWidth = 300;
+const TInt KPhysicalHeight = 10;
+/** Bytes between physical rows: a little more than a row of 32bpp pixels. */
+const TInt KStride = KPhysicalWidth * 4 + 8;
+const TInt KMemoryBytes = KStride * KPhysicalHeight;
+const TInt KMaxFactor = 9;
+const TInt KMaxFactorY = 3;
+/** Longest span checked, in logical pixels. */
+const TInt KMaxLength = 67;
+
+/** Display modes checked, one per pixel size. */
+LOCAL_D const TDisplayMode KModes[] =
+	{
+	EColor256, EColor64K, EColor16M, EColor16MU
+	};
+
+/**
+Functions checked.
+*/
+enum TScaledFunction
+	{
+	EReadLine,
+	EReadLineBoxFiltered,
+	EWriteLine,
+	EWriteRgbMulti,
+	EWriteRgbAlphaLine,
+	EScaledFunctionCount
+	};
+
+LOCAL_D const TText* const KFunctionNames[EScaledFunctionCount] =
+	{
+	_S("ReadLine"), _S("ReadLineBoxFiltered"), _S("WriteLine"), _S("WriteRgbMulti"), _S("WriteRgbAlphaLine")
+	};
+
+LOCAL_D TInt64 TheSeed = 0x5eed1234;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C void FillRandom(TAny* aBuffer, TInt aBytes)
+	{
+	TUint8* byte = static_cast<TUint8*>(aBuffer);
+	for (TInt index = 0; index < aBytes; index++)
+		byte[index] = TUint8(Random() >> 8);
+	}
+
+/**
+Pixel memory and its layout, and a copy of the memory that the reference implementation
+is applied to.
+*/
+class TScaledMemory
+	{
+public:
+	TScaledMemory(TUint8* aMemory, TUint8* aExpected);
+	void Reset(TDisplayMode aMode, TInt aFactorX, TInt aFactorY);
+	inline TInt LogicalWidth() const;
+	inline TInt LogicalHeight() const;
+	TUint8* Physical(TUint8* aMemory, TInt aPhysicalX, TInt aPhysicalY) const;
+	void SetBlock(TUint8* aMemory, TInt aX, TInt aY, const TUint8* aPixel) const;
+	TBool IsExpected() const;
+public:
+	TDirectScanLineInfo iInfo;
+	TUint8* iMemory;
+	TUint8* iExpected;
+	TInt iBytesPerPixel;
+	};
+
+TScaledMemory::TScaledMemory(TUint8* aMemory, TUint8* aExpected):
+	iMemory(aMemory),
+	iExpected(aExpected),
+	iBytesPerPixel(0)
+	{
+	}
+
+/**
+Sets up the layout of a device scaled by aFactorX x aFactorY, with a random logical origin,
+and fills the memory with random pixels. For the 32bpp mode the alpha channel is 0xFF, as in
+an EColor16MU device.
+*/
+void TScaledMemory::Reset(TDisplayMode aMode, TInt aFactorX, TInt aFactorY)
+	{
+	iBytesPerPixel = BitsInMemory(aMode) >> 3;
+	iInfo.iBits = iMemory;
+	iInfo.iStride = KStride;
+	iInfo.iDisplayMode = aMode;
+	iInfo.iBitsPerPixel = iBytesPerPixel * 8;
+	iInfo.iPhysicalSize = TSize(KPhysicalWidth, KPhysicalHeight);
+	iInfo.iOrientation = CFbsDrawDevice::EOrientationNormal;
+	iInfo.iPhysicalOrigin = TPoint(Random() % 3, Random() % 3);
+	iInfo.iLogicalXStep = TPoint(1, 0);
+	iInfo.iLogicalYStep = TPoint(0, 1);
+	iInfo.iFactorX = aFactorX;
+	iInfo.iFactorY = aFactorY;
+	FillRandom(iMemory, KMemoryBytes);
+	if (iBytesPerPixel == 4)
+		{
+		for (TInt y = 0; y < KPhysicalHeight; y++)
+			{
+			for (TInt x = 0; x < KPhysicalWidth; x++)
+				Physical(iMemory, x, y)[3] = 0xff;
+			}
+		}
+	Mem::Copy(iExpected, iMemory, KMemoryBytes);
+	}
+
+/**
+@return Number of logical pixels along x, including one partly outside the memory.
+*/
+inline TInt TScaledMemory::LogicalWidth() const
+	{
+	return (KPhysicalWidth - iInfo.iPhysicalOrigin.iX + iInfo.iFactorX - 1) / iInfo.iFactorX;
+	}
+
+/**
+@return Number of logical pixels along y, including one partly outside the memory.
+*/
+inline TInt TScaledMemory::LogicalHeight() const
+	{
+	return (KPhysicalHeight - iInfo.iPhysicalOrigin.iY + iInfo.iFactorY - 1) / iInfo.iFactorY;
+	}
+
+TUint8* TScaledMemory::Physical(TUint8* aMemory, TInt aPhysicalX, TInt aPhysicalY) const
+	{
+	return aMemory + aPhysicalY * KStride + aPhysicalX * iBytesPerPixel;
+	}
+
+/**
+Sets every physical pixel of the logical pixel [aX,aY] that is within the memory.
+*/
+void TScaledMemory::SetBlock(TUint8* aMemory, TInt aX, TInt aY, const TUint8* aPixel) const
+	{
+	const TPoint first(iInfo.LogicalToPhysical(TPoint(aX, aY)));
+	const TInt right = Min(first.iX + iInfo.iFactorX, KPhysicalWidth);
+	const TInt bottom = Min(first.iY + iInfo.iFactorY, KPhysicalHeight);
+	for (TInt y = first.iY; y < bottom; y++)
+		{
+		for (TInt x = first.iX; x < right; x++)
+			Mem::Copy(Physical(aMemory, x, y), aPixel, iBytesPerPixel);
+		}
+	}
+
+/**
+@return ETrue if the memory and the reference copy are identical.
+*/
+TBool TScaledMemory::IsExpected() const
+	{
+	return Mem::Compare(iMemory, KMemoryBytes, iExpected, KMemoryBytes) == 0;
+	}
+
+/**
+Average of the physical pixels of the logical pixel [aX,aY] that are within the memory, each
+channel rounded to nearest, in 32bpp or EColor64K format.
+*/
+LOCAL_C TUint32 BoxAverage(const TScaledMemory& aMemory, TInt aX, TInt aY)
+	{
+	const TPoint first(aMemory.iInfo.LogicalToPhysical(TPoint(aX, aY)));
+	const TInt right = Min(first.iX + aMemory.iInfo.iFactorX, KPhysicalWidth);
+	const TInt bottom = Min(first.iY + aMemory.iInfo.iFactorY, KPhysicalHeight);
+	const TUint32 count = (right - first.iX) * (bottom - first.iY);
+	// Shift and width of each channel.
+	const TInt numChannels = aMemory.iBytesPerPixel == 4 ? 4 : 3;
+	const TInt shifts32[] = {0, 8, 16, 24};
+	const TInt widths32[] = {8, 8, 8, 8};
+	const TInt shifts64K[] = {0, 5, 11};
+	const TInt widths64K[] = {5, 6, 5};
+	const TInt* shifts = aMemory.iBytesPerPixel == 4 ? shifts32 : shifts64K;
+	const TInt* widths = aMemory.iBytesPerPixel == 4 ? widths32 : widths64K;
+	TUint32 result = 0;
+	for (TInt channel = 0; channel < numChannels; channel++)
+		{
+		TUint32 sum = 0;
+		for (TInt y = first.iY; y < bottom; y++)
+			{
+			for (TInt x = first.iX; x < right; x++)
+				{
+				const TUint8* pixel = aMemory.Physical(aMemory.iMemory, x, y);
+				const TUint32 value = aMemory.iBytesPerPixel == 4 ?
+									  pixel[0] | (pixel[1] << 8) | (pixel[2] << 16) | (pixel[3] << 24) :
+									  pixel[0] | (pixel[1] << 8);
+				sum += (value >> shifts[channel]) & ((1 << widths[channel]) - 1);
+				}
+			}
+		result |= ((sum + count / 2) / count) << shifts[channel];
+		}
+	return result;
+	}
+
+/**
+Checks one call of aFunction on a span of aLength logical pixels starting at [aX,aY].
+@return ETrue if the memory, and the pixels read, are as expected.
+*/
+LOCAL_C TBool CheckSpan(TScaledMemory& aMemory, TScaledFunction aFunction, TInt aX, TInt aY, TInt aLength)
+	{
+	const TInt bytesPerPixel = aMemory.iBytesPerPixel;
+	TUint8 pixels[KMaxLength * 4];
+	TUint8 expected[KMaxLength * 4];
+	TUint32 rgb[KMaxLength];
+	TUint8 mask[KMaxLength];
+	FillRandom(pixels, sizeof(pixels));
+	Mem::Copy(expected, pixels, sizeof(pixels));
+	switch (aFunction)
+		{
+	case EReadLine:
+		for (TInt index = 0; index < aLength; index++)
+			{
+			const TPoint first(aMemory.iInfo.LogicalToPhysical(TPoint(aX + index, aY)));
+			Mem::Copy(expected + index * bytesPerPixel, aMemory.Physical(aMemory.iMemory, first.iX, first.iY), bytesPerPixel);
+			}
+		TScaledScanLine::ReadLine(aMemory.iInfo, aX, aY, aLength, pixels);
+		break;
+	case EReadLineBoxFiltered:
+		for (TInt index = 0; index < aLength; index++)
+			{
+			const TUint32 average = BoxAverage(aMemory, aX + index, aY);
+			Mem::Copy(expected + index * bytesPerPixel, &average, bytesPerPixel);
+			}
+		TScaledScanLine::ReadLineBoxFiltered(aMemory.iInfo, aX, aY, aLength, pixels);
+		break;
+	case EWriteLine:
+		for (TInt index = 0; index < aLength; index++)
+			aMemory.SetBlock(aMemory.iExpected, aX + index, aY, pixels + index * bytesPerPixel);
+		TScaledScanLine::WriteLine(aMemory.iInfo, aX, aY, aLength, pixels);
+		break;
+	case EWriteRgbMulti:
+		{
+		const TInt height = 1 + Random() % (aMemory.LogicalHeight() - aY);
+		for (TInt y = aY; y < aY + height; y++)
+			{
+			for (TInt index = 0; index < aLength; index++)
+				aMemory.SetBlock(aMemory.iExpected, aX + index, y, pixels);
+			}
+		TUint32 pixel = 0;
+		Mem::Copy(&pixel, pixels, bytesPerPixel);
+		TScaledScanLine::WriteRgbMulti(aMemory.iInfo, TRect(aX, aY, aX + aLength, aY + height), pixel);
+		break;
+		}
+	case EWriteRgbAlphaLine:
+		{
+		// Half the time the physical rows of the logical line start identical, so that the
+		// blended row is shared.
+		const TPoint first(aMemory.iInfo.LogicalToPhysical(TPoint(0, aY)));
+		if (Random() & 1)
+			{
+			const TInt bottom = Min(first.iY + aMemory.iInfo.iFactorY, KPhysicalHeight);
+			for (TInt y = first.iY + 1; y < bottom; y++)
+				{
+				Mem::Copy(aMemory.Physical(aMemory.iMemory, 0, y), aMemory.Physical(aMemory.iMemory, 0, first.iY),
+						  KPhysicalWidth * bytesPerPixel);
+				}
+			Mem::Copy(aMemory.iExpected, aMemory.iMemory, KMemoryBytes);
+			}
+		FillRandom(rgb, sizeof(rgb));
+		for (TInt index = 0; index < aLength; index++)
+			{
+			const TInt kind = Random() % 3;
+			mask[index] = TUint8(kind == 0 ? 0 : kind == 1 ? 0xff : Random() >> 8);
+			}
+		const TAlphaBlendSpan blend(EBlendImplScalar);
+		for (TInt index = 0; index < aLength; index++)
+			{
+			const TPoint block(aMemory.iInfo.LogicalToPhysical(TPoint(aX + index, aY)));
+			const TInt right = Min(block.iX + aMemory.iInfo.iFactorX, KPhysicalWidth);
+			const TInt bottom = Min(block.iY + aMemory.iInfo.iFactorY, KPhysicalHeight);
+			for (TInt y = block.iY; y < bottom; y++)
+				{
+				for (TInt x = block.iX; x < right; x++)
+					{
+					TUint8* dest = aMemory.Physical(aMemory.iExpected, x, y);
+					blend.BlendLine(aMemory.iInfo.iDisplayMode, dest, reinterpret_cast<const TUint8*>(rgb + index),
+									dest, mask + index, 1);
+					}
+				}
+			}
+		const TScaledScanLine scaled;
+		scaled.WriteRgbAlphaLine(aMemory.iInfo, aX, aY, aLength, reinterpret_cast<const TUint8*>(rgb), mask);
+		break;
+		}
+	default:
+		break;
+		}
+	return aMemory.IsExpected() && Mem::Compare(pixels, sizeof(pixels), expected, sizeof(expected)) == 0;
+	}
+
+/**
+Checks aFunction in aMode with every factor and every span length.
+*/
+LOCAL_C void TestFunction(TScaledMemory& aMemory, TScaledFunction aFunction, TDisplayMode aMode)
+	{
+	for (TInt factorY = 1; factorY <= KMaxFactorY; factorY++)
+		{
+		for (TInt factorX = 1; factorX <= KMaxFactor; factorX++)
+			{
+			for (TInt length = 0; length <= KMaxLength; length++)
+				{
+				aMemory.Reset(aMode, factorX, factorY);
+				if (length > aMemory.LogicalWidth())
+					break;
+				test(TScaledScanLine::IsSupported(aMemory.iInfo));
+				// Every other span ends at the edge of the memory.
+				const TInt x = (length & 1) ? aMemory.LogicalWidth() - length : Random() % (aMemory.LogicalWidth() - length + 1);
+				const TInt y = Random() % aMemory.LogicalHeight();
+				const TBool same = CheckSpan(aMemory, aFunction, x, y, length);
+				if (!same)
+					test.Printf(_L("%s: mode %d, factors %dx%d, [%d,%d], length %d\n"),
+								KFunctionNames[aFunction], aMode, factorX, factorY, x, y, length);
+				test(same);
+				}
+			}
+		}
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	TUint8* memory = static_cast<TUint8*>(User::AllocLC(KMemoryBytes));
+	TUint8* expected = static_cast<TUint8*>(User::AllocLC(KMemoryBytes));
+	TScaledMemory scaledMemory(memory, expected);
+
+	test.Start(_L("Supported layouts"));
+	scaledMemory.Reset(EColor16MU, 2, 2);
+	test(TScaledScanLine::IsSupported(scaledMemory.iInfo));
+	test(TScaledScanLine::IsBoxFilterSupported(scaledMemory.iInfo));
+	scaledMemory.Reset(EColor16M, 2, 2);
+	test(TScaledScanLine::IsSupported(scaledMemory.iInfo));
+	test(!TScaledScanLine::IsBoxFilterSupported(scaledMemory.iInfo));
+	scaledMemory.iInfo.iOrientation = CFbsDrawDevice::EOrientationRotated90;
+	test(!TScaledScanLine::IsSupported(scaledMemory.iInfo));
+
+	const TInt numModes = sizeof(KModes) / sizeof(KModes[0]);
+	for (TInt function = 0; function < EScaledFunctionCount; function++)
+		{
+		test.Next(_L("Scaled kernels against per-pixel results"));
+		test.Printf(_L("%s\n"), KFunctionNames[function]);
+		for (TInt index = 0; index < numModes; index++)
+			{
+			const TDisplayMode mode = KModes[index];
+			scaledMemory.Reset(mode, 1, 1);
+			if (function == EReadLineBoxFiltered && !TScaledScanLine::IsBoxFilterSupported(scaledMemory.iInfo))
+				continue;
+			if (function == EWriteRgbAlphaLine && !TAlphaBlendSpan::IsDisplayModeSupported(mode))
+				continue;
+			TestFunction(scaledMemory, TScaledFunction(function), mode);
+			}
+		}
+	test.End();
+	CleanupStack::PopAndDestroy(2, memory);
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}
@@ -0,0 +1,489 @@
+// Copyright (c) 1997-2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// Checks CTiledBitmapDevice against a device from CFbsDrawDevice::NewBitmapDeviceL() of the same
+// display mode and size, given the same calls. After each step every pixel of the two devices
+// must read the same.
+//	- Compress and expand: a device of one tile is filled so that Compact() stores it uniform,
+//	  run-length encoded, palette compressed and uncompressed, which CompressedBytes() confirms,
+//	  and it is then read back and drawn to again.
+//	- Eviction: tiles are written one after the other, so that the least recently used one is
+//	  compressed when KTileWorkingSet tiles are in use, and a tile that was only read keeps its
+//	  compressed copy. Random primitives over more than KTileWorkingSet tiles follow.
+//	- Edge tiles: WriteRgbMulti(), MapColors() and ShadowArea() on uniform tiles and on the
+//	  partial tiles at the right and bottom edges, covering them entirely or in part.
+//	- Binary writes: WriteBinary(), WriteBinaryLine() and WriteBinaryLineVertical() straddling
+//	  tile borders in both directions.
+// The device is KWidth x KHeight pixels, so the tiles of the last column and row are partial.
+//
+// Usage: tbitdrawtiled
+// The process panics at the first difference, after printing the step, mode and pixel.
+//
+
+#include <e32test.h>
+#include <e32math.h>
+#include "BitDrawTiled.h"
+#include "BitDrawPixelFormat.h"
+
+LOCAL_D RTest test(_L("TBitDrawTiled"));
+
+const TInt KWidth = 5 * KTileSize + 13;
+const TInt KHeight = 3 * KTileSize + 7;
+/** Random calls made by each step. */
+const TInt KIterations = 150;
+/** Longest buffer passed to the line primitives, in pixels. */
+const TInt KMaxLength = KWidth;
+
+/** Display modes checked, one per pixel size. */
+LOCAL_D const TDisplayMode KModes[] =
+	{
+	EColor256, EColor64K, EColor16M, EColor16MU
+	};
+
+LOCAL_D const CGraphicsContext::TDrawMode KDrawModes[] =
+	{
+	CGraphicsContext::EDrawModePEN, CGraphicsContext::EDrawModeXOR,
+	CGraphicsContext::EDrawModeAND, CGraphicsContext::EDrawModeNOTSCREEN
+	};
+
+/** Colours of the plain areas; mapped onto each other by MapColors(). */
+LOCAL_D const TRgb KPlainColors[] =
+	{
+	TRgb(0x00, 0x00, 0x00), TRgb(0xff, 0xff, 0xff), TRgb(0xff, 0x00, 0x00), TRgb(0x00, 0x00, 0xff)
+	};
+const TInt KPlainColorCount = sizeof(KPlainColors) / sizeof(KPlainColors[0]);
+
+LOCAL_D TInt64 TheSeed = 0x5eed711e;
+
+LOCAL_C TUint32 Random()
+	{
+	return TUint32(Math::Rand(TheSeed));
+	}
+
+LOCAL_C TInt Random(TInt aLow, TInt aHigh)
+	{
+	return aLow + TInt(Random() % TUint32(aHigh - aLow));
+	}
+
+LOCAL_C TRgb RandomColor()
+	{
+	return TRgb(Random() & 0xff, Random() & 0xff, Random() & 0xff);
+	}
+
+LOCAL_C CGraphicsContext::TDrawMode RandomDrawMode()
+	{
+	return KDrawModes[Random() % (sizeof(KDrawModes) / sizeof(KDrawModes[0]))];
+	}
+
+/**
+The tiled device, the bitmap device it is checked against, and the memory of the latter.
+*/
+class TTiledDevices
+	{
+public:
+	TTiledDevices();
+	void CreateL(TDisplayMode aMode, const TSize& aSize);
+	void Close();
+	TInt TileBytes() const;
+	void WriteRgb(TInt aX, TInt aY, TRgb aColor);
+	void WriteRgbMulti(const TRect& aRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode);
+	void FillNoise(const TRect& aRect, TInt aColors);
+	TBool IsExpected(const TText* aStep) const;
+public:
+	CTiledBitmapDevice* iTiled;
+	CFbsDrawDevice* iReference;
+	TUint8* iMemory;
+	TDisplayMode iMode;
+	TSize iSize;
+	};
+
+TTiledDevices::TTiledDevices():
+	iTiled(NULL),
+	iReference(NULL),
+	iMemory(NULL),
+	iMode(ENone)
+	{
+	}
+
+/**
+Creates both devices, with all pixels 0.
+*/
+void TTiledDevices::CreateL(TDisplayMode aMode, const TSize& aSize)
+	{
+	iMode = aMode;
+	iSize = aSize;
+	iTiled = CTiledBitmapDevice::NewL(aSize, aMode);
+	const TInt stride = ((aSize.iWidth * BitsInMemory(aMode) + 31) >> 5) << 2;
+	iMemory = static_cast<TUint8*>(User::AllocZL(stride * aSize.iHeight));
+	iReference = CFbsDrawDevice::NewBitmapDeviceL(aSize, aMode, stride);
+	iReference->SetBits(iMemory);
+	}
+
+void TTiledDevices::Close()
+	{
+	delete iTiled;
+	iTiled = NULL;
+	delete iReference;
+	iReference = NULL;
+	User::Free(iMemory);
+	iMemory = NULL;
+	}
+
+/**
+@return The size of an uncompressed tile in bytes.
+*/
+TInt TTiledDevices::TileBytes() const
+	{
+	return KTileSize * KTileSize * (BitsInMemory(iMode) >> 3);
+	}
+
+void TTiledDevices::WriteRgb(TInt aX, TInt aY, TRgb aColor)
+	{
+	iTiled->WriteRgb(aX, aY, aColor, CGraphicsContext::EDrawModePEN);
+	iReference->WriteRgb(aX, aY, aColor, CGraphicsContext::EDrawModePEN);
+	}
+
+void TTiledDevices::WriteRgbMulti(const TRect& aRect, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode)
+	{
+	iTiled->WriteRgbMulti(aRect.iTl.iX, aRect.iTl.iY, aRect.Width(), aRect.Height(), aColor, aDrawMode);
+	iReference->WriteRgbMulti(aRect.iTl.iX, aRect.iTl.iY, aRect.Width(), aRect.Height(), aColor, aDrawMode);
+	}
+
+/**
+Writes every pixel of aRect in a random colour: one of the first aColors plain colours, or any
+colour if aColors is 0.
+*/
+void TTiledDevices::FillNoise(const TRect& aRect, TInt aColors)
+	{
+	for (TInt y = aRect.iTl.iY; y < aRect.iBr.iY; y++)
+		{
+		for (TInt x = aRect.iTl.iX; x < aRect.iBr.iX; x++)
+			WriteRgb(x, y, aColors ? KPlainColors[Random() % aColors] : RandomColor());
+		}
+	}
+
+/**
+@return ETrue if every pixel of the two devices reads the same.
+*/
+TBool TTiledDevices::IsExpected(const TText* aStep) const
+	{
+	for (TInt y = 0; y < iSize.iHeight; y++)
+		{
+		for (TInt x = 0; x < iSize.iWidth; x++)
+			{
+			const TRgb actual(iTiled->ReadPixel(x, y));
+			const TRgb expected(iReference->ReadPixel(x, y));
+			if (actual.Red() != expected.Red() || actual.Green() != expected.Green() ||
+				actual.Blue() != expected.Blue())
+				{
+				test.Printf(_L("%s: mode %d, [%d,%d] is %06x, expected %06x\n"), aStep, iMode, x, y,
+							actual.Internal() & 0xffffff, expected.Internal() & 0xffffff);
+				return EFalse;
+				}
+			}
+		}
+	return ETrue;
+	}
+
+/**
+@return A rectangle of at least one pixel within the device, whose edges are at most 3 pixels from
+a tile border or from the edge of the device.
+*/
+LOCAL_C TRect RandomBorderRect(const TSize& aSize)
+	{
+	TInt edges[4];
+	for (TInt index = 0; index < 4; index++)
+		{
+		const TInt size = index & 1 ? aSize.iHeight : aSize.iWidth;
+		const TInt border = Random(0, size / KTileSize + 2) * KTileSize;
+		edges[index] = Max(0, Min(size, border + Random(-3, 4)));
+		}
+	const TPoint topLeft(Min(Min(edges[0], edges[2]), aSize.iWidth - 1), Min(Min(edges[1], edges[3]), aSize.iHeight - 1));
+	const TPoint bottomRight(Max(Max(edges[0], edges[2]), topLeft.iX + 1), Max(Max(edges[1], edges[3]), topLeft.iY + 1));
+	return TRect(topLeft, bottomRight);
+	}
+
+/**
+A device of one tile, stored in each format in turn.
+*/
+LOCAL_C void TestFormatsL(TDisplayMode aMode)
+	{
+	TTiledDevices devices;
+	CleanupClosePushL(devices);
+	devices.CreateL(aMode, TSize(KTileSize, KTileSize));
+	const TRect tile(devices.iSize);
+	const TInt bytesPerPixel = BitsInMemory(aMode) >> 3;
+
+	// Uniform: a plain fill leaves nothing to compress.
+	devices.WriteRgbMulti(tile, KPlainColors[2], CGraphicsContext::EDrawModePEN);
+	test(devices.iTiled->Compact() == KErrNone);
+	test(devices.iTiled->CompressedBytes() == 0);
+	test(devices.IsExpected(_S("uniform")));
+
+	// Run-length: one run per row, in colours that alternate from row to row.
+	for (TInt y = 0; y < KTileSize; y++)
+		devices.WriteRgbMulti(TRect(0, y, KTileSize, y + 1), KPlainColors[y & 3], CGraphicsContext::EDrawModePEN);
+	test(devices.iTiled->Compact() == KErrNone);
+	test(devices.iTiled->CompressedBytes() == KTileSize * (1 + bytesPerPixel));
+	test(devices.IsExpected(_S("run-length")));
+
+	// Palette: noise in the plain colours, whose runs are too short to encode.
+	devices.FillNoise(tile, KPlainColorCount);
+	test(devices.iTiled->Compact() == KErrNone);
+	test(devices.iTiled->CompressedBytes() == 1 + KPlainColorCount * bytesPerPixel + KTileSize * KTileSize / 2);
+	test(devices.IsExpected(_S("palette")));
+
+	// Uncompressed: noise in more colours than a tile palette holds.
+	devices.FillNoise(tile, 0);
+	test(devices.iTiled->Compact() == KErrNone);
+	test(devices.iTiled->CompressedBytes() == devices.TileBytes());
+	test(devices.IsExpected(_S("uncompressed")));
+
+	// Drawing to an expanded tile and compressing it again.
+	for (TInt iteration = 0; iteration < KIterations; iteration++)
+		{
+		const TRect rect(RandomBorderRect(devices.iSize));
+		devices.WriteRgbMulti(rect, iteration & 1 ? RandomColor() : KPlainColors[Random() % KPlainColorCount],
+							  RandomDrawMode());
+		test(devices.iTiled->Compact() == KErrNone);
+		test(devices.IsExpected(_S("compress and expand")));
+		}
+	CleanupStack::PopAndDestroy(&devices);
+	}
+
+/**
+Tiles written one after the other are evicted least recently used first.
+*/
+LOCAL_C void TestEvictionL(TDisplayMode aMode)
+	{
+	TTiledDevices devices;
+	CleanupClosePushL(devices);
+	devices.CreateL(aMode, TSize(KWidth, KHeight));
+	// Whole tiles, in the order they are written; noise keeps them uncompressed.
+	TRect tiles[KTileWorkingSet + 1];
+	for (TInt index = 0; index <= KTileWorkingSet; index++)
+		{
+		const TInt tileX = index % (KWidth / KTileSize);
+		const TInt tileY = index / (KWidth / KTileSize);
+		tiles[index].SetRect(TPoint(tileX * KTileSize, tileY * KTileSize), TSize(KTileSize, KTileSize));
+		devices.FillNoise(tiles[index], 0);
+		}
+	const TInt tileBytes = devices.TileBytes();
+	// The first tile made room for the last one.
+	test(devices.iTiled->CompressedBytes() == tileBytes);
+	// Reading it back makes room by evicting the second one, and keeps its compressed copy.
+	devices.iTiled->ReadPixel(tiles[0].iTl.iX, tiles[0].iTl.iY);
+	test(devices.iTiled->CompressedBytes() == 2 * tileBytes);
+	// Writing to it drops the copy.
+	devices.WriteRgb(tiles[0].iTl.iX, tiles[0].iTl.iY, RandomColor());
+	test(devices.iTiled->CompressedBytes() == tileBytes);
+	test(devices.IsExpected(_S("eviction order")));
+
+	TUint32 line[KMaxLength];
+	TUint8 mask[KMaxLength];
+	for (TInt iteration = 0; iteration < KIterations; iteration++)
+		{
+		const TRect rect(RandomBorderRect(devices.iSize));
+		const TInt x = rect.iTl.iX;
+		const TInt y = rect.iTl.iY;
+		const TInt length = rect.Width();
+		for (TInt index = 0; index < length; index++)
+			{
+			line[index] = Random() | 0xff000000;
+			mask[index] = TUint8(Random() % 3 ? Random() >> 8 : (Random() & 1) * 0xff);
+			}
+		switch (Random() % 4)
+			{
+		case 0:
+			devices.WriteRgbMulti(rect, RandomColor(), RandomDrawMode());
+			break;
+		case 1:
+			devices.FillNoise(TRect(x, y, x + length, Min(y + 3, KHeight)), 0);
+			break;
+		case 2:
+			{
+			const TRgb color(RandomColor());
+			devices.iTiled->WriteRgbAlphaMulti(x, y, length, color, mask);
+			devices.iReference->WriteRgbAlphaMulti(x, y, length, color, mask);
+			break;
+			}
+		default:
+			devices.iTiled->WriteRgbAlphaLine(x, y, length, reinterpret_cast<TUint8*>(line), mask,
+											  CGraphicsContext::EDrawModePEN);
+			devices.iReference->WriteRgbAlphaLine(x, y, length, reinterpret_cast<TUint8*>(line), mask,
+												  CGraphicsContext::EDrawModePEN);
+			break;
+			}
+		test(devices.IsExpected(_S("eviction")));
+		}
+	CleanupStack::PopAndDestroy(&devices);
+	}
+
+/**
+WriteRgbMulti(), MapColors() and ShadowArea() on uniform tiles and partial edge tiles.
+*/
+LOCAL_C void TestEdgeTilesL(TDisplayMode aMode)
+	{
+	TTiledDevices devices;
+	CleanupClosePushL(devices);
+	devices.CreateL(aMode, TSize(KWidth, KHeight));
+	const TInt lastColumn = (KWidth / KTileSize) * KTileSize;
+	const TInt lastRow = (KHeight / KTileSize) * KTileSize;
+
+	// An opaque fill of the whole device only sets the value of each tile.
+	devices.WriteRgbMulti(TRect(devices.iSize), KPlainColors[1], CGraphicsContext::EDrawModePEN);
+	test(devices.iTiled->Compact() == KErrNone);
+	test(devices.iTiled->CompressedBytes() == 0);
+	test(devices.IsExpected(_S("plain fill")));
+
+	// So does a fill of the visible part of the partial tiles.
+	devices.WriteRgbMulti(TRect(lastColumn, 0, KWidth, KHeight), KPlainColors[2], CGraphicsContext::EDrawModePEN);
+	devices.WriteRgbMulti(TRect(0, lastRow, KWidth, KHeight), KPlainColors[3], CGraphicsContext::EDrawModePEN);
+	test(devices.iTiled->Compact() == KErrNone);
+	test(devices.iTiled->CompressedBytes() == 0);
+	test(devices.IsExpected(_S("edge fill")));
+
+	// Mapping the colours and shadowing uniform tiles keeps them uniform.
+	const TRgb colors[4] = { KPlainColors[1], KPlainColors[0], KPlainColors[2], KPlainColors[1] };
+	devices.iTiled->MapColors(TRect(devices.iSize), colors, 2, ETrue);
+	devices.iReference->MapColors(TRect(devices.iSize), colors, 2, ETrue);
+	test(devices.IsExpected(_S("uniform MapColors")));
+	devices.iTiled->SetShadowMode(CFbsDrawDevice::EShadow);
+	devices.iReference->SetShadowMode(CFbsDrawDevice::EShadow);
+	devices.iTiled->ShadowArea(TRect(devices.iSize));
+	devices.iReference->ShadowArea(TRect(devices.iSize));
+	test(devices.iTiled->Compact() == KErrNone);
+	test(devices.iTiled->CompressedBytes() == 0);
+	test(devices.IsExpected(_S("uniform ShadowArea")));
+
+	for (TInt iteration = 0; iteration < KIterations; iteration++)
+		{
+		const TRect rect(RandomBorderRect(devices.iSize));
+		switch (Random() % 3)
+			{
+		case 0:
+			devices.WriteRgbMulti(rect, KPlainColors[Random() % KPlainColorCount], RandomDrawMode());
+			break;
+		case 1:
+			{
+			TRgb pairs[KPlainColorCount * 2];
+			for (TInt index = 0; index < KPlainColorCount * 2; index++)
+				pairs[index] = KPlainColors[Random() % KPlainColorCount];
+			const TBool forwards = Random() & 1;
+			devices.iTiled->MapColors(rect, pairs, KPlainColorCount, forwards);
+			devices.iReference->MapColors(rect, pairs, KPlainColorCount, forwards);
+			break;
+			}
+		default:
+			{
+			const CFbsDrawDevice::TShadowMode shadowMode = CFbsDrawDevice::TShadowMode(Random(1, 4));
+			const TUint8 blackMap = TUint8(Random() & 0x7f);
+			const TUint8 whiteMap = TUint8(Random(0x80, 0x100));
+			devices.iTiled->SetFadingParameters(blackMap, whiteMap);
+			devices.iReference->SetFadingParameters(blackMap, whiteMap);
+			devices.iTiled->SetShadowMode(shadowMode);
+			devices.iReference->SetShadowMode(shadowMode);
+			devices.iTiled->ShadowArea(rect);
+			devices.iReference->ShadowArea(rect);
+			break;
+			}
+			}
+		test(devices.IsExpected(_S("edge tiles")));
+		}
+	devices.iTiled->SetShadowMode(CFbsDrawDevice::ENoShadow);
+	devices.iReference->SetShadowMode(CFbsDrawDevice::ENoShadow);
+	CleanupStack::PopAndDestroy(&devices);
+	}
+
+/**
+Binary writes straddling tile borders.
+*/
+LOCAL_C void TestBinaryL(TDisplayMode aMode)
+	{
+	TTiledDevices devices;
+	CleanupClosePushL(devices);
+	devices.CreateL(aMode, TSize(KWidth, KHeight));
+	devices.FillNoise(TRect(0, 0, KWidth, KTileSize + 4), KPlainColorCount);
+	TUint32 buffer[KMaxLength];
+	for (TInt iteration = 0; iteration < KIterations; iteration++)
+		{
+		for (TInt index = 0; index < KMaxLength; index++)
+			buffer[index] = Random() ^ (Random() << 16);
+		const TRgb color(RandomColor());
+		const CGraphicsContext::TDrawMode drawMode = RandomDrawMode();
+		// Just before a tile border, so that the writes reach the next tile.
+		const TInt x = Max(0, Random(1, KWidth / KTileSize + 1) * KTileSize - Random(1, KTileSize));
+		const TInt y = Max(0, Random(1, KHeight / KTileSize + 1) * KTileSize - Random(1, KTileSize));
+		switch (Random() % 3)
+			{
+		case 0:
+			{
+			const TInt length = Random(1, Min(KTileSize, KWidth - x) + 1);
+			const TInt height = Random(1, KHeight - y + 1);
+			devices.iTiled->WriteBinary(x, y, buffer, length, height, color, drawMode);
+			devices.iReference->WriteBinary(x, y, buffer, length, height, color, drawMode);
+			break;
+			}
+		case 1:
+			{
+			const TInt length = Random(1, KWidth - x + 1);
+			devices.iTiled->WriteBinaryLine(x, y, buffer, length, color, drawMode);
+			devices.iReference->WriteBinaryLine(x, y, buffer, length, color, drawMode);
+			break;
+			}
+		default:
+			{
+			const TBool up = Random() & 1;
+			const TInt startY = up ? Min(KHeight - 1, y + Random(1, KTileSize)) : y;
+			const TInt height = Random(1, (up ? startY + 1 : KHeight - startY) + 1);
+			devices.iTiled->WriteBinaryLineVertical(x, startY, buffer, height, color, drawMode, up);
+			devices.iReference->WriteBinaryLineVertical(x, startY, buffer, height, color, drawMode, up);
+			break;
+			}
+			}
+		test(devices.IsExpected(_S("binary")));
+		}
+	CleanupStack::PopAndDestroy(&devices);
+	}
+
+LOCAL_C void DoTestsL()
+	{
+	const TInt numModes = sizeof(KModes) / sizeof(KModes[0]);
+	test.Start(_L("Compress and expand every tile format"));
+	for (TInt index = 0; index < numModes; index++)
+		TestFormatsL(KModes[index]);
+	test.Next(_L("Least recently used tiles are evicted"));
+	for (TInt index = 0; index < numModes; index++)
+		TestEvictionL(KModes[index]);
+	test.Next(_L("Uniform and partial edge tiles"));
+	for (TInt index = 0; index < numModes; index++)
+		TestEdgeTilesL(KModes[index]);
+	test.Next(_L("Binary writes across tile borders"));
+	for (TInt index = 0; index < numModes; index++)
+		TestBinaryL(KModes[index]);
+	test.End();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	__UHEAP_MARK;
+	test.Title();
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	test(cleanup != NULL);
+	TRAPD(err, DoTestsL());
+	test(err == KErrNone);
+	delete cleanup;
+	test.Close();
+	__UHEAP_MARKEND;
+	return KErrNone;
+	}